@@ -98,6 +98,16 @@ ATOMIC_INLINE int64_t atomic_fetch_and_sub_int64(int64_t *p, int64_t x)
 {
   return InterlockedExchangeAdd64(p, -x);
 }
+
+ATOMIC_INLINE int64_t atomic_load_int64(const int64_t *v)
+{
+  return __iso_volatile_load64((const volatile __int64 *)v);
+}
+
+ATOMIC_INLINE void atomic_store_int64(int64_t *p, int64_t v)
+{
+  __iso_volatile_store64((volatile __int64 *)p, v);
+}
 #endif
 
 /******************************************************************************/
@@ -149,6 +159,16 @@ ATOMIC_INLINE int32_t atomic_cas_int32(int32_t *v, int32_t old, int32_t _new)
   return InterlockedCompareExchange((long *)v, _new, old);
 }
 
+ATOMIC_INLINE int32_t atomic_load_int32(const int32_t *v)
+{
+  return __iso_volatile_load32((const volatile __int32 *)v);
+}
+
+ATOMIC_INLINE void atomic_store_int32(int32_t *p, int32_t v)
+{
+  __iso_volatile_store32((volatile __int32 *)p, v);
+}
+
 ATOMIC_INLINE int32_t atomic_fetch_and_add_int32(int32_t *p, int32_t x)
 {
   return InterlockedExchangeAdd((long *)p, x);
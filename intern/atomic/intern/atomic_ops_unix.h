@@ -105,6 +105,16 @@ ATOMIC_INLINE int64_t atomic_cas_int64(int64_t *v, int64_t old, int64_t _new)
   return __sync_val_compare_and_swap(v, old, _new);
 }
 
+ATOMIC_INLINE int64_t atomic_load_int64(const int64_t *v)
+{
+  return __atomic_load_n(v, __ATOMIC_RELAXED);
+}
+
+ATOMIC_INLINE void atomic_store_int64(int64_t *p, int64_t v)
+{
+  __atomic_store_n(p, v, __ATOMIC_RELAXED);
+}
+
 #  elif (defined(__amd64__) || defined(__x86_64__))
 /* Unsigned */
 ATOMIC_INLINE uint64_t atomic_fetch_and_add_uint64(uint64_t *p, uint64_t x)
@@ -179,6 +189,17 @@ ATOMIC_INLINE int64_t atomic_cas_int64(int64_t *v, int64_t old, int64_t _new)
   asm volatile("lock; cmpxchgq %2,%1" : "=a"(ret), "+m"(*v) : "r"(_new), "0"(old) : "memory");
   return ret;
 }
+
+/* Aligned 64-bit loads and stores are atomic on x86-64. */
+ATOMIC_INLINE int64_t atomic_load_int64(const int64_t *v)
+{
+  return *(const volatile int64_t *)v;
+}
+
+ATOMIC_INLINE void atomic_store_int64(int64_t *p, int64_t v)
+{
+  *(volatile int64_t *)p = v;
+}
 #  else
 #    error "Missing implementation for 64-bit atomic operations"
 #  endif
@@ -219,6 +240,16 @@ ATOMIC_INLINE int32_t atomic_cas_int32(int32_t *v, int32_t old, int32_t _new)
   return __sync_val_compare_and_swap(v, old, _new);
 }
 
+ATOMIC_INLINE int32_t atomic_load_int32(const int32_t *v)
+{
+  return __atomic_load_n(v, __ATOMIC_RELAXED);
+}
+
+ATOMIC_INLINE void atomic_store_int32(int32_t *p, int32_t v)
+{
+  __atomic_store_n(p, v, __ATOMIC_RELAXED);
+}
+
 #elif (defined(__i386__) || defined(__amd64__) || defined(__x86_64__))
 /* Unsigned */
 ATOMIC_INLINE uint32_t atomic_add_and_fetch_uint32(uint32_t *p, uint32_t x)
@@ -276,6 +307,17 @@ ATOMIC_INLINE int32_t atomic_cas_int32(int32_t *v, int32_t old, int32_t _new)
   return ret;
 }
 
+/* Aligned 32-bit loads and stores are atomic on x86. */
+ATOMIC_INLINE int32_t atomic_load_int32(const int32_t *v)
+{
+  return *(const volatile int32_t *)v;
+}
+
+ATOMIC_INLINE void atomic_store_int32(int32_t *p, int32_t v)
+{
+  *(volatile int32_t *)p = v;
+}
+
 #else
 #  error "Missing implementation for 32-bit atomic operations"
 #endif
@@ -214,6 +214,10 @@ extern const char *(*MEM_name_ptr)(void *vmemh);
 /* Switch allocator to slower but fully guarded mode. */
 void MEM_use_guarded_allocator(void);
 
+/* Switch allocator to cache small blocks and memory usage counters per thread.
+ * Peak memory is only updated when a thread flushes its counters and is approximate. */
+void MEM_use_tcache_allocator(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -148,6 +148,49 @@ size_t MEM_lockfree_get_peak_memory(void) ATTR_WARN_UNUSED_RESULT;
 const char *MEM_lockfree_name_ptr(void *vmemh);
 #endif
 
+/* Prototypes for thread caching allocator functions */
+size_t MEM_tcache_allocN_len(const void *vmemh) ATTR_WARN_UNUSED_RESULT;
+void MEM_tcache_freeN(void *vmemh);
+void *MEM_tcache_dupallocN(const void *vmemh) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+void *MEM_tcache_reallocN_id(void *vmemh,
+                             size_t len,
+                             const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(2);
+void *MEM_tcache_recallocN_id(void *vmemh,
+                              size_t len,
+                              const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(2);
+void *MEM_tcache_callocN(size_t len, const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(1) ATTR_NONNULL(2);
+void *MEM_tcache_calloc_arrayN(size_t len,
+                               size_t size,
+                               const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(1, 2) ATTR_NONNULL(3);
+void *MEM_tcache_mallocN(size_t len, const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(1) ATTR_NONNULL(2);
+void *MEM_tcache_malloc_arrayN(size_t len,
+                               size_t size,
+                               const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(1, 2) ATTR_NONNULL(3);
+void *MEM_tcache_mallocN_aligned(size_t len,
+                                 size_t alignment,
+                                 const char *UNUSED(str)) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_ALLOC_SIZE(1) ATTR_NONNULL(3);
+void MEM_tcache_printmemlist_pydict(void);
+void MEM_tcache_printmemlist(void);
+void MEM_tcache_callbackmemlist(void (*func)(void *));
+void MEM_tcache_printmemlist_stats(void);
+void MEM_tcache_set_error_callback(void (*func)(const char *));
+bool MEM_tcache_consistency_check(void);
+void MEM_tcache_set_memory_debug(void);
+size_t MEM_tcache_get_memory_in_use(void);
+unsigned int MEM_tcache_get_memory_blocks_in_use(void);
+void MEM_tcache_reset_peak_memory(void);
+size_t MEM_tcache_get_peak_memory(void) ATTR_WARN_UNUSED_RESULT;
+#ifndef NDEBUG
+const char *MEM_tcache_name_ptr(void *vmemh);
+#endif
+
 /* Prototypes for fully guarded allocator functions */
 size_t MEM_guarded_allocN_len(const void *vmemh) ATTR_WARN_UNUSED_RESULT;
 void MEM_guarded_freeN(void *vmemh);
@@ -0,0 +1,696 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup MEM
+ *
+ * Memory allocation with per-thread caches of small blocks.
+ *
+ * Small blocks are rounded up to a size class and freed blocks are kept in a free list of the
+ * thread which freed them, so the next allocation of the same class does not go to the system
+ * allocator. Memory usage counters are accumulated per thread and only added to the global
+ * counters once they exceed a threshold, which avoids contention on the global atomics when
+ * many threads allocate at the same time.
+ *
+ * The peak memory usage is only updated when a thread flushes its counters, so it is
+ * approximate and can miss short peaks of less than the flush threshold per thread.
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h> /* memcpy */
+#include <sys/types.h>
+
+#include "MEM_guardedalloc.h"
+
+/* to ensure strict conversions */
+#include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+#include "atomic_ops.h"
+#include "mallocn_intern.h"
+
+#ifdef _MSC_VER
+#  define MEM_THREAD_LOCAL __declspec(thread)
+#else
+#  define MEM_THREAD_LOCAL __thread
+#endif
+
+typedef struct MemHead {
+  /* Length of allocated memory block. */
+  size_t len;
+} MemHead;
+
+typedef struct MemHeadAligned {
+  short alignment;
+  size_t len;
+} MemHeadAligned;
+
+enum {
+  MEMHEAD_ALIGN_FLAG = 1,
+};
+
+#define MEMHEAD_FROM_PTR(ptr) (((MemHead *)ptr) - 1)
+#define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
+#define MEMHEAD_ALIGNED_FROM_PTR(ptr) (((MemHeadAligned *)ptr) - 1)
+#define MEMHEAD_IS_ALIGNED(memhead) ((memhead)->len & (size_t)MEMHEAD_ALIGN_FLAG)
+
+/* Blocks up to this size (including MemHead) are rounded up to a size class and cached. */
+#define SIZE_CLASS_GRANULARITY 16
+#define SIZE_CLASS_NUM 64
+#define SIZE_CLASS_MAX_SIZE (SIZE_CLASS_GRANULARITY * SIZE_CLASS_NUM)
+#define SIZE_CLASS_INDEX(size) (((size)-1) / SIZE_CLASS_GRANULARITY)
+#define SIZE_CLASS_SIZE(index) (((size_t)(index) + 1) * SIZE_CLASS_GRANULARITY)
+
+/* Maximum number of free blocks kept per size class and thread. */
+#define THREAD_CACHE_MAX_FREE_BLOCKS 32
+
+/* Thread local usage is added to the global counters once it differs this much. */
+#define THREAD_CACHE_FLUSH_MEM (256 * 1024)
+#define THREAD_CACHE_FLUSH_BLOCKS 256
+
+typedef struct FreeBlock {
+  struct FreeBlock *next;
+} FreeBlock;
+
+typedef struct ThreadCache {
+  struct ThreadCache *next, *prev;
+
+  FreeBlock *free_blocks[SIZE_CLASS_NUM];
+  unsigned int num_free_blocks[SIZE_CLASS_NUM];
+
+  /* Usage which is not yet added to the global counters, can be negative when the thread frees
+   * memory allocated by other threads. Only written by the owning thread, but read by others
+   * for statistics, so always accessed atomically. */
+  int64_t mem_in_use_delta;
+  int64_t totblock_delta;
+} ThreadCache;
+
+/* Global counters, only updated when a thread cache flushes its usage. They can temporarily go
+ * negative, only the sum with all thread local deltas is meaningful. */
+static int64_t totblock = 0;
+static int64_t mem_in_use = 0;
+static size_t peak_mem = 0;
+static bool malloc_debug_memset = false;
+
+static void (*error_callback)(const char *) = NULL;
+
+/* All thread caches, used to include their usage in the statistics. The lock is also held while
+ * flushing usage, so statistics never count a delta both in the global and thread counters. */
+static ThreadCache *thread_caches = NULL;
+static pthread_mutex_t thread_caches_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_key_t thread_cache_key;
+static pthread_once_t thread_cache_key_once = PTHREAD_ONCE_INIT;
+
+static MEM_THREAD_LOCAL ThreadCache *thread_cache = NULL;
+/* Set when the thread cache is destroyed on thread exit, frees done by destructors which run
+ * after that must not create a new cache which would never be freed. */
+static MEM_THREAD_LOCAL bool thread_cache_destroyed = false;
+
+#ifdef __GNUC__
+__attribute__((format(printf, 1, 2)))
+#endif
+static void
+print_error(const char *str, ...)
+{
+  char buf[512];
+  va_list ap;
+
+  va_start(ap, str);
+  vsnprintf(buf, sizeof(buf), str, ap);
+  va_end(ap);
+  buf[sizeof(buf) - 1] = '\0';
+
+  if (error_callback) {
+    error_callback(buf);
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Thread Cache
+ * \{ */
+
+static void memory_usage_add_global(int64_t mem_delta, int64_t block_delta)
+{
+  const int64_t mem = atomic_add_and_fetch_int64(&mem_in_use, mem_delta);
+  atomic_add_and_fetch_int64(&totblock, block_delta);
+
+  /* Only approximate since other threads may still hold unflushed usage. */
+  if (mem > 0) {
+    atomic_fetch_and_update_max_z(&peak_mem, (size_t)mem);
+  }
+}
+
+/* Must be called with thread_caches_lock held. */
+static void thread_cache_flush_usage_locked(ThreadCache *cache)
+{
+  memory_usage_add_global(atomic_load_int64(&cache->mem_in_use_delta),
+                          atomic_load_int64(&cache->totblock_delta));
+  atomic_store_int64(&cache->mem_in_use_delta, 0);
+  atomic_store_int64(&cache->totblock_delta, 0);
+}
+
+static void thread_cache_flush_usage(ThreadCache *cache)
+{
+  pthread_mutex_lock(&thread_caches_lock);
+  thread_cache_flush_usage_locked(cache);
+  pthread_mutex_unlock(&thread_caches_lock);
+}
+
+static void thread_cache_free(void *cache_v)
+{
+  ThreadCache *cache = (ThreadCache *)cache_v;
+
+  for (int i = 0; i < SIZE_CLASS_NUM; i++) {
+    FreeBlock *block = cache->free_blocks[i];
+    while (block) {
+      FreeBlock *next = block->next;
+      free(block);
+      block = next;
+    }
+  }
+
+  pthread_mutex_lock(&thread_caches_lock);
+  thread_cache_flush_usage_locked(cache);
+  if (cache->prev) {
+    cache->prev->next = cache->next;
+  }
+  else {
+    thread_caches = cache->next;
+  }
+  if (cache->next) {
+    cache->next->prev = cache->prev;
+  }
+  pthread_mutex_unlock(&thread_caches_lock);
+
+  free(cache);
+
+  thread_cache = NULL;
+  thread_cache_destroyed = true;
+}
+
+static void thread_cache_key_create(void)
+{
+  pthread_key_create(&thread_cache_key, thread_cache_free);
+}
+
+static ThreadCache *thread_cache_create(void)
+{
+  pthread_once(&thread_cache_key_once, thread_cache_key_create);
+
+  ThreadCache *cache = (ThreadCache *)calloc(1, sizeof(ThreadCache));
+  if (UNLIKELY(cache == NULL)) {
+    return NULL;
+  }
+
+  pthread_mutex_lock(&thread_caches_lock);
+  cache->next = thread_caches;
+  if (thread_caches) {
+    thread_caches->prev = cache;
+  }
+  thread_caches = cache;
+  pthread_mutex_unlock(&thread_caches_lock);
+
+  pthread_setspecific(thread_cache_key, cache);
+  thread_cache = cache;
+
+  return cache;
+}
+
+/* Returns NULL when the thread is exiting, in that case global counters are used directly. */
+MEM_INLINE ThreadCache *thread_cache_get(void)
+{
+  if (LIKELY(thread_cache)) {
+    return thread_cache;
+  }
+  if (thread_cache_destroyed) {
+    return NULL;
+  }
+  return thread_cache_create();
+}
+
+MEM_INLINE void memory_usage_add(ThreadCache *cache, size_t len)
+{
+  if (UNLIKELY(cache == NULL)) {
+    memory_usage_add_global((int64_t)len, 1);
+    return;
+  }
+
+  const int64_t mem_delta = atomic_load_int64(&cache->mem_in_use_delta) + (int64_t)len;
+  const int64_t block_delta = atomic_load_int64(&cache->totblock_delta) + 1;
+  atomic_store_int64(&cache->mem_in_use_delta, mem_delta);
+  atomic_store_int64(&cache->totblock_delta, block_delta);
+  if (mem_delta > THREAD_CACHE_FLUSH_MEM || block_delta > THREAD_CACHE_FLUSH_BLOCKS) {
+    thread_cache_flush_usage(cache);
+  }
+}
+
+MEM_INLINE void memory_usage_sub(ThreadCache *cache, size_t len)
+{
+  if (UNLIKELY(cache == NULL)) {
+    memory_usage_add_global(-(int64_t)len, -1);
+    return;
+  }
+
+  const int64_t mem_delta = atomic_load_int64(&cache->mem_in_use_delta) - (int64_t)len;
+  const int64_t block_delta = atomic_load_int64(&cache->totblock_delta) - 1;
+  atomic_store_int64(&cache->mem_in_use_delta, mem_delta);
+  atomic_store_int64(&cache->totblock_delta, block_delta);
+  if (mem_delta < -THREAD_CACHE_FLUSH_MEM || block_delta < -THREAD_CACHE_FLUSH_BLOCKS) {
+    thread_cache_flush_usage(cache);
+  }
+}
+
+/* Small blocks are always allocated with their size class size, also when there is no thread
+ * cache, since they might be freed into the cache of another thread and reused from there. */
+static MemHead *memhead_alloc(ThreadCache *cache, size_t len, bool clear)
+{
+  const size_t size = len + sizeof(MemHead);
+
+  if (size > SIZE_CLASS_MAX_SIZE) {
+    return (MemHead *)(clear ? calloc(1, size) : malloc(size));
+  }
+
+  const size_t index = SIZE_CLASS_INDEX(size);
+  MemHead *memh;
+
+  if (cache && cache->free_blocks[index]) {
+    FreeBlock *block = cache->free_blocks[index];
+    cache->free_blocks[index] = block->next;
+    cache->num_free_blocks[index]--;
+    memh = (MemHead *)block;
+  }
+  else {
+    memh = (MemHead *)malloc(SIZE_CLASS_SIZE(index));
+  }
+
+  if (clear && memh) {
+    memset(memh, 0, size);
+  }
+  return memh;
+}
+
+static void memhead_free(ThreadCache *cache, MemHead *memh, size_t len)
+{
+  const size_t size = len + sizeof(MemHead);
+
+  if (cache && size <= SIZE_CLASS_MAX_SIZE) {
+    const size_t index = SIZE_CLASS_INDEX(size);
+    if (cache->num_free_blocks[index] < THREAD_CACHE_MAX_FREE_BLOCKS) {
+      FreeBlock *block = (FreeBlock *)memh;
+      block->next = cache->free_blocks[index];
+      cache->free_blocks[index] = block;
+      cache->num_free_blocks[index]++;
+      return;
+    }
+  }
+
+  free(memh);
+}
+
+/** \} */
+
+size_t MEM_tcache_allocN_len(const void *vmemh)
+{
+  if (vmemh) {
+    return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t)(MEMHEAD_ALIGN_FLAG));
+  }
+  else {
+    return 0;
+  }
+}
+
+void MEM_tcache_freeN(void *vmemh)
+{
+  MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+  size_t len = MEM_tcache_allocN_len(vmemh);
+
+  if (vmemh == NULL) {
+    print_error("Attempt to free NULL pointer\n");
+#ifdef WITH_ASSERT_ABORT
+    abort();
+#endif
+    return;
+  }
+
+  ThreadCache *cache = thread_cache_get();
+  memory_usage_sub(cache, len);
+
+  if (UNLIKELY(malloc_debug_memset && len)) {
+    memset(memh + 1, 255, len);
+  }
+  if (UNLIKELY(MEMHEAD_IS_ALIGNED(memh))) {
+    MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
+    aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
+  }
+  else {
+    memhead_free(cache, memh, len);
+  }
+}
+
+void *MEM_tcache_dupallocN(const void *vmemh)
+{
+  void *newp = NULL;
+  if (vmemh) {
+    MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+    const size_t prev_size = MEM_tcache_allocN_len(vmemh);
+    if (UNLIKELY(MEMHEAD_IS_ALIGNED(memh))) {
+      MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
+      newp = MEM_tcache_mallocN_aligned(
+          prev_size, (size_t)memh_aligned->alignment, "dupli_malloc");
+    }
+    else {
+      newp = MEM_tcache_mallocN(prev_size, "dupli_malloc");
+    }
+    memcpy(newp, vmemh, prev_size);
+  }
+  return newp;
+}
+
+void *MEM_tcache_reallocN_id(void *vmemh, size_t len, const char *str)
+{
+  void *newp = NULL;
+
+  if (vmemh) {
+    MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+    size_t old_len = MEM_tcache_allocN_len(vmemh);
+
+    if (LIKELY(!MEMHEAD_IS_ALIGNED(memh))) {
+      newp = MEM_tcache_mallocN(len, "realloc");
+    }
+    else {
+      MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
+      newp = MEM_tcache_mallocN_aligned(len, (size_t)memh_aligned->alignment, "realloc");
+    }
+
+    if (newp) {
+      if (len < old_len) {
+        /* shrink */
+        memcpy(newp, vmemh, len);
+      }
+      else {
+        /* grow (or remain same size) */
+        memcpy(newp, vmemh, old_len);
+      }
+    }
+
+    MEM_tcache_freeN(vmemh);
+  }
+  else {
+    newp = MEM_tcache_mallocN(len, str);
+  }
+
+  return newp;
+}
+
+void *MEM_tcache_recallocN_id(void *vmemh, size_t len, const char *str)
+{
+  void *newp = NULL;
+
+  if (vmemh) {
+    MemHead *memh = MEMHEAD_FROM_PTR(vmemh);
+    size_t old_len = MEM_tcache_allocN_len(vmemh);
+
+    if (LIKELY(!MEMHEAD_IS_ALIGNED(memh))) {
+      newp = MEM_tcache_mallocN(len, "recalloc");
+    }
+    else {
+      MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
+      newp = MEM_tcache_mallocN_aligned(len, (size_t)memh_aligned->alignment, "recalloc");
+    }
+
+    if (newp) {
+      if (len < old_len) {
+        /* shrink */
+        memcpy(newp, vmemh, len);
+      }
+      else {
+        memcpy(newp, vmemh, old_len);
+
+        if (len > old_len) {
+          /* grow */
+          /* zero new bytes */
+          memset(((char *)newp) + old_len, 0, len - old_len);
+        }
+      }
+    }
+
+    MEM_tcache_freeN(vmemh);
+  }
+  else {
+    newp = MEM_tcache_callocN(len, str);
+  }
+
+  return newp;
+}
+
+void *MEM_tcache_callocN(size_t len, const char *str)
+{
+  MemHead *memh;
+  ThreadCache *cache = thread_cache_get();
+
+  len = SIZET_ALIGN_4(len);
+
+  memh = memhead_alloc(cache, len, true);
+
+  if (LIKELY(memh)) {
+    memh->len = len;
+    memory_usage_add(cache, len);
+
+    return PTR_FROM_MEMHEAD(memh);
+  }
+  print_error("Calloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+              SIZET_ARG(len),
+              str,
+              (unsigned int)MEM_tcache_get_memory_in_use());
+  return NULL;
+}
+
+void *MEM_tcache_calloc_arrayN(size_t len, size_t size, const char *str)
+{
+  size_t total_size;
+  if (UNLIKELY(!MEM_size_safe_multiply(len, size, &total_size))) {
+    print_error(
+        "Calloc array aborted due to integer overflow: "
+        "len=" SIZET_FORMAT "x" SIZET_FORMAT " in %s, total %u\n",
+        SIZET_ARG(len),
+        SIZET_ARG(size),
+        str,
+        (unsigned int)MEM_tcache_get_memory_in_use());
+    abort();
+    return NULL;
+  }
+
+  return MEM_tcache_callocN(total_size, str);
+}
+
+void *MEM_tcache_mallocN(size_t len, const char *str)
+{
+  MemHead *memh;
+  ThreadCache *cache = thread_cache_get();
+
+  len = SIZET_ALIGN_4(len);
+
+  memh = memhead_alloc(cache, len, false);
+
+  if (LIKELY(memh)) {
+    if (UNLIKELY(malloc_debug_memset && len)) {
+      memset(memh + 1, 255, len);
+    }
+
+    memh->len = len;
+    memory_usage_add(cache, len);
+
+    return PTR_FROM_MEMHEAD(memh);
+  }
+  print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+              SIZET_ARG(len),
+              str,
+              (unsigned int)MEM_tcache_get_memory_in_use());
+  return NULL;
+}
+
+void *MEM_tcache_malloc_arrayN(size_t len, size_t size, const char *str)
+{
+  size_t total_size;
+  if (UNLIKELY(!MEM_size_safe_multiply(len, size, &total_size))) {
+    print_error(
+        "Malloc array aborted due to integer overflow: "
+        "len=" SIZET_FORMAT "x" SIZET_FORMAT " in %s, total %u\n",
+        SIZET_ARG(len),
+        SIZET_ARG(size),
+        str,
+        (unsigned int)MEM_tcache_get_memory_in_use());
+    abort();
+    return NULL;
+  }
+
+  return MEM_tcache_mallocN(total_size, str);
+}
+
+void *MEM_tcache_mallocN_aligned(size_t len, size_t alignment, const char *str)
+{
+  /* Huge alignment values doesn't make sense and they wouldn't fit into 'short' used in the
+   * MemHead. */
+  assert(alignment < 1024);
+
+  /* We only support alignments that are a power of two. */
+  assert(IS_POW2(alignment));
+
+  /* Some OS specific aligned allocators require a certain minimal alignment. */
+  if (alignment < ALIGNED_MALLOC_MINIMUM_ALIGNMENT) {
+    alignment = ALIGNED_MALLOC_MINIMUM_ALIGNMENT;
+  }
+
+  /* It's possible that MemHead's size is not properly aligned,
+   * do extra padding to deal with this.
+   *
+   * Aligned blocks are not cached, they are rare enough to go to the system allocator.
+   */
+  size_t extra_padding = MEMHEAD_ALIGN_PADDING(alignment);
+
+  len = SIZET_ALIGN_4(len);
+
+  MemHeadAligned *memh = (MemHeadAligned *)aligned_malloc(
+      len + extra_padding + sizeof(MemHeadAligned), alignment);
+
+  if (LIKELY(memh)) {
+    /* We keep padding in the beginning of MemHead,
+     * this way it's always possible to get MemHead
+     * from the data pointer.
+     */
+    memh = (MemHeadAligned *)((char *)memh + extra_padding);
+
+    if (UNLIKELY(malloc_debug_memset && len)) {
+      memset(memh + 1, 255, len);
+    }
+
+    memh->len = len | (size_t)MEMHEAD_ALIGN_FLAG;
+    memh->alignment = (short)alignment;
+    memory_usage_add(thread_cache_get(), len);
+
+    return PTR_FROM_MEMHEAD(memh);
+  }
+  print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
+              SIZET_ARG(len),
+              str,
+              (unsigned int)MEM_tcache_get_memory_in_use());
+  return NULL;
+}
+
+void MEM_tcache_printmemlist_pydict(void)
+{
+}
+
+void MEM_tcache_printmemlist(void)
+{
+}
+
+/* unused */
+void MEM_tcache_callbackmemlist(void (*func)(void *))
+{
+  (void)func; /* Ignored. */
+}
+
+void MEM_tcache_printmemlist_stats(void)
+{
+  size_t cached_mem = 0;
+
+  pthread_mutex_lock(&thread_caches_lock);
+  for (ThreadCache *cache = thread_caches; cache; cache = cache->next) {
+    for (int i = 0; i < SIZE_CLASS_NUM; i++) {
+      cached_mem += cache->num_free_blocks[i] * SIZE_CLASS_SIZE(i);
+    }
+  }
+  pthread_mutex_unlock(&thread_caches_lock);
+
+  printf("\ntotal memory len: %.3f MB\n",
+         (double)MEM_tcache_get_memory_in_use() / (double)(1024 * 1024));
+  printf("peak memory len: %.3f MB\n", (double)peak_mem / (double)(1024 * 1024));
+  printf("thread cached memory len: %.3f MB\n", (double)cached_mem / (double)(1024 * 1024));
+  printf(
+      "\nFor more detailed per-block statistics run Blender with memory debugging command line "
+      "argument.\n");
+
+#ifdef HAVE_MALLOC_STATS
+  printf("System Statistics:\n");
+  malloc_stats();
+#endif
+}
+
+void MEM_tcache_set_error_callback(void (*func)(const char *))
+{
+  error_callback = func;
+}
+
+bool MEM_tcache_consistency_check(void)
+{
+  return true;
+}
+
+void MEM_tcache_set_memory_debug(void)
+{
+  malloc_debug_memset = true;
+}
+
+/* Sum of the global counters and the usage not yet flushed by each thread. Other threads may
+ * still allocate while the deltas are read, so the result can be slightly stale. */
+size_t MEM_tcache_get_memory_in_use(void)
+{
+  pthread_mutex_lock(&thread_caches_lock);
+  int64_t mem = atomic_load_int64(&mem_in_use);
+  for (ThreadCache *cache = thread_caches; cache; cache = cache->next) {
+    mem += atomic_load_int64(&cache->mem_in_use_delta);
+  }
+  pthread_mutex_unlock(&thread_caches_lock);
+
+  return (mem > 0) ? (size_t)mem : 0;
+}
+
+unsigned int MEM_tcache_get_memory_blocks_in_use(void)
+{
+  pthread_mutex_lock(&thread_caches_lock);
+  int64_t blocks = atomic_load_int64(&totblock);
+  for (ThreadCache *cache = thread_caches; cache; cache = cache->next) {
+    blocks += atomic_load_int64(&cache->totblock_delta);
+  }
+  pthread_mutex_unlock(&thread_caches_lock);
+
+  return (blocks > 0) ? (unsigned int)blocks : 0;
+}
+
+void MEM_tcache_reset_peak_memory(void)
+{
+  peak_mem = MEM_tcache_get_memory_in_use();
+}
+
+size_t MEM_tcache_get_peak_memory(void)
+{
+  return peak_mem;
+}
+
+#ifndef NDEBUG
+const char *MEM_tcache_name_ptr(void *vmemh)
+{
+  if (vmemh) {
+    return "unknown block name ptr";
+  }
+  else {
+    return "MEM_tcache_name_ptr(NULL)";
+  }
+}
+#endif /* NDEBUG */
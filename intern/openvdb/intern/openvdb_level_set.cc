@@ -32,15 +32,15 @@ OpenVDBLevelSet::~OpenVDBLevelSet()
 {
 }
 
-void OpenVDBLevelSet::mesh_to_level_set(const float *vertices,
-                                        const unsigned int *faces,
-                                        const unsigned int totvertices,
-                                        const unsigned int totfaces,
-                                        const openvdb::math::Transform::Ptr &xform)
+static void mesh_to_volume_input_copy(const float *vertices,
+                                      const unsigned int *faces,
+                                      const unsigned int totvertices,
+                                      const unsigned int totfaces,
+                                      std::vector<openvdb::Vec3s> &points,
+                                      std::vector<openvdb::Vec3I> &triangles)
 {
-  std::vector<openvdb::Vec3s> points(totvertices);
-  std::vector<openvdb::Vec3I> triangles(totfaces);
-  std::vector<openvdb::Vec4I> quads;
+  points.resize(totvertices);
+  triangles.resize(totfaces);
 
   for (unsigned int i = 0; i < totvertices; i++) {
     points[i] = openvdb::Vec3s(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
@@ -49,26 +49,85 @@ void OpenVDBLevelSet::mesh_to_level_set(const float *vertices,
   for (unsigned int i = 0; i < totfaces; i++) {
     triangles[i] = openvdb::Vec3I(faces[i * 3], faces[i * 3 + 1], faces[i * 3 + 2]);
   }
+}
+
+void OpenVDBLevelSet::mesh_to_level_set(const float *vertices,
+                                        const unsigned int *faces,
+                                        const unsigned int totvertices,
+                                        const unsigned int totfaces,
+                                        const openvdb::math::Transform::Ptr &xform)
+{
+  std::vector<openvdb::Vec3s> points;
+  std::vector<openvdb::Vec3I> triangles;
+  std::vector<openvdb::Vec4I> quads;
+  mesh_to_volume_input_copy(vertices, faces, totvertices, totfaces, points, triangles);
 
   this->grid = openvdb::tools::meshToLevelSet<openvdb::FloatGrid>(
       *xform, points, triangles, quads, 1);
 }
 
-void OpenVDBLevelSet::volume_to_mesh(OpenVDBVolumeToMeshData *mesh,
-                                     const double isovalue,
-                                     const double adaptivity,
-                                     const bool relax_disoriented_triangles)
+/* Distances to a surface that doesn't have to be closed, in a narrow band of the same width as
+ * #mesh_to_level_set. The voxels on both sides of the surface are positive. */
+void OpenVDBLevelSet::mesh_to_unsigned_distance(const float *vertices,
+                                                const unsigned int *faces,
+                                                const unsigned int totvertices,
+                                                const unsigned int totfaces,
+                                                const openvdb::math::Transform::Ptr &xform)
+{
+  std::vector<openvdb::Vec3s> points;
+  std::vector<openvdb::Vec3I> triangles;
+  std::vector<openvdb::Vec4I> quads;
+  mesh_to_volume_input_copy(vertices, faces, totvertices, totfaces, points, triangles);
+
+  this->grid = openvdb::tools::meshToUnsignedDistanceField<openvdb::FloatGrid>(
+      *xform, points, triangles, quads, float(openvdb::LEVEL_SET_HALF_WIDTH));
+}
+
+/* Turn the unsigned distances inside the bounding box (in index space) into a level set, the
+ * voxels outside of it are cleared.
+ *
+ * The sign of each voxel is the one of the closest voxel center of the reference level set,
+ * flipped for every time the surface is crossed between the two. This only needs the part of the
+ * surface around the box and the reference can be much coarser, as long as it's built from the
+ * closed surface: the sign at its voxel centers is exact. */
+void OpenVDBLevelSet::sign_from_reference(const openvdb::FloatGrid::Ptr &reference,
+                                          const int bbox_min[3],
+                                          const int bbox_max[3],
+                                          OpenVDBLevelSet_CrossingsFn crossings_fn,
+                                          void *userdata)
+{
+  this->grid->clip(openvdb::CoordBBox(openvdb::Coord(bbox_min[0], bbox_min[1], bbox_min[2]),
+                                      openvdb::Coord(bbox_max[0], bbox_max[1], bbox_max[2])));
+
+  const openvdb::math::Transform &xform = this->grid->transform();
+  const openvdb::math::Transform &reference_xform = reference->transform();
+  openvdb::FloatGrid::ConstAccessor reference_acc = reference->getConstAccessor();
+
+  for (openvdb::FloatGrid::ValueOnIter iter = this->grid->beginValueOn(); iter; ++iter) {
+    const openvdb::Vec3d co = xform.indexToWorld(iter.getCoord());
+    const openvdb::Coord reference_ijk = reference_xform.worldToIndexCellCentered(co);
+    const openvdb::Vec3d reference_co = reference_xform.indexToWorld(reference_ijk);
+
+    const float a[3] = {float(co.x()), float(co.y()), float(co.z())};
+    const float b[3] = {float(reference_co.x()), float(reference_co.y()), float(reference_co.z())};
+    bool inside = reference_acc.getValue(reference_ijk) < 0.0f;
+    if (crossings_fn(userdata, a, b) % 2 == 1) {
+      inside = !inside;
+    }
+    const float distance = std::abs(*iter);
+    iter.setValue(inside ? -distance : distance);
+  }
+
+  /* The inactive voxels inside the surface get a negative background. */
+  openvdb::tools::signedFloodFill(this->grid->tree());
+  this->grid->setGridClass(openvdb::GRID_LEVEL_SET);
+}
+
+static void volume_to_mesh_output_copy(OpenVDBVolumeToMeshData *mesh,
+                                       const std::vector<openvdb::Vec3s> &out_points,
+                                       const std::vector<openvdb::Vec3I> &out_tris,
+                                       const std::vector<openvdb::Vec4I> &out_quads)
 {
-  std::vector<openvdb::Vec3s> out_points;
-  std::vector<openvdb::Vec4I> out_quads;
-  std::vector<openvdb::Vec3I> out_tris;
-  openvdb::tools::volumeToMesh<openvdb::FloatGrid>(*this->grid,
-                                                   out_points,
-                                                   out_tris,
-                                                   out_quads,
-                                                   isovalue,
-                                                   adaptivity,
-                                                   relax_disoriented_triangles);
   mesh->vertices = (float *)MEM_malloc_arrayN(
       out_points.size(), 3 * sizeof(float), "openvdb remesher out verts");
   mesh->quads = (unsigned int *)MEM_malloc_arrayN(
@@ -103,6 +162,65 @@ void OpenVDBLevelSet::volume_to_mesh(OpenVDBVolumeToMeshData *mesh,
   }
 }
 
+void OpenVDBLevelSet::volume_to_mesh(OpenVDBVolumeToMeshData *mesh,
+                                     const double isovalue,
+                                     const double adaptivity,
+                                     const bool relax_disoriented_triangles)
+{
+  std::vector<openvdb::Vec3s> out_points;
+  std::vector<openvdb::Vec4I> out_quads;
+  std::vector<openvdb::Vec3I> out_tris;
+  openvdb::tools::volumeToMesh<openvdb::FloatGrid>(*this->grid,
+                                                   out_points,
+                                                   out_tris,
+                                                   out_quads,
+                                                   isovalue,
+                                                   adaptivity,
+                                                   relax_disoriented_triangles);
+  volume_to_mesh_output_copy(mesh, out_points, out_tris, out_quads);
+}
+
+/* Only generate polygons for the voxels inside the bounding box (in index space). The voxels
+ * around it are still used to place the vertices on its border, so meshing adjacent boxes of the
+ * same grid gives matching vertices on both sides. */
+void OpenVDBLevelSet::volume_to_mesh_clipped(OpenVDBVolumeToMeshData *mesh,
+                                             const double isovalue,
+                                             const double adaptivity,
+                                             const bool relax_disoriented_triangles,
+                                             const int bbox_min[3],
+                                             const int bbox_max[3])
+{
+  openvdb::BoolGrid::Ptr mask = openvdb::BoolGrid::create(false);
+  mask->setTransform(this->grid->transform().copy());
+  mask->fill(openvdb::CoordBBox(openvdb::Coord(bbox_min[0], bbox_min[1], bbox_min[2]),
+                                openvdb::Coord(bbox_max[0], bbox_max[1], bbox_max[2])),
+             true);
+
+  openvdb::tools::VolumeToMesh mesher(isovalue, adaptivity, relax_disoriented_triangles);
+  mesher.setSurfaceMask(mask);
+  mesher(*this->grid);
+
+  std::vector<openvdb::Vec3s> out_points(mesher.pointListSize());
+  std::vector<openvdb::Vec4I> out_quads;
+  std::vector<openvdb::Vec3I> out_tris;
+  for (size_t i = 0; i < out_points.size(); i++) {
+    out_points[i] = mesher.pointList()[i];
+  }
+
+  openvdb::tools::PolygonPoolList &polygon_pools = mesher.polygonPoolList();
+  for (size_t n = 0; n < mesher.polygonPoolListSize(); n++) {
+    const openvdb::tools::PolygonPool &polygons = polygon_pools[n];
+    for (size_t i = 0; i < polygons.numQuads(); i++) {
+      out_quads.push_back(polygons.quad(i));
+    }
+    for (size_t i = 0; i < polygons.numTriangles(); i++) {
+      out_tris.push_back(polygons.triangle(i));
+    }
+  }
+
+  volume_to_mesh_output_copy(mesh, out_points, out_tris, out_quads);
+}
+
 void OpenVDBLevelSet::filter(OpenVDBLevelSet_FilterType filter_type,
                              int width,
                              float distance,
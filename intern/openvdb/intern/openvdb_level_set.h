@@ -26,6 +26,7 @@
 #include <openvdb/tools/GridTransformer.h>
 #include <openvdb/tools/LevelSetFilter.h>
 #include <openvdb/tools/MeshToVolume.h>
+#include <openvdb/tools/SignedFloodFill.h>
 #include <openvdb/tools/VolumeToMesh.h>
 
 struct OpenVDBLevelSet {
@@ -43,11 +44,27 @@ struct OpenVDBLevelSet {
                          const unsigned int totvertices,
                          const unsigned int totfaces,
                          const openvdb::math::Transform::Ptr &transform);
+  void mesh_to_unsigned_distance(const float *vertices,
+                                 const unsigned int *faces,
+                                 const unsigned int totvertices,
+                                 const unsigned int totfaces,
+                                 const openvdb::math::Transform::Ptr &transform);
+  void sign_from_reference(const openvdb::FloatGrid::Ptr &reference,
+                           const int bbox_min[3],
+                           const int bbox_max[3],
+                           OpenVDBLevelSet_CrossingsFn crossings_fn,
+                           void *userdata);
 
   void volume_to_mesh(struct OpenVDBVolumeToMeshData *mesh,
                       const double isovalue,
                       const double adaptivity,
                       const bool relax_disoriented_triangles);
+  void volume_to_mesh_clipped(struct OpenVDBVolumeToMeshData *mesh,
+                              const double isovalue,
+                              const double adaptivity,
+                              const bool relax_disoriented_triangles,
+                              const int bbox_min[3],
+                              const int bbox_max[3]);
   void filter(OpenVDBLevelSet_FilterType filter_type,
               int width,
               float distance,
@@ -285,6 +285,28 @@ void OpenVDBLevelSet_mesh_to_level_set_transform(struct OpenVDBLevelSet *level_s
   level_set->mesh_to_level_set(vertices, faces, totvertices, totfaces, transform->get_transform());
 }
 
+void OpenVDBLevelSet_mesh_to_unsigned_distance(struct OpenVDBLevelSet *level_set,
+                                               const float *vertices,
+                                               const unsigned int *faces,
+                                               const unsigned int totvertices,
+                                               const unsigned int totfaces,
+                                               OpenVDBTransform *xform)
+{
+  level_set->mesh_to_unsigned_distance(
+      vertices, faces, totvertices, totfaces, xform->get_transform());
+}
+
+void OpenVDBLevelSet_sign_from_reference(struct OpenVDBLevelSet *level_set,
+                                         struct OpenVDBLevelSet *reference,
+                                         const int bbox_min[3],
+                                         const int bbox_max[3],
+                                         OpenVDBLevelSet_CrossingsFn crossings_fn,
+                                         void *userdata)
+{
+  level_set->sign_from_reference(
+      reference->get_grid(), bbox_min, bbox_max, crossings_fn, userdata);
+}
+
 void OpenVDBLevelSet_volume_to_mesh(struct OpenVDBLevelSet *level_set,
                                     struct OpenVDBVolumeToMeshData *mesh,
                                     const double isovalue,
@@ -294,6 +316,18 @@ void OpenVDBLevelSet_volume_to_mesh(struct OpenVDBLevelSet *level_set,
   level_set->volume_to_mesh(mesh, isovalue, adaptivity, relax_disoriented_triangles);
 }
 
+void OpenVDBLevelSet_volume_to_mesh_clipped(struct OpenVDBLevelSet *level_set,
+                                            struct OpenVDBVolumeToMeshData *mesh,
+                                            const double isovalue,
+                                            const double adaptivity,
+                                            const bool relax_disoriented_triangles,
+                                            const int bbox_min[3],
+                                            const int bbox_max[3])
+{
+  level_set->volume_to_mesh_clipped(
+      mesh, isovalue, adaptivity, relax_disoriented_triangles, bbox_min, bbox_max);
+}
+
 void OpenVDBLevelSet_filter(struct OpenVDBLevelSet *level_set,
                             OpenVDBLevelSet_FilterType filter_type,
                             int width,
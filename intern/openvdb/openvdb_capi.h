@@ -58,6 +58,9 @@ typedef enum OpenVDBLevelSet_GridSampler {
   OPENVDB_LEVELSET_GRIDSAMPLER_QUADRATIC = 3,
 } OpenVDBLevelSet_Gridsampler;
 
+/* Number of times the surface crosses the segment between two points in world space. */
+typedef int (*OpenVDBLevelSet_CrossingsFn)(void *userdata, const float a[3], const float b[3]);
+
 struct OpenVDBReader;
 struct OpenVDBWriter;
 struct OpenVDBTransform;
@@ -199,11 +202,30 @@ void OpenVDBLevelSet_mesh_to_level_set_transform(struct OpenVDBLevelSet *level_s
                                                  const unsigned int totvertices,
                                                  const unsigned int totfaces,
                                                  struct OpenVDBTransform *transform);
+void OpenVDBLevelSet_mesh_to_unsigned_distance(struct OpenVDBLevelSet *level_set,
+                                               const float *vertices,
+                                               const unsigned int *faces,
+                                               const unsigned int totvertices,
+                                               const unsigned int totfaces,
+                                               struct OpenVDBTransform *xform);
+void OpenVDBLevelSet_sign_from_reference(struct OpenVDBLevelSet *level_set,
+                                         struct OpenVDBLevelSet *reference,
+                                         const int bbox_min[3],
+                                         const int bbox_max[3],
+                                         OpenVDBLevelSet_CrossingsFn crossings_fn,
+                                         void *userdata);
 void OpenVDBLevelSet_volume_to_mesh(struct OpenVDBLevelSet *level_set,
                                     struct OpenVDBVolumeToMeshData *mesh,
                                     const double isovalue,
                                     const double adaptivity,
                                     const bool relax_disoriented_triangles);
+void OpenVDBLevelSet_volume_to_mesh_clipped(struct OpenVDBLevelSet *level_set,
+                                            struct OpenVDBVolumeToMeshData *mesh,
+                                            const double isovalue,
+                                            const double adaptivity,
+                                            const bool relax_disoriented_triangles,
+                                            const int bbox_min[3],
+                                            const int bbox_max[3]);
 void OpenVDBLevelSet_filter(struct OpenVDBLevelSet *level_set,
                             OpenVDBLevelSet_FilterType filter_type,
                             int width,
@@ -2182,6 +2182,7 @@ class USERPREF_PT_experimental_debugging(ExperimentalPanel, Panel):
         self._draw_items(
             context, (
                 ({"property": "use_undo_legacy"}, "T60695"),
+                ({"property": "use_undo_skip_unchanged"}, None),
                 ({"property": "use_cycles_debug"}, None),
             ),
         )
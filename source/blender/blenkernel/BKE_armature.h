@@ -382,6 +382,8 @@ void BKE_armature_deform_coords_with_editmesh(const struct Object *ob_arm,
                                               const char *defgrp_name,
                                               struct BMEditMesh *em_target);
 
+void BKE_armature_deform_discard_skin_table(struct Mesh *mesh);
+
 /** \} */
 
 #ifdef __cplusplus
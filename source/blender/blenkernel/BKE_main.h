@@ -104,6 +104,12 @@ typedef struct Main {
    * instead do a complete full re-read/update from stored memfile.
    */
   char use_memfile_full_barrier;
+  /**
+   * The last memfile undo step was written from this main, and since then IDs were only changed
+   * in ways that tag them (#ID.recalc_after_undo_push). When set, the next memfile undo step can
+   * re-use the data of untagged IDs from the previous one instead of writing them again.
+   */
+  char is_memfile_undo_id_reuse_valid;
 
   /**
    * When linking, disallow creation of new data-blocks.
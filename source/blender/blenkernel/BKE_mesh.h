@@ -684,6 +684,8 @@ enum {
   BKE_MESH_BATCH_DIRTY_SHADING,
   BKE_MESH_BATCH_DIRTY_UVEDIT_ALL,
   BKE_MESH_BATCH_DIRTY_UVEDIT_SELECT,
+  /* Only the vertex positions changed, topology, triangulation and attributes are unchanged. */
+  BKE_MESH_BATCH_DIRTY_DEFORM,
 };
 void BKE_mesh_batch_cache_dirty_tag(struct Mesh *me, int mode);
 void BKE_mesh_batch_cache_free(struct Mesh *me);
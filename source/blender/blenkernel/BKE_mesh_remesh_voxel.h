@@ -34,6 +34,8 @@ extern "C" {
 
 struct Mesh;
 
+typedef void (*BKE_mesh_remesh_update_cb)(void *data, float progress, int *cancel);
+
 /* OpenVDB Voxel Remesher */
 #ifdef WITH_OPENVDB
 struct OpenVDBLevelSet *BKE_mesh_remesh_voxel_ovdb_mesh_to_level_set_create(
@@ -49,6 +51,13 @@ struct Mesh *BKE_mesh_remesh_voxel_to_mesh_nomain(struct Mesh *mesh,
                                                   float voxel_size,
                                                   float adaptivity,
                                                   float isovalue);
+struct Mesh *BKE_mesh_remesh_voxel_to_mesh_chunked_nomain(struct Mesh *mesh,
+                                                          float voxel_size,
+                                                          float adaptivity,
+                                                          float isovalue,
+                                                          size_t memory_limit,
+                                                          BKE_mesh_remesh_update_cb update_cb,
+                                                          void *update_cb_data);
 struct Mesh *BKE_mesh_remesh_quadriflow_to_mesh_nomain(struct Mesh *mesh,
                                                        int target_faces,
                                                        int seed,
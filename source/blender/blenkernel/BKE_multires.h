@@ -57,6 +57,8 @@ void multires_mark_as_modified(struct Depsgraph *depsgraph,
                                struct Object *object,
                                enum MultiresModifiedFlags flags);
 
+void multires_mark_sculpt_grids_as_modified(struct Depsgraph *depsgraph, struct Object *object);
+
 void multires_flush_sculpt_updates(struct Object *object);
 void multires_force_sculpt_rebuild(struct Object *object);
 void multires_force_external_reload(struct Object *object);
@@ -307,6 +307,10 @@ void BKE_pbvh_update_visibility(PBVH *pbvh);
 void BKE_pbvh_update_normals(PBVH *pbvh, struct SubdivCCG *subdiv_ccg);
 void BKE_pbvh_redraw_BB(PBVH *pbvh, float bb_min[3], float bb_max[3]);
 void BKE_pbvh_get_grid_updates(PBVH *pbvh, bool clear, void ***r_gridfaces, int *r_totface);
+void BKE_pbvh_get_grid_updates_for_flag(PBVH *pbvh,
+                                        PBVHNodeFlags flag,
+                                        void ***r_gridfaces,
+                                        int *r_totface);
 void BKE_pbvh_grids_update(PBVH *pbvh,
                            struct CCGElem **grid_elems,
                            void **gridfaces,
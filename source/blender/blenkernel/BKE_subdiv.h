@@ -191,6 +191,9 @@ typedef struct Subdiv {
     /* Indexed by base face index, element indicates total number of ptex
      * faces created for preceding base faces. */
     int *face_ptex_offset;
+    /* Subdivided mesh and its limit surface coordinates, see
+     * #SubdivToMeshSettings.use_topology_cache. */
+    struct SubdivMeshCache *mesh;
   } cache_;
 } Subdiv;
 
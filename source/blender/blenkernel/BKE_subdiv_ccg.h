@@ -213,6 +213,9 @@ typedef struct SubdivCCG {
     bool coords;
     /* Corresponds to MULTIRES_HIDDEN_MODIFIED. */
     bool hidden;
+    /* Indexed by grid index, grids which coordinates were modified. When coordinates are dirty
+     * and this is NULL all grids are considered to be modified. */
+    BLI_bitmap *grids;
   } dirty;
 
   /* Cached values, are not supposed to be accessed directly. */
@@ -268,6 +271,12 @@ void BKE_subdiv_ccg_average_stitch_faces(SubdivCCG *subdiv_ccg,
                                          struct CCGFace **effected_faces,
                                          int num_effected_faces);
 
+/* Tag coordinates of the grids of given faces as modified, together with the grids of their
+ * neighbor faces which are affected by stitching. */
+void BKE_subdiv_ccg_tag_faces_modified(SubdivCCG *subdiv_ccg,
+                                       struct CCGFace **effected_faces,
+                                       int num_effected_faces);
+
 /* Get geometry counters at the current subdivision level. */
 void BKE_subdiv_ccg_topology_counters(const SubdivCCG *subdiv_ccg,
                                       int *r_num_vertices,
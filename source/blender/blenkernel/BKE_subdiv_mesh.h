@@ -43,6 +43,10 @@ typedef struct SubdivToMeshSettings {
   int resolution;
   /* When true, only edges emitted from coarse ones will be displayed. */
   bool use_optimal_display;
+  /* When true, the subdivided mesh is cached in the subdivision surface descriptor, and is
+   * re-used for as long as the coarse mesh topology does not change. Only positions and normals
+   * are re-evaluated then, all other data is copied from the cached mesh. */
+  bool use_topology_cache;
 } SubdivToMeshSettings;
 
 /* Create real hi-res mesh from subdivision, all geometry is "real". */
@@ -50,6 +54,9 @@ struct Mesh *BKE_subdiv_to_mesh(struct Subdiv *subdiv,
                                 const SubdivToMeshSettings *settings,
                                 const struct Mesh *coarse_mesh);
 
+/* Free the subdivided mesh cached by #BKE_subdiv_to_mesh. */
+void BKE_subdiv_to_mesh_cache_free(struct Subdiv *subdiv);
+
 #ifdef __cplusplus
 }
 #endif
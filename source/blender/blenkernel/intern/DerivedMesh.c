@@ -1757,6 +1757,79 @@ static void mesh_runtime_check_normals_valid(const Mesh *mesh)
   BLI_assert(!(mesh->runtime.cd_dirty_poly & CD_MASK_NORMAL));
 }
 
+/**
+ * Take the previous evaluated mesh out of the object when its draw cache can be reused by the
+ * next evaluation. That is when it is a deformed-only result of an input mesh which wasn't changed
+ * since, evaluated with the same settings.
+ */
+static Mesh *mesh_build_data_deform_prev_detach(Object *ob,
+                                                const CustomData_MeshMasks *dataMask,
+                                                const bool need_mapping)
+{
+  if ((ob->runtime.data_eval == NULL) || !ob->runtime.is_data_eval_owned ||
+      (GS(ob->runtime.data_eval->name) != ID_ME) || (ob->runtime.data_orig == NULL)) {
+    return NULL;
+  }
+  /* Sculpt mode keeps references to the evaluated mesh data. */
+  if (ob->sculpt != NULL) {
+    return NULL;
+  }
+  Mesh *mesh_eval_prev = (Mesh *)ob->runtime.data_eval;
+  const Mesh *mesh_input = (const Mesh *)ob->runtime.data_orig;
+  if (!mesh_eval_prev->runtime.deformed_only || (mesh_eval_prev->runtime.batch_cache == NULL)) {
+    return NULL;
+  }
+  /* The input mesh is tagged for an update by any change to its own data. */
+  if (mesh_input->id.recalc != 0) {
+    return NULL;
+  }
+  if ((ob->runtime.last_need_mapping != need_mapping) ||
+      !CustomData_MeshMasks_are_matching(&ob->runtime.last_data_mask, dataMask) ||
+      !CustomData_MeshMasks_are_matching(dataMask, &ob->runtime.last_data_mask)) {
+    return NULL;
+  }
+  ob->runtime.data_eval = NULL;
+  return mesh_eval_prev;
+}
+
+/**
+ * Quads and n-gons are triangulated depending on their vertex positions (see
+ * #BKE_mesh_recalc_looptri), so the draw cache triangles are only valid when the triangulation
+ * of the previous evaluated mesh is still the same.
+ */
+static bool mesh_build_data_looptri_matches_prev(Mesh *mesh_eval, const Mesh *mesh_eval_prev)
+{
+  const MLoopTri *looptri_prev = mesh_eval_prev->runtime.looptris.array;
+  const int looptri_len = mesh_eval_prev->runtime.looptris.len;
+  if (looptri_prev == NULL || looptri_len != BKE_mesh_runtime_looptri_len(mesh_eval)) {
+    return false;
+  }
+  const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(mesh_eval);
+  return memcmp(looptri, looptri_prev, sizeof(*looptri) * (size_t)looptri_len) == 0;
+}
+
+/**
+ * Move the draw cache of the previous evaluated mesh to the new one when it only differs by its
+ * vertex positions, so only the buffers depending on them are extracted again.
+ */
+static void mesh_build_data_deform_prev_finish(Object *ob, Mesh *mesh_eval, Mesh *mesh_eval_prev)
+{
+  if (ob->runtime.is_data_eval_owned && mesh_eval->runtime.deformed_only &&
+      (mesh_eval->runtime.batch_cache == NULL) &&
+      (mesh_eval->totvert == mesh_eval_prev->totvert) &&
+      (mesh_eval->totedge == mesh_eval_prev->totedge) &&
+      (mesh_eval->totloop == mesh_eval_prev->totloop) &&
+      (mesh_eval->totpoly == mesh_eval_prev->totpoly) &&
+      (mesh_eval->totcol == mesh_eval_prev->totcol) &&
+      mesh_build_data_looptri_matches_prev(mesh_eval, mesh_eval_prev)) {
+    mesh_eval->runtime.batch_cache = mesh_eval_prev->runtime.batch_cache;
+    mesh_eval_prev->runtime.batch_cache = NULL;
+    BKE_mesh_batch_cache_dirty_tag(mesh_eval, BKE_MESH_BATCH_DIRTY_DEFORM);
+    ob->runtime.is_data_eval_deform_update = true;
+  }
+  BKE_mesh_eval_delete(mesh_eval_prev);
+}
+
 static void mesh_build_data(struct Depsgraph *depsgraph,
                             Scene *scene,
                             Object *ob,
@@ -1769,6 +1842,7 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
    * they aren't cleaned up properly on mode switch, causing crashes, e.g T58150. */
   BLI_assert(ob->id.tag & LIB_TAG_COPIED_ON_WRITE);
 
+  Mesh *mesh_eval_prev = mesh_build_data_deform_prev_detach(ob, dataMask, need_mapping);
   BKE_object_free_derived_caches(ob);
   if (DEG_is_active(depsgraph)) {
     BKE_sculpt_update_object_before_eval(ob);
@@ -1806,6 +1880,10 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
   const bool is_mesh_eval_owned = (mesh_eval != mesh->runtime.mesh_eval);
   BKE_object_eval_assign_data(ob, &mesh_eval->id, is_mesh_eval_owned);
 
+  if (mesh_eval_prev != NULL) {
+    mesh_build_data_deform_prev_finish(ob, mesh_eval, mesh_eval_prev);
+  }
+
   ob->runtime.mesh_deform_eval = mesh_deform_eval;
   ob->runtime.last_data_mask = *dataMask;
   ob->runtime.last_need_mapping = need_mapping;
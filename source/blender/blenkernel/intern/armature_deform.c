@@ -32,9 +32,14 @@
 
 #include "MEM_guardedalloc.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_armature_types.h"
@@ -231,6 +236,224 @@ static void pchan_bone_deform(bPoseChannel *pchan,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Armature Skin Table
+ *
+ * Compact copy of the vertex group weights of a mesh, with a fixed number of influences per
+ * vertex stored contiguously instead of a separately allocated #MDeformWeight array per vertex.
+ * It only depends on the weights (not on the armature), so it's cached on the evaluated mesh and
+ * shared by all the objects using it. It's freed with the mesh geometry caches.
+ * \{ */
+
+/* Influences stored per vertex, vertices with more use their #MDeformVert. */
+#define SKIN_TABLE_INFLUENCES 4
+/* First #ArmatureSkinTable.def_nr of vertices with more than #SKIN_TABLE_INFLUENCES weights. */
+#define SKIN_TABLE_OVERFLOW -2
+
+typedef struct ArmatureSkinTable {
+  /** Weights the table was built from. */
+  const MDeformVert *dverts;
+  int dverts_len;
+  /** Vertex group index of each influence in the #MDeformVert order, -1 for unused slots. */
+  int (*def_nr)[SKIN_TABLE_INFLUENCES];
+  float (*weight)[SKIN_TABLE_INFLUENCES];
+} ArmatureSkinTable;
+
+/* Bone data of a vertex group for the skin table code path. */
+typedef struct ArmatureSkinGroup {
+  /** NULL when the group doesn't have a deforming bone. */
+  const float (*chan_mat)[4];
+  const DualQuat *dual_quat;
+  /** B-Bones and envelope multiply use #armature_vert_task_with_dvert. */
+  bool use_dvert;
+} ArmatureSkinGroup;
+
+static ArmatureSkinTable *armature_skin_table_create(const MDeformVert *dverts, int dverts_len)
+{
+  ArmatureSkinTable *table = MEM_callocN(sizeof(*table), __func__);
+  table->dverts = dverts;
+  table->dverts_len = dverts_len;
+  table->def_nr = MEM_malloc_arrayN(dverts_len, sizeof(*table->def_nr), __func__);
+  table->weight = MEM_malloc_arrayN(dverts_len, sizeof(*table->weight), __func__);
+
+  for (int i = 0; i < dverts_len; i++) {
+    const MDeformVert *dvert = &dverts[i];
+    int *def_nr = table->def_nr[i];
+    float *weight = table->weight[i];
+
+    for (int j = 0; j < SKIN_TABLE_INFLUENCES; j++) {
+      def_nr[j] = -1;
+      weight[j] = 0.0f;
+    }
+    if (dvert->totweight > SKIN_TABLE_INFLUENCES) {
+      def_nr[0] = SKIN_TABLE_OVERFLOW;
+      continue;
+    }
+    for (int j = 0; j < dvert->totweight; j++) {
+      if (dvert->dw[j].def_nr > INT_MAX) {
+        def_nr[0] = SKIN_TABLE_OVERFLOW;
+        break;
+      }
+      def_nr[j] = (int)dvert->dw[j].def_nr;
+      weight[j] = dvert->dw[j].weight;
+    }
+  }
+
+  return table;
+}
+
+static void armature_skin_table_free(ArmatureSkinTable *table)
+{
+  MEM_freeN(table->def_nr);
+  MEM_freeN(table->weight);
+  MEM_freeN(table);
+}
+
+/* Get the skin table of the mesh vertex groups, building it if needed. */
+static const ArmatureSkinTable *armature_skin_table_ensure(Mesh *mesh)
+{
+  BLI_mutex_lock(mesh->runtime.eval_mutex);
+
+  ArmatureSkinTable *table = mesh->runtime.armature_skin_table;
+  if (table != NULL && (table->dverts != mesh->dvert || table->dverts_len != mesh->totvert)) {
+    armature_skin_table_free(table);
+    table = NULL;
+  }
+  if (table == NULL) {
+    table = armature_skin_table_create(mesh->dvert, mesh->totvert);
+    mesh->runtime.armature_skin_table = table;
+  }
+
+  BLI_mutex_unlock(mesh->runtime.eval_mutex);
+
+  return table;
+}
+
+void BKE_armature_deform_discard_skin_table(Mesh *mesh)
+{
+  if (mesh->runtime.armature_skin_table != NULL) {
+    armature_skin_table_free(mesh->runtime.armature_skin_table);
+    mesh->runtime.armature_skin_table = NULL;
+  }
+}
+
+static ArmatureSkinGroup *armature_skin_groups_create(bPoseChannel **pchan_from_defbase,
+                                                      int defbase_len)
+{
+  ArmatureSkinGroup *groups = MEM_calloc_arrayN(defbase_len, sizeof(*groups), __func__);
+  for (int i = 0; i < defbase_len; i++) {
+    const bPoseChannel *pchan = pchan_from_defbase[i];
+    if (pchan == NULL) {
+      continue;
+    }
+    const Bone *bone = pchan->bone;
+    groups[i].chan_mat = pchan->chan_mat;
+    groups[i].dual_quat = &pchan->runtime.deform_dual_quat;
+    groups[i].use_dvert = (bone->flag & BONE_MULT_VG_ENV) ||
+                          (bone->segments > 1 && pchan->runtime.bbone_segments == bone->segments);
+  }
+  return groups;
+}
+
+/* Same as #add_weighted_dq_dq, four components at a time. */
+BLI_INLINE void skin_accumulate_dq(DualQuat *dq_sum, const DualQuat *dq, float weight)
+{
+#ifdef __SSE2__
+  bool flipped = false;
+
+  /* Make sure we interpolate quats in the right direction. */
+  if (dot_qtqt(dq->quat, dq_sum->quat) < 0) {
+    flipped = true;
+    weight = -weight;
+  }
+
+  __m128 w = _mm_set1_ps(weight);
+  _mm_storeu_ps(dq_sum->quat,
+                _mm_add_ps(_mm_loadu_ps(dq_sum->quat), _mm_mul_ps(w, _mm_loadu_ps(dq->quat))));
+  _mm_storeu_ps(dq_sum->trans,
+                _mm_add_ps(_mm_loadu_ps(dq_sum->trans), _mm_mul_ps(w, _mm_loadu_ps(dq->trans))));
+
+  if (dq->scale_weight) {
+    if (flipped) {
+      weight = -weight;
+      w = _mm_set1_ps(weight);
+    }
+    for (int i = 0; i < 4; i++) {
+      _mm_storeu_ps(
+          dq_sum->scale[i],
+          _mm_add_ps(_mm_loadu_ps(dq_sum->scale[i]), _mm_mul_ps(_mm_loadu_ps(dq->scale[i]), w)));
+    }
+    dq_sum->scale_weight += weight;
+  }
+#else
+  add_weighted_dq_dq(dq_sum, dq, weight);
+#endif
+}
+
+/* Same as #pchan_deform_accumulate for linear blending, with the results of all influences
+ * accumulated in registers. The operations are done in the same order so results match. */
+static void skin_accumulate_linear(const ArmatureSkinGroup *groups,
+                                   const int def_nr[SKIN_TABLE_INFLUENCES],
+                                   const float weight[SKIN_TABLE_INFLUENCES],
+                                   const int groups_len,
+                                   const float co[3],
+                                   float vec[3],
+                                   float (*smat)[3],
+                                   float *contrib)
+{
+#ifdef __SSE2__
+  const __m128 x = _mm_set1_ps(co[0]);
+  const __m128 y = _mm_set1_ps(co[1]);
+  const __m128 z = _mm_set1_ps(co[2]);
+  const __m128 co_v = _mm_set_ps(0.0f, co[2], co[1], co[0]);
+  __m128 vec_v = _mm_setzero_ps();
+  __m128 smat_v[3] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+
+  for (int j = 0; j < SKIN_TABLE_INFLUENCES && def_nr[j] != -1; j++) {
+    if (def_nr[j] >= groups_len || groups[def_nr[j]].chan_mat == NULL || weight[j] == 0.0f) {
+      continue;
+    }
+    const float(*mat)[4] = groups[def_nr[j]].chan_mat;
+    const __m128 w = _mm_set1_ps(weight[j]);
+
+    __m128 tmp = _mm_mul_ps(x, _mm_loadu_ps(mat[0]));
+    tmp = _mm_add_ps(tmp, _mm_mul_ps(y, _mm_loadu_ps(mat[1])));
+    tmp = _mm_add_ps(tmp, _mm_mul_ps(_mm_loadu_ps(mat[2]), z));
+    tmp = _mm_add_ps(tmp, _mm_loadu_ps(mat[3]));
+    tmp = _mm_sub_ps(tmp, co_v);
+    vec_v = _mm_add_ps(vec_v, _mm_mul_ps(tmp, w));
+
+    if (smat) {
+      for (int i = 0; i < 3; i++) {
+        smat_v[i] = _mm_add_ps(smat_v[i], _mm_mul_ps(_mm_loadu_ps(mat[i]), w));
+      }
+    }
+    *contrib += weight[j];
+  }
+
+  float tmp[4];
+  _mm_storeu_ps(tmp, vec_v);
+  copy_v3_v3(vec, tmp);
+  if (smat) {
+    for (int i = 0; i < 3; i++) {
+      _mm_storeu_ps(tmp, smat_v[i]);
+      copy_v3_v3(smat[i], tmp);
+    }
+  }
+#else
+  for (int j = 0; j < SKIN_TABLE_INFLUENCES && def_nr[j] != -1; j++) {
+    if (def_nr[j] >= groups_len || groups[def_nr[j]].chan_mat == NULL || weight[j] == 0.0f) {
+      continue;
+    }
+    const ArmatureSkinGroup *group = &groups[def_nr[j]];
+    pchan_deform_accumulate(group->dual_quat, group->chan_mat, co, weight[j], vec, NULL, smat);
+    *contrib += weight[j];
+  }
+#endif
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Armature Deform #BKE_armature_deform_coords API
  *
@@ -258,6 +481,10 @@ typedef struct ArmatureUserdata {
   bPoseChannel **pchan_from_defbase;
   int defbase_len;
 
+  /** Optional, only used for meshes without an overall armature vertex group. */
+  const ArmatureSkinTable *skin_table;
+  const ArmatureSkinGroup *skin_groups;
+
   float premat[4][4];
   float postmat[4][4];
 
@@ -267,6 +494,72 @@ typedef struct ArmatureUserdata {
   } bmesh;
 } ArmatureUserdata;
 
+/* Apply the accumulated bone influences to the coordinate (in armature space) and the
+ * deform matrix of the vertex. */
+static void armature_vert_deform_apply(const ArmatureUserdata *data,
+                                       const int i,
+                                       float *co,
+                                       float vec[3],
+                                       DualQuat *dq,
+                                       float summat[3][3],
+                                       const float contrib,
+                                       const float armature_weight,
+                                       const float prevco_weight)
+{
+  float(*const vert_coords)[3] = data->vert_coords;
+  float(*const vert_deform_mats)[3][3] = data->vert_deform_mats;
+  float(*const vert_coords_prev)[3] = data->vert_coords_prev;
+  const bool use_quaternion = data->use_quaternion;
+  float dco[3];
+
+  /* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
+  if (contrib > 0.0001f) {
+    if (use_quaternion) {
+      normalize_dq(dq, contrib);
+
+      if (armature_weight != 1.0f) {
+        copy_v3_v3(dco, co);
+        mul_v3m3_dq(dco, (vert_deform_mats) ? summat : NULL, dq);
+        sub_v3_v3(dco, co);
+        mul_v3_fl(dco, armature_weight);
+        add_v3_v3(co, dco);
+      }
+      else {
+        mul_v3m3_dq(co, (vert_deform_mats) ? summat : NULL, dq);
+      }
+    }
+    else {
+      mul_v3_fl(vec, armature_weight / contrib);
+      add_v3_v3v3(co, vec, co);
+    }
+
+    if (vert_deform_mats) {
+      float pre[3][3], post[3][3], tmpmat[3][3];
+
+      copy_m3_m4(pre, data->premat);
+      copy_m3_m4(post, data->postmat);
+      copy_m3_m3(tmpmat, vert_deform_mats[i]);
+
+      if (!use_quaternion) { /* quaternion already is scale corrected */
+        mul_m3_fl(summat, armature_weight / contrib);
+      }
+
+      mul_m3_series(vert_deform_mats[i], post, summat, pre, tmpmat);
+    }
+  }
+
+  /* always, check above code */
+  mul_m4_v3(data->postmat, co);
+
+  /* interpolate with previous modifier position using weight group */
+  if (vert_coords_prev) {
+    float mw = 1.0f - prevco_weight;
+    vert_coords[i][0] = prevco_weight * vert_coords[i][0] + mw * co[0];
+    vert_coords[i][1] = prevco_weight * vert_coords[i][1] + mw * co[1];
+    vert_coords[i][2] = prevco_weight * vert_coords[i][2] + mw * co[2];
+  }
+}
+
 static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
                                           const int i,
                                           const MDeformVert *dvert)
@@ -281,7 +574,7 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
 
   DualQuat sumdq, *dq = NULL;
   bPoseChannel *pchan;
-  float *co, dco[3];
+  float *co;
   float sumvec[3], summat[3][3];
   float *vec = NULL, (*smat)[3] = NULL;
   float contrib = 0.0f;
@@ -364,54 +657,8 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
     }
   }
 
-  /* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
-  if (contrib > 0.0001f) {
-    if (use_quaternion) {
-      normalize_dq(dq, contrib);
-
-      if (armature_weight != 1.0f) {
-        copy_v3_v3(dco, co);
-        mul_v3m3_dq(dco, (vert_deform_mats) ? summat : NULL, dq);
-        sub_v3_v3(dco, co);
-        mul_v3_fl(dco, armature_weight);
-        add_v3_v3(co, dco);
-      }
-      else {
-        mul_v3m3_dq(co, (vert_deform_mats) ? summat : NULL, dq);
-      }
-
-      smat = summat;
-    }
-    else {
-      mul_v3_fl(vec, armature_weight / contrib);
-      add_v3_v3v3(co, vec, co);
-    }
-
-    if (vert_deform_mats) {
-      float pre[3][3], post[3][3], tmpmat[3][3];
-
-      copy_m3_m4(pre, data->premat);
-      copy_m3_m4(post, data->postmat);
-      copy_m3_m3(tmpmat, vert_deform_mats[i]);
-
-      if (!use_quaternion) { /* quaternion already is scale corrected */
-        mul_m3_fl(smat, armature_weight / contrib);
-      }
-
-      mul_m3_series(vert_deform_mats[i], post, smat, pre, tmpmat);
-    }
-  }
-
-  /* always, check above code */
-  mul_m4_v3(data->postmat, co);
-
-  /* interpolate with previous modifier position using weight group */
-  if (vert_coords_prev) {
-    float mw = 1.0f - prevco_weight;
-    vert_coords[i][0] = prevco_weight * vert_coords[i][0] + mw * co[0];
-    vert_coords[i][1] = prevco_weight * vert_coords[i][1] + mw * co[1];
-    vert_coords[i][2] = prevco_weight * vert_coords[i][2] + mw * co[2];
-  }
+  armature_vert_deform_apply(
+      data, i, co, vec, dq, summat, contrib, armature_weight, prevco_weight);
 }
 
 static void armature_vert_task(void *__restrict userdata,
@@ -444,6 +691,71 @@ static void armature_vert_task(void *__restrict userdata,
   armature_vert_task_with_dvert(data, i, dvert);
 }
 
+/* Vertex task using the skin table, vertices with influences it doesn't support use
+ * #armature_vert_task_with_dvert. */
+static void armature_vert_task_skin_table(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArmatureUserdata *data = userdata;
+  const ArmatureSkinTable *table = data->skin_table;
+  const ArmatureSkinGroup *groups = data->skin_groups;
+  const int *def_nr = table->def_nr[i];
+  const float *weight = table->weight[i];
+
+  bool deformed = false;
+  if (def_nr[0] != SKIN_TABLE_OVERFLOW) {
+    for (int j = 0; j < SKIN_TABLE_INFLUENCES && def_nr[j] != -1; j++) {
+      if (def_nr[j] >= data->defbase_len || groups[def_nr[j]].chan_mat == NULL) {
+        continue;
+      }
+      if (groups[def_nr[j]].use_dvert) {
+        deformed = false;
+        break;
+      }
+      deformed = true;
+    }
+  }
+  if (!deformed) {
+    /* Also handles envelopes used for vertices without bone vertex groups. */
+    armature_vert_task_with_dvert(data, i, &table->dverts[i]);
+    return;
+  }
+
+  float *co = data->vert_coords[i];
+  float vec[3] = {0.0f}, summat[3][3] = {{0.0f}};
+  float contrib = 0.0f;
+  DualQuat sumdq, *dq = NULL;
+
+  /* Apply the object's matrix */
+  mul_m4_v3(data->premat, co);
+
+  if (data->use_quaternion) {
+    memset(&sumdq, 0, sizeof(DualQuat));
+    dq = &sumdq;
+    for (int j = 0; j < SKIN_TABLE_INFLUENCES && def_nr[j] != -1; j++) {
+      if (def_nr[j] >= data->defbase_len || groups[def_nr[j]].chan_mat == NULL ||
+          weight[j] == 0.0f) {
+        continue;
+      }
+      skin_accumulate_dq(dq, groups[def_nr[j]].dual_quat, weight[j]);
+      contrib += weight[j];
+    }
+  }
+  else {
+    skin_accumulate_linear(groups,
+                           def_nr,
+                           weight,
+                           data->defbase_len,
+                           co,
+                           vec,
+                           data->vert_deform_mats ? summat : NULL,
+                           &contrib);
+  }
+
+  armature_vert_deform_apply(data, i, co, vec, dq, summat, contrib, 1.0f, 1.0f);
+}
+
 static void armature_vert_task_editmesh(void *__restrict userdata, MempoolIterData *iter)
 {
   const ArmatureUserdata *data = userdata;
@@ -582,6 +894,20 @@ static void armature_deform_coords_impl(const Object *ob_arm,
           },
   };
 
+  /* The skin table is cached on the mesh owning the vertex group weights, it doesn't support
+   * blending with an overall vertex group or with previous coordinates. */
+  ArmatureSkinGroup *skin_groups = NULL;
+  if (use_dverts && em_target == NULL && ob_target->type == OB_MESH && armature_def_nr == -1 &&
+      vert_coords_prev == NULL) {
+    Mesh *me = ob_target->data;
+    const MDeformVert *dverts_target = me_target ? me_target->dvert : dverts;
+    if (dverts_target == me->dvert && vert_coords_len == me->totvert) {
+      skin_groups = armature_skin_groups_create(pchan_from_defbase, defbase_len);
+      data.skin_table = armature_skin_table_ensure(me);
+      data.skin_groups = skin_groups;
+    }
+  }
+
   float obinv[4][4];
   invert_m4_m4(obinv, ob_target->obmat);
 
@@ -605,12 +931,19 @@ static void armature_deform_coords_impl(const Object *ob_arm,
     TaskParallelSettings settings;
     BLI_parallel_range_settings_defaults(&settings);
     settings.min_iter_per_thread = 32;
-    BLI_task_parallel_range(0, vert_coords_len, &data, armature_vert_task, &settings);
+    BLI_task_parallel_range(0,
+                            vert_coords_len,
+                            &data,
+                            data.skin_table ? armature_vert_task_skin_table : armature_vert_task,
+                            &settings);
   }
 
   if (pchan_from_defbase) {
     MEM_freeN(pchan_from_defbase);
   }
+  if (skin_groups) {
+    MEM_freeN(skin_groups);
+  }
 }
 
 void BKE_armature_deform_coords_with_gpencil_stroke(const Object *ob_arm,
@@ -37,6 +37,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BLI_path_util.h"
 #include "BLI_string.h"
@@ -127,8 +128,14 @@ MemFileUndoData *BKE_memfile_undo_encode(Main *bmain, MemFileUndoData *mfu_prev)
     if (prevfile) {
       BLO_memfile_clear_future(prevfile);
     }
-    /* success = */ /* UNUSED */ BLO_write_file_mem(bmain, prevfile, &mfu->memfile, G.fileflags);
+    const bool use_id_reuse = bmain->is_memfile_undo_id_reuse_valid &&
+                              USER_EXPERIMENTAL_TEST(&U, use_undo_skip_unchanged);
+    /* success = */ /* UNUSED */ BLO_write_file_mem(
+        bmain, prevfile, &mfu->memfile, G.fileflags, use_id_reuse);
     mfu->undo_size = mfu->memfile.size;
+
+    /* Tags accumulated from now on are relative to this step. */
+    bmain->is_memfile_undo_id_reuse_valid = true;
   }
 
   bmain->is_memfile_undo_written = true;
@@ -43,6 +43,7 @@
 #include "BLT_translation.h"
 
 #include "BKE_anim_data.h"
+#include "BKE_armature.h"
 #include "BKE_editmesh.h"
 #include "BKE_global.h"
 #include "BKE_idtype.h"
@@ -1982,6 +1983,7 @@ void BKE_mesh_eval_geometry(Depsgraph *depsgraph, Mesh *mesh)
     BKE_id_free(NULL, mesh->runtime.mesh_eval);
     mesh->runtime.mesh_eval = NULL;
   }
+  BKE_armature_deform_discard_skin_table(mesh);
   if (DEG_is_active(depsgraph)) {
     Mesh *mesh_orig = (Mesh *)DEG_get_original_id(&mesh->id);
     if (mesh->texflag & ME_AUTOSPACE_EVALUATED) {
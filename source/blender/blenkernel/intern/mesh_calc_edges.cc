@@ -0,0 +1,230 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ *
+ * Calculate the edges of a mesh from its polygons.
+ *
+ * Existing edges keep their index when updating. New edges are sorted into the shards of a
+ * #ShardedEdgeSet by chunks of polygons in parallel, then every shard is filled by a separate
+ * task, adding the edges of all chunks in order. The number of shards only depends on the size of
+ * the mesh, so the resulting edge order is the same regardless of the number of threads.
+ */
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "BLI_array.hh"
+#include "BLI_math_base.h"
+#include "BLI_sharded_edge_set.hh"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+#include "BLI_vector.hh"
+
+#include "BKE_customdata.h"
+#include "BKE_mesh.h"
+
+using blender::Array;
+using blender::OrderedEdge;
+using blender::ShardedEdgeSet;
+using blender::Vector;
+
+/* Meshes with fewer loops use a single shard. */
+#define CALC_EDGES_SHARDED_LOOPS_MIN 16384
+#define CALC_EDGES_SHARDS_NUM 16
+/* Polygons scanned by a single task when sorting the edges into shards. */
+#define CALC_EDGES_CHUNK_POLYS 4096
+
+struct CalcEdgesData {
+  Mesh *mesh;
+  short ed_flag;
+  /* Existing edges when updating, in their original order without duplicates. They keep their
+   * index, new edges are added after them. */
+  ShardedEdgeSet::Shard *orig_edges;
+  ShardedEdgeSet *edge_set;
+  /* New edges of every chunk of polygons, per shard. */
+  Array<Vector<OrderedEdge>> *chunk_edges;
+  int chunks_num;
+  MEdge *medge;
+};
+
+static void calc_edges_chunk_cb(void *__restrict userdata,
+                                const int chunk_index,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const CalcEdgesData *data = (const CalcEdgesData *)userdata;
+  const Mesh *mesh = data->mesh;
+  const ShardedEdgeSet &edge_set = *data->edge_set;
+  const uint shards_num = edge_set.shards_num();
+  Vector<OrderedEdge> *shard_edges = &(*data->chunk_edges)[(uint)chunk_index * shards_num];
+
+  const int poly_start = chunk_index * CALC_EDGES_CHUNK_POLYS;
+  const int poly_end = min_ii(poly_start + CALC_EDGES_CHUNK_POLYS, mesh->totpoly);
+  for (int i = poly_start; i < poly_end; i++) {
+    const MPoly *mp = &mesh->mpoly[i];
+    const MLoop *l = &mesh->mloop[mp->loopstart];
+    uint v_prev = (l + (mp->totloop - 1))->v;
+    for (int j = 0; j < mp->totloop; j++, l++) {
+      if (v_prev != l->v) {
+        const OrderedEdge edge(v_prev, l->v);
+        if (!data->orig_edges->contains(edge)) {
+          shard_edges[edge_set.shard_index(edge)].append(edge);
+        }
+      }
+      v_prev = l->v;
+    }
+  }
+}
+
+static void calc_edges_add_shard_cb(void *__restrict userdata,
+                                    const int shard_index,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const CalcEdgesData *data = (const CalcEdgesData *)userdata;
+  const uint shards_num = data->edge_set->shards_num();
+  ShardedEdgeSet::Shard &shard = data->edge_set->shard((uint)shard_index);
+
+  /* Chunks are added in order, so edges are in polygon order within the shard. */
+  for (int chunk = 0; chunk < data->chunks_num; chunk++) {
+    const Vector<OrderedEdge> &edges =
+        (*data->chunk_edges)[(uint)chunk * shards_num + (uint)shard_index];
+    for (const OrderedEdge &edge : edges) {
+      shard.add(edge);
+    }
+  }
+}
+
+static void calc_edges_write_shard_cb(void *__restrict userdata,
+                                      const int shard_index,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const CalcEdgesData *data = (const CalcEdgesData *)userdata;
+  const ShardedEdgeSet::Shard &shard = data->edge_set->shard((uint)shard_index);
+
+  MEdge *med = &data->medge[data->orig_edges->size() +
+                            data->edge_set->shard_offset((uint)shard_index)];
+  for (uint i = 0; i < shard.size(); i++, med++) {
+    med->v1 = shard[i].v_low;
+    med->v2 = shard[i].v_high;
+    med->flag = data->ed_flag;
+  }
+}
+
+static void calc_edges_assign_loops_cb(void *__restrict userdata,
+                                       const int poly_index,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const CalcEdgesData *data = (const CalcEdgesData *)userdata;
+  const Mesh *mesh = data->mesh;
+  const MPoly *mp = &mesh->mpoly[poly_index];
+
+  MLoop *l = &mesh->mloop[mp->loopstart];
+  MLoop *l_prev = (l + (mp->totloop - 1));
+  for (int j = 0; j < mp->totloop; j++, l++) {
+    /* Lookup the edge index, if it's valid. */
+    if (l_prev->v != l->v) {
+      const OrderedEdge edge(l_prev->v, l->v);
+      const int orig_index = data->orig_edges->index_of_try(edge);
+      l_prev->e = (orig_index != -1) ? (uint)orig_index :
+                                       data->orig_edges->size() + data->edge_set->index_of(edge);
+    }
+    else {
+      /* This is an invalid edge; normally this does not happen in Blender, but it can be part
+       * of an imported mesh with invalid geometry. See T76514. */
+      l_prev->e = 0;
+    }
+    l_prev = l;
+  }
+}
+
+/**
+ * Calculate edges from polygons
+ *
+ * \param mesh: The mesh to add edges into
+ * \param update: When true create new edges co-exist
+ */
+void BKE_mesh_calc_edges(Mesh *mesh, bool update, const bool select)
+{
+  /* select for newly created meshes which are selected [#25595] */
+  const short ed_flag = (ME_EDGEDRAW | ME_EDGERENDER) | (select ? SELECT : 0);
+
+  if (mesh->totedge == 0) {
+    update = false;
+  }
+
+  /* assume existing edges are valid
+   * useful when adding more faces and generating edges from them */
+  ShardedEdgeSet::Shard orig_edges;
+  Array<int> orig_edge_indices(update ? (uint)mesh->totedge : 0u);
+  if (update) {
+    const MEdge *med = mesh->medge;
+    for (int i = 0; i < mesh->totedge; i++, med++) {
+      if (orig_edges.add(OrderedEdge(med->v1, med->v2))) {
+        orig_edge_indices[orig_edges.size() - 1] = i;
+      }
+    }
+  }
+
+  const int shards_num = (mesh->totloop < CALC_EDGES_SHARDED_LOOPS_MIN) ? 1 :
+                                                                           CALC_EDGES_SHARDS_NUM;
+  const int chunks_num = (mesh->totpoly + CALC_EDGES_CHUNK_POLYS - 1) / CALC_EDGES_CHUNK_POLYS;
+  ShardedEdgeSet edge_set((uint)shards_num);
+  Array<Vector<OrderedEdge>> chunk_edges((uint)(chunks_num * shards_num));
+
+  CalcEdgesData data;
+  data.mesh = mesh;
+  data.ed_flag = ed_flag;
+  data.orig_edges = &orig_edges;
+  data.edge_set = &edge_set;
+  data.chunk_edges = &chunk_edges;
+  data.chunks_num = chunks_num;
+  data.medge = NULL;
+
+  /* Sort the new edges into shards, then de-duplicate every shard separately. */
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, chunks_num, &data, calc_edges_chunk_cb, &settings);
+  BLI_task_parallel_range(0, shards_num, &data, calc_edges_add_shard_cb, &settings);
+
+  edge_set.update_offsets();
+  const int totedge = (int)(orig_edges.size() + edge_set.size());
+
+  /* write new edges into a temporary CustomData */
+  CustomData edata;
+  CustomData_reset(&edata);
+  CustomData_add_layer(&edata, CD_MEDGE, CD_CALLOC, NULL, totedge);
+  data.medge = (MEdge *)CustomData_get_layer(&edata, CD_MEDGE);
+
+  for (uint i = 0; i < orig_edges.size(); i++) {
+    data.medge[i] = mesh->medge[orig_edge_indices[i]]; /* copy from the original */
+  }
+  BLI_task_parallel_range(0, shards_num, &data, calc_edges_write_shard_cb, &settings);
+
+  /* second pass, iterate through all loops again and assign
+   * the newly created edges to them. */
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, mesh->totpoly, &data, calc_edges_assign_loops_cb, &settings);
+
+  /* free old CustomData and assign new one */
+  CustomData_free(&mesh->edata, mesh->totedge);
+  mesh->edata = edata;
+  mesh->totedge = totedge;
+
+  mesh->medge = (MEdge *)CustomData_get_layer(&mesh->edata, CD_MEDGE);
+}
@@ -0,0 +1,128 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+}
+
+namespace blender::bke::tests {
+
+/* Grid of quads without edges. */
+static Mesh *calc_edges_test_grid_mesh(const int size)
+{
+  const int polys_len = size * size;
+  Mesh *mesh = BKE_mesh_new_nomain((size + 1) * (size + 1), 0, 0, polys_len * 4, polys_len);
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int poly = y * size + x;
+      const int v = y * (size + 1) + x;
+      mesh->mpoly[poly].loopstart = poly * 4;
+      mesh->mpoly[poly].totloop = 4;
+      mesh->mloop[poly * 4 + 0].v = v;
+      mesh->mloop[poly * 4 + 1].v = v + 1;
+      mesh->mloop[poly * 4 + 2].v = v + size + 2;
+      mesh->mloop[poly * 4 + 3].v = v + size + 1;
+    }
+  }
+  return mesh;
+}
+
+static void calc_edges_test_expect_loop_edges(const Mesh *mesh)
+{
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly *mp = &mesh->mpoly[i];
+    for (int j = 0; j < mp->totloop; j++) {
+      const MLoop *ml = &mesh->mloop[mp->loopstart + j];
+      const MLoop *ml_next = &mesh->mloop[mp->loopstart + (j + 1) % mp->totloop];
+      ASSERT_LT((int)ml->e, mesh->totedge);
+      const MEdge *med = &mesh->medge[ml->e];
+      EXPECT_TRUE((med->v1 == ml->v && med->v2 == ml_next->v) ||
+                  (med->v2 == ml->v && med->v1 == ml_next->v));
+    }
+  }
+}
+
+static void calc_edges_test_update(const int size)
+{
+  BLI_threadapi_init();
+  BKE_idtype_init();
+
+  Mesh *mesh = calc_edges_test_grid_mesh(size);
+  BKE_mesh_calc_edges(mesh, false, false);
+  calc_edges_test_expect_loop_edges(mesh);
+  const int totedge = mesh->totedge;
+
+  /* Keep every third edge in reverse order, with a duplicate and a custom flag. */
+  std::vector<MEdge> orig_edges;
+  for (int i = totedge - 1; i >= 0; i -= 3) {
+    MEdge med = mesh->medge[i];
+    med.flag |= ME_SEAM;
+    orig_edges.push_back(med);
+  }
+  const int orig_edges_len = (int)orig_edges.size();
+  orig_edges.push_back(orig_edges[0]);
+
+  CustomData_free(&mesh->edata, mesh->totedge);
+  mesh->totedge = (int)orig_edges.size();
+  CustomData_add_layer(&mesh->edata, CD_MEDGE, CD_CALLOC, NULL, mesh->totedge);
+  BKE_mesh_update_customdata_pointers(mesh, false);
+  memcpy(mesh->medge, orig_edges.data(), sizeof(MEdge) * orig_edges.size());
+
+  BKE_mesh_calc_edges(mesh, true, false);
+  ASSERT_EQ(mesh->totedge, totedge);
+  /* Existing edges come first in their original order. */
+  for (int i = 0; i < orig_edges_len; i++) {
+    EXPECT_EQ(mesh->medge[i].v1, orig_edges[i].v1);
+    EXPECT_EQ(mesh->medge[i].v2, orig_edges[i].v2);
+    EXPECT_EQ(mesh->medge[i].flag, orig_edges[i].flag);
+  }
+  for (int i = orig_edges_len; i < totedge; i++) {
+    EXPECT_FALSE(mesh->medge[i].flag & ME_SEAM);
+  }
+  calc_edges_test_expect_loop_edges(mesh);
+
+  BKE_id_free(nullptr, mesh);
+  BLI_threadapi_exit();
+}
+
+TEST(mesh_calc_edges, UpdateSingleShard)
+{
+  calc_edges_test_update(20);
+}
+
+TEST(mesh_calc_edges, UpdateSharded)
+{
+  /* Enough loops to split the edges in shards. */
+  calc_edges_test_update(200);
+}
+
+}  // namespace blender::bke::tests
@@ -32,6 +32,8 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
+#include "BLI_sort.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_mesh_types.h"
@@ -97,60 +99,523 @@ struct OpenVDBLevelSet *BKE_mesh_remesh_voxel_ovdb_mesh_to_level_set_create(
   return level_set;
 }
 
-Mesh *BKE_mesh_remesh_voxel_ovdb_volume_to_mesh_nomain(struct OpenVDBLevelSet *level_set,
-                                                       double isovalue,
-                                                       double adaptivity,
-                                                       bool relax_disoriented_triangles)
+/* Build a mesh from the output of the OpenVDB mesher and free the output arrays. */
+static Mesh *remesh_voxel_volume_output_to_mesh(struct OpenVDBVolumeToMeshData *output_mesh)
 {
-#  ifdef WITH_OPENVDB
-  struct OpenVDBVolumeToMeshData output_mesh;
-  OpenVDBLevelSet_volume_to_mesh(
-      level_set, &output_mesh, isovalue, adaptivity, relax_disoriented_triangles);
-#  endif
-
-  Mesh *mesh = BKE_mesh_new_nomain(output_mesh.totvertices,
+  Mesh *mesh = BKE_mesh_new_nomain(output_mesh->totvertices,
                                    0,
                                    0,
-                                   (output_mesh.totquads * 4) + (output_mesh.tottriangles * 3),
-                                   output_mesh.totquads + output_mesh.tottriangles);
+                                   (output_mesh->totquads * 4) + (output_mesh->tottriangles * 3),
+                                   output_mesh->totquads + output_mesh->tottriangles);
 
-  for (int i = 0; i < output_mesh.totvertices; i++) {
-    copy_v3_v3(mesh->mvert[i].co, &output_mesh.vertices[i * 3]);
+  for (int i = 0; i < output_mesh->totvertices; i++) {
+    copy_v3_v3(mesh->mvert[i].co, &output_mesh->vertices[i * 3]);
   }
 
   MPoly *mp = mesh->mpoly;
   MLoop *ml = mesh->mloop;
-  for (int i = 0; i < output_mesh.totquads; i++, mp++, ml += 4) {
+  for (int i = 0; i < output_mesh->totquads; i++, mp++, ml += 4) {
     mp->loopstart = (int)(ml - mesh->mloop);
     mp->totloop = 4;
 
-    ml[0].v = output_mesh.quads[i * 4 + 3];
-    ml[1].v = output_mesh.quads[i * 4 + 2];
-    ml[2].v = output_mesh.quads[i * 4 + 1];
-    ml[3].v = output_mesh.quads[i * 4];
+    ml[0].v = output_mesh->quads[i * 4 + 3];
+    ml[1].v = output_mesh->quads[i * 4 + 2];
+    ml[2].v = output_mesh->quads[i * 4 + 1];
+    ml[3].v = output_mesh->quads[i * 4];
   }
 
-  for (int i = 0; i < output_mesh.tottriangles; i++, mp++, ml += 3) {
+  for (int i = 0; i < output_mesh->tottriangles; i++, mp++, ml += 3) {
     mp->loopstart = (int)(ml - mesh->mloop);
     mp->totloop = 3;
 
-    ml[0].v = output_mesh.triangles[i * 3 + 2];
-    ml[1].v = output_mesh.triangles[i * 3 + 1];
-    ml[2].v = output_mesh.triangles[i * 3];
+    ml[0].v = output_mesh->triangles[i * 3 + 2];
+    ml[1].v = output_mesh->triangles[i * 3 + 1];
+    ml[2].v = output_mesh->triangles[i * 3];
   }
 
   BKE_mesh_calc_edges(mesh, false, false);
   BKE_mesh_calc_normals(mesh);
 
-  MEM_freeN(output_mesh.quads);
-  MEM_freeN(output_mesh.vertices);
+  MEM_SAFE_FREE(output_mesh->quads);
+  MEM_SAFE_FREE(output_mesh->vertices);
+  MEM_SAFE_FREE(output_mesh->triangles);
+
+  return mesh;
+}
 
-  if (output_mesh.tottriangles > 0) {
-    MEM_freeN(output_mesh.triangles);
+Mesh *BKE_mesh_remesh_voxel_ovdb_volume_to_mesh_nomain(struct OpenVDBLevelSet *level_set,
+                                                       double isovalue,
+                                                       double adaptivity,
+                                                       bool relax_disoriented_triangles)
+{
+  struct OpenVDBVolumeToMeshData output_mesh;
+  OpenVDBLevelSet_volume_to_mesh(
+      level_set, &output_mesh, isovalue, adaptivity, relax_disoriented_triangles);
+  return remesh_voxel_volume_output_to_mesh(&output_mesh);
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Chunked Voxel Remesher
+ *
+ * At small voxel sizes the level set of the whole mesh doesn't fit in memory. Instead the voxel
+ * lattice is split in bricks: each brick builds a level set from the triangles around it and only
+ * meshes the voxels it owns. All bricks use the same transform, so the vertices on the border of
+ * two bricks are computed from the same distances and are welded back together afterwards.
+ *
+ * The triangles of a brick are cut out of the mesh, so they can't tell inside from outside: the
+ * exterior sweep of a level set would leak in through the cut. The bricks only compute unsigned
+ * distances, their sign comes from a coarse level set of the whole mesh instead.
+ * \{ */
+
+/* Voxels around a brick included in its level set, so the vertices on its border are exact. */
+#  define REMESH_BRICK_HALO 4
+/* Voxels around a brick that are signed, the mesher reads them next to the brick border. */
+#  define REMESH_BRICK_BORDER 2
+/* Largest voxel size of the level set used for the sign (in voxels). */
+#  define REMESH_SIGN_VOXEL_MAX 8
+/* Don't split bricks smaller than this (in voxels). */
+#  define REMESH_BRICK_MIN_SIZE 32
+/* Rough peak memory per voxel of surface area while building and meshing a level set
+ * (narrow band distances, closest primitive indices and mesher data). */
+#  define REMESH_SURFACE_VOXEL_BYTES 64
+
+typedef struct RemeshBrick {
+  /** Voxels meshed by this brick (index space, inclusive). */
+  int min[3], max[3];
+  /** Looptris overlapping the brick and its halo. */
+  int *tris;
+  int tris_len;
+  struct OpenVDBVolumeToMeshData output;
+} RemeshBrick;
+
+typedef struct RemeshChunkedData {
+  Mesh *mesh;
+  const MLoopTri *looptri;
+  struct OpenVDBTransform *xform;
+  double isovalue;
+
+  /** Coarse level set of the whole mesh, only used for its sign. */
+  struct OpenVDBLevelSet *sign_level_set;
+
+  /** Bounds of each looptri in index space. */
+  float (*tri_bounds)[2][3];
+  float *tri_areas;
+  float area_to_bytes;
+  size_t brick_memory_limit;
+  /** Distance around a brick of the triangles it uses (in voxels). */
+  float tri_halo;
+
+  RemeshBrick *bricks;
+  int bricks_len, bricks_alloc;
+} RemeshChunkedData;
+
+static void remesh_bricks_add(RemeshChunkedData *data,
+                              const int min[3],
+                              const int max[3],
+                              int *tris,
+                              int tris_len)
+{
+  if (data->bricks_len == data->bricks_alloc) {
+    data->bricks_alloc = max_ii(16, data->bricks_alloc * 2);
+    data->bricks = MEM_reallocN(data->bricks, sizeof(*data->bricks) * data->bricks_alloc);
   }
+  RemeshBrick *brick = &data->bricks[data->bricks_len++];
+  memset(brick, 0, sizeof(*brick));
+  copy_v3_v3_int(brick->min, min);
+  copy_v3_v3_int(brick->max, max);
+  brick->tris = tris;
+  brick->tris_len = tris_len;
+}
 
-  return mesh;
+/* Split the range until the level set of each brick fits in the memory limit. Takes ownership of
+ * the tris array. */
+static void remesh_bricks_split(
+    RemeshChunkedData *data, const int min[3], const int max[3], int *tris, int tris_len)
+{
+  if (tris_len == 0) {
+    /* No surface in this brick. */
+    MEM_freeN(tris);
+    return;
+  }
+
+  float area = 0.0f;
+  for (int i = 0; i < tris_len; i++) {
+    area += data->tri_areas[tris[i]];
+  }
+
+  int axis = 0;
+  for (int i = 1; i < 3; i++) {
+    if (max[i] - min[i] > max[axis] - min[axis]) {
+      axis = i;
+    }
+  }
+
+  if ((size_t)(area * data->area_to_bytes) <= data->brick_memory_limit ||
+      max[axis] - min[axis] < REMESH_BRICK_MIN_SIZE * 2) {
+    remesh_bricks_add(data, min, max, tris, tris_len);
+    return;
+  }
+
+  const int mid = (min[axis] + max[axis]) / 2;
+  int child_min[3], child_max[3];
+
+  for (int side = 0; side < 2; side++) {
+    copy_v3_v3_int(child_min, min);
+    copy_v3_v3_int(child_max, max);
+    if (side == 0) {
+      child_max[axis] = mid;
+    }
+    else {
+      child_min[axis] = mid + 1;
+    }
+
+    /* Triangles overlapping the child brick and its halo. */
+    const float halo_min = (float)child_min[axis] - data->tri_halo;
+    const float halo_max = (float)child_max[axis] + data->tri_halo;
+    int *child_tris = MEM_malloc_arrayN(tris_len, sizeof(int), __func__);
+    int child_tris_len = 0;
+    for (int i = 0; i < tris_len; i++) {
+      float(*bounds)[3] = data->tri_bounds[tris[i]];
+      if (bounds[0][axis] <= halo_max && bounds[1][axis] >= halo_min) {
+        child_tris[child_tris_len++] = tris[i];
+      }
+    }
+    remesh_bricks_split(data, child_min, child_max, child_tris, child_tris_len);
+  }
+
+  MEM_freeN(tris);
+}
+
+static int remesh_uint_cmp(const void *a, const void *b)
+{
+  const uint x = *(const uint *)a, y = *(const uint *)b;
+  return (x > y) - (x < y);
+}
+
+typedef struct RemeshBrickSignData {
+  BVHTree *tree;
+  const float *verts;
+  const uint *faces;
+  struct IsectRayPrecalc isect_precalc;
+  float dist;
+  int crossings;
+} RemeshBrickSignData;
+
+static void remesh_brick_sign_raycast_cb(void *userdata,
+                                         int index,
+                                         const BVHTreeRay *ray,
+                                         BVHTreeRayHit *UNUSED(hit))
+{
+  RemeshBrickSignData *data = userdata;
+  const uint *tri = &data->faces[index * 3];
+  float dist = data->dist;
+  if (isect_ray_tri_watertight_v3(ray->origin,
+                                  &data->isect_precalc,
+                                  &data->verts[tri[0] * 3],
+                                  &data->verts[tri[1] * 3],
+                                  &data->verts[tri[2] * 3],
+                                  &dist,
+                                  NULL)) {
+    data->crossings++;
+  }
 }
+
+static int remesh_brick_sign_crossings(void *userdata, const float a[3], const float b[3])
+{
+  RemeshBrickSignData *data = userdata;
+  float dir[3];
+  sub_v3_v3v3(dir, b, a);
+  data->dist = normalize_v3(dir);
+  data->crossings = 0;
+  if (data->dist > 0.0f) {
+    isect_ray_tri_watertight_v3_precalc(&data->isect_precalc, dir);
+    BLI_bvhtree_ray_cast_all(
+        data->tree, a, dir, 0.0f, data->dist, remesh_brick_sign_raycast_cb, data);
+  }
+  return data->crossings;
+}
+
+static void remesh_brick_task(void *__restrict userdata,
+                              const int index,
+                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RemeshChunkedData *data = userdata;
+  RemeshBrick *brick = &data->bricks[index];
+  const MLoop *mloop = data->mesh->mloop;
+
+  /* Gather the vertices used by the brick triangles, only copying those. */
+  const int faces_len = brick->tris_len * 3;
+  uint *faces = MEM_malloc_arrayN(faces_len, sizeof(uint), __func__);
+  for (int i = 0; i < brick->tris_len; i++) {
+    const MLoopTri *lt = &data->looptri[brick->tris[i]];
+    for (int j = 0; j < 3; j++) {
+      faces[i * 3 + j] = mloop[lt->tri[j]].v;
+    }
+  }
+  MEM_SAFE_FREE(brick->tris);
+
+  uint *vert_indices = MEM_dupallocN(faces);
+  qsort(vert_indices, faces_len, sizeof(uint), remesh_uint_cmp);
+  int verts_len = 0;
+  for (int i = 0; i < faces_len; i++) {
+    if (verts_len == 0 || vert_indices[verts_len - 1] != vert_indices[i]) {
+      vert_indices[verts_len++] = vert_indices[i];
+    }
+  }
+
+  float *verts = MEM_malloc_arrayN(verts_len, sizeof(float[3]), __func__);
+  for (int i = 0; i < verts_len; i++) {
+    copy_v3_v3(&verts[i * 3], data->mesh->mvert[vert_indices[i]].co);
+  }
+  for (int i = 0; i < faces_len; i++) {
+    const uint *v = bsearch(&faces[i], vert_indices, verts_len, sizeof(uint), remesh_uint_cmp);
+    faces[i] = (uint)(v - vert_indices);
+  }
+  MEM_freeN(vert_indices);
+
+  struct OpenVDBLevelSet *level_set = OpenVDBLevelSet_create(false, NULL);
+  OpenVDBLevelSet_mesh_to_unsigned_distance(
+      level_set, verts, faces, verts_len, brick->tris_len, data->xform);
+
+  RemeshBrickSignData sign_data = {
+      .tree = BLI_bvhtree_new(brick->tris_len, 0.0f, 4, 6),
+      .verts = verts,
+      .faces = faces,
+  };
+  for (int i = 0; i < brick->tris_len; i++) {
+    float co[3][3];
+    for (int j = 0; j < 3; j++) {
+      copy_v3_v3(co[j], &verts[faces[i * 3 + j] * 3]);
+    }
+    BLI_bvhtree_insert(sign_data.tree, i, co[0], 3);
+  }
+  BLI_bvhtree_balance(sign_data.tree);
+
+  int sign_min[3], sign_max[3];
+  for (int axis = 0; axis < 3; axis++) {
+    sign_min[axis] = brick->min[axis] - REMESH_BRICK_BORDER;
+    sign_max[axis] = brick->max[axis] + REMESH_BRICK_BORDER;
+  }
+  OpenVDBLevelSet_sign_from_reference(level_set,
+                                      data->sign_level_set,
+                                      sign_min,
+                                      sign_max,
+                                      remesh_brick_sign_crossings,
+                                      &sign_data);
+  BLI_bvhtree_free(sign_data.tree);
+  MEM_freeN(verts);
+  MEM_freeN(faces);
+
+  /* Adaptivity would merge polygons differently on each side of the brick borders. */
+  OpenVDBLevelSet_volume_to_mesh_clipped(
+      level_set, &brick->output, data->isovalue, 0.0, false, brick->min, brick->max);
+  OpenVDBLevelSet_free(level_set);
+}
+
+static int remesh_vert_co_cmp(const void *a, const void *b, void *thunk)
+{
+  const float *vertices = thunk;
+  const float *co_a = &vertices[*(const int *)a * 3];
+  const float *co_b = &vertices[*(const int *)b * 3];
+  for (int i = 0; i < 3; i++) {
+    if (co_a[i] != co_b[i]) {
+      return (co_a[i] > co_b[i]) ? 1 : -1;
+    }
+  }
+  return 0;
+}
+
+/* Concatenate the output of all bricks, welding the duplicated vertices along their borders. */
+static Mesh *remesh_bricks_to_mesh(RemeshChunkedData *data, float voxel_size)
+{
+  struct OpenVDBVolumeToMeshData output = {0};
+  for (int b = 0; b < data->bricks_len; b++) {
+    output.totvertices += data->bricks[b].output.totvertices;
+    output.totquads += data->bricks[b].output.totquads;
+    output.tottriangles += data->bricks[b].output.tottriangles;
+  }
+  output.vertices = MEM_malloc_arrayN(output.totvertices, sizeof(float[3]), __func__);
+  output.quads = MEM_malloc_arrayN(output.totquads, sizeof(uint[4]), __func__);
+  output.triangles = MEM_malloc_arrayN(output.tottriangles, sizeof(uint[3]), __func__);
+
+  /* Vertices close to a brick border may be shared with the neighbor brick. */
+  int *seam_verts = MEM_malloc_arrayN(output.totvertices, sizeof(int), __func__);
+  int seam_verts_len = 0;
+
+  int vert_ofs = 0, quad_ofs = 0, tri_ofs = 0;
+  for (int b = 0; b < data->bricks_len; b++) {
+    RemeshBrick *brick = &data->bricks[b];
+    struct OpenVDBVolumeToMeshData *brick_output = &brick->output;
+
+    for (int i = 0; i < brick_output->totvertices; i++) {
+      const float *co = &brick_output->vertices[i * 3];
+      copy_v3_v3(&output.vertices[(vert_ofs + i) * 3], co);
+      for (int axis = 0; axis < 3; axis++) {
+        const float co_index = co[axis] / voxel_size;
+        if (co_index < (float)(brick->min[axis] + 2) || co_index > (float)(brick->max[axis] - 1)) {
+          seam_verts[seam_verts_len++] = vert_ofs + i;
+          break;
+        }
+      }
+    }
+    for (int i = 0; i < brick_output->totquads * 4; i++) {
+      output.quads[quad_ofs * 4 + i] = brick_output->quads[i] + (uint)vert_ofs;
+    }
+    for (int i = 0; i < brick_output->tottriangles * 3; i++) {
+      output.triangles[tri_ofs * 3 + i] = brick_output->triangles[i] + (uint)vert_ofs;
+    }
+
+    vert_ofs += brick_output->totvertices;
+    quad_ofs += brick_output->totquads;
+    tri_ofs += brick_output->tottriangles;
+
+    MEM_SAFE_FREE(brick_output->vertices);
+    MEM_SAFE_FREE(brick_output->quads);
+    MEM_SAFE_FREE(brick_output->triangles);
+  }
+
+  /* Weld the seam vertices with the exact same position. */
+  int *vert_map = MEM_malloc_arrayN(output.totvertices, sizeof(int), __func__);
+  for (int i = 0; i < output.totvertices; i++) {
+    vert_map[i] = i;
+  }
+  BLI_qsort_r(seam_verts, seam_verts_len, sizeof(int), remesh_vert_co_cmp, output.vertices);
+  for (int i = 1; i < seam_verts_len; i++) {
+    if (remesh_vert_co_cmp(&seam_verts[i - 1], &seam_verts[i], output.vertices) == 0) {
+      vert_map[seam_verts[i]] = vert_map[seam_verts[i - 1]];
+    }
+  }
+  MEM_freeN(seam_verts);
+
+  /* Compact the vertices, welded ones use the index of the vertex they map to. */
+  int *vert_index = MEM_malloc_arrayN(output.totvertices, sizeof(int), __func__);
+  int totvert = 0;
+  for (int i = 0; i < output.totvertices; i++) {
+    if (vert_map[i] == i) {
+      copy_v3_v3(&output.vertices[totvert * 3], &output.vertices[i * 3]);
+      vert_index[i] = totvert++;
+    }
+  }
+  for (int i = 0; i < output.totquads * 4; i++) {
+    output.quads[i] = (uint)vert_index[vert_map[output.quads[i]]];
+  }
+  for (int i = 0; i < output.tottriangles * 3; i++) {
+    output.triangles[i] = (uint)vert_index[vert_map[output.triangles[i]]];
+  }
+  output.totvertices = totvert;
+  MEM_freeN(vert_index);
+  MEM_freeN(vert_map);
+
+  return remesh_voxel_volume_output_to_mesh(&output);
+}
+
+static Mesh *remesh_voxel_chunked(Mesh *mesh,
+                                  float voxel_size,
+                                  float isovalue,
+                                  size_t memory_limit,
+                                  BKE_mesh_remesh_update_cb update_cb,
+                                  void *update_cb_data)
+{
+  const float area_to_bytes = (float)REMESH_SURFACE_VOXEL_BYTES / square_f(voxel_size);
+
+  /* The coarse level set uses the largest voxels that fit in half of the memory, up to a limit
+   * since the triangles of each brick must cover the segments to its voxel centers. */
+  const float sign_voxel_scale = clamp_f(
+      ceilf(sqrtf(BKE_mesh_calc_area(mesh) * area_to_bytes / (float)max_zz(memory_limit / 2, 1))),
+      1.0f,
+      (float)REMESH_SIGN_VOXEL_MAX);
+  struct OpenVDBTransform *sign_xform = OpenVDBTransform_create();
+  OpenVDBTransform_create_linear_transform(sign_xform, (double)(voxel_size * sign_voxel_scale));
+  /* Also computes the looptris. */
+  struct OpenVDBLevelSet *sign_level_set = BKE_mesh_remesh_voxel_ovdb_mesh_to_level_set_create(
+      mesh, sign_xform);
+  OpenVDBTransform_free(sign_xform);
+
+  const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+  const int looptri_len = BKE_mesh_runtime_looptri_len(mesh);
+  const int threads_len = BLI_task_scheduler_num_threads();
+
+  RemeshChunkedData data = {
+      .mesh = mesh,
+      .looptri = looptri,
+      .isovalue = (double)isovalue,
+      .sign_level_set = sign_level_set,
+      .area_to_bytes = area_to_bytes,
+      /* Each thread builds the level set of one brick at a time with the other half. */
+      .brick_memory_limit = memory_limit / 2 / (size_t)threads_len,
+      .tri_halo = (float)REMESH_BRICK_HALO + sign_voxel_scale * (float)M_SQRT3 * 0.5f,
+  };
+
+  data.tri_bounds = MEM_malloc_arrayN(looptri_len, sizeof(*data.tri_bounds), __func__);
+  data.tri_areas = MEM_malloc_arrayN(looptri_len, sizeof(float), __func__);
+  int *tris = MEM_malloc_arrayN(looptri_len, sizeof(int), __func__);
+  float min[3], max[3];
+  INIT_MINMAX(min, max);
+  for (int i = 0; i < looptri_len; i++) {
+    const float *co[3];
+    for (int j = 0; j < 3; j++) {
+      co[j] = mesh->mvert[mesh->mloop[looptri[i].tri[j]].v].co;
+    }
+    INIT_MINMAX(data.tri_bounds[i][0], data.tri_bounds[i][1]);
+    for (int j = 0; j < 3; j++) {
+      float co_index[3];
+      mul_v3_v3fl(co_index, co[j], 1.0f / voxel_size);
+      minmax_v3v3_v3(data.tri_bounds[i][0], data.tri_bounds[i][1], co_index);
+    }
+    minmax_v3v3_v3(min, max, data.tri_bounds[i][0]);
+    minmax_v3v3_v3(min, max, data.tri_bounds[i][1]);
+    data.tri_areas[i] = area_tri_v3(co[0], co[1], co[2]);
+    tris[i] = i;
+  }
+
+  int min_index[3], max_index[3];
+  for (int axis = 0; axis < 3; axis++) {
+    min_index[axis] = (int)floorf(min[axis]) - REMESH_BRICK_HALO;
+    max_index[axis] = (int)ceilf(max[axis]) + REMESH_BRICK_HALO;
+  }
+  remesh_bricks_split(&data, min_index, max_index, tris, looptri_len);
+  MEM_freeN(data.tri_bounds);
+  MEM_freeN(data.tri_areas);
+
+  data.xform = OpenVDBTransform_create();
+  OpenVDBTransform_create_linear_transform(data.xform, (double)voxel_size);
+
+  /* Mesh one batch of bricks per thread at a time to bound the memory usage and to report
+   * progress from the calling thread. */
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  bool canceled = false;
+  for (int start = 0; start < data.bricks_len && !canceled; start += threads_len) {
+    const int end = min_ii(start + threads_len, data.bricks_len);
+    BLI_task_parallel_range(start, end, &data, remesh_brick_task, &settings);
+
+    if (update_cb) {
+      int cancel = 0;
+      update_cb(update_cb_data, (float)end / (float)data.bricks_len, &cancel);
+      canceled = (cancel != 0);
+    }
+  }
+  OpenVDBTransform_free(data.xform);
+  OpenVDBLevelSet_free(data.sign_level_set);
+
+  Mesh *new_mesh = NULL;
+  if (canceled) {
+    for (int b = 0; b < data.bricks_len; b++) {
+      MEM_SAFE_FREE(data.bricks[b].tris);
+      MEM_SAFE_FREE(data.bricks[b].output.vertices);
+      MEM_SAFE_FREE(data.bricks[b].output.quads);
+      MEM_SAFE_FREE(data.bricks[b].output.triangles);
+    }
+  }
+  else {
+    new_mesh = remesh_bricks_to_mesh(&data, voxel_size);
+  }
+  MEM_SAFE_FREE(data.bricks);
+
+  return new_mesh;
+}
+
+/** \} */
 #endif
 
 #ifdef WITH_QUADRIFLOW
@@ -316,6 +781,37 @@ Mesh *BKE_mesh_remesh_voxel_to_mesh_nomain(Mesh *mesh,
   return new_mesh;
 }
 
+/**
+ * Same as #BKE_mesh_remesh_voxel_to_mesh_nomain, but splits the volume in bricks meshed in
+ * parallel when the estimated memory usage of the level set exceeds \a memory_limit (in bytes,
+ * 0 for no limit). Adaptivity is ignored when the volume is split.
+ *
+ * \param update_cb: Optional, called from the calling thread with the progress. Setting its
+ * cancel argument aborts the remesh and NULL is returned.
+ */
+Mesh *BKE_mesh_remesh_voxel_to_mesh_chunked_nomain(Mesh *mesh,
+                                                   float voxel_size,
+                                                   float adaptivity,
+                                                   float isovalue,
+                                                   size_t memory_limit,
+                                                   BKE_mesh_remesh_update_cb update_cb,
+                                                   void *update_cb_data)
+{
+#ifdef WITH_OPENVDB
+  if (memory_limit != 0) {
+    const float area = BKE_mesh_calc_area(mesh);
+    const float memory = area * (float)REMESH_SURFACE_VOXEL_BYTES / square_f(voxel_size);
+    if (memory > (float)memory_limit) {
+      return remesh_voxel_chunked(
+          mesh, voxel_size, isovalue, memory_limit, update_cb, update_cb_data);
+    }
+  }
+#else
+  UNUSED_VARS(memory_limit, update_cb, update_cb_data);
+#endif
+  return BKE_mesh_remesh_voxel_to_mesh_nomain(mesh, voxel_size, adaptivity, isovalue);
+}
+
 void BKE_mesh_remesh_reproject_paint_mask(Mesh *target, Mesh *source)
 {
   BVHTreeFromMesh bvhtree = {
@@ -0,0 +1,118 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_remesh_voxel.h"
+
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+}
+
+namespace blender::bke::tests {
+
+/* Closed cube, slightly offset so its faces don't lie on voxel centers. */
+static Mesh *remesh_test_cube_mesh(const float size)
+{
+  static const int face_verts[6][4] = {
+      {0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}};
+
+  Mesh *mesh = BKE_mesh_new_nomain(8, 0, 0, 24, 6);
+  for (int i = 0; i < 8; i++) {
+    for (int axis = 0; axis < 3; axis++) {
+      mesh->mvert[i].co[axis] = ((i & (1 << axis)) ? size : -size) + 0.0123f;
+    }
+  }
+  for (int i = 0; i < 6; i++) {
+    mesh->mpoly[i].loopstart = i * 4;
+    mesh->mpoly[i].totloop = 4;
+    for (int j = 0; j < 4; j++) {
+      mesh->mloop[i * 4 + j].v = face_verts[i][j];
+    }
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  BKE_mesh_calc_normals(mesh);
+  return mesh;
+}
+
+/* Number of edges not used by exactly two faces. */
+static int remesh_test_non_manifold_edges(const Mesh *mesh)
+{
+  std::vector<int> edge_faces(mesh->totedge, 0);
+  for (int i = 0; i < mesh->totloop; i++) {
+    edge_faces[mesh->mloop[i].e]++;
+  }
+  int non_manifold = 0;
+  for (const int faces : edge_faces) {
+    if (faces != 2) {
+      non_manifold++;
+    }
+  }
+  return non_manifold;
+}
+
+static void remesh_test_update_cb(void *data, float UNUSED(progress), int *UNUSED(cancel))
+{
+  (*(int *)data)++;
+}
+
+TEST(mesh_remesh_voxel, ChunkedMatchesSingleLevelSet)
+{
+  BLI_threadapi_init();
+  BKE_idtype_init();
+  BLI_task_scheduler_init();
+
+  /* Large enough in voxels to be split in several bricks. */
+  const float voxel_size = 0.02f;
+  Mesh *mesh = remesh_test_cube_mesh(1.0f);
+
+  Mesh *single = BKE_mesh_remesh_voxel_to_mesh_nomain(mesh, voxel_size, 0.0f, 0.0f);
+  ASSERT_NE(single, nullptr);
+
+  /* A limit of a single byte forces the smallest bricks. */
+  int updates_num = 0;
+  Mesh *chunked = BKE_mesh_remesh_voxel_to_mesh_chunked_nomain(
+      mesh, voxel_size, 0.0f, 0.0f, 1, remesh_test_update_cb, &updates_num);
+  ASSERT_NE(chunked, nullptr);
+  EXPECT_GT(updates_num, 0);
+
+  /* Vertices on brick seams must be welded and no faces may be missing or duplicated. */
+  EXPECT_EQ(chunked->totvert, single->totvert);
+  EXPECT_EQ(chunked->totpoly, single->totpoly);
+  EXPECT_EQ(remesh_test_non_manifold_edges(single), 0);
+  EXPECT_EQ(remesh_test_non_manifold_edges(chunked), 0);
+
+  BKE_id_free(nullptr, chunked);
+  BKE_id_free(nullptr, single);
+  BKE_id_free(nullptr, mesh);
+
+  BLI_task_scheduler_exit();
+  BLI_threadapi_exit();
+}
+
+}  // namespace blender::bke::tests
@@ -1513,111 +1513,6 @@ void BKE_mesh_calc_edges_legacy(Mesh *me, const bool use_old)
   BKE_mesh_strip_loose_faces(me);
 }
 
-/**
- * Calculate edges from polygons
- *
- * \param mesh: The mesh to add edges into
- * \param update: When true create new edges co-exist
- */
-void BKE_mesh_calc_edges(Mesh *mesh, bool update, const bool select)
-{
-  CustomData edata;
-  EdgeHashIterator *ehi;
-  MPoly *mp;
-  MEdge *med, *med_orig;
-  EdgeHash *eh;
-  unsigned int eh_reserve;
-  int i, totedge, totpoly = mesh->totpoly;
-  int med_index;
-  /* select for newly created meshes which are selected [#25595] */
-  const short ed_flag = (ME_EDGEDRAW | ME_EDGERENDER) | (select ? SELECT : 0);
-
-  if (mesh->totedge == 0) {
-    update = false;
-  }
-
-  eh_reserve = max_ii(update ? mesh->totedge : 0, BLI_EDGEHASH_SIZE_GUESS_FROM_POLYS(totpoly));
-  eh = BLI_edgehash_new_ex(__func__, eh_reserve);
-
-  if (update) {
-    /* assume existing edges are valid
-     * useful when adding more faces and generating edges from them */
-    med = mesh->medge;
-    for (i = 0; i < mesh->totedge; i++, med++) {
-      BLI_edgehash_insert(eh, med->v1, med->v2, med);
-    }
-  }
-
-  /* mesh loops (bmesh only) */
-  for (mp = mesh->mpoly, i = 0; i < totpoly; mp++, i++) {
-    MLoop *l = &mesh->mloop[mp->loopstart];
-    int j, v_prev = (l + (mp->totloop - 1))->v;
-    for (j = 0; j < mp->totloop; j++, l++) {
-      if (v_prev != l->v) {
-        void **val_p;
-        if (!BLI_edgehash_ensure_p(eh, v_prev, l->v, &val_p)) {
-          *val_p = NULL;
-        }
-      }
-      v_prev = l->v;
-    }
-  }
-
-  totedge = BLI_edgehash_len(eh);
-
-  /* write new edges into a temporary CustomData */
-  CustomData_reset(&edata);
-  CustomData_add_layer(&edata, CD_MEDGE, CD_CALLOC, NULL, totedge);
-
-  med = CustomData_get_layer(&edata, CD_MEDGE);
-  for (ehi = BLI_edgehashIterator_new(eh), i = 0; BLI_edgehashIterator_isDone(ehi) == false;
-       BLI_edgehashIterator_step(ehi), ++i, ++med) {
-    if (update && (med_orig = BLI_edgehashIterator_getValue(ehi))) {
-      *med = *med_orig; /* copy from the original */
-    }
-    else {
-      BLI_edgehashIterator_getKey(ehi, &med->v1, &med->v2);
-      med->flag = ed_flag;
-    }
-
-    /* store the new edge index in the hash value */
-    BLI_edgehashIterator_setValue(ehi, POINTER_FROM_INT(i));
-  }
-  BLI_edgehashIterator_free(ehi);
-
-  if (mesh->totpoly) {
-    /* second pass, iterate through all loops again and assign
-     * the newly created edges to them. */
-    for (mp = mesh->mpoly, i = 0; i < mesh->totpoly; mp++, i++) {
-      MLoop *l = &mesh->mloop[mp->loopstart];
-      MLoop *l_prev = (l + (mp->totloop - 1));
-      int j;
-      for (j = 0; j < mp->totloop; j++, l++) {
-        /* Lookup hashed edge index, if it's valid. */
-        if (l_prev->v != l->v) {
-          med_index = POINTER_AS_INT(BLI_edgehash_lookup(eh, l_prev->v, l->v));
-        }
-        else {
-          /* This is an invalid edge; normally this does not happen in Blender, but it can be part
-           * of an imported mesh with invalid geometry. See T76514. */
-          med_index = 0;
-        }
-        l_prev->e = med_index;
-        l_prev = l;
-      }
-    }
-  }
-
-  /* free old CustomData and assign new one */
-  CustomData_free(&mesh->edata, mesh->totedge);
-  mesh->edata = edata;
-  mesh->totedge = totedge;
-
-  mesh->medge = CustomData_get_layer(&mesh->edata, CD_MEDGE);
-
-  BLI_edgehash_free(eh, NULL);
-}
-
 void BKE_mesh_calc_edges_loose(Mesh *mesh)
 {
   MEdge *med = mesh->medge;
@@ -440,6 +440,8 @@ static void multires_ccg_mark_as_modified(SubdivCCG *subdiv_ccg, MultiresModifie
 {
   if (flags & MULTIRES_COORDS_MODIFIED) {
     subdiv_ccg->dirty.coords = true;
+    /* It is unknown which grids were modified, consider all of them. */
+    MEM_SAFE_FREE(subdiv_ccg->dirty.grids);
   }
   if (flags & MULTIRES_HIDDEN_MODIFIED) {
     subdiv_ccg->dirty.hidden = true;
@@ -467,6 +469,27 @@ void multires_mark_as_modified(Depsgraph *depsgraph, Object *object, MultiresMod
   multires_ccg_mark_as_modified(subdiv_ccg, flags);
 }
 
+/* Mark coordinates of the grids of sculpt PBVH nodes which are to be redrawn as modified, so that
+ * reshape only needs to process those grids and their neighbors. */
+void multires_mark_sculpt_grids_as_modified(Depsgraph *depsgraph, Object *object)
+{
+  SculptSession *sculpt_session = object->sculpt;
+  if (sculpt_session == NULL || sculpt_session->pbvh == NULL ||
+      sculpt_session->subdiv_ccg == NULL || BKE_pbvh_type(sculpt_session->pbvh) != PBVH_GRIDS) {
+    multires_mark_as_modified(depsgraph, object, MULTIRES_COORDS_MODIFIED);
+    return;
+  }
+
+  CCGFace **faces;
+  int num_faces;
+  BKE_pbvh_get_grid_updates_for_flag(
+      sculpt_session->pbvh, PBVH_UpdateRedraw, (void ***)&faces, &num_faces);
+  if (num_faces) {
+    BKE_subdiv_ccg_tag_faces_modified(sculpt_session->subdiv_ccg, faces, num_faces);
+    MEM_freeN(faces);
+  }
+}
+
 void multires_flush_sculpt_updates(Object *object)
 {
   if (object == NULL || object->sculpt == NULL || object->sculpt->pbvh == NULL) {
@@ -494,6 +517,7 @@ void multires_flush_sculpt_updates(Object *object)
 
   subdiv_ccg->dirty.coords = false;
   subdiv_ccg->dirty.hidden = false;
+  MEM_SAFE_FREE(subdiv_ccg->dirty.grids);
 }
 
 void multires_force_sculpt_rebuild(Object *object)
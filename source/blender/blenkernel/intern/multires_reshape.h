@@ -24,6 +24,7 @@
 #ifndef __BKE_INTERN_MULTIRES_RESHAPE_H__
 #define __BKE_INTERN_MULTIRES_RESHAPE_H__
 
+#include "BLI_bitmap.h"
 #include "BLI_sys_types.h"
 
 #include "BKE_multires.h"
@@ -82,6 +83,10 @@ typedef struct MultiresReshapeContext {
   /* Number of grids which are required for base_mesh. */
   int num_grids;
 
+  /* Indexed by grid index, grids which are to be reshaped. NULL when all grids are.
+   * NOTE: Only used when reshaping from CCG. */
+  const BLI_bitmap *modified_grids;
+
   /* Destination displacement and mask.
    * Points to a custom data on a destination mesh. */
   struct MDisps *mdisps;
@@ -41,6 +41,10 @@ bool multires_reshape_assign_final_coords_from_ccg(const MultiresReshapeContext
 
   int num_grids = subdiv_ccg->num_grids;
   for (int grid_index = 0; grid_index < num_grids; ++grid_index) {
+    if (reshape_context->modified_grids != NULL &&
+        !BLI_BITMAP_TEST(reshape_context->modified_grids, grid_index)) {
+      continue;
+    }
     CCGElem *ccg_grid = subdiv_ccg->grids[grid_index];
     for (int y = 0; y < reshape_grid_size; ++y) {
       const float v = (float)y * reshape_grid_size_1_inv;
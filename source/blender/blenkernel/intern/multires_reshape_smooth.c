@@ -870,6 +870,7 @@ static void geometry_create(MultiresReshapeSmoothContext *reshape_smooth_context
   SubdivToMeshSettings mesh_settings;
   mesh_settings.resolution = get_reshape_level_resolution(reshape_context);
   mesh_settings.use_optimal_display = false;
+  mesh_settings.use_topology_cache = false;
 
   /* TODO(sergey): Tell the foreach() to ignore loose vertices. */
   BKE_subdiv_foreach_subdiv_geometry(
@@ -647,6 +647,10 @@ static void foreach_grid_face_coordinate_task(void *__restrict userdata_v,
   const int num_corners = mpoly[face_index].totloop;
   int grid_index = reshape_context->face_start_grid_index[face_index];
   for (int corner = 0; corner < num_corners; ++corner, ++grid_index) {
+    if (reshape_context->modified_grids != NULL &&
+        !BLI_BITMAP_TEST(reshape_context->modified_grids, grid_index)) {
+      continue;
+    }
     for (int y = 0; y < grid_size; ++y) {
       const float v = (float)y * grid_size_1_inv;
       for (int x = 0; x < grid_size; ++x) {
@@ -205,6 +205,7 @@ bool multires_reshape_assign_final_coords_from_vertcos(
   SubdivToMeshSettings mesh_settings;
   mesh_settings.resolution = (1 << reshape_context->reshape.level) + 1;
   mesh_settings.use_optimal_display = false;
+  mesh_settings.use_topology_cache = false;
 
   return BKE_subdiv_foreach_subdiv_geometry(
       reshape_context->subdiv, &foreach_context, &mesh_settings, reshape_context->base_mesh);
@@ -57,4 +57,5 @@ void BKE_multires_subdiv_mesh_settings_init(SubdivToMeshSettings *mesh_settings,
   mesh_settings->resolution = (1 << level) + 1;
   mesh_settings->use_optimal_display = (mmd->flags & eMultiresModifierFlag_ControlEdges) &&
                                        !ignore_control_edges;
+  mesh_settings->use_topology_cache = false;
 }
@@ -847,6 +847,7 @@ static void object_update_from_subsurf_ccg(Object *object)
   /* Everything is now up-to-date. */
   subdiv_ccg->dirty.coords = false;
   subdiv_ccg->dirty.hidden = false;
+  MEM_SAFE_FREE(subdiv_ccg->dirty.grids);
 }
 
 /* Assign data after modifier stack evaluation. */
@@ -896,6 +897,7 @@ void BKE_object_free_derived_caches(Object *ob)
     }
     ob->runtime.data_eval = NULL;
   }
+  ob->runtime.is_data_eval_deform_update = false;
   if (ob->runtime.mesh_deform_eval != NULL) {
     Mesh *mesh_deform_eval = ob->runtime.mesh_deform_eval;
     BKE_mesh_eval_delete(mesh_deform_eval);
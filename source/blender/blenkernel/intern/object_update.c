@@ -382,7 +382,11 @@ void BKE_object_eval_uber_data(Depsgraph *depsgraph, Scene *scene, Object *ob)
   DEG_debug_print_eval(depsgraph, __func__, ob->id.name, ob);
   BLI_assert(ob->type != OB_ARMATURE);
   BKE_object_handle_data_update(depsgraph, scene, ob);
-  BKE_object_batch_cache_dirty_tag(ob);
+  /* The draw cache taken over from the previous evaluation is already tagged for the deformation
+   * update, tagging everything would discard the buffers that are still valid. */
+  if (!ob->runtime.is_data_eval_deform_update) {
+    BKE_object_batch_cache_dirty_tag(ob);
+  }
 }
 
 void BKE_object_eval_ptcache_reset(Depsgraph *depsgraph, Scene *scene, Object *object)
@@ -820,33 +820,6 @@ static void exec_distribute_child(TaskPool *__restrict UNUSED(pool), void *taskd
   }
 }
 
-static int distribute_compare_orig_index(const void *p1, const void *p2, void *user_data)
-{
-  int *orig_index = (int *)user_data;
-  int index1 = orig_index[*(const int *)p1];
-  int index2 = orig_index[*(const int *)p2];
-
-  if (index1 < index2) {
-    return -1;
-  }
-  else if (index1 == index2) {
-    /* this pointer comparison appears to make qsort stable for glibc,
-     * and apparently on solaris too, makes the renders reproducible */
-    if (p1 < p2) {
-      return -1;
-    }
-    else if (p1 == p2) {
-      return 0;
-    }
-    else {
-      return 1;
-    }
-  }
-  else {
-    return 1;
-  }
-}
-
 static void distribute_invalid(ParticleSimulationData *sim, int from)
 {
   Scene *scene = sim->scene;
@@ -1251,8 +1224,13 @@ static int psys_thread_context_init_distribute(ParticleThreadContext *ctx,
     }
 
     if (orig_index) {
-      BLI_qsort_r(
-          particle_element, totpart, sizeof(int), distribute_compare_orig_index, orig_index);
+      /* Stable, keeps renders reproducible. */
+      int *sort_keys = MEM_mallocN(sizeof(*sort_keys) * (size_t)totpart, __func__);
+      for (p = 0; p < totpart; p++) {
+        sort_keys[p] = orig_index[particle_element[p]];
+      }
+      BLI_radix_sort_int(sort_keys, (uint *)particle_element, (size_t)totpart);
+      MEM_freeN(sort_keys);
     }
   }
 
@@ -26,6 +26,7 @@
 #include "BLI_ghash.h"
 #include "BLI_math.h"
 #include "BLI_rand.h"
+#include "BLI_sort.h"
 #include "BLI_task.h"
 
 #include "DNA_mesh_types.h"
@@ -174,28 +175,6 @@ static bool grid_materials_match(const DMFlagMat *f1, const DMFlagMat *f2)
   return ((f1->flag & ME_SMOOTH) == (f2->flag & ME_SMOOTH) && (f1->mat_nr == f2->mat_nr));
 }
 
-/* Adapted from BLI_kdopbvh.c */
-/* Returns the index of the first element on the right of the partition */
-static int partition_indices(int *prim_indices, int lo, int hi, int axis, float mid, BBC *prim_bbc)
-{
-  int i = lo, j = hi;
-  for (;;) {
-    for (; prim_bbc[prim_indices[i]].bcentroid[axis] < mid; i++) {
-      /* pass */
-    }
-    for (; mid < prim_bbc[prim_indices[j]].bcentroid[axis]; j--) {
-      /* pass */
-    }
-
-    if (!(i < j)) {
-      return i;
-    }
-
-    SWAP(int, prim_indices[i], prim_indices[j]);
-    i++;
-  }
-}
-
 /* Returns the index of the first element on the right of the partition */
 static int partition_indices_material(PBVH *pbvh, int lo, int hi)
 {
@@ -253,109 +232,6 @@ void pbvh_grow_nodes(PBVH *pbvh, int totnode)
   pbvh->totnode = totnode;
 }
 
-/* Add a vertex to the map, with a positive value for unique vertices and
- * a negative value for additional vertices */
-static int map_insert_vert(
-    PBVH *pbvh, GHash *map, unsigned int *face_verts, unsigned int *uniq_verts, int vertex)
-{
-  void *key, **value_p;
-
-  key = POINTER_FROM_INT(vertex);
-  if (!BLI_ghash_ensure_p(map, key, &value_p)) {
-    int value_i;
-    if (BLI_BITMAP_TEST(pbvh->vert_bitmap, vertex) == 0) {
-      BLI_BITMAP_ENABLE(pbvh->vert_bitmap, vertex);
-      value_i = *uniq_verts;
-      (*uniq_verts)++;
-    }
-    else {
-      value_i = ~(*face_verts);
-      (*face_verts)++;
-    }
-    *value_p = POINTER_FROM_INT(value_i);
-    return value_i;
-  }
-  else {
-    return POINTER_AS_INT(*value_p);
-  }
-}
-
-/* Find vertices used by the faces in this node and update the draw buffers */
-static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
-{
-  bool has_visible = false;
-
-  node->uniq_verts = node->face_verts = 0;
-  const int totface = node->totprim;
-
-  /* reserve size is rough guess */
-  GHash *map = BLI_ghash_int_new_ex("build_mesh_leaf_node gh", 2 * totface);
-
-  int(*face_vert_indices)[3] = MEM_mallocN(sizeof(int[3]) * totface, "bvh node face vert indices");
-
-  node->face_vert_indices = (const int(*)[3])face_vert_indices;
-
-  if (pbvh->respect_hide == false) {
-    has_visible = true;
-  }
-
-  for (int i = 0; i < totface; i++) {
-    const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
-    for (int j = 0; j < 3; j++) {
-      face_vert_indices[i][j] = map_insert_vert(
-          pbvh, map, &node->face_verts, &node->uniq_verts, pbvh->mloop[lt->tri[j]].v);
-    }
-
-    if (has_visible == false) {
-      if (!paint_is_face_hidden(lt, pbvh->verts, pbvh->mloop)) {
-        has_visible = true;
-      }
-    }
-  }
-
-  int *vert_indices = MEM_callocN(sizeof(int) * (node->uniq_verts + node->face_verts),
-                                  "bvh node vert indices");
-  node->vert_indices = vert_indices;
-
-  /* Build the vertex list, unique verts first */
-  GHashIterator gh_iter;
-  GHASH_ITER (gh_iter, map) {
-    void *value = BLI_ghashIterator_getValue(&gh_iter);
-    int ndx = POINTER_AS_INT(value);
-
-    if (ndx < 0) {
-      ndx = -ndx + node->uniq_verts - 1;
-    }
-
-    vert_indices[ndx] = POINTER_AS_INT(BLI_ghashIterator_getKey(&gh_iter));
-  }
-
-  for (int i = 0; i < totface; i++) {
-    const int sides = 3;
-
-    for (int j = 0; j < sides; j++) {
-      if (face_vert_indices[i][j] < 0) {
-        face_vert_indices[i][j] = -face_vert_indices[i][j] + node->uniq_verts - 1;
-      }
-    }
-  }
-
-  BKE_pbvh_node_mark_rebuild_draw(node);
-
-  BKE_pbvh_node_fully_hidden_set(node, !has_visible);
-
-  BLI_ghash_free(map, NULL, NULL);
-}
-
-static void update_vb(PBVH *pbvh, PBVHNode *node, BBC *prim_bbc, int offset, int count)
-{
-  BB_reset(&node->vb);
-  for (int i = offset + count - 1; i >= offset; i--) {
-    BB_expand_with_bb(&node->vb, (BB *)(&prim_bbc[pbvh->prim_indices[i]]));
-  }
-  node->orig_vb = node->vb;
-}
-
 /* Returns the number of visible quads in the nodes' grids. */
 int BKE_pbvh_count_grid_quads(BLI_bitmap **grid_hidden,
                               const int *grid_indices,
@@ -409,32 +285,6 @@ void BKE_pbvh_sync_face_sets_to_grids(PBVH *pbvh)
   }
 }
 
-static void build_grid_leaf_node(PBVH *pbvh, PBVHNode *node)
-{
-  int totquads = BKE_pbvh_count_grid_quads(
-      pbvh->grid_hidden, node->prim_indices, node->totprim, pbvh->gridkey.grid_size);
-  BKE_pbvh_node_fully_hidden_set(node, (totquads == 0));
-  BKE_pbvh_node_mark_rebuild_draw(node);
-}
-
-static void build_leaf(PBVH *pbvh, int node_index, BBC *prim_bbc, int offset, int count)
-{
-  pbvh->nodes[node_index].flag |= PBVH_Leaf;
-
-  pbvh->nodes[node_index].prim_indices = pbvh->prim_indices + offset;
-  pbvh->nodes[node_index].totprim = count;
-
-  /* Still need vb for searches */
-  update_vb(pbvh, &pbvh->nodes[node_index], prim_bbc, offset, count);
-
-  if (pbvh->looptri) {
-    build_mesh_leaf_node(pbvh, pbvh->nodes + node_index);
-  }
-  else {
-    build_grid_leaf_node(pbvh, pbvh->nodes + node_index);
-  }
-}
-
 /* Return zero if all primitives in the node can be drawn with the
  * same material (including flat/smooth shading), non-zero otherwise */
 static bool leaf_needs_material_split(PBVH *pbvh, int offset, int count)
@@ -469,73 +319,532 @@ static bool leaf_needs_material_split(PBVH *pbvh, int offset, int count)
   return false;
 }
 
-/* Recursively build a node in the tree
- *
- * vb is the voxel box around all of the primitives contained in
- * this node.
- *
- * cb is the bounding box around all the centroids of the primitives
- * contained in this node
+/* -------------------------------------------------------------------- */
+/** \name Tree Build
  *
- * offset and start indicate a range in the array of primitive indices
- */
+ * The tree is built in three steps:
+ * - The primitives are partitioned recursively, nodes with many primitives are split by tasks of
+ *   their own. Splits are chosen by the surface area heuristic, evaluated on a fixed number of
+ *   bins along the widest axis of the primitive centroids.
+ * - The resulting tree is flattened into the nodes array in the same depth-first order the
+ *   recursion would visit the nodes, so node indices don't depend on the order the tasks ran in.
+ * - Leaves are filled in parallel. A vertex is unique to the first leaf (in depth-first order)
+ *   using it, which is found with an atomic minimum in a flat per-vertex array.
+ * \{ */
+
+/* Nodes with more primitives are split by a task of their own. */
+#define PBVH_BUILD_TASK_PRIMS_MIN 32768
+/* Nodes with more primitives compute their bounds and bins with a parallel loop. */
+#define PBVH_BUILD_PARALLEL_PRIMS_MIN 262144
+#define PBVH_BUILD_PARALLEL_BLOCK_SIZE 16384
+#define PBVH_BUILD_BINS_NUM 16
+/* Splits which leave less than 1 / PBVH_BUILD_SPLIT_BALANCE of the primitives on one side are
+ * only used when there is no more balanced one, this keeps leaves of similar size. */
+#define PBVH_BUILD_SPLIT_BALANCE 8
+
+typedef struct PBVHBuildNode {
+  /* Bounding box of the primitives of the node. */
+  BB vb;
+  /* Bounding box of the primitive centroids. */
+  BB cb;
+  /* The bounds are already known from the split of the parent. */
+  bool has_bounds;
+  /* Range in the primitive indices. */
+  int offset;
+  int count;
+  /* Both children, NULL for leaves. */
+  struct PBVHBuildNode *children;
+} PBVHBuildNode;
+
+typedef struct PBVHBuildData {
+  PBVH *pbvh;
+  const BBC *prim_bbc;
+  TaskPool *task_pool;
+} PBVHBuildData;
+
+typedef struct PBVHBuildBounds {
+  /* Bounds of the primitives. */
+  BB vb;
+  /* Bounds of the primitive centroids. */
+  BB cb;
+} PBVHBuildBounds;
 
-static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int offset, int count)
+typedef struct PBVHBuildBins {
+  int axis;
+  float bin_min;
+  float bin_scale;
+  int count[PBVH_BUILD_BINS_NUM];
+  BB bb[PBVH_BUILD_BINS_NUM];
+  BB cb[PBVH_BUILD_BINS_NUM];
+} PBVHBuildBins;
+
+typedef struct PBVHBuildRangeData {
+  const PBVHBuildData *data;
+  int offset;
+  int count;
+} PBVHBuildRangeData;
+
+static void pbvh_build_range_settings(TaskParallelSettings *settings,
+                                      const int count,
+                                      void *chunk,
+                                      const size_t chunk_size,
+                                      TaskParallelReduceFunc func_reduce)
 {
-  int end;
-  BB cb_backing;
+  BLI_parallel_range_settings_defaults(settings);
+  settings->use_threading = count >= PBVH_BUILD_PARALLEL_PRIMS_MIN;
+  settings->userdata_chunk = chunk;
+  settings->userdata_chunk_size = chunk_size;
+  settings->func_reduce = func_reduce;
+  settings->min_iter_per_thread = 1;
+}
+
+static int pbvh_build_range_blocks_num(const int count)
+{
+  return (count + PBVH_BUILD_PARALLEL_BLOCK_SIZE - 1) / PBVH_BUILD_PARALLEL_BLOCK_SIZE;
+}
+
+static void pbvh_build_bounds_cb(void *__restrict userdata,
+                                 const int block,
+                                 const TaskParallelTLS *__restrict tls)
+{
+  const PBVHBuildRangeData *range = userdata;
+  const int *prim_indices = range->data->pbvh->prim_indices;
+  const BBC *prim_bbc = range->data->prim_bbc;
+  PBVHBuildBounds *bounds = tls->userdata_chunk;
+  const int start = range->offset + block * PBVH_BUILD_PARALLEL_BLOCK_SIZE;
+  const int end = min_ii(start + PBVH_BUILD_PARALLEL_BLOCK_SIZE, range->offset + range->count);
+  for (int i = start; i < end; i++) {
+    const BBC *bbc = &prim_bbc[prim_indices[i]];
+    BB_expand_with_bb(&bounds->vb, (BB *)bbc);
+    BB_expand(&bounds->cb, bbc->bcentroid);
+  }
+}
+
+static void pbvh_build_bounds_reduce(const void *__restrict UNUSED(userdata),
+                                     void *__restrict chunk_join,
+                                     void *__restrict chunk)
+{
+  PBVHBuildBounds *join = chunk_join;
+  PBVHBuildBounds *bounds = chunk;
+  BB_expand_with_bb(&join->vb, &bounds->vb);
+  BB_expand_with_bb(&join->cb, &bounds->cb);
+}
+
+static void pbvh_build_bounds(const PBVHBuildData *data,
+                              const int offset,
+                              const int count,
+                              PBVHBuildBounds *r_bounds)
+{
+  BB_reset(&r_bounds->vb);
+  BB_reset(&r_bounds->cb);
+
+  PBVHBuildRangeData range = {data, offset, count};
+  TaskParallelSettings settings;
+  pbvh_build_range_settings(
+      &settings, count, r_bounds, sizeof(*r_bounds), pbvh_build_bounds_reduce);
+  BLI_task_parallel_range(
+      0, pbvh_build_range_blocks_num(count), &range, pbvh_build_bounds_cb, &settings);
+}
+
+BLI_INLINE int pbvh_build_bin_index(const PBVHBuildBins *bins, const BBC *bbc)
+{
+  const int bin = (int)((bbc->bcentroid[bins->axis] - bins->bin_min) * bins->bin_scale);
+  return min_ii(max_ii(bin, 0), PBVH_BUILD_BINS_NUM - 1);
+}
+
+static void pbvh_build_bins_cb(void *__restrict userdata,
+                               const int block,
+                               const TaskParallelTLS *__restrict tls)
+{
+  const PBVHBuildRangeData *range = userdata;
+  const int *prim_indices = range->data->pbvh->prim_indices;
+  const BBC *prim_bbc = range->data->prim_bbc;
+  PBVHBuildBins *bins = tls->userdata_chunk;
+  const int start = range->offset + block * PBVH_BUILD_PARALLEL_BLOCK_SIZE;
+  const int end = min_ii(start + PBVH_BUILD_PARALLEL_BLOCK_SIZE, range->offset + range->count);
+  for (int i = start; i < end; i++) {
+    const BBC *bbc = &prim_bbc[prim_indices[i]];
+    const int bin = pbvh_build_bin_index(bins, bbc);
+    bins->count[bin]++;
+    BB_expand_with_bb(&bins->bb[bin], (BB *)bbc);
+    BB_expand(&bins->cb[bin], bbc->bcentroid);
+  }
+}
+
+static void pbvh_build_bins_reduce(const void *__restrict UNUSED(userdata),
+                                   void *__restrict chunk_join,
+                                   void *__restrict chunk)
+{
+  PBVHBuildBins *join = chunk_join;
+  PBVHBuildBins *bins = chunk;
+  for (int i = 0; i < PBVH_BUILD_BINS_NUM; i++) {
+    join->count[i] += bins->count[i];
+    BB_expand_with_bb(&join->bb[i], &bins->bb[i]);
+    BB_expand_with_bb(&join->cb[i], &bins->cb[i]);
+  }
+}
+
+/* Half of the surface area, zero for an empty box. */
+static float pbvh_build_bb_area(const BB *bb)
+{
+  if (bb->bmin[0] > bb->bmax[0]) {
+    return 0.0f;
+  }
+  const float dx = bb->bmax[0] - bb->bmin[0];
+  const float dy = bb->bmax[1] - bb->bmin[1];
+  const float dz = bb->bmax[2] - bb->bmin[2];
+  return dx * dy + dy * dz + dz * dx;
+}
+
+/* Returns the bin of the first primitive on the right of the split, or zero when the centroids
+ * can't be split. */
+static int pbvh_build_bins_split(const PBVHBuildBins *bins, const int count)
+{
+  float area_right[PBVH_BUILD_BINS_NUM];
+  BB bb;
+  BB_reset(&bb);
+  for (int i = PBVH_BUILD_BINS_NUM - 1; i > 0; i--) {
+    BB_expand_with_bb(&bb, (BB *)&bins->bb[i]);
+    area_right[i] = pbvh_build_bb_area(&bb);
+  }
+
+  const int count_balanced = count / PBVH_BUILD_SPLIT_BALANCE;
+  int best_split = 0;
+  bool best_is_balanced = false;
+  float best_cost = FLT_MAX;
+  int count_left = 0;
+  BB_reset(&bb);
+  for (int i = 1; i < PBVH_BUILD_BINS_NUM; i++) {
+    count_left += bins->count[i - 1];
+    BB_expand_with_bb(&bb, (BB *)&bins->bb[i - 1]);
+    const int count_right = count - count_left;
+    if (count_left == 0 || count_right == 0) {
+      continue;
+    }
+    const bool is_balanced = min_ii(count_left, count_right) >= count_balanced;
+    if (best_is_balanced && !is_balanced) {
+      continue;
+    }
+    const float cost = pbvh_build_bb_area(&bb) * count_left + area_right[i] * count_right;
+    if (cost < best_cost || (is_balanced && !best_is_balanced)) {
+      best_split = i;
+      best_cost = cost;
+      best_is_balanced = is_balanced;
+    }
+  }
+  return best_split;
+}
+
+/* Returns the index of the first element on the right of the partition */
+static int partition_indices_bin(const PBVHBuildBins *bins,
+                                 int *prim_indices,
+                                 const BBC *prim_bbc,
+                                 int lo,
+                                 int hi,
+                                 const int split_bin)
+{
+  while (lo <= hi) {
+    if (pbvh_build_bin_index(bins, &prim_bbc[prim_indices[lo]]) < split_bin) {
+      lo++;
+    }
+    else {
+      SWAP(int, prim_indices[lo], prim_indices[hi]);
+      hi--;
+    }
+  }
+  return lo;
+}
+
+/* Returns the index of the first element on the right of the split. The bounds of the children
+ * are set when they are known from the bins. */
+static int pbvh_build_split(const PBVHBuildData *data,
+                            const int offset,
+                            const int count,
+                            const BB *cb,
+                            PBVHBuildNode children[2])
+{
+  PBVHBuildBins bins = {0};
+  bins.axis = BB_widest_axis(cb);
+  const float extent = cb->bmax[bins.axis] - cb->bmin[bins.axis];
+  if (!(extent > 0.0f)) {
+    /* All centroids are in the same spot, any split is as good as another. */
+    return offset + count / 2;
+  }
+  bins.bin_min = cb->bmin[bins.axis];
+  bins.bin_scale = (float)PBVH_BUILD_BINS_NUM / extent;
+  for (int i = 0; i < PBVH_BUILD_BINS_NUM; i++) {
+    BB_reset(&bins.bb[i]);
+    BB_reset(&bins.cb[i]);
+  }
+
+  PBVHBuildRangeData range = {data, offset, count};
+  TaskParallelSettings settings;
+  pbvh_build_range_settings(&settings, count, &bins, sizeof(bins), pbvh_build_bins_reduce);
+  BLI_task_parallel_range(
+      0, pbvh_build_range_blocks_num(count), &range, pbvh_build_bins_cb, &settings);
+
+  const int split_bin = pbvh_build_bins_split(&bins, count);
+  if (split_bin == 0) {
+    return offset + count / 2;
+  }
+
+  for (int i = 0; i < 2; i++) {
+    BB_reset(&children[i].vb);
+    BB_reset(&children[i].cb);
+    children[i].has_bounds = true;
+  }
+  for (int i = 0; i < PBVH_BUILD_BINS_NUM; i++) {
+    PBVHBuildNode *child = &children[i < split_bin ? 0 : 1];
+    BB_expand_with_bb(&child->vb, &bins.bb[i]);
+    BB_expand_with_bb(&child->cb, &bins.cb[i]);
+  }
+
+  return partition_indices_bin(
+      &bins, data->pbvh->prim_indices, data->prim_bbc, offset, offset + count - 1, split_bin);
+}
+
+static void pbvh_build_node(const PBVHBuildData *data, PBVHBuildNode *node);
+
+static void pbvh_build_node_task_cb(TaskPool *__restrict pool, void *taskdata)
+{
+  const PBVHBuildData *data = BLI_task_pool_user_data(pool);
+  pbvh_build_node(data, taskdata);
+}
+
+static void pbvh_build_node(const PBVHBuildData *data, PBVHBuildNode *node)
+{
+  PBVH *pbvh = data->pbvh;
+  const int offset = node->offset;
+  const int count = node->count;
+
+  if (!node->has_bounds) {
+    PBVHBuildBounds bounds;
+    pbvh_build_bounds(data, offset, count, &bounds);
+    node->vb = bounds.vb;
+    node->cb = bounds.cb;
+  }
 
   /* Decide whether this is a leaf or not */
   const bool below_leaf_limit = count <= pbvh->leaf_limit;
   if (below_leaf_limit) {
     if (!leaf_needs_material_split(pbvh, offset, count)) {
-      build_leaf(pbvh, node_index, prim_bbc, offset, count);
       return;
     }
   }
 
-  /* Add two child nodes */
-  pbvh->nodes[node_index].children_offset = pbvh->totnode;
-  pbvh_grow_nodes(pbvh, pbvh->totnode + 2);
-
-  /* Update parent node bounding box */
-  update_vb(pbvh, &pbvh->nodes[node_index], prim_bbc, offset, count);
+  node->children = MEM_callocN(sizeof(PBVHBuildNode[2]), "PBVHBuildNode children");
 
+  int end;
   if (!below_leaf_limit) {
-    /* Find axis with widest range of primitive centroids */
-    if (!cb) {
-      cb = &cb_backing;
-      BB_reset(cb);
-      for (int i = offset + count - 1; i >= offset; i--) {
-        BB_expand(cb, prim_bbc[pbvh->prim_indices[i]].bcentroid);
-      }
-    }
-    const int axis = BB_widest_axis(cb);
-
-    /* Partition primitives along that axis */
-    end = partition_indices(pbvh->prim_indices,
-                            offset,
-                            offset + count - 1,
-                            axis,
-                            (cb->bmax[axis] + cb->bmin[axis]) * 0.5f,
-                            prim_bbc);
+    end = pbvh_build_split(data, offset, count, &node->cb, node->children);
   }
   else {
     /* Partition primitives by material */
     end = partition_indices_material(pbvh, offset, offset + count - 1);
   }
 
-  /* Build children */
-  build_sub(pbvh, pbvh->nodes[node_index].children_offset, NULL, prim_bbc, offset, end - offset);
-  build_sub(pbvh,
-            pbvh->nodes[node_index].children_offset + 1,
-            NULL,
-            prim_bbc,
-            end,
-            offset + count - end);
+  node->children[0].offset = offset;
+  node->children[0].count = end - offset;
+  node->children[1].offset = end;
+  node->children[1].count = offset + count - end;
+
+  if (node->children[0].count >= PBVH_BUILD_TASK_PRIMS_MIN) {
+    BLI_task_pool_push(data->task_pool, pbvh_build_node_task_cb, &node->children[0], false, NULL);
+  }
+  else {
+    pbvh_build_node(data, &node->children[0]);
+  }
+  pbvh_build_node(data, &node->children[1]);
+}
+
+static int pbvh_build_nodes_num(const PBVHBuildNode *node)
+{
+  if (node->children == NULL) {
+    return 1;
+  }
+  return 1 + pbvh_build_nodes_num(&node->children[0]) +
+         pbvh_build_nodes_num(&node->children[1]);
+}
+
+/* Copy the built nodes into the PBVH, in the order of a depth-first traversal. */
+static void pbvh_build_flatten(PBVH *pbvh,
+                               PBVHBuildNode *build_node,
+                               const int node_index,
+                               int *leaves,
+                               int *r_totleaf)
+{
+  PBVHNode *node = &pbvh->nodes[node_index];
+  node->vb = build_node->vb;
+  node->orig_vb = build_node->vb;
+
+  if (build_node->children == NULL) {
+    node->flag |= PBVH_Leaf;
+    node->prim_indices = pbvh->prim_indices + build_node->offset;
+    node->totprim = build_node->count;
+    leaves[(*r_totleaf)++] = node_index;
+    return;
+  }
+
+  node->children_offset = pbvh->totnode;
+  pbvh->totnode += 2;
+  pbvh_build_flatten(pbvh, &build_node->children[0], node->children_offset, leaves, r_totleaf);
+  pbvh_build_flatten(
+      pbvh, &build_node->children[1], node->children_offset + 1, leaves, r_totleaf);
+  MEM_freeN(build_node->children);
 }
 
-static void pbvh_build(PBVH *pbvh, BB *cb, BBC *prim_bbc, int totprim)
+typedef struct PBVHBuildLeavesData {
+  PBVH *pbvh;
+  const int *leaves;
+  /* For every vertex, the first leaf using it. */
+  int *vert_owners;
+} PBVHBuildLeavesData;
+
+static void pbvh_build_vert_owner_set(int *vert_owner, const int leaf)
+{
+  int owner = *vert_owner;
+  while (leaf < owner) {
+    const int owner_prev = atomic_cas_int32(vert_owner, owner, leaf);
+    if (owner_prev == owner) {
+      break;
+    }
+    owner = owner_prev;
+  }
+}
+
+static void pbvh_build_vert_owners_cb(void *__restrict userdata,
+                                      const int leaf,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  PBVH *pbvh = data->pbvh;
+  const PBVHNode *node = &pbvh->nodes[data->leaves[leaf]];
+  for (int i = 0; i < node->totprim; i++) {
+    const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
+    for (int j = 0; j < 3; j++) {
+      pbvh_build_vert_owner_set(&data->vert_owners[pbvh->mloop[lt->tri[j]].v], leaf);
+    }
+  }
+}
+
+/* Find vertices used by the faces in this node and update the draw buffers */
+static void build_mesh_leaf_node(PBVH *pbvh,
+                                 PBVHNode *node,
+                                 const int leaf,
+                                 const int *vert_owners)
+{
+  bool has_visible = false;
+
+  node->uniq_verts = node->face_verts = 0;
+  const int totface = node->totprim;
+  const int totcorner = totface * 3;
+
+  int(*face_vert_indices)[3] = MEM_mallocN(sizeof(int[3]) * totface, "bvh node face vert indices");
+  int *corner_vert_indices = &face_vert_indices[0][0];
+
+  node->face_vert_indices = (const int(*)[3])face_vert_indices;
+
+  if (pbvh->respect_hide == false) {
+    has_visible = true;
+  }
+
+  /* Sort the corners by vertex, to find the corners sharing a vertex without a hash. */
+  uint *verts = MEM_malloc_arrayN(totcorner, sizeof(uint), __func__);
+  uint *corners = MEM_malloc_arrayN(totcorner, sizeof(uint), __func__);
+  for (int i = 0; i < totface; i++) {
+    const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
+    for (int j = 0; j < 3; j++) {
+      verts[i * 3 + j] = pbvh->mloop[lt->tri[j]].v;
+      corners[i * 3 + j] = (uint)(i * 3 + j);
+    }
+
+    if (has_visible == false) {
+      if (!paint_is_face_hidden(lt, pbvh->verts, pbvh->mloop)) {
+        has_visible = true;
+      }
+    }
+  }
+  BLI_radix_sort_uint(verts, corners, totcorner);
+
+  /* Assign every corner the index of its vertex in the sorted unique vertices. */
+  int totvert = 0;
+  for (int i = 0; i < totcorner; i++) {
+    if (i > 0 && verts[i] != verts[i - 1]) {
+      totvert++;
+    }
+    verts[totvert] = verts[i];
+    corner_vert_indices[corners[i]] = totvert;
+  }
+  totvert = (totcorner != 0) ? totvert + 1 : 0;
+
+  /* Number the vertices in the order of their first use, with a positive value for unique
+   * vertices and a negative value for additional vertices. */
+  int *vert_node_indices = (int *)corners;
+  copy_vn_i(vert_node_indices, totvert, INT_MAX);
+  for (int i = 0; i < totcorner; i++) {
+    int *vert_node_index = &vert_node_indices[corner_vert_indices[i]];
+    if (*vert_node_index == INT_MAX) {
+      if (vert_owners[verts[corner_vert_indices[i]]] == leaf) {
+        *vert_node_index = node->uniq_verts++;
+      }
+      else {
+        *vert_node_index = ~node->face_verts++;
+      }
+    }
+    corner_vert_indices[i] = *vert_node_index;
+  }
+
+  int *vert_indices = MEM_callocN(sizeof(int) * (node->uniq_verts + node->face_verts),
+                                  "bvh node vert indices");
+  node->vert_indices = vert_indices;
+
+  /* Build the vertex list, unique verts first */
+  for (int i = 0; i < totvert; i++) {
+    int ndx = vert_node_indices[i];
+    if (ndx < 0) {
+      ndx = -ndx + node->uniq_verts - 1;
+    }
+    vert_indices[ndx] = (int)verts[i];
+  }
+
+  for (int i = 0; i < totcorner; i++) {
+    if (corner_vert_indices[i] < 0) {
+      corner_vert_indices[i] = -corner_vert_indices[i] + node->uniq_verts - 1;
+    }
+  }
+
+  BKE_pbvh_node_mark_rebuild_draw(node);
+
+  BKE_pbvh_node_fully_hidden_set(node, !has_visible);
+
+  MEM_freeN(verts);
+  MEM_freeN(corners);
+}
+
+static void build_grid_leaf_node(PBVH *pbvh, PBVHNode *node)
+{
+  int totquads = BKE_pbvh_count_grid_quads(
+      pbvh->grid_hidden, node->prim_indices, node->totprim, pbvh->gridkey.grid_size);
+  BKE_pbvh_node_fully_hidden_set(node, (totquads == 0));
+  BKE_pbvh_node_mark_rebuild_draw(node);
+}
+
+static void pbvh_build_leaf_cb(void *__restrict userdata,
+                               const int leaf,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  PBVH *pbvh = data->pbvh;
+  PBVHNode *node = &pbvh->nodes[data->leaves[leaf]];
+  if (pbvh->looptri) {
+    build_mesh_leaf_node(pbvh, node, leaf, data->vert_owners);
+  }
+  else {
+    build_grid_leaf_node(pbvh, node);
+  }
+}
+
+static void pbvh_build(PBVH *pbvh, const BBC *prim_bbc, int totprim)
 {
   if (totprim != pbvh->totprim) {
     pbvh->totprim = totprim;
@@ -556,8 +865,91 @@ static void pbvh_build(PBVH *pbvh, BB *cb, BBC *prim_bbc, int totprim)
     }
   }
 
+  /* Partition the primitives. */
+  PBVHBuildNode root = {{{0}}};
+  root.offset = 0;
+  root.count = totprim;
+
+  PBVHBuildData data;
+  data.pbvh = pbvh;
+  data.prim_bbc = prim_bbc;
+  data.task_pool = BLI_task_pool_create(&data, TASK_PRIORITY_HIGH);
+  pbvh_build_node(&data, &root);
+  BLI_task_pool_work_and_wait(data.task_pool);
+  BLI_task_pool_free(data.task_pool);
+
+  /* Create the nodes. */
+  const int totnode = pbvh_build_nodes_num(&root);
+  pbvh_grow_nodes(pbvh, totnode);
   pbvh->totnode = 1;
-  build_sub(pbvh, 0, cb, prim_bbc, 0, totprim);
+  int *leaves = MEM_malloc_arrayN(totnode, sizeof(int), __func__);
+  int totleaf = 0;
+  pbvh_build_flatten(pbvh, &root, 0, leaves, &totleaf);
+  BLI_assert(pbvh->totnode == totnode);
+
+  /* Fill the leaves. */
+  PBVHBuildLeavesData leaves_data;
+  leaves_data.pbvh = pbvh;
+  leaves_data.leaves = leaves;
+  leaves_data.vert_owners = NULL;
+
+  TaskParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, totleaf);
+
+  if (pbvh->looptri) {
+    leaves_data.vert_owners = MEM_malloc_arrayN(pbvh->totvert, sizeof(int), __func__);
+    copy_vn_i(leaves_data.vert_owners, pbvh->totvert, INT_MAX);
+    BLI_task_parallel_range(0, totleaf, &leaves_data, pbvh_build_vert_owners_cb, &settings);
+  }
+  BLI_task_parallel_range(0, totleaf, &leaves_data, pbvh_build_leaf_cb, &settings);
+
+  MEM_SAFE_FREE(leaves_data.vert_owners);
+  MEM_freeN(leaves);
+}
+
+/** \} */
+
+typedef struct PBVHPrimBBCData {
+  const PBVH *pbvh;
+  BBC *prim_bbc;
+} PBVHPrimBBCData;
+
+static void pbvh_build_mesh_prim_bbc_cb(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const PBVHPrimBBCData *data = userdata;
+  const PBVH *pbvh = data->pbvh;
+  const MLoopTri *lt = &pbvh->looptri[i];
+  const int sides = 3;
+  BBC *bbc = data->prim_bbc + i;
+
+  BB_reset((BB *)bbc);
+
+  for (int j = 0; j < sides; j++) {
+    BB_expand((BB *)bbc, pbvh->verts[pbvh->mloop[lt->tri[j]].v].co);
+  }
+
+  BBC_update_centroid(bbc);
+}
+
+static void pbvh_build_grids_prim_bbc_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const PBVHPrimBBCData *data = userdata;
+  const PBVH *pbvh = data->pbvh;
+  const CCGKey *key = &pbvh->gridkey;
+  CCGElem *grid = pbvh->grids[i];
+  BBC *bbc = data->prim_bbc + i;
+
+  BB_reset((BB *)bbc);
+
+  for (int j = 0; j < key->grid_area; j++) {
+    BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
+  }
+
+  BBC_update_centroid(bbc);
 }
 
 /**
@@ -579,7 +971,6 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
                          int looptri_num)
 {
   BBC *prim_bbc = NULL;
-  BB cb;
 
   pbvh->mesh = mesh;
   pbvh->type = PBVH_FACES;
@@ -587,7 +978,6 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
   pbvh->mloop = mloop;
   pbvh->looptri = looptri;
   pbvh->verts = verts;
-  pbvh->vert_bitmap = BLI_BITMAP_NEW(totvert, "bvh->vert_bitmap");
   pbvh->totvert = totvert;
   pbvh->leaf_limit = LEAF_LIMIT;
   pbvh->vdata = vdata;
@@ -597,33 +987,20 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
   pbvh->face_sets_color_seed = mesh->face_sets_color_seed;
   pbvh->face_sets_color_default = mesh->face_sets_color_default;
 
-  BB_reset(&cb);
-
   /* For each face, store the AABB and the AABB centroid */
   prim_bbc = MEM_mallocN(sizeof(BBC) * looptri_num, "prim_bbc");
 
-  for (int i = 0; i < looptri_num; i++) {
-    const MLoopTri *lt = &looptri[i];
-    const int sides = 3;
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < sides; j++) {
-      BB_expand((BB *)bbc, verts[pbvh->mloop[lt->tri[j]].v].co);
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  PBVHPrimBBCData prim_bbc_data = {pbvh, prim_bbc};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = PBVH_BUILD_PARALLEL_BLOCK_SIZE;
+  BLI_task_parallel_range(0, looptri_num, &prim_bbc_data, pbvh_build_mesh_prim_bbc_cb, &settings);
 
   if (looptri_num) {
-    pbvh_build(pbvh, &cb, prim_bbc, looptri_num);
+    pbvh_build(pbvh, prim_bbc, looptri_num);
   }
 
   MEM_freeN(prim_bbc);
-  MEM_freeN(pbvh->vert_bitmap);
 }
 
 /* Do a full rebuild with on Grids data structure */
@@ -646,29 +1023,17 @@ void BKE_pbvh_build_grids(PBVH *pbvh,
   pbvh->grid_hidden = grid_hidden;
   pbvh->leaf_limit = max_ii(LEAF_LIMIT / ((gridsize - 1) * (gridsize - 1)), 1);
 
-  BB cb;
-  BB_reset(&cb);
-
   /* For each grid, store the AABB and the AABB centroid */
   BBC *prim_bbc = MEM_mallocN(sizeof(BBC) * totgrid, "prim_bbc");
 
-  for (int i = 0; i < totgrid; i++) {
-    CCGElem *grid = grids[i];
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < gridsize * gridsize; j++) {
-      BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  PBVHPrimBBCData prim_bbc_data = {pbvh, prim_bbc};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = max_ii(PBVH_BUILD_PARALLEL_BLOCK_SIZE / key->grid_area, 1);
+  BLI_task_parallel_range(0, totgrid, &prim_bbc_data, pbvh_build_grids_prim_bbc_cb, &settings);
 
   if (totgrid) {
-    pbvh_build(pbvh, &cb, prim_bbc, totgrid);
+    pbvh_build(pbvh, prim_bbc, totgrid);
   }
 
   MEM_freeN(prim_bbc);
@@ -1610,7 +1975,9 @@ void BKE_pbvh_redraw_BB(PBVH *pbvh, float bb_min[3], float bb_max[3])
   copy_v3_v3(bb_max, bb.bmax);
 }
 
-void BKE_pbvh_get_grid_updates(PBVH *pbvh, bool clear, void ***r_gridfaces, int *r_totface)
+/* Gather the faces of the grids of nodes which have any of the given flags set. */
+static void pbvh_get_grid_updates(
+    PBVH *pbvh, PBVHNodeFlags flag, bool clear, void ***r_gridfaces, int *r_totface)
 {
   GSet *face_set = BLI_gset_ptr_new(__func__);
   PBVHNode *node;
@@ -1619,14 +1986,14 @@ void BKE_pbvh_get_grid_updates(PBVH *pbvh, bool clear, void ***r_gridfaces, int
   pbvh_iter_begin(&iter, pbvh, NULL, NULL);
 
   while ((node = pbvh_iter_next(&iter))) {
-    if (node->flag & PBVH_UpdateNormals) {
+    if (node->flag & flag) {
       for (uint i = 0; i < node->totprim; i++) {
         void *face = pbvh->gridfaces[node->prim_indices[i]];
         BLI_gset_add(face_set, face);
       }
 
       if (clear) {
-        node->flag &= ~PBVH_UpdateNormals;
+        node->flag &= ~flag;
       }
     }
   }
@@ -1655,6 +2022,19 @@ void BKE_pbvh_get_grid_updates(PBVH *pbvh, bool clear, void ***r_gridfaces, int
   *r_gridfaces = faces;
 }
 
+void BKE_pbvh_get_grid_updates(PBVH *pbvh, bool clear, void ***r_gridfaces, int *r_totface)
+{
+  pbvh_get_grid_updates(pbvh, PBVH_UpdateNormals, clear, r_gridfaces, r_totface);
+}
+
+void BKE_pbvh_get_grid_updates_for_flag(PBVH *pbvh,
+                                        PBVHNodeFlags flag,
+                                        void ***r_gridfaces,
+                                        int *r_totface)
+{
+  pbvh_get_grid_updates(pbvh, flag, false, r_gridfaces, r_totface);
+}
+
 /***************************** PBVH Access ***********************************/
 
 PBVHType BKE_pbvh_type(const PBVH *pbvh)
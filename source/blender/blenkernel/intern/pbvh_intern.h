@@ -151,10 +151,6 @@ struct PBVH {
   int totgrid;
   BLI_bitmap **grid_hidden;
 
-  /* Only used during BVH build and update,
-   * don't need to remain valid after */
-  BLI_bitmap *vert_bitmap;
-
 #ifdef PERFCNTRS
   int perf_modified;
 #endif
@@ -0,0 +1,174 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cmath>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_bitmap.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_ccg.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_pbvh.h"
+
+#include "pbvh_intern.h"
+}
+
+namespace blender::bke::tests {
+
+/* Wavy grid of quads, the right half uses a second material. */
+static Mesh *pbvh_test_grid_mesh(const int size)
+{
+  const int verts_len = (size + 1) * (size + 1);
+  const int polys_len = size * size;
+  Mesh *mesh = BKE_mesh_new_nomain(verts_len, 0, 0, polys_len * 4, polys_len);
+
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      float *co = mesh->mvert[y * (size + 1) + x].co;
+      co[0] = (float)x / size;
+      co[1] = (float)y / size;
+      co[2] = 0.1f * sinf(co[0] * 7.0f) * cosf(co[1] * 5.0f);
+    }
+  }
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int poly = y * size + x;
+      const int v = y * (size + 1) + x;
+      mesh->mpoly[poly].loopstart = poly * 4;
+      mesh->mpoly[poly].totloop = 4;
+      mesh->mpoly[poly].mat_nr = (x < size / 2) ? 0 : 1;
+      mesh->mloop[poly * 4 + 0].v = v;
+      mesh->mloop[poly * 4 + 1].v = v + 1;
+      mesh->mloop[poly * 4 + 2].v = v + size + 2;
+      mesh->mloop[poly * 4 + 3].v = v + size + 1;
+    }
+  }
+  return mesh;
+}
+
+static bool pbvh_test_bb_contains(const BB *bb, const float co[3])
+{
+  for (int i = 0; i < 3; i++) {
+    if (co[i] < bb->bmin[i] || co[i] > bb->bmax[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void pbvh_test_build_mesh(const int size)
+{
+  BLI_threadapi_init();
+  BKE_idtype_init();
+
+  Mesh *mesh = pbvh_test_grid_mesh(size);
+  const int looptri_len = poly_to_tri_count(mesh->totpoly, mesh->totloop);
+  MLoopTri *looptri = (MLoopTri *)MEM_malloc_arrayN(looptri_len, sizeof(*looptri), __func__);
+  BKE_mesh_recalc_looptri(
+      mesh->mloop, mesh->mpoly, mesh->mvert, mesh->totloop, mesh->totpoly, looptri);
+
+  PBVH *pbvh = BKE_pbvh_new();
+  BKE_pbvh_build_mesh(pbvh,
+                      mesh,
+                      mesh->mpoly,
+                      mesh->mloop,
+                      mesh->mvert,
+                      mesh->totvert,
+                      &mesh->vdata,
+                      &mesh->ldata,
+                      &mesh->pdata,
+                      looptri,
+                      looptri_len);
+
+  std::vector<int> prim_refs(looptri_len, 0);
+  std::vector<int> vert_unique_refs(mesh->totvert, 0);
+  for (int n = 0; n < pbvh->totnode; n++) {
+    const PBVHNode *node = &pbvh->nodes[n];
+
+    if (!(node->flag & PBVH_Leaf)) {
+      /* Children are within the bounds of their parent. */
+      for (int c = 0; c < 2; c++) {
+        const BB *child_vb = &pbvh->nodes[node->children_offset + c].vb;
+        EXPECT_TRUE(pbvh_test_bb_contains(&node->vb, child_vb->bmin));
+        EXPECT_TRUE(pbvh_test_bb_contains(&node->vb, child_vb->bmax));
+      }
+      continue;
+    }
+
+    EXPECT_GT(node->totprim, 0u);
+    EXPECT_LE((int)node->totprim, pbvh->leaf_limit);
+
+    const MPoly *mp_first = &mesh->mpoly[looptri[node->prim_indices[0]].poly];
+    for (int i = 0; i < (int)node->totprim; i++) {
+      const int prim = node->prim_indices[i];
+      ASSERT_GE(prim, 0);
+      ASSERT_LT(prim, looptri_len);
+      prim_refs[prim]++;
+
+      const MLoopTri *lt = &looptri[prim];
+      for (int j = 0; j < 3; j++) {
+        const float *co = mesh->mvert[mesh->mloop[lt->tri[j]].v].co;
+        EXPECT_TRUE(pbvh_test_bb_contains(&node->vb, co));
+      }
+      /* Leaves are split by material. */
+      EXPECT_EQ(mesh->mpoly[lt->poly].mat_nr, mp_first->mat_nr);
+    }
+
+    for (int i = 0; i < (int)node->uniq_verts; i++) {
+      vert_unique_refs[node->vert_indices[i]]++;
+    }
+  }
+
+  for (int i = 0; i < looptri_len; i++) {
+    EXPECT_EQ(prim_refs[i], 1);
+  }
+  for (int i = 0; i < mesh->totvert; i++) {
+    EXPECT_EQ(vert_unique_refs[i], 1);
+  }
+
+  BKE_pbvh_free(pbvh);
+  BKE_id_free(nullptr, mesh);
+  BLI_threadapi_exit();
+}
+
+TEST(pbvh, BuildMeshSmall)
+{
+  /* A few leaves, built without tasks. */
+  pbvh_test_build_mesh(100);
+}
+
+TEST(pbvh, BuildMeshLarge)
+{
+  /* Large enough to build nodes in parallel. */
+  pbvh_test_build_mesh(300);
+}
+
+}  // namespace blender::bke::tests
@@ -40,8 +40,10 @@
 #include "BLI_fileops_types.h"
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
 #include "BLI_path_util.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_global.h"
@@ -49,6 +51,15 @@
 #include "BKE_scene.h"
 #include "BKE_sequencer.h"
 
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#  define LZO_OUT_LEN(size) ((size) + (size) / 16 + 64 + 3)
+#endif
+
 /**
  * Sequencer Cache Design Notes
  * ============================
@@ -82,7 +93,12 @@
  * Multiple(DCACHE_IMAGES_PER_FILE) images share the same file.
  * Each of these files contains header DiskCacheHeader followed by image data.
  * Zlib compression with user definable level can be used to compress image data(per image)
+ * Alternatively LZO compression can be used. With LZO, image data is split into blocks of
+ * DCACHE_BLOCK_SIZE bytes which are compressed and decompressed in parallel. Compressed image
+ * data is then prefixed by table of compressed block sizes.
  * Images are written in order in which they are rendered.
+ * Writing is done by background thread, so rendering is not blocked by compression and I/O.
+ * Number of images waiting to be written is limited by DCACHE_MAX_PENDING_WRITES.
  * Overwriting of individual entry is not possible.
  * Stored images are deleted by invalidation, or when size of all files exceeds maximum
  * size specified in user preferences.
@@ -94,11 +110,20 @@
 /* <cache type>-<resolution X>x<resolution Y>-<rendersize>%(<view_id>)-<frame no>.dcf */
 #define DCACHE_FNAME_FORMAT "%d-%dx%d-%d%%(%d)-%d.dcf"
 #define DCACHE_IMAGES_PER_FILE 100
-#define DCACHE_CURRENT_VERSION 1
+#define DCACHE_CURRENT_VERSION 2
+#define DCACHE_BLOCK_SIZE (256 * 1024)
+#define DCACHE_MAX_PENDING_WRITES 8
 #define COLORSPACE_NAME_MAX 64 /* XXX: defined in imb intern */
 
+/* DiskCacheHeaderEntry.codec */
+enum {
+  DCACHE_CODEC_ZLIB = 0,
+  DCACHE_CODEC_LZO = 1,
+};
+
 typedef struct DiskCacheHeaderEntry {
   unsigned char encoding;
+  unsigned char codec;
   uint64_t frameno;
   uint64_t size_compressed;
   uint64_t size_raw;
@@ -116,8 +141,19 @@ typedef struct SeqDiskCache {
   ListBase files;
   ThreadMutex read_write_mutex;
   size_t size_total;
+  /* Write-behind. */
+  TaskPool *write_pool;
+  uint num_pending_writes;
+  ThreadMutex write_mutex;
+  ThreadCondition write_condition;
 } SeqDiskCache;
 
+typedef struct DiskCacheWriteTask {
+  char path[FILE_MAX];
+  float nfra;
+  ImBuf *ibuf;
+} DiskCacheWriteTask;
+
 typedef struct DiskCacheFile {
   struct DiskCacheFile *next, *prev;
   char path[FILE_MAX];
@@ -181,11 +217,24 @@ static int seq_disk_cache_compression_level(void)
       return 1;
     case USER_SEQ_DISK_CACHE_COMPRESSION_HIGH:
       return 9;
+    case USER_SEQ_DISK_CACHE_COMPRESSION_FAST:
+      /* Only used when LZO is not available. */
+      return 1;
   }
 
   return U.sequencer_disk_cache_compression;
 }
 
+static int seq_disk_cache_codec(void)
+{
+#ifdef WITH_LZO
+  if (U.sequencer_disk_cache_compression == USER_SEQ_DISK_CACHE_COMPRESSION_FAST) {
+    return DCACHE_CODEC_LZO;
+  }
+#endif
+  return DCACHE_CODEC_ZLIB;
+}
+
 static size_t seq_disk_cache_size_limit(void)
 {
   return (size_t)U.sequencer_disk_cache_size_limit * (1024 * 1024 * 1024);
@@ -455,6 +504,20 @@ static void seq_disk_cache_delete_invalid_files(SeqDiskCache *disk_cache,
   }
 }
 
+/* Wait until all scheduled images are written.
+ *
+ * Don't use #BLI_task_pool_work_and_wait here: for background pools it stops the queue from
+ * blocking for good, so tasks pushed afterwards would never run. The pending write counter is
+ * only decremented once a task is done and freed. */
+static void seq_disk_cache_write_wait(SeqDiskCache *disk_cache)
+{
+  BLI_mutex_lock(&disk_cache->write_mutex);
+  while (disk_cache->num_pending_writes > 0) {
+    BLI_condition_wait(&disk_cache->write_condition, &disk_cache->write_mutex);
+  }
+  BLI_mutex_unlock(&disk_cache->write_mutex);
+}
+
 static void seq_disk_cache_invalidate(Scene *scene,
                                       Sequence *seq,
                                       Sequence *seq_changed,
@@ -464,6 +527,9 @@ static void seq_disk_cache_invalidate(Scene *scene,
   int end;
   SeqDiskCache *disk_cache = scene->ed->cache->disk_cache;
 
+  /* Pending writes could store invalid images after files are deleted. */
+  seq_disk_cache_write_wait(disk_cache);
+
   BLI_mutex_lock(&disk_cache->read_write_mutex);
 
   start = seq_changed->startdisp - DCACHE_IMAGES_PER_FILE;
@@ -474,31 +540,198 @@ static void seq_disk_cache_invalidate(Scene *scene,
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
 }
 
+#ifdef WITH_LZO
+
+typedef struct DiskCacheBlockData {
+  unsigned char *raw;
+  size_t size_raw;
+  /* Compressed data of each block and its size. */
+  unsigned char **blocks;
+  uint32_t *block_sizes;
+  bool error;
+} DiskCacheBlockData;
+
+BLI_INLINE size_t seq_disk_cache_block_size_raw(const DiskCacheBlockData *data, const int block)
+{
+  return min_zz(DCACHE_BLOCK_SIZE, data->size_raw - (size_t)block * DCACHE_BLOCK_SIZE);
+}
+
+static void seq_disk_cache_compress_block_cb(void *__restrict userdata,
+                                             const int block,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DiskCacheBlockData *data = userdata;
+  const size_t in_len = seq_disk_cache_block_size_raw(data, block);
+  unsigned char *in = data->raw + (size_t)block * DCACHE_BLOCK_SIZE;
+  unsigned char *out = MEM_mallocN(LZO_OUT_LEN(in_len), "seq_disk_cache_lzo_block");
+  void *wrkmem = MEM_mallocN(LZO1X_MEM_COMPRESS, "seq_disk_cache_lzo_wrkmem");
+  lzo_uint out_len = 0;
+
+  int r = lzo1x_1_compress(in, (lzo_uint)in_len, out, &out_len, wrkmem);
+  /* Store block uncompressed if it can't be compressed, size of block tells which is the case. */
+  if (r != LZO_E_OK || out_len >= in_len) {
+    memcpy(out, in, in_len);
+    out_len = in_len;
+  }
+
+  MEM_freeN(wrkmem);
+  data->blocks[block] = out;
+  data->block_sizes[block] = (uint32_t)out_len;
+}
+
+static void seq_disk_cache_decompress_block_cb(void *__restrict userdata,
+                                               const int block,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DiskCacheBlockData *data = userdata;
+  const size_t out_len = seq_disk_cache_block_size_raw(data, block);
+  unsigned char *out = data->raw + (size_t)block * DCACHE_BLOCK_SIZE;
+  const unsigned char *in = data->blocks[block];
+  const size_t in_len = data->block_sizes[block];
+
+  if (in_len == out_len) {
+    memcpy(out, in, out_len);
+    return;
+  }
+
+  lzo_uint decompressed_len = out_len;
+  int r = lzo1x_decompress_safe(in, (lzo_uint)in_len, out, &decompressed_len, NULL);
+  if (r != LZO_E_OK || decompressed_len != out_len) {
+    data->error = true;
+  }
+}
+
+/* Image data is compressed in blocks of DCACHE_BLOCK_SIZE bytes in parallel. File contains table
+ * of compressed block sizes followed by compressed blocks. */
+static size_t lzo_mem_to_file_at_pos(void *buf, size_t len, FILE *file, size_t offset)
+{
+  const int num_blocks = (int)((len + DCACHE_BLOCK_SIZE - 1) / DCACHE_BLOCK_SIZE);
+  DiskCacheBlockData data = {
+      .raw = buf,
+      .size_raw = len,
+      .blocks = MEM_mallocN(sizeof(*data.blocks) * num_blocks, __func__),
+      .block_sizes = MEM_mallocN(sizeof(*data.block_sizes) * num_blocks, __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, num_blocks, &data, seq_disk_cache_compress_block_cb, &settings);
+
+  size_t bytes_written = 0;
+  fseek(file, offset, 0);
+  if (fwrite(data.block_sizes, sizeof(*data.block_sizes), num_blocks, file) == num_blocks) {
+    bytes_written = sizeof(*data.block_sizes) * num_blocks;
+    for (int block = 0; block < num_blocks; block++) {
+      if (fwrite(data.blocks[block], 1, data.block_sizes[block], file) !=
+          data.block_sizes[block]) {
+        bytes_written = 0;
+        break;
+      }
+      bytes_written += data.block_sizes[block];
+    }
+  }
+
+  for (int block = 0; block < num_blocks; block++) {
+    MEM_freeN(data.blocks[block]);
+  }
+  MEM_freeN(data.blocks);
+  MEM_freeN(data.block_sizes);
+
+  return bytes_written;
+}
+
+static size_t lzo_file_to_mem_at_pos(void *buf,
+                                     size_t len,
+                                     FILE *file,
+                                     DiskCacheHeaderEntry *header_entry)
+{
+  const int num_blocks = (int)((len + DCACHE_BLOCK_SIZE - 1) / DCACHE_BLOCK_SIZE);
+  const size_t table_size = sizeof(uint32_t) * num_blocks;
+
+  if (header_entry->size_compressed < table_size) {
+    return 0;
+  }
+
+  /* Read all compressed data at once, then decompress blocks in parallel. */
+  unsigned char *compressed = MEM_mallocN(header_entry->size_compressed, __func__);
+  fseek(file, header_entry->offset, 0);
+  if (fread(compressed, 1, header_entry->size_compressed, file) !=
+      header_entry->size_compressed) {
+    MEM_freeN(compressed);
+    return 0;
+  }
+
+  DiskCacheBlockData data = {
+      .raw = buf,
+      .size_raw = len,
+      .blocks = MEM_mallocN(sizeof(*data.blocks) * num_blocks, __func__),
+      .block_sizes = (uint32_t *)compressed,
+  };
+
+  if ((ENDIAN_ORDER == B_ENDIAN) && header_entry->encoding == 0) {
+    BLI_endian_switch_uint32_array(data.block_sizes, num_blocks);
+  }
+
+  /* Find start of each block, validating sizes stored in file. */
+  size_t block_offset = table_size;
+  for (int block = 0; block < num_blocks; block++) {
+    data.blocks[block] = compressed + block_offset;
+    block_offset += data.block_sizes[block];
+    if (block_offset > header_entry->size_compressed) {
+      data.error = true;
+      break;
+    }
+  }
+
+  if (!data.error) {
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+    BLI_task_parallel_range(0, num_blocks, &data, seq_disk_cache_decompress_block_cb, &settings);
+  }
+
+  MEM_freeN(data.blocks);
+  MEM_freeN(compressed);
+
+  return data.error ? 0 : len;
+}
+
+#endif /* WITH_LZO */
+
 static size_t deflate_imbuf_to_file(ImBuf *ibuf,
                                     FILE *file,
                                     int level,
                                     DiskCacheHeaderEntry *header_entry)
 {
-  if (ibuf->rect) {
-    return BLI_gzip_mem_to_file_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset, level);
-  }
-  else {
-    return BLI_gzip_mem_to_file_at_pos(
-        ibuf->rect_float, header_entry->size_raw, file, header_entry->offset, level);
+  void *buf = ibuf->rect ? (void *)ibuf->rect : (void *)ibuf->rect_float;
+
+#ifdef WITH_LZO
+  if (header_entry->codec == DCACHE_CODEC_LZO) {
+    return lzo_mem_to_file_at_pos(buf, header_entry->size_raw, file, header_entry->offset);
   }
+#endif
+
+  return BLI_gzip_mem_to_file_at_pos(
+      buf, header_entry->size_raw, file, header_entry->offset, level);
 }
 
 static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
 {
-  if (ibuf->rect) {
-    return BLI_ungzip_file_to_mem_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset);
-  }
-  else {
-    return BLI_ungzip_file_to_mem_at_pos(
-        ibuf->rect_float, header_entry->size_raw, file, header_entry->offset);
+  void *buf = ibuf->rect ? (void *)ibuf->rect : (void *)ibuf->rect_float;
+
+  switch (header_entry->codec) {
+    case DCACHE_CODEC_ZLIB:
+      return BLI_ungzip_file_to_mem_at_pos(
+          buf, header_entry->size_raw, file, header_entry->offset);
+#ifdef WITH_LZO
+    case DCACHE_CODEC_LZO:
+      return lzo_file_to_mem_at_pos(buf, header_entry->size_raw, file, header_entry);
+#endif
   }
+
+  /* Written by build with LZO support. */
+  return 0;
 }
 
 static void seq_disk_cache_read_header(FILE *file, DiskCacheHeader *header)
@@ -522,7 +755,7 @@ static size_t seq_disk_cache_write_header(FILE *file, DiskCacheHeader *header)
   return fwrite(header, sizeof(*header), 1, file);
 }
 
-static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCacheHeader *header)
+static int seq_disk_cache_add_header_entry(float nfra, ImBuf *ibuf, DiskCacheHeader *header)
 {
   int i;
   uint64_t offset = sizeof(*header);
@@ -554,8 +787,9 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
     header->entry[i].encoding = 0;
   }
 
+  header->entry[i].codec = seq_disk_cache_codec();
   header->entry[i].offset = offset;
-  header->entry[i].frameno = key->nfra;
+  header->entry[i].frameno = nfra;
 
   /* Store colorspace name of ibuf. */
   const char *colorspace_name;
@@ -584,11 +818,11 @@ static int seq_disk_cache_get_header_entry(SeqCacheKey *key, DiskCacheHeader *he
   return -1;
 }
 
-static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache,
+                                      char *path,
+                                      float nfra,
+                                      ImBuf *ibuf)
 {
-  char path[FILE_MAX];
-
-  seq_disk_cache_get_file_path(disk_cache, key, path, sizeof(path));
   BLI_make_existing_file(path);
 
   FILE *file = BLI_fopen(path, "rb+");
@@ -603,7 +837,7 @@ static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key
   DiskCacheHeader header;
   memset(&header, 0, sizeof(header));
   seq_disk_cache_read_header(file, &header);
-  int entry_index = seq_disk_cache_add_header_entry(key, ibuf, &header);
+  int entry_index = seq_disk_cache_add_header_entry(nfra, ibuf, &header);
   size_t bytes_written = deflate_imbuf_to_file(
       ibuf, file, seq_disk_cache_compression_level(), &header.entry[entry_index]);
 
@@ -619,9 +853,62 @@ static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key
     return true;
   }
 
+  fclose(file);
   return false;
 }
 
+static void seq_disk_cache_write_task_run(TaskPool *__restrict pool, void *taskdata)
+{
+  SeqDiskCache *disk_cache = BLI_task_pool_user_data(pool);
+  DiskCacheWriteTask *task = taskdata;
+
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  seq_disk_cache_write_file(disk_cache, task->path, task->nfra, task->ibuf);
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+  seq_disk_cache_enforce_limits(disk_cache);
+}
+
+static void seq_disk_cache_write_task_free(TaskPool *__restrict pool, void *taskdata)
+{
+  SeqDiskCache *disk_cache = BLI_task_pool_user_data(pool);
+  DiskCacheWriteTask *task = taskdata;
+
+  IMB_freeImBuf(task->ibuf);
+  MEM_freeN(task);
+
+  BLI_mutex_lock(&disk_cache->write_mutex);
+  disk_cache->num_pending_writes--;
+  BLI_condition_notify_all(&disk_cache->write_condition);
+  BLI_mutex_unlock(&disk_cache->write_mutex);
+}
+
+/* Schedule image to be written by background thread. Image is referenced until it is written. */
+static void seq_disk_cache_write_file_async(SeqDiskCache *disk_cache,
+                                            SeqCacheKey *key,
+                                            ImBuf *ibuf)
+{
+  DiskCacheWriteTask *task = MEM_mallocN(sizeof(DiskCacheWriteTask), __func__);
+  seq_disk_cache_get_file_path(disk_cache, key, task->path, sizeof(task->path));
+  task->nfra = key->nfra;
+  task->ibuf = ibuf;
+  IMB_refImBuf(ibuf);
+
+  /* Don't let rendering run too far ahead of writing, referenced images are not counted in cache
+   * memory usage. */
+  BLI_mutex_lock(&disk_cache->write_mutex);
+  while (disk_cache->num_pending_writes >= DCACHE_MAX_PENDING_WRITES) {
+    BLI_condition_wait(&disk_cache->write_condition, &disk_cache->write_mutex);
+  }
+  disk_cache->num_pending_writes++;
+  BLI_mutex_unlock(&disk_cache->write_mutex);
+
+  BLI_task_pool_push(disk_cache->write_pool,
+                     seq_disk_cache_write_task_run,
+                     task,
+                     true,
+                     seq_disk_cache_write_task_free);
+}
+
 static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
 {
   char path[FILE_MAX];
@@ -683,6 +970,8 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
 #undef DCACHE_IMAGES_PER_FILE
 #undef COLORSPACE_NAME_MAX
 #undef DCACHE_CURRENT_VERSION
+#undef DCACHE_BLOCK_SIZE
+#undef DCACHE_MAX_PENDING_WRITES
 
 static bool seq_cmp_render_data(const SeqRenderData *a, const SeqRenderData *b)
 {
@@ -1048,6 +1337,10 @@ static void seq_disk_cache_create(Main *bmain, Scene *scene)
   cache->disk_cache = MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache");
   cache->disk_cache->bmain = bmain;
   BLI_mutex_init(&cache->disk_cache->read_write_mutex);
+  BLI_mutex_init(&cache->disk_cache->write_mutex);
+  BLI_condition_init(&cache->disk_cache->write_condition);
+  cache->disk_cache->write_pool = BLI_task_pool_create_background_serial(cache->disk_cache,
+                                                                         TASK_PRIORITY_LOW);
   seq_disk_cache_handle_versioning(cache->disk_cache);
   seq_disk_cache_get_files(cache->disk_cache, seq_disk_cache_base_dir());
   cache->disk_cache->timestamp = scene->ed->disk_cache_timestamp;
@@ -1112,6 +1405,10 @@ void BKE_sequencer_cache_destruct(Scene *scene)
   BLI_mutex_end(&cache->iterator_mutex);
 
   if (cache->disk_cache != NULL) {
+    seq_disk_cache_write_wait(cache->disk_cache);
+    BLI_task_pool_free(cache->disk_cache->write_pool);
+    BLI_mutex_end(&cache->disk_cache->write_mutex);
+    BLI_condition_end(&cache->disk_cache->write_condition);
     BLI_freelistN(&cache->disk_cache->files);
     BLI_mutex_end(&cache->disk_cache->read_write_mutex);
     MEM_freeN(cache->disk_cache);
@@ -1409,10 +1706,7 @@ void BKE_sequencer_cache_put(const SeqRenderData *context,
         seq_disk_cache_create(context->bmain, context->scene);
       }
 
-      BLI_mutex_lock(&cache->disk_cache->read_write_mutex);
-      seq_disk_cache_write_file(cache->disk_cache, key, i);
-      BLI_mutex_unlock(&cache->disk_cache->read_write_mutex);
-      seq_disk_cache_enforce_limits(cache->disk_cache);
+      seq_disk_cache_write_file_async(cache->disk_cache, key, i);
     }
   }
 }
@@ -48,6 +48,7 @@
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utf8.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -3960,6 +3961,86 @@ static ImBuf *seq_render_strip_stack_apply_effect(
   return out;
 }
 
+/* Strips which don't render other strips or scenes and don't depend on global state (like fonts)
+ * can be rendered from multiple threads at once. */
+static bool seq_render_strip_is_threadsafe(Sequence *seq)
+{
+  return ELEM(seq->type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE, SEQ_TYPE_COLOR);
+}
+
+typedef struct RenderStripsTaskData {
+  const SeqRenderData *context;
+  SeqRenderState *state;
+  Sequence **seq_arr;
+  /* Index into seq_arr of each strip to render. */
+  const int *render_indices;
+  /* Rendered images, indexed same as seq_arr. */
+  ImBuf **ibufs;
+  float cfra;
+} RenderStripsTaskData;
+
+static void seq_render_strips_task(void *__restrict userdata,
+                                   const int index,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RenderStripsTaskData *data = userdata;
+  const int i = data->render_indices[index];
+
+  data->ibufs[i] = seq_render_strip(data->context, data->state, data->seq_arr[i], data->cfra);
+}
+
+/* Render strips of the stack which will be blended together. Images are decoded, transformed
+ * and preprocessed concurrently, so only blending is left to be done one strip after another.
+ * Strips are rendered in parallel only if all of them can be, otherwise no image is rendered and
+ * strips are rendered one by one when blending. */
+static void seq_render_strip_stack_prerender(const SeqRenderData *context,
+                                             SeqRenderState *state,
+                                             Sequence **seq_arr,
+                                             const int *render_indices,
+                                             int render_count,
+                                             float cfra,
+                                             ImBuf **r_ibufs)
+{
+  if (render_count < 2) {
+    return;
+  }
+
+  for (int i = 0; i < render_count; i++) {
+    if (!seq_render_strip_is_threadsafe(seq_arr[render_indices[i]])) {
+      return;
+    }
+  }
+
+  RenderStripsTaskData data = {
+      .context = context,
+      .state = state,
+      .seq_arr = seq_arr,
+      .render_indices = render_indices,
+      .ibufs = r_ibufs,
+      .cfra = cfra,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, render_count, &data, seq_render_strips_task, &settings);
+}
+
+static ImBuf *seq_render_strip_stack_get_strip(const SeqRenderData *context,
+                                               SeqRenderState *state,
+                                               Sequence **seq_arr,
+                                               ImBuf **ibufs,
+                                               int i,
+                                               float cfra)
+{
+  if (ibufs[i] != NULL) {
+    ImBuf *ibuf = ibufs[i];
+    ibufs[i] = NULL;
+    return ibuf;
+  }
+  return seq_render_strip(context, state, seq_arr[i], cfra);
+}
+
 static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      SeqRenderState *state,
                                      ListBase *seqbasep,
@@ -3967,6 +4048,9 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      int chanshown)
 {
   Sequence *seq_arr[MAXSEQ + 1];
+  ImBuf *ibufs[MAXSEQ + 1] = {NULL};
+  int render_indices[MAXSEQ + 1];
+  int render_count = 0;
   int count;
   int i;
   ImBuf *out = NULL;
@@ -3978,8 +4062,9 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     return NULL;
   }
 
+  /* Find bottom of the stack: strip which is either cached or covers all strips below it. */
+  int early_out = EARLY_NO_INPUT;
   for (i = count - 1; i >= 0; i--) {
-    int early_out;
     Sequence *seq = seq_arr[i];
 
     out = BKE_sequencer_cache_get(context, seq, cfra, SEQ_CACHE_STORE_COMPOSITE, false);
@@ -3988,42 +4073,56 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       break;
     }
     if (seq->blend_mode == SEQ_BLEND_REPLACE) {
-      out = seq_render_strip(context, state, seq, cfra);
+      early_out = EARLY_NO_INPUT;
       break;
     }
 
     early_out = seq_get_early_out_for_blend_mode(seq);
 
+    if (ELEM(early_out, EARLY_NO_INPUT, EARLY_USE_INPUT_2) || i == 0) {
+      break;
+    }
+  }
+
+  /* Collect strips which have to be rendered. */
+  if (out == NULL && early_out != EARLY_USE_INPUT_1) {
+    render_indices[render_count++] = i;
+  }
+  for (int j = i + 1; j < count; j++) {
+    if (seq_get_early_out_for_blend_mode(seq_arr[j]) == EARLY_DO_EFFECT) {
+      render_indices[render_count++] = j;
+    }
+  }
+
+  seq_render_strip_stack_prerender(
+      context, state, seq_arr, render_indices, render_count, cfra, ibufs);
+
+  if (out == NULL) {
+    Sequence *seq = seq_arr[i];
+
     switch (early_out) {
       case EARLY_NO_INPUT:
       case EARLY_USE_INPUT_2:
-        out = seq_render_strip(context, state, seq, cfra);
+        out = seq_render_strip_stack_get_strip(context, state, seq_arr, ibufs, i, cfra);
         break;
       case EARLY_USE_INPUT_1:
-        if (i == 0) {
-          out = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
-        }
+        out = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
         break;
-      case EARLY_DO_EFFECT:
-        if (i == 0) {
-          begin = seq_estimate_render_cost_begin();
+      case EARLY_DO_EFFECT: {
+        begin = seq_estimate_render_cost_begin();
 
-          ImBuf *ibuf1 = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
-          ImBuf *ibuf2 = seq_render_strip(context, state, seq, cfra);
+        ImBuf *ibuf1 = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
+        ImBuf *ibuf2 = seq_render_strip_stack_get_strip(context, state, seq_arr, ibufs, i, cfra);
 
-          out = seq_render_strip_stack_apply_effect(context, seq, cfra, ibuf1, ibuf2);
+        out = seq_render_strip_stack_apply_effect(context, seq, cfra, ibuf1, ibuf2);
 
-          float cost = seq_estimate_render_cost_end(context->scene, begin);
-          BKE_sequencer_cache_put(
-              context, seq_arr[i], cfra, SEQ_CACHE_STORE_COMPOSITE, out, cost, false);
+        float cost = seq_estimate_render_cost_end(context->scene, begin);
+        BKE_sequencer_cache_put(context, seq, cfra, SEQ_CACHE_STORE_COMPOSITE, out, cost, false);
 
-          IMB_freeImBuf(ibuf1);
-          IMB_freeImBuf(ibuf2);
-        }
+        IMB_freeImBuf(ibuf1);
+        IMB_freeImBuf(ibuf2);
         break;
-    }
-    if (out) {
-      break;
+      }
     }
   }
 
@@ -4034,7 +4133,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
 
     if (seq_get_early_out_for_blend_mode(seq) == EARLY_DO_EFFECT) {
       ImBuf *ibuf1 = out;
-      ImBuf *ibuf2 = seq_render_strip(context, state, seq, cfra);
+      ImBuf *ibuf2 = seq_render_strip_stack_get_strip(context, state, seq_arr, ibufs, i, cfra);
 
       out = seq_render_strip_stack_apply_effect(context, seq, cfra, ibuf1, ibuf2);
 
@@ -46,6 +46,11 @@
 
 static void subdiv_ccg_average_all_boundaries_and_corners(SubdivCCG *subdiv_ccg, CCGKey *key);
 
+static void subdiv_ccg_average_faces_boundaries_and_corners(SubdivCCG *subdiv_ccg,
+                                                            CCGKey *key,
+                                                            struct CCGFace **effected_faces,
+                                                            int num_effected_faces);
+
 static void subdiv_ccg_average_inner_face_grids(SubdivCCG *subdiv_ccg,
                                                 CCGKey *key,
                                                 SubdivCCGFace *face);
@@ -656,6 +661,7 @@ void BKE_subdiv_ccg_destroy(SubdivCCG *subdiv_ccg)
   }
   MEM_SAFE_FREE(subdiv_ccg->adjacent_vertices);
   MEM_SAFE_FREE(subdiv_ccg->cache_.start_face_grid_index);
+  MEM_SAFE_FREE(subdiv_ccg->dirty.grids);
   MEM_freeN(subdiv_ccg);
 }
 
@@ -889,11 +895,10 @@ void BKE_subdiv_ccg_update_normals(SubdivCCG *subdiv_ccg,
     return;
   }
   subdiv_ccg_recalc_modified_inner_grid_normals(subdiv_ccg, effected_faces, num_effected_faces);
-  /* TODO(sergey): Only average elements which are adjacent to modified
-   * faces. */
   CCGKey key;
   BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
-  subdiv_ccg_average_all_boundaries_and_corners(subdiv_ccg, &key);
+  subdiv_ccg_average_faces_boundaries_and_corners(
+      subdiv_ccg, &key, effected_faces, num_effected_faces);
 }
 
 /** \} */
@@ -1032,6 +1037,9 @@ static void subdiv_ccg_average_inner_grids_task(void *__restrict userdata_v,
 typedef struct AverageGridsBoundariesData {
   SubdivCCG *subdiv_ccg;
   CCGKey *key;
+
+  /* Indices of the adjacent edges to average, NULL to average all of them. */
+  const int *adjacent_edge_index_map;
 } AverageGridsBoundariesData;
 
 typedef struct AverageGridsBoundariesTLSData {
@@ -1079,13 +1087,16 @@ static void subdiv_ccg_average_grids_boundary(SubdivCCG *subdiv_ccg,
 }
 
 static void subdiv_ccg_average_grids_boundaries_task(void *__restrict userdata_v,
-                                                     const int adjacent_edge_index,
+                                                     const int n,
                                                      const TaskParallelTLS *__restrict tls_v)
 {
   AverageGridsBoundariesData *data = userdata_v;
   AverageGridsBoundariesTLSData *tls = tls_v->userdata_chunk;
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
   CCGKey *key = data->key;
+  const int adjacent_edge_index = data->adjacent_edge_index_map ?
+                                      data->adjacent_edge_index_map[n] :
+                                      n;
   SubdivCCGAdjacentEdge *adjacent_edge = &subdiv_ccg->adjacent_edges[adjacent_edge_index];
   subdiv_ccg_average_grids_boundary(subdiv_ccg, key, adjacent_edge, tls);
 }
@@ -1100,6 +1111,9 @@ static void subdiv_ccg_average_grids_boundaries_free(const void *__restrict UNUS
 typedef struct AverageGridsCornerData {
   SubdivCCG *subdiv_ccg;
   CCGKey *key;
+
+  /* Indices of the adjacent vertices to average, NULL to average all of them. */
+  const int *adjacent_vertex_index_map;
 } AverageGridsCornerData;
 
 static void subdiv_ccg_average_grids_corners(SubdivCCG *subdiv_ccg,
@@ -1128,45 +1142,56 @@ static void subdiv_ccg_average_grids_corners(SubdivCCG *subdiv_ccg,
 }
 
 static void subdiv_ccg_average_grids_corners_task(void *__restrict userdata_v,
-                                                  const int adjacent_vertex_index,
+                                                  const int n,
                                                   const TaskParallelTLS *__restrict UNUSED(tls_v))
 {
   AverageGridsCornerData *data = userdata_v;
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
   CCGKey *key = data->key;
+  const int adjacent_vertex_index = data->adjacent_vertex_index_map ?
+                                        data->adjacent_vertex_index_map[n] :
+                                        n;
   SubdivCCGAdjacentVertex *adjacent_vertex = &subdiv_ccg->adjacent_vertices[adjacent_vertex_index];
   subdiv_ccg_average_grids_corners(subdiv_ccg, key, adjacent_vertex);
 }
 
-static void subdiv_ccg_average_all_boundaries(SubdivCCG *subdiv_ccg, CCGKey *key)
+static void subdiv_ccg_average_boundaries(SubdivCCG *subdiv_ccg,
+                                          CCGKey *key,
+                                          const int *adjacent_edge_index_map,
+                                          const int num_adjacent_edges)
 {
   TaskParallelSettings parallel_range_settings;
   BLI_parallel_range_settings_defaults(&parallel_range_settings);
   AverageGridsBoundariesData boundaries_data = {
       .subdiv_ccg = subdiv_ccg,
       .key = key,
+      .adjacent_edge_index_map = adjacent_edge_index_map,
   };
   AverageGridsBoundariesTLSData tls_data = {NULL};
   parallel_range_settings.userdata_chunk = &tls_data;
   parallel_range_settings.userdata_chunk_size = sizeof(tls_data);
   parallel_range_settings.func_free = subdiv_ccg_average_grids_boundaries_free;
   BLI_task_parallel_range(0,
-                          subdiv_ccg->num_adjacent_edges,
+                          num_adjacent_edges,
                           &boundaries_data,
                           subdiv_ccg_average_grids_boundaries_task,
                           &parallel_range_settings);
 }
 
-static void subdiv_ccg_average_all_corners(SubdivCCG *subdiv_ccg, CCGKey *key)
+static void subdiv_ccg_average_corners(SubdivCCG *subdiv_ccg,
+                                       CCGKey *key,
+                                       const int *adjacent_vertex_index_map,
+                                       const int num_adjacent_vertices)
 {
   TaskParallelSettings parallel_range_settings;
   BLI_parallel_range_settings_defaults(&parallel_range_settings);
   AverageGridsCornerData corner_data = {
       .subdiv_ccg = subdiv_ccg,
       .key = key,
+      .adjacent_vertex_index_map = adjacent_vertex_index_map,
   };
   BLI_task_parallel_range(0,
-                          subdiv_ccg->num_adjacent_vertices,
+                          num_adjacent_vertices,
                           &corner_data,
                           subdiv_ccg_average_grids_corners_task,
                           &parallel_range_settings);
@@ -1174,8 +1199,101 @@ static void subdiv_ccg_average_all_corners(SubdivCCG *subdiv_ccg, CCGKey *key)
 
 static void subdiv_ccg_average_all_boundaries_and_corners(SubdivCCG *subdiv_ccg, CCGKey *key)
 {
-  subdiv_ccg_average_all_boundaries(subdiv_ccg, key);
-  subdiv_ccg_average_all_corners(subdiv_ccg, key);
+  subdiv_ccg_average_boundaries(subdiv_ccg, key, NULL, subdiv_ccg->num_adjacent_edges);
+  subdiv_ccg_average_corners(subdiv_ccg, key, NULL, subdiv_ccg->num_adjacent_vertices);
+}
+
+/* Gather indices of edges and vertices which are adjacent to the given faces. The arrays are
+ * allocated and are to be freed by the caller. */
+static void subdiv_ccg_affected_face_adjacency(SubdivCCG *subdiv_ccg,
+                                               struct CCGFace **effected_faces,
+                                               const int num_effected_faces,
+                                               int **r_adjacent_edges,
+                                               int *r_num_adjacent_edges,
+                                               int **r_adjacent_vertices,
+                                               int *r_num_adjacent_vertices)
+{
+  Subdiv *subdiv = subdiv_ccg->subdiv;
+  OpenSubdiv_TopologyRefiner *topology_refiner = subdiv->topology_refiner;
+  BLI_bitmap *edges_tag = BLI_BITMAP_NEW(subdiv_ccg->num_adjacent_edges, __func__);
+  BLI_bitmap *vertices_tag = BLI_BITMAP_NEW(subdiv_ccg->num_adjacent_vertices, __func__);
+  int *adjacent_edges = NULL;
+  int *adjacent_vertices = NULL;
+  int num_adjacent_edges = 0;
+  int num_adjacent_vertices = 0;
+  int adjacent_edges_len = 0;
+  int adjacent_vertices_len = 0;
+
+  StaticOrHeapIntStorage face_vertices_storage;
+  StaticOrHeapIntStorage face_edges_storage;
+  static_or_heap_storage_init(&face_vertices_storage);
+  static_or_heap_storage_init(&face_edges_storage);
+
+  for (int i = 0; i < num_effected_faces; i++) {
+    SubdivCCGFace *face = (SubdivCCGFace *)effected_faces[i];
+    const int face_index = face - subdiv_ccg->faces;
+    const int num_face_grids = face->num_grids;
+
+    /* Grow the output arrays so they can hold all the elements of this face. */
+    if (num_adjacent_edges + num_face_grids > adjacent_edges_len) {
+      adjacent_edges_len = max_ii(adjacent_edges_len * 2, num_adjacent_edges + num_face_grids);
+      adjacent_edges = MEM_reallocN(adjacent_edges, sizeof(int) * adjacent_edges_len);
+    }
+    if (num_adjacent_vertices + num_face_grids > adjacent_vertices_len) {
+      adjacent_vertices_len = max_ii(adjacent_vertices_len * 2,
+                                     num_adjacent_vertices + num_face_grids);
+      adjacent_vertices = MEM_reallocN(adjacent_vertices, sizeof(int) * adjacent_vertices_len);
+    }
+
+    int *face_vertices = static_or_heap_storage_get(&face_vertices_storage, num_face_grids);
+    topology_refiner->getFaceVertices(topology_refiner, face_index, face_vertices);
+    int *face_edges = static_or_heap_storage_get(&face_edges_storage, num_face_grids);
+    topology_refiner->getFaceEdges(topology_refiner, face_index, face_edges);
+
+    for (int corner = 0; corner < num_face_grids; corner++) {
+      const int vertex_index = face_vertices[corner];
+      if (!BLI_BITMAP_TEST(vertices_tag, vertex_index)) {
+        BLI_BITMAP_ENABLE(vertices_tag, vertex_index);
+        adjacent_vertices[num_adjacent_vertices++] = vertex_index;
+      }
+      const int edge_index = face_edges[corner];
+      if (!BLI_BITMAP_TEST(edges_tag, edge_index)) {
+        BLI_BITMAP_ENABLE(edges_tag, edge_index);
+        adjacent_edges[num_adjacent_edges++] = edge_index;
+      }
+    }
+  }
+
+  static_or_heap_storage_free(&face_vertices_storage);
+  static_or_heap_storage_free(&face_edges_storage);
+  MEM_freeN(edges_tag);
+  MEM_freeN(vertices_tag);
+
+  *r_adjacent_edges = adjacent_edges;
+  *r_num_adjacent_edges = num_adjacent_edges;
+  *r_adjacent_vertices = adjacent_vertices;
+  *r_num_adjacent_vertices = num_adjacent_vertices;
+}
+
+/* Average boundaries and corners of the given faces with their neighbors. */
+static void subdiv_ccg_average_faces_boundaries_and_corners(SubdivCCG *subdiv_ccg,
+                                                            CCGKey *key,
+                                                            struct CCGFace **effected_faces,
+                                                            int num_effected_faces)
+{
+  int *adjacent_edges, *adjacent_vertices;
+  int num_adjacent_edges, num_adjacent_vertices;
+  subdiv_ccg_affected_face_adjacency(subdiv_ccg,
+                                     effected_faces,
+                                     num_effected_faces,
+                                     &adjacent_edges,
+                                     &num_adjacent_edges,
+                                     &adjacent_vertices,
+                                     &num_adjacent_vertices);
+  subdiv_ccg_average_boundaries(subdiv_ccg, key, adjacent_edges, num_adjacent_edges);
+  subdiv_ccg_average_corners(subdiv_ccg, key, adjacent_vertices, num_adjacent_vertices);
+  MEM_SAFE_FREE(adjacent_edges);
+  MEM_SAFE_FREE(adjacent_vertices);
 }
 
 void BKE_subdiv_ccg_average_grids(SubdivCCG *subdiv_ccg)
@@ -1236,9 +1354,56 @@ void BKE_subdiv_ccg_average_stitch_faces(SubdivCCG *subdiv_ccg,
                           &data,
                           subdiv_ccg_stitch_face_inner_grids_task,
                           &parallel_range_settings);
-  /* TODO(sergey): Only average elements which are adjacent to modified
-   * faces. */
-  subdiv_ccg_average_all_boundaries_and_corners(subdiv_ccg, &key);
+  subdiv_ccg_average_faces_boundaries_and_corners(
+      subdiv_ccg, &key, effected_faces, num_effected_faces);
+}
+
+static void subdiv_ccg_tag_face_grids_modified(SubdivCCG *subdiv_ccg, const SubdivCCGFace *face)
+{
+  for (int corner = 0; corner < face->num_grids; corner++) {
+    BLI_BITMAP_ENABLE(subdiv_ccg->dirty.grids, face->start_grid_index + corner);
+  }
+}
+
+void BKE_subdiv_ccg_tag_faces_modified(SubdivCCG *subdiv_ccg,
+                                       struct CCGFace **effected_faces,
+                                       int num_effected_faces)
+{
+  if (num_effected_faces == 0) {
+    return;
+  }
+  if (subdiv_ccg->dirty.coords && subdiv_ccg->dirty.grids == NULL) {
+    /* All grids are already modified. */
+    return;
+  }
+  subdiv_ccg->dirty.coords = true;
+  if (subdiv_ccg->dirty.grids == NULL) {
+    subdiv_ccg->dirty.grids = BLI_BITMAP_NEW(subdiv_ccg->num_grids, __func__);
+  }
+  /* Boundaries and corners are averaged with all the faces sharing a vertex with the modified
+   * ones, which covers faces sharing an edge as well. */
+  int *adjacent_edges, *adjacent_vertices;
+  int num_adjacent_edges, num_adjacent_vertices;
+  subdiv_ccg_affected_face_adjacency(subdiv_ccg,
+                                     effected_faces,
+                                     num_effected_faces,
+                                     &adjacent_edges,
+                                     &num_adjacent_edges,
+                                     &adjacent_vertices,
+                                     &num_adjacent_vertices);
+  for (int i = 0; i < num_effected_faces; i++) {
+    subdiv_ccg_tag_face_grids_modified(subdiv_ccg, (SubdivCCGFace *)effected_faces[i]);
+  }
+  for (int i = 0; i < num_adjacent_vertices; i++) {
+    const SubdivCCGAdjacentVertex *adjacent_vertex =
+        &subdiv_ccg->adjacent_vertices[adjacent_vertices[i]];
+    for (int face_index = 0; face_index < adjacent_vertex->num_adjacent_faces; face_index++) {
+      const int grid_index = adjacent_vertex->corner_coords[face_index].grid_index;
+      subdiv_ccg_tag_face_grids_modified(subdiv_ccg, subdiv_ccg->grid_faces[grid_index]);
+    }
+  }
+  MEM_SAFE_FREE(adjacent_edges);
+  MEM_SAFE_FREE(adjacent_vertices);
 }
 
 void BKE_subdiv_ccg_topology_counters(const SubdivCCG *subdiv_ccg,
@@ -230,6 +230,7 @@ void BKE_subdiv_deform_coarse_vertices(struct Subdiv *subdiv,
   SubdivToMeshSettings mesh_settings;
   mesh_settings.resolution = 1;
   mesh_settings.use_optimal_display = false;
+  mesh_settings.use_topology_cache = false;
 
   /* Multi-threaded traversal/evaluation. */
   BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
@@ -23,6 +23,8 @@
 
 #include "BKE_subdiv_mesh.h"
 
+#include <string.h>
+
 #include "atomic_ops.h"
 
 #include "DNA_key_types.h"
@@ -30,10 +32,13 @@
 #include "DNA_meshdata_types.h"
 
 #include "BLI_alloca.h"
+#include "BLI_bitmap.h"
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
 
 #include "BKE_customdata.h"
 #include "BKE_key.h"
+#include "BKE_lib_id.h"
 #include "BKE_mesh.h"
 #include "BKE_subdiv.h"
 #include "BKE_subdiv_eval.h"
@@ -41,6 +46,9 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.h"
+#include "opensubdiv_evaluator_capi.h"
+
 /* -------------------------------------------------------------------- */
 /** \name Subdivision Context
  * \{ */
@@ -76,6 +84,17 @@ typedef struct SubdivMeshContext {
    * when it's not possible is when displacement is used. */
   bool can_evaluate_normals;
   bool have_displacement;
+  /* Limit surface coordinates recorded for the #SubdivMeshCache, only allocated when the cache is
+   * to be built. */
+  bool need_patch_coords;
+  OpenSubdiv_PatchCoord *vertex_patch_coords;
+  /* Every evaluation used for normals averaging, in order of the traversal. */
+  OpenSubdiv_PatchCoord *boundary_patch_coords;
+  int *boundary_vertex_indices;
+  int num_boundary_patch_coords;
+  int boundary_patch_coords_alloc;
+  /* Loose geometry is not evaluated from the limit surface, meshes with it are not cached. */
+  bool have_loose_geometry;
 } SubdivMeshContext;
 
 static void subdiv_mesh_ctx_cache_uv_layers(SubdivMeshContext *ctx)
@@ -113,10 +132,22 @@ static void subdiv_mesh_prepare_accumulator(SubdivMeshContext *ctx, int num_vert
       sizeof(*ctx->accumulated_counters), num_vertices, "subdiv accumulated counters");
 }
 
+static void subdiv_mesh_prepare_patch_coords(SubdivMeshContext *ctx, int num_vertices)
+{
+  if (!ctx->need_patch_coords) {
+    return;
+  }
+  ctx->vertex_patch_coords = MEM_malloc_arrayN(
+      num_vertices, sizeof(*ctx->vertex_patch_coords), "subdiv vertex patch coords");
+}
+
 static void subdiv_mesh_context_free(SubdivMeshContext *ctx)
 {
   MEM_SAFE_FREE(ctx->accumulated_normals);
   MEM_SAFE_FREE(ctx->accumulated_counters);
+  MEM_SAFE_FREE(ctx->vertex_patch_coords);
+  MEM_SAFE_FREE(ctx->boundary_patch_coords);
+  MEM_SAFE_FREE(ctx->boundary_vertex_indices);
 }
 
 /** \} */
@@ -504,6 +535,54 @@ static void subdiv_accumulate_vertex_normal_and_displacement(SubdivMeshContext *
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Patch coordinates recording
+ * \{ */
+
+static void subdiv_mesh_record_vertex_patch_coord(SubdivMeshContext *ctx,
+                                                  const int ptex_face_index,
+                                                  const float u,
+                                                  const float v,
+                                                  const int subdiv_vertex_index)
+{
+  if (ctx->vertex_patch_coords == NULL) {
+    return;
+  }
+  OpenSubdiv_PatchCoord *patch_coord = &ctx->vertex_patch_coords[subdiv_vertex_index];
+  patch_coord->ptex_face = ptex_face_index;
+  patch_coord->u = u;
+  patch_coord->v = v;
+}
+
+/* NOTE: Boundary vertices are traversed from a single thread. */
+static void subdiv_mesh_record_boundary_patch_coord(SubdivMeshContext *ctx,
+                                                    const int ptex_face_index,
+                                                    const float u,
+                                                    const float v,
+                                                    const int subdiv_vertex_index)
+{
+  if (ctx->vertex_patch_coords == NULL) {
+    return;
+  }
+  if (ctx->num_boundary_patch_coords == ctx->boundary_patch_coords_alloc) {
+    ctx->boundary_patch_coords_alloc = max_ii(1024, ctx->boundary_patch_coords_alloc * 2);
+    ctx->boundary_patch_coords = MEM_reallocN(
+        ctx->boundary_patch_coords,
+        sizeof(*ctx->boundary_patch_coords) * ctx->boundary_patch_coords_alloc);
+    ctx->boundary_vertex_indices = MEM_reallocN(
+        ctx->boundary_vertex_indices,
+        sizeof(*ctx->boundary_vertex_indices) * ctx->boundary_patch_coords_alloc);
+  }
+  const int index = ctx->num_boundary_patch_coords++;
+  OpenSubdiv_PatchCoord *patch_coord = &ctx->boundary_patch_coords[index];
+  patch_coord->ptex_face = ptex_face_index;
+  patch_coord->u = u;
+  patch_coord->v = v;
+  ctx->boundary_vertex_indices[index] = subdiv_vertex_index;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Callbacks
  * \{ */
@@ -524,6 +603,7 @@ static bool subdiv_mesh_topology_info(const SubdivForeachContext *foreach_contex
       subdiv_context->coarse_mesh, num_vertices, num_edges, 0, num_loops, num_polygons, mask);
   subdiv_mesh_ctx_cache_custom_data_layers(subdiv_context);
   subdiv_mesh_prepare_accumulator(subdiv_context, num_vertices);
+  subdiv_mesh_prepare_patch_coords(subdiv_context, num_vertices);
   return true;
 }
 
@@ -641,6 +721,7 @@ static void subdiv_mesh_vertex_every_corner_or_edge(const SubdivForeachContext *
   MVert *subdiv_mvert = subdiv_mesh->mvert;
   MVert *subdiv_vert = &subdiv_mvert[subdiv_vertex_index];
   subdiv_accumulate_vertex_normal_and_displacement(ctx, ptex_face_index, u, v, subdiv_vert);
+  subdiv_mesh_record_boundary_patch_coord(ctx, ptex_face_index, u, v, subdiv_vertex_index);
 }
 
 static void subdiv_mesh_vertex_every_corner(const SubdivForeachContext *foreach_context,
@@ -691,6 +772,7 @@ static void subdiv_mesh_vertex_corner(const SubdivForeachContext *foreach_contex
   MVert *subdiv_vert = &subdiv_mvert[subdiv_vertex_index];
   evaluate_vertex_and_apply_displacement_copy(
       ctx, ptex_face_index, u, v, coarse_vert, subdiv_vert);
+  subdiv_mesh_record_vertex_patch_coord(ctx, ptex_face_index, u, v, subdiv_vertex_index);
 }
 
 static void subdiv_mesh_ensure_vertex_interpolation(SubdivMeshContext *ctx,
@@ -742,6 +824,7 @@ static void subdiv_mesh_vertex_edge(const SubdivForeachContext *foreach_context,
   subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_poly, coarse_corner);
   evaluate_vertex_and_apply_displacement_interpolate(
       ctx, ptex_face_index, u, v, &tls->vertex_interpolation, subdiv_vert);
+  subdiv_mesh_record_vertex_patch_coord(ctx, ptex_face_index, u, v, subdiv_vertex_index);
 }
 
 static bool subdiv_mesh_is_center_vertex(const MPoly *coarse_poly, const float u, const float v)
@@ -792,6 +875,7 @@ static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context
   eval_final_point_and_vertex_normal(
       subdiv, ptex_face_index, u, v, subdiv_vert->co, subdiv_vert->no);
   subdiv_mesh_tag_center_vertex(coarse_poly, subdiv_vert, u, v);
+  subdiv_mesh_record_vertex_patch_coord(ctx, ptex_face_index, u, v, subdiv_vertex_index);
 }
 
 /** \} */
@@ -996,6 +1080,7 @@ static void subdiv_mesh_vertex_loose(const SubdivForeachContext *foreach_context
   MVert *subdiv_mvert = subdiv_mesh->mvert;
   MVert *subdiv_vertex = &subdiv_mvert[subdiv_vertex_index];
   subdiv_vertex_data_copy(ctx, coarse_vertex, subdiv_vertex);
+  ctx->have_loose_geometry = true;
 }
 
 /* Get neighbor edges of the given one.
@@ -1118,6 +1203,7 @@ static void subdiv_mesh_vertex_of_loose_edge(const struct SubdivForeachContext *
   Mesh *subdiv_mesh = ctx->subdiv_mesh;
   MVert *subdiv_mvert = subdiv_mesh->mvert;
   const bool is_simple = ctx->subdiv->settings.is_simple;
+  ctx->have_loose_geometry = true;
   /* Find neighbors of the current loose edge. */
   const MEdge *neighbors[2];
   find_edge_neighbors(ctx, coarse_edge, neighbors);
@@ -1185,6 +1271,319 @@ static void setup_foreach_callbacks(const SubdivMeshContext *subdiv_context,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Topology cache
+ *
+ * For as long as the topology of the coarse mesh does not change, the subdivided mesh only
+ * differs in vertex positions and normals. The first evaluation stores the subdivided mesh along
+ * with the limit surface coordinates of all its vertices, following evaluations copy the cached
+ * mesh and re-evaluate the coordinates in batches, skipping the whole traversal.
+ * \{ */
+
+/* Layers of a custom data, enough to detect layers being added or removed. */
+typedef struct SubdivMeshCacheLayout {
+  int totlayer;
+  int typemap[CD_NUMTYPES];
+} SubdivMeshCacheLayout;
+
+typedef struct SubdivMeshCache {
+  SubdivToMeshSettings settings;
+  /* Copy of the coarse mesh topology the mesh was created for. */
+  int coarse_totvert;
+  int coarse_totedge;
+  int coarse_totloop;
+  int coarse_totpoly;
+  MVert *coarse_mvert;
+  MEdge *coarse_medge;
+  MLoop *coarse_mloop;
+  MPoly *coarse_mpoly;
+  SubdivMeshCacheLayout coarse_layout[4];
+  /* Subdivided mesh, every evaluation gets its own copy. */
+  Mesh *mesh;
+  /* Limit surface coordinate of every subdivided vertex. */
+  OpenSubdiv_PatchCoord *vertex_patch_coords;
+  /* Vertices on boundaries of ptex faces, their normal is averaged from all the ptex faces they
+   * belong to. Coordinates of the boundary vertex `i` are in the range
+   * `[boundary_offsets[i], boundary_offsets[i + 1])` of the boundary patch coordinates. */
+  int num_boundary_vertices;
+  int *boundary_vertices;
+  int *boundary_offsets;
+  OpenSubdiv_PatchCoord *boundary_patch_coords;
+  BLI_bitmap *boundary_vertices_map;
+} SubdivMeshCache;
+
+/* Number of vertices evaluated by a single task. */
+#define SUBDIV_MESH_CACHE_CHUNK_SIZE 1024
+
+static void subdiv_mesh_cache_layout_init(SubdivMeshCacheLayout *layout, const CustomData *data)
+{
+  layout->totlayer = data->totlayer;
+  memcpy(layout->typemap, data->typemap, sizeof(layout->typemap));
+}
+
+static bool subdiv_mesh_cache_layout_equal(const SubdivMeshCacheLayout *layout,
+                                           const CustomData *data)
+{
+  return layout->totlayer == data->totlayer &&
+         memcmp(layout->typemap, data->typemap, sizeof(layout->typemap)) == 0;
+}
+
+static bool subdiv_mesh_cache_is_valid(const SubdivMeshCache *cache,
+                                       const SubdivToMeshSettings *settings,
+                                       const Mesh *coarse_mesh)
+{
+  if (cache->settings.resolution != settings->resolution ||
+      cache->settings.use_optimal_display != settings->use_optimal_display) {
+    return false;
+  }
+  if (cache->coarse_totvert != coarse_mesh->totvert ||
+      cache->coarse_totedge != coarse_mesh->totedge ||
+      cache->coarse_totloop != coarse_mesh->totloop ||
+      cache->coarse_totpoly != coarse_mesh->totpoly) {
+    return false;
+  }
+  if (!subdiv_mesh_cache_layout_equal(&cache->coarse_layout[0], &coarse_mesh->vdata) ||
+      !subdiv_mesh_cache_layout_equal(&cache->coarse_layout[1], &coarse_mesh->edata) ||
+      !subdiv_mesh_cache_layout_equal(&cache->coarse_layout[2], &coarse_mesh->ldata) ||
+      !subdiv_mesh_cache_layout_equal(&cache->coarse_layout[3], &coarse_mesh->pdata)) {
+    return false;
+  }
+  /* Positions and normals are allowed to change, everything else is copied from the cache. */
+  for (int i = 0; i < coarse_mesh->totvert; i++) {
+    const MVert *cache_vert = &cache->coarse_mvert[i];
+    const MVert *coarse_vert = &coarse_mesh->mvert[i];
+    if (cache_vert->flag != coarse_vert->flag || cache_vert->bweight != coarse_vert->bweight) {
+      return false;
+    }
+  }
+  return memcmp(cache->coarse_medge, coarse_mesh->medge, sizeof(MEdge) * coarse_mesh->totedge) ==
+             0 &&
+         memcmp(cache->coarse_mloop, coarse_mesh->mloop, sizeof(MLoop) * coarse_mesh->totloop) ==
+             0 &&
+         memcmp(cache->coarse_mpoly, coarse_mesh->mpoly, sizeof(MPoly) * coarse_mesh->totpoly) ==
+             0;
+}
+
+/* Sort the recorded boundary coordinates by vertex, keeping the traversal order of every vertex
+ * so normals are accumulated in the same order as in the traversal. */
+static void subdiv_mesh_cache_boundary_init(SubdivMeshCache *cache,
+                                            const SubdivMeshContext *ctx,
+                                            const int num_vertices)
+{
+  const int num_coords = ctx->num_boundary_patch_coords;
+  int *vertex_counters = MEM_calloc_arrayN(num_vertices, sizeof(int), __func__);
+  for (int i = 0; i < num_coords; i++) {
+    vertex_counters[ctx->boundary_vertex_indices[i]]++;
+  }
+  int num_boundary_vertices = 0;
+  for (int i = 0; i < num_vertices; i++) {
+    if (vertex_counters[i] != 0) {
+      num_boundary_vertices++;
+    }
+  }
+  cache->num_boundary_vertices = num_boundary_vertices;
+  cache->boundary_vertices = MEM_malloc_arrayN(
+      num_boundary_vertices, sizeof(int), "subdiv cache boundary vertices");
+  cache->boundary_offsets = MEM_malloc_arrayN(
+      num_boundary_vertices + 1, sizeof(int), "subdiv cache boundary offsets");
+  cache->boundary_patch_coords = MEM_malloc_arrayN(
+      num_coords, sizeof(OpenSubdiv_PatchCoord), "subdiv cache boundary patch coords");
+  cache->boundary_vertices_map = BLI_BITMAP_NEW(num_vertices, "subdiv cache boundary map");
+  /* Turn the counters into offsets of the vertices. */
+  int offset = 0;
+  for (int i = 0, boundary_index = 0; i < num_vertices; i++) {
+    if (vertex_counters[i] == 0) {
+      continue;
+    }
+    cache->boundary_vertices[boundary_index] = i;
+    cache->boundary_offsets[boundary_index] = offset;
+    BLI_BITMAP_ENABLE(cache->boundary_vertices_map, i);
+    const int count = vertex_counters[i];
+    vertex_counters[i] = offset;
+    offset += count;
+    boundary_index++;
+  }
+  cache->boundary_offsets[num_boundary_vertices] = offset;
+  for (int i = 0; i < num_coords; i++) {
+    const int vertex_index = ctx->boundary_vertex_indices[i];
+    cache->boundary_patch_coords[vertex_counters[vertex_index]++] = ctx->boundary_patch_coords[i];
+  }
+  MEM_freeN(vertex_counters);
+}
+
+static void subdiv_mesh_cache_create(Subdiv *subdiv,
+                                     SubdivMeshContext *ctx,
+                                     const SubdivToMeshSettings *settings,
+                                     const Mesh *coarse_mesh,
+                                     Mesh *subdiv_mesh)
+{
+  SubdivMeshCache *cache = MEM_callocN(sizeof(SubdivMeshCache), "subdiv mesh cache");
+  cache->settings = *settings;
+  cache->coarse_totvert = coarse_mesh->totvert;
+  cache->coarse_totedge = coarse_mesh->totedge;
+  cache->coarse_totloop = coarse_mesh->totloop;
+  cache->coarse_totpoly = coarse_mesh->totpoly;
+  cache->coarse_mvert = MEM_dupallocN(coarse_mesh->mvert);
+  cache->coarse_medge = MEM_dupallocN(coarse_mesh->medge);
+  cache->coarse_mloop = MEM_dupallocN(coarse_mesh->mloop);
+  cache->coarse_mpoly = MEM_dupallocN(coarse_mesh->mpoly);
+  subdiv_mesh_cache_layout_init(&cache->coarse_layout[0], &coarse_mesh->vdata);
+  subdiv_mesh_cache_layout_init(&cache->coarse_layout[1], &coarse_mesh->edata);
+  subdiv_mesh_cache_layout_init(&cache->coarse_layout[2], &coarse_mesh->ldata);
+  subdiv_mesh_cache_layout_init(&cache->coarse_layout[3], &coarse_mesh->pdata);
+  cache->mesh = BKE_mesh_copy_for_eval(subdiv_mesh, false);
+  /* Ownership of the vertex coordinates is moved to the cache. */
+  cache->vertex_patch_coords = ctx->vertex_patch_coords;
+  ctx->vertex_patch_coords = NULL;
+  subdiv_mesh_cache_boundary_init(cache, ctx, subdiv_mesh->totvert);
+  subdiv->cache_.mesh = cache;
+}
+
+void BKE_subdiv_to_mesh_cache_free(Subdiv *subdiv)
+{
+  SubdivMeshCache *cache = subdiv->cache_.mesh;
+  if (cache == NULL) {
+    return;
+  }
+  MEM_SAFE_FREE(cache->coarse_mvert);
+  MEM_SAFE_FREE(cache->coarse_medge);
+  MEM_SAFE_FREE(cache->coarse_mloop);
+  MEM_SAFE_FREE(cache->coarse_mpoly);
+  BKE_id_free(NULL, cache->mesh);
+  MEM_freeN(cache->vertex_patch_coords);
+  MEM_freeN(cache->boundary_vertices);
+  MEM_freeN(cache->boundary_offsets);
+  MEM_freeN(cache->boundary_patch_coords);
+  MEM_freeN(cache->boundary_vertices_map);
+  MEM_freeN(cache);
+  subdiv->cache_.mesh = NULL;
+}
+
+typedef struct SubdivMeshCacheEvalData {
+  Subdiv *subdiv;
+  const SubdivMeshCache *cache;
+  MVert *mvert;
+} SubdivMeshCacheEvalData;
+
+static void subdiv_mesh_cache_eval_limit_derivatives(Subdiv *subdiv,
+                                                     const OpenSubdiv_PatchCoord *patch_coord,
+                                                     float r_P[3],
+                                                     float r_dPdu[3],
+                                                     float r_dPdv[3])
+{
+  /* Same fallback for zero derivatives as in the single point evaluation. */
+  if (is_zero_v3(r_dPdu) || is_zero_v3(r_dPdv)) {
+    BKE_subdiv_eval_limit_point_and_derivatives(
+        subdiv, patch_coord->ptex_face, patch_coord->u, patch_coord->v, r_P, r_dPdu, r_dPdv);
+  }
+}
+
+static void subdiv_mesh_cache_eval_vertices_cb(void *__restrict userdata,
+                                               const int chunk_index,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SubdivMeshCacheEvalData *data = userdata;
+  Subdiv *subdiv = data->subdiv;
+  const SubdivMeshCache *cache = data->cache;
+  const int start = chunk_index * SUBDIV_MESH_CACHE_CHUNK_SIZE;
+  const int num = min_ii(SUBDIV_MESH_CACHE_CHUNK_SIZE, cache->mesh->totvert - start);
+  const OpenSubdiv_PatchCoord *patch_coords = &cache->vertex_patch_coords[start];
+  float(*P)[3] = MEM_malloc_arrayN(num, sizeof(*P), __func__);
+  float(*dPdu)[3] = MEM_malloc_arrayN(num, sizeof(*dPdu), __func__);
+  float(*dPdv)[3] = MEM_malloc_arrayN(num, sizeof(*dPdv), __func__);
+  subdiv->evaluator->evaluatePatchesLimit(
+      subdiv->evaluator, patch_coords, num, &P[0][0], &dPdu[0][0], &dPdv[0][0]);
+  for (int i = 0; i < num; i++) {
+    MVert *subdiv_vert = &data->mvert[start + i];
+    if (BLI_BITMAP_TEST(cache->boundary_vertices_map, start + i)) {
+      /* Normal is averaged from all the ptex faces of the vertex. */
+      copy_v3_v3(subdiv_vert->co, P[i]);
+      continue;
+    }
+    subdiv_mesh_cache_eval_limit_derivatives(subdiv, &patch_coords[i], P[i], dPdu[i], dPdv[i]);
+    copy_v3_v3(subdiv_vert->co, P[i]);
+    float N[3];
+    cross_v3_v3v3(N, dPdu[i], dPdv[i]);
+    normalize_v3(N);
+    normal_float_to_short_v3(subdiv_vert->no, N);
+  }
+  MEM_freeN(P);
+  MEM_freeN(dPdu);
+  MEM_freeN(dPdv);
+}
+
+static void subdiv_mesh_cache_eval_boundary_normals_cb(void *__restrict userdata,
+                                                       const int chunk_index,
+                                                       const TaskParallelTLS *__restrict
+                                                           UNUSED(tls))
+{
+  const SubdivMeshCacheEvalData *data = userdata;
+  Subdiv *subdiv = data->subdiv;
+  const SubdivMeshCache *cache = data->cache;
+  const int start = chunk_index * SUBDIV_MESH_CACHE_CHUNK_SIZE;
+  const int num = min_ii(SUBDIV_MESH_CACHE_CHUNK_SIZE, cache->num_boundary_vertices - start);
+  const int coords_start = cache->boundary_offsets[start];
+  const int num_coords = cache->boundary_offsets[start + num] - coords_start;
+  const OpenSubdiv_PatchCoord *patch_coords = &cache->boundary_patch_coords[coords_start];
+  float(*P)[3] = MEM_malloc_arrayN(num_coords, sizeof(*P), __func__);
+  float(*dPdu)[3] = MEM_malloc_arrayN(num_coords, sizeof(*dPdu), __func__);
+  float(*dPdv)[3] = MEM_malloc_arrayN(num_coords, sizeof(*dPdv), __func__);
+  subdiv->evaluator->evaluatePatchesLimit(
+      subdiv->evaluator, patch_coords, num_coords, &P[0][0], &dPdu[0][0], &dPdv[0][0]);
+  for (int i = 0; i < num; i++) {
+    const int boundary_index = start + i;
+    float N_accumulated[3] = {0.0f, 0.0f, 0.0f};
+    for (int j = cache->boundary_offsets[boundary_index] - coords_start;
+         j < cache->boundary_offsets[boundary_index + 1] - coords_start;
+         j++) {
+      subdiv_mesh_cache_eval_limit_derivatives(subdiv, &patch_coords[j], P[j], dPdu[j], dPdv[j]);
+      float N[3];
+      cross_v3_v3v3(N, dPdu[j], dPdv[j]);
+      normalize_v3(N);
+      add_v3_v3(N_accumulated, N);
+    }
+    normalize_v3(N_accumulated);
+    MVert *subdiv_vert = &data->mvert[cache->boundary_vertices[boundary_index]];
+    normal_float_to_short_v3(subdiv_vert->no, N_accumulated);
+  }
+  MEM_freeN(P);
+  MEM_freeN(dPdu);
+  MEM_freeN(dPdv);
+}
+
+static int subdiv_mesh_cache_num_chunks(const int num)
+{
+  return (num + SUBDIV_MESH_CACHE_CHUNK_SIZE - 1) / SUBDIV_MESH_CACHE_CHUNK_SIZE;
+}
+
+static Mesh *subdiv_mesh_from_cache(Subdiv *subdiv)
+{
+  const SubdivMeshCache *cache = subdiv->cache_.mesh;
+  Mesh *result = BKE_mesh_copy_for_eval(cache->mesh, false);
+
+  SubdivMeshCacheEvalData data;
+  data.subdiv = subdiv;
+  data.cache = cache;
+  data.mvert = result->mvert;
+
+  TaskParallelSettings parallel_range_settings;
+  BLI_parallel_range_settings_defaults(&parallel_range_settings);
+  parallel_range_settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0,
+                          subdiv_mesh_cache_num_chunks(result->totvert),
+                          &data,
+                          subdiv_mesh_cache_eval_vertices_cb,
+                          &parallel_range_settings);
+  BLI_task_parallel_range(0,
+                          subdiv_mesh_cache_num_chunks(cache->num_boundary_vertices),
+                          &data,
+                          subdiv_mesh_cache_eval_boundary_normals_cb,
+                          &parallel_range_settings);
+  return result;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Public entry point
  * \{ */
@@ -1196,7 +1595,8 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
   /* Make sure evaluator is up to date with possible new topology, and that
    * it is refined for the new positions of coarse vertices. */
-  if (!BKE_subdiv_eval_begin_from_mesh(subdiv, coarse_mesh, NULL)) {
+  const bool have_evaluator = BKE_subdiv_eval_begin_from_mesh(subdiv, coarse_mesh, NULL);
+  if (!have_evaluator) {
     /* This could happen in two situations:
      * - OpenSubdiv is disabled.
      * - Something totally bad happened, and OpenSubdiv rejected our
@@ -1207,6 +1607,18 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
       return NULL;
     }
   }
+  /* Only positions and normals need to be evaluated when the topology did not change. */
+  const bool use_topology_cache = settings->use_topology_cache && have_evaluator &&
+                                  subdiv->displacement_evaluator == NULL;
+  if (use_topology_cache && subdiv->cache_.mesh != NULL &&
+      subdiv_mesh_cache_is_valid(subdiv->cache_.mesh, settings, coarse_mesh)) {
+    BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
+    Mesh *result = subdiv_mesh_from_cache(subdiv);
+    BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
+    BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
+    return result;
+  }
+  BKE_subdiv_to_mesh_cache_free(subdiv);
   /* Initialize subdivion mesh creation context. */
   SubdivMeshContext subdiv_context = {0};
   subdiv_context.settings = settings;
@@ -1214,6 +1626,7 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   subdiv_context.subdiv = subdiv;
   subdiv_context.have_displacement = (subdiv->displacement_evaluator != NULL);
   subdiv_context.can_evaluate_normals = !subdiv_context.have_displacement;
+  subdiv_context.need_patch_coords = use_topology_cache;
   /* Multi-threaded traversal/evaluation. */
   BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
   SubdivForeachContext foreach_context;
@@ -1230,6 +1643,9 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   if (!subdiv_context.can_evaluate_normals) {
     result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
   }
+  if (use_topology_cache && !subdiv_context.have_loose_geometry) {
+    subdiv_mesh_cache_create(subdiv, &subdiv_context, settings, coarse_mesh, result);
+  }
   /* Free used memory. */
   subdiv_mesh_context_free(&subdiv_context);
   return result;
@@ -0,0 +1,169 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_subdiv.h"
+#include "BKE_subdiv_mesh.h"
+}
+
+namespace blender::bke::tests {
+
+static Mesh *subdiv_test_cube_mesh()
+{
+  static const int face_verts[6][4] = {
+      {0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}};
+
+  Mesh *mesh = BKE_mesh_new_nomain(8, 0, 0, 24, 6);
+  for (int i = 0; i < 8; i++) {
+    for (int axis = 0; axis < 3; axis++) {
+      mesh->mvert[i].co[axis] = (i & (1 << axis)) ? 1.0f : -1.0f;
+    }
+  }
+  for (int i = 0; i < 6; i++) {
+    mesh->mpoly[i].loopstart = i * 4;
+    mesh->mpoly[i].totloop = 4;
+    for (int j = 0; j < 4; j++) {
+      mesh->mloop[i * 4 + j].v = face_verts[i][j];
+    }
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  BKE_mesh_calc_normals(mesh);
+  return mesh;
+}
+
+static void subdiv_test_settings_init(SubdivSettings *settings)
+{
+  memset(settings, 0, sizeof(*settings));
+  settings->is_adaptive = true;
+  settings->level = 3;
+  settings->vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
+  settings->fvar_linear_interpolation = SUBDIV_FVAR_LINEAR_INTERPOLATION_BOUNDARIES;
+}
+
+static void subdiv_test_mesh_settings_init(SubdivToMeshSettings *mesh_settings,
+                                           const bool use_topology_cache)
+{
+  mesh_settings->resolution = (1 << 2) + 1;
+  mesh_settings->use_optimal_display = false;
+  mesh_settings->use_topology_cache = use_topology_cache;
+}
+
+/* Subdivide without the topology cache, from a new descriptor. */
+static Mesh *subdiv_test_to_mesh_fresh(const Mesh *coarse_mesh)
+{
+  SubdivSettings settings;
+  subdiv_test_settings_init(&settings);
+  SubdivToMeshSettings mesh_settings;
+  subdiv_test_mesh_settings_init(&mesh_settings, false);
+
+  Subdiv *subdiv = BKE_subdiv_new_from_mesh(&settings, coarse_mesh);
+  Mesh *result = BKE_subdiv_to_mesh(subdiv, &mesh_settings, coarse_mesh);
+  BKE_subdiv_free(subdiv);
+  return result;
+}
+
+static void subdiv_test_expect_mesh_eq(const Mesh *a, const Mesh *b)
+{
+  ASSERT_EQ(a->totvert, b->totvert);
+  ASSERT_EQ(a->totedge, b->totedge);
+  ASSERT_EQ(a->totloop, b->totloop);
+  ASSERT_EQ(a->totpoly, b->totpoly);
+  for (int i = 0; i < a->totvert; i++) {
+    for (int axis = 0; axis < 3; axis++) {
+      EXPECT_NEAR(a->mvert[i].co[axis], b->mvert[i].co[axis], 1e-5f);
+      EXPECT_NEAR(a->mvert[i].no[axis], b->mvert[i].no[axis], 2);
+    }
+  }
+  EXPECT_EQ(memcmp(a->medge, b->medge, sizeof(MEdge) * a->totedge), 0);
+  EXPECT_EQ(memcmp(a->mloop, b->mloop, sizeof(MLoop) * a->totloop), 0);
+  EXPECT_EQ(memcmp(a->mpoly, b->mpoly, sizeof(MPoly) * a->totpoly), 0);
+}
+
+/* Subdivide like the modifier does, re-using the descriptor, and compare against a fresh
+ * evaluation. */
+static void subdiv_test_to_mesh_cached(Subdiv **subdiv, const Mesh *coarse_mesh)
+{
+  SubdivSettings settings;
+  subdiv_test_settings_init(&settings);
+  SubdivToMeshSettings mesh_settings;
+  subdiv_test_mesh_settings_init(&mesh_settings, true);
+
+  *subdiv = BKE_subdiv_update_from_mesh(*subdiv, &settings, coarse_mesh);
+  Mesh *result = BKE_subdiv_to_mesh(*subdiv, &mesh_settings, coarse_mesh);
+  ASSERT_NE(result, nullptr);
+  EXPECT_NE((*subdiv)->cache_.mesh, nullptr);
+
+  Mesh *expected = subdiv_test_to_mesh_fresh(coarse_mesh);
+  subdiv_test_expect_mesh_eq(result, expected);
+
+  BKE_id_free(nullptr, expected);
+  BKE_id_free(nullptr, result);
+}
+
+TEST(subdiv_mesh, TopologyCache)
+{
+  BLI_threadapi_init();
+  BKE_idtype_init();
+
+  Mesh *coarse_mesh = subdiv_test_cube_mesh();
+  Subdiv *subdiv = NULL;
+
+  /* Creates the cache. */
+  subdiv_test_to_mesh_cached(&subdiv, coarse_mesh);
+
+  /* Cache hit, only positions changed. */
+  const Subdiv *subdiv_prev = subdiv;
+  const SubdivMeshCache *cache_prev = subdiv->cache_.mesh;
+  add_v3_fl(coarse_mesh->mvert[0].co, 0.5f);
+  BKE_mesh_calc_normals(coarse_mesh);
+  subdiv_test_to_mesh_cached(&subdiv, coarse_mesh);
+  EXPECT_EQ(subdiv, subdiv_prev);
+  EXPECT_EQ(subdiv->cache_.mesh, cache_prev);
+
+  /* Data copied from the cache changed. */
+  coarse_mesh->mpoly[2].mat_nr = 1;
+  subdiv_test_to_mesh_cached(&subdiv, coarse_mesh);
+
+  /* Topology changed: same number of elements, but the corners of a face are rotated. */
+  MLoop *ml = &coarse_mesh->mloop[coarse_mesh->mpoly[0].loopstart];
+  const MLoop ml_first = ml[0];
+  memmove(ml, ml + 1, sizeof(MLoop) * 3);
+  ml[3] = ml_first;
+  subdiv_test_to_mesh_cached(&subdiv, coarse_mesh);
+
+  BKE_subdiv_free(subdiv);
+  BKE_id_free(nullptr, coarse_mesh);
+  BLI_threadapi_exit();
+}
+
+}  // namespace blender::bke::tests
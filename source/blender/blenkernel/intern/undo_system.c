@@ -154,6 +154,11 @@ static void undosys_id_ref_resolve(void *user_data, UndoRefID *id_ref)
 static bool undosys_step_encode(bContext *C, Main *bmain, UndoStack *ustack, UndoStep *us)
 {
   CLOG_INFO(&LOG, 2, "addr=%p, name='%s', type='%s'", us, us->name, us->type->name);
+  if (us->type != BKE_UNDOSYS_TYPE_MEMFILE) {
+    /* Other undo systems change data without tagging it, the next memfile step must write all
+     * data-blocks. */
+    bmain->is_memfile_undo_id_reuse_valid = false;
+  }
   UNDO_NESTED_CHECK_BEGIN;
   bool ok = us->type->step_encode(C, bmain, us);
   UNDO_NESTED_CHECK_END;
@@ -206,6 +211,8 @@ static void undosys_step_decode(
     us->type->step_foreach_ID_ref(us, undosys_id_ref_resolve, bmain);
   }
 
+  /* Decoding changes data without tagging it (a memfile step reads a new main anyway). */
+  bmain->is_memfile_undo_id_reuse_valid = false;
   UNDO_NESTED_CHECK_BEGIN;
   us->type->step_decode(C, bmain, us, dir, is_final);
   UNDO_NESTED_CHECK_END;
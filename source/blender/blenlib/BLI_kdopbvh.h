@@ -233,6 +233,23 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
                               BVHTree_RayCastCallback callback,
                               void *userdata);
 
+void BLI_bvhtree_find_nearest_batch(BVHTree *tree,
+                                    const float (*co)[3],
+                                    BVHTreeNearest *nearest,
+                                    const int co_num,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    int flag);
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                float radius,
+                                BVHTreeRayHit *hit,
+                                const int ray_num,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag);
+
 float BLI_bvhtree_bb_raycast(const float bv[6],
                              const float light_start[3],
                              const float light_end[3],
@@ -0,0 +1,143 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BLI_SHARDED_EDGE_SET_HH__
+#define __BLI_SHARDED_EDGE_SET_HH__
+
+/** \file
+ * \ingroup bli
+ *
+ * A set of undirected edges that is split into a fixed number of shards. Every edge belongs to
+ * exactly one shard, which is determined by its hash. Different shards can be filled by different
+ * threads without any locking, as long as each thread only adds the edges belonging to its shard.
+ *
+ * Every shard keeps the edges in insertion order, so when the shards are filled in a
+ * deterministic order, the index of every edge is deterministic as well. This does not depend on
+ * the number of threads, only on the number of shards.
+ */
+
+#include "BLI_array.hh"
+#include "BLI_vector_set.hh"
+
+namespace blender {
+
+/**
+ * An undirected edge, the vertex indices are stored in ascending order.
+ */
+struct OrderedEdge {
+  uint v_low;
+  uint v_high;
+
+  OrderedEdge(const uint v1, const uint v2)
+  {
+    if (v1 < v2) {
+      v_low = v1;
+      v_high = v2;
+    }
+    else {
+      v_low = v2;
+      v_high = v1;
+    }
+  }
+
+  uint32_t hash() const
+  {
+    return (v_low * 0x9E3779B1u) ^ (v_high * 0x85EBCA6Bu);
+  }
+
+  friend bool operator==(const OrderedEdge &a, const OrderedEdge &b)
+  {
+    return a.v_low == b.v_low && a.v_high == b.v_high;
+  }
+};
+
+class ShardedEdgeSet {
+ public:
+  using Shard = VectorSet<OrderedEdge>;
+
+  /* The shard is taken from the upper bits of the hash, the lower bits are used by the shards. */
+  static constexpr uint MAX_SHARDS = 256;
+
+ private:
+  Array<Shard> shards_;
+  Array<uint> shard_offsets_;
+  uint shard_mask_;
+
+ public:
+  /**
+   * The number of shards has to be a power of two.
+   */
+  ShardedEdgeSet(const uint shards_num)
+      : shards_(shards_num), shard_offsets_(shards_num + 1, 0), shard_mask_(shards_num - 1)
+  {
+    BLI_assert(shards_num > 0 && shards_num <= MAX_SHARDS);
+    BLI_assert((shards_num & shard_mask_) == 0);
+  }
+
+  uint shards_num() const
+  {
+    return shards_.size();
+  }
+
+  uint shard_index(const OrderedEdge &edge) const
+  {
+    return (edge.hash() >> 24) & shard_mask_;
+  }
+
+  Shard &shard(const uint shard_index)
+  {
+    return shards_[shard_index];
+  }
+
+  const Shard &shard(const uint shard_index) const
+  {
+    return shards_[shard_index];
+  }
+
+  /**
+   * Must be called after all edges have been added and before #index_of and #size are used.
+   * Edges get indices in the order of the shards, followed by their order within the shard.
+   */
+  void update_offsets()
+  {
+    for (uint i = 0; i < shards_.size(); i++) {
+      shard_offsets_[i + 1] = shard_offsets_[i] + shards_[i].size();
+    }
+  }
+
+  uint shard_offset(const uint shard_index) const
+  {
+    return shard_offsets_[shard_index];
+  }
+
+  uint size() const
+  {
+    return shard_offsets_[shards_.size()];
+  }
+
+  /**
+   * Get the index of an edge that is in the set. This is thread-safe when no edges are added.
+   */
+  uint index_of(const OrderedEdge &edge) const
+  {
+    const uint shard_index = this->shard_index(edge);
+    return shard_offsets_[shard_index] + shards_[shard_index].index_of(edge);
+  }
+};
+
+}  // namespace blender
+
+#endif /* __BLI_SHARDED_EDGE_SET_HH__ */
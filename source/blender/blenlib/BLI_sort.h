@@ -40,4 +40,15 @@ void BLI_qsort_r(void *a, size_t n, size_t es, BLI_sort_cmp_t cmp, void *thunk)
 #endif
     ;
 
+/* Stable parallel sorting of large arrays (sort_parallel.c). */
+void BLI_radix_sort_uint(unsigned int *keys, unsigned int *values, size_t len);
+void BLI_radix_sort_int(int *keys, unsigned int *values, size_t len);
+void BLI_radix_sort_float(float *keys, unsigned int *values, size_t len);
+
+void BLI_merge_sort_r(void *a, size_t n, size_t es, BLI_sort_cmp_t cmp, void *thunk)
+#ifdef __GNUC__
+    __attribute__((nonnull(1, 4)))
+#endif
+    ;
+
 #endif /* __BLI_SORT_H__ */
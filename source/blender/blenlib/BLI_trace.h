@@ -0,0 +1,60 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BLI_TRACE_H__
+#define __BLI_TRACE_H__
+
+/** \file
+ * \ingroup bli
+ *
+ * Trace profiler, records nested scopes of all threads on a single timeline and writes them
+ * as Chrome trace JSON, which can be opened in `chrome://tracing` or Perfetto.
+ *
+ * Each thread records into its own ring buffer without locking, only a shared counter of
+ * recording threads is updated. When tracing is disabled the scope functions return
+ * immediately, so markers can be left in hot code paths.
+ *
+ * \code{.c}
+ * BLI_trace_scope_begin_fmt("Modifier %s", md->name);
+ * ...
+ * BLI_trace_scope_end();
+ * \endcode
+ */
+
+#include "BLI_compiler_attrs.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Start recording, the trace is written to `filepath` by #BLI_trace_end. */
+void BLI_trace_begin(const char *filepath) ATTR_NONNULL();
+/* Stop recording, wait for threads still recording an event and write the trace file.
+ * The per-thread buffers are freed afterwards. */
+bool BLI_trace_end(void);
+bool BLI_trace_is_enabled(void);
+
+/* Scopes must be ended in the thread they were started in, names are copied. */
+void BLI_trace_scope_begin(const char *name) ATTR_NONNULL();
+void BLI_trace_scope_begin_fmt(const char *format, ...) ATTR_NONNULL(1) ATTR_PRINTF_FORMAT(1, 2);
+void BLI_trace_scope_end(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_TRACE_H__ */
@@ -20,8 +20,15 @@
 /** \file
  * \ingroup bli
  *
- * A general (pointer -> pointer) chaining hash table
+ * A general (pointer -> pointer) open addressing hash table
  * for 'Abstract Data Types' (known as an ADT Hash Table).
+ *
+ * Entries are allocated from a memory pool and never move, so pointers returned by the API
+ * (see #BLI_ghash_lookup_p & #BLI_ghash_ensure_p) stay valid while the table grows.
+ * The table itself only stores the full hash and a pointer to the entry for each slot,
+ * as separate arrays, so probing compares cached hashes and only accesses an entry
+ * (and calls the comparison callback) when the hashes match.
+ * Cached hashes also mean resizing never calls the hash callback.
  */
 
 #include <limits.h>
@@ -32,6 +39,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_mempool.h"
+#include "BLI_probing_strategies.hh"
 #include "BLI_sys_types.h" /* for intptr_t support */
 #include "BLI_utildefines.h"
 
@@ -45,44 +53,42 @@
 /** \name Structs & Constants
  * \{ */
 
-#define GHASH_USE_MODULO_BUCKETS
-
 /**
  * Next prime after `2^n` (skipping 2 & 3).
  *
- * \note Also used by: `BLI_edgehash` & `BLI_smallhash`.
+ * \note No longer used by GHash itself, but still used by: `BLI_edgehash` & `BLI_smallhash`.
  */
-extern const uint BLI_ghash_hash_sizes[]; /* Quiet warning, this is only used by smallhash.c */
+extern "C" const uint BLI_ghash_hash_sizes[]; /* Quiet warning, this is only used by smallhash.c */
 const uint BLI_ghash_hash_sizes[] = {
     5,       11,      17,      37,      67,       131,      257,      521,       1031,
     2053,    4099,    8209,    16411,   32771,    65537,    131101,   262147,    524309,
     1048583, 2097169, 4194319, 8388617, 16777259, 33554467, 67108879, 134217757, 268435459,
 };
-#define hashsizes BLI_ghash_hash_sizes
 
-#ifdef GHASH_USE_MODULO_BUCKETS
-#  define GHASH_MAX_SIZE 27
-BLI_STATIC_ASSERT(ARRAY_SIZE(hashsizes) == GHASH_MAX_SIZE, "Invalid 'hashsizes' size");
-#else
-#  define GHASH_BUCKET_BIT_MIN 2
-#  define GHASH_BUCKET_BIT_MAX 28 /* About 268M of buckets... */
-#endif
+#define GHASH_SLOT_BIT_MIN 3
+#define GHASH_SLOT_BIT_MAX 30 /* About 1G of slots... */
 
 /**
- * \note Max load #GHASH_LIMIT_GROW used to be 3. (pre 2.74).
- * Python uses 0.6666, tommyhashlib even goes down to 0.5.
- * Reducing our from 3 to 0.75 gives huge speedup
- * (about twice quicker pure GHash insertions/lookup,
- * about 25% - 30% quicker 'dynamic-topology' stroke drawing e.g.).
+ * \note Open addressing needs a lower max load than chaining did (chained buckets used 0.75),
+ * removed entries keep occupying their slot until the next resize and count towards it too.
  * Min load #GHASH_LIMIT_SHRINK is a quarter of max load, to avoid resizing to quickly.
  */
-#define GHASH_LIMIT_GROW(_nbkt) (((_nbkt)*3) / 4)
-#define GHASH_LIMIT_SHRINK(_nbkt) (((_nbkt)*3) / 16)
+#define GHASH_LIMIT_GROW(_nslots) ((_nslots) / 2)
+#define GHASH_LIMIT_SHRINK(_nslots) ((_nslots) / 8)
+
+/**
+ * Slot states, any other value is a used slot pointing to its entry.
+ */
+#define GHASH_SLOT_EMPTY ((Entry *)NULL)
+#define GHASH_SLOT_REMOVED ((Entry *)(uintptr_t)1)
+#define GHASH_SLOT_IS_USED(_e) ((uintptr_t)(_e) > (uintptr_t)GHASH_SLOT_REMOVED)
+
+#define GHASH_SLOT_NONE UINT_MAX
+
+using ProbingStrategy = blender::DefaultProbingStrategy;
 
 /* WARNING! Keep in sync with ugly _gh_Entry in header!!! */
 typedef struct Entry {
-  struct Entry *next;
-
   void *key;
 } Entry;
 
@@ -100,17 +106,17 @@ struct GHash {
   GHashHashFP hashfp;
   GHashCmpFP cmpfp;
 
-  Entry **buckets;
+  /* Full hash and entry of every slot. */
+  uint *slot_hashes;
+  Entry **slot_entries;
   struct BLI_mempool *entrypool;
-  uint nbuckets;
+  uint nslots;
+  uint slot_mask, slot_bit, slot_bit_min;
   uint limit_grow, limit_shrink;
-#ifdef GHASH_USE_MODULO_BUCKETS
-  uint cursize, size_min;
-#else
-  uint bucket_mask, bucket_bit, bucket_bit_min;
-#endif
 
   uint nentries;
+  /* Slots of removed entries, still needed to continue probing until the next resize. */
+  uint nremoved;
   uint flag;
 };
 
@@ -149,44 +155,21 @@ BLI_INLINE uint ghash_keyhash(GHash *gh, const void *key)
 }
 
 /**
- * Get the full hash for an entry.
+ * Find the index of next used slot, starting from \a curr_slot (\a gh is assumed non-empty).
  */
-BLI_INLINE uint ghash_entryhash(GHash *gh, const Entry *e)
+BLI_INLINE uint ghash_find_next_slot_index(GHash *gh, uint curr_slot)
 {
-  return gh->hashfp(e->key);
-}
-
-/**
- * Get the bucket-index for an already-computed full hash.
- */
-BLI_INLINE uint ghash_bucket_index(GHash *gh, const uint hash)
-{
-#ifdef GHASH_USE_MODULO_BUCKETS
-  return hash % gh->nbuckets;
-#else
-  return hash & gh->bucket_mask;
-#endif
-}
-
-/**
- * Find the index of next used bucket, starting from \a curr_bucket (\a gh is assumed non-empty).
- */
-BLI_INLINE uint ghash_find_next_bucket_index(GHash *gh, uint curr_bucket)
-{
-  if (curr_bucket >= gh->nbuckets) {
-    curr_bucket = 0;
-  }
-  if (gh->buckets[curr_bucket]) {
-    return curr_bucket;
+  if (curr_slot >= gh->nslots) {
+    curr_slot = 0;
   }
-  for (; curr_bucket < gh->nbuckets; curr_bucket++) {
-    if (gh->buckets[curr_bucket]) {
-      return curr_bucket;
+  for (; curr_slot < gh->nslots; curr_slot++) {
+    if (GHASH_SLOT_IS_USED(gh->slot_entries[curr_slot])) {
+      return curr_slot;
     }
   }
-  for (curr_bucket = 0; curr_bucket < gh->nbuckets; curr_bucket++) {
-    if (gh->buckets[curr_bucket]) {
-      return curr_bucket;
+  for (curr_slot = 0; curr_slot < gh->nslots; curr_slot++) {
+    if (GHASH_SLOT_IS_USED(gh->slot_entries[curr_slot])) {
+      return curr_slot;
     }
   }
   BLI_assert(0);
@@ -194,239 +177,183 @@ BLI_INLINE uint ghash_find_next_bucket_index(GHash *gh, uint curr_bucket)
 }
 
 /**
- * Expand buckets to the next size up or down.
+ * Find the first slot that an entry with \a hash can be inserted into.
  */
-static void ghash_buckets_resize(GHash *gh, const uint nbuckets)
+BLI_INLINE uint ghash_find_free_slot_index(GHash *gh, const uint hash)
 {
-  Entry **buckets_old = gh->buckets;
-  Entry **buckets_new;
-  const uint nbuckets_old = gh->nbuckets;
-  uint i;
-
-  BLI_assert((gh->nbuckets != nbuckets) || !gh->buckets);
-  //  printf("%s: %d -> %d\n", __func__, nbuckets_old, nbuckets);
-
-  gh->nbuckets = nbuckets;
-#ifdef GHASH_USE_MODULO_BUCKETS
-#else
-  gh->bucket_mask = nbuckets - 1;
-#endif
-
-  buckets_new = (Entry **)MEM_callocN(sizeof(*gh->buckets) * gh->nbuckets, __func__);
-
-  if (buckets_old) {
-    if (nbuckets > nbuckets_old) {
-      for (i = 0; i < nbuckets_old; i++) {
-        for (Entry *e = buckets_old[i], *e_next; e; e = e_next) {
-          const uint hash = ghash_entryhash(gh, e);
-          const uint bucket_index = ghash_bucket_index(gh, hash);
-          e_next = e->next;
-          e->next = buckets_new[bucket_index];
-          buckets_new[bucket_index] = e;
-        }
-      }
-    }
-    else {
-      for (i = 0; i < nbuckets_old; i++) {
-#ifdef GHASH_USE_MODULO_BUCKETS
-        for (Entry *e = buckets_old[i], *e_next; e; e = e_next) {
-          const uint hash = ghash_entryhash(gh, e);
-          const uint bucket_index = ghash_bucket_index(gh, hash);
-          e_next = e->next;
-          e->next = buckets_new[bucket_index];
-          buckets_new[bucket_index] = e;
-        }
-#else
-        /* No need to recompute hashes in this case, since our mask is just smaller,
-         * all items in old bucket 'i' will go in same new bucket (i & new_mask)! */
-        const uint bucket_index = ghash_bucket_index(gh, i);
-        BLI_assert(!buckets_old[i] ||
-                   (bucket_index == ghash_bucket_index(gh, ghash_entryhash(gh, buckets_old[i]))));
-        Entry *e;
-        for (e = buckets_old[i]; e && e->next; e = e->next) {
-          /* pass */
-        }
-        if (e) {
-          e->next = buckets_new[bucket_index];
-          buckets_new[bucket_index] = buckets_old[i];
-        }
-#endif
-      }
+  Entry **slot_entries = gh->slot_entries;
+  SLOT_PROBING_BEGIN (ProbingStrategy, hash, gh->slot_mask, slot_index) {
+    if (!GHASH_SLOT_IS_USED(slot_entries[slot_index])) {
+      return slot_index;
     }
   }
+  SLOT_PROBING_END();
+}
 
-  gh->buckets = buckets_new;
-  if (buckets_old) {
-    MEM_freeN(buckets_old);
+/**
+ * Resize the slots, removed slots are dropped.
+ */
+static void ghash_slots_resize(GHash *gh, const uint slot_bit)
+{
+  uint *slot_hashes_old = gh->slot_hashes;
+  Entry **slot_entries_old = gh->slot_entries;
+  const uint nslots_old = gh->nslots;
+
+  //  printf("%s: %d -> %d\n", __func__, nslots_old, 1u << slot_bit);
+
+  gh->slot_bit = slot_bit;
+  gh->nslots = 1u << slot_bit;
+  gh->slot_mask = gh->nslots - 1;
+  gh->limit_grow = GHASH_LIMIT_GROW(gh->nslots);
+  gh->limit_shrink = GHASH_LIMIT_SHRINK(gh->nslots);
+  gh->nremoved = 0;
+
+  /* Hashes of empty slots are never read, no need to clear them. */
+  gh->slot_hashes = (uint *)MEM_mallocN(sizeof(*gh->slot_hashes) * gh->nslots, __func__);
+  gh->slot_entries = (Entry **)MEM_callocN(sizeof(*gh->slot_entries) * gh->nslots, __func__);
+
+  if (slot_entries_old) {
+    for (uint i = 0; i < nslots_old; i++) {
+      Entry *e = slot_entries_old[i];
+      if (GHASH_SLOT_IS_USED(e)) {
+        const uint hash = slot_hashes_old[i];
+        const uint slot_index = ghash_find_free_slot_index(gh, hash);
+        gh->slot_hashes[slot_index] = hash;
+        gh->slot_entries[slot_index] = e;
+      }
+    }
+    MEM_freeN(slot_hashes_old);
+    MEM_freeN(slot_entries_old);
   }
 }
 
 /**
- * Check if the number of items in the GHash is large enough to require more buckets,
- * or small enough to require less buckets, and resize \a gh accordingly.
+ * Check if the number of items in the GHash is large enough to require more slots,
+ * and resize \a gh accordingly.
  */
-static void ghash_buckets_expand(GHash *gh, const uint nentries, const bool user_defined)
+static void ghash_slots_expand(GHash *gh, const uint nentries, const bool user_defined)
 {
-  uint new_nbuckets;
+  uint new_slot_bit;
 
-  if (LIKELY(gh->buckets && (nentries < gh->limit_grow))) {
+  if (LIKELY(gh->slot_entries && (nentries <= gh->limit_grow))) {
     return;
   }
 
-  new_nbuckets = gh->nbuckets;
-
-#ifdef GHASH_USE_MODULO_BUCKETS
-  while ((nentries > gh->limit_grow) && (gh->cursize < GHASH_MAX_SIZE - 1)) {
-    new_nbuckets = hashsizes[++gh->cursize];
-    gh->limit_grow = GHASH_LIMIT_GROW(new_nbuckets);
+  new_slot_bit = gh->slot_bit;
+  while ((nentries > GHASH_LIMIT_GROW(1u << new_slot_bit)) &&
+         (new_slot_bit < GHASH_SLOT_BIT_MAX)) {
+    new_slot_bit++;
   }
-#else
-  while ((nentries > gh->limit_grow) && (gh->bucket_bit < GHASH_BUCKET_BIT_MAX)) {
-    new_nbuckets = 1u << ++gh->bucket_bit;
-    gh->limit_grow = GHASH_LIMIT_GROW(new_nbuckets);
-  }
-#endif
 
   if (user_defined) {
-#ifdef GHASH_USE_MODULO_BUCKETS
-    gh->size_min = gh->cursize;
-#else
-    gh->bucket_bit_min = gh->bucket_bit;
-#endif
+    gh->slot_bit_min = new_slot_bit;
   }
 
-  if ((new_nbuckets == gh->nbuckets) && gh->buckets) {
+  if ((new_slot_bit == gh->slot_bit) && gh->slot_entries) {
     return;
   }
 
-  gh->limit_grow = GHASH_LIMIT_GROW(new_nbuckets);
-  gh->limit_shrink = GHASH_LIMIT_SHRINK(new_nbuckets);
-  ghash_buckets_resize(gh, new_nbuckets);
+  ghash_slots_resize(gh, new_slot_bit);
 }
 
-static void ghash_buckets_contract(GHash *gh,
-                                   const uint nentries,
-                                   const bool user_defined,
-                                   const bool force_shrink)
+static void ghash_slots_contract(GHash *gh,
+                                 const uint nentries,
+                                 const bool user_defined,
+                                 const bool force_shrink)
 {
-  uint new_nbuckets;
+  uint new_slot_bit;
 
   if (!(force_shrink || (gh->flag & GHASH_FLAG_ALLOW_SHRINK))) {
     return;
   }
 
-  if (LIKELY(gh->buckets && (nentries > gh->limit_shrink))) {
+  if (LIKELY(gh->slot_entries && (nentries > gh->limit_shrink))) {
     return;
   }
 
-  new_nbuckets = gh->nbuckets;
-
-#ifdef GHASH_USE_MODULO_BUCKETS
-  while ((nentries < gh->limit_shrink) && (gh->cursize > gh->size_min)) {
-    new_nbuckets = hashsizes[--gh->cursize];
-    gh->limit_shrink = GHASH_LIMIT_SHRINK(new_nbuckets);
+  new_slot_bit = gh->slot_bit;
+  while ((nentries < GHASH_LIMIT_SHRINK(1u << new_slot_bit)) &&
+         (new_slot_bit > gh->slot_bit_min)) {
+    new_slot_bit--;
   }
-#else
-  while ((nentries < gh->limit_shrink) && (gh->bucket_bit > gh->bucket_bit_min)) {
-    new_nbuckets = 1u << --gh->bucket_bit;
-    gh->limit_shrink = GHASH_LIMIT_SHRINK(new_nbuckets);
-  }
-#endif
 
   if (user_defined) {
-#ifdef GHASH_USE_MODULO_BUCKETS
-    gh->size_min = gh->cursize;
-#else
-    gh->bucket_bit_min = gh->bucket_bit;
-#endif
+    gh->slot_bit_min = new_slot_bit;
   }
 
-  if ((new_nbuckets == gh->nbuckets) && gh->buckets) {
+  if ((new_slot_bit == gh->slot_bit) && gh->slot_entries) {
     return;
   }
 
-  gh->limit_grow = GHASH_LIMIT_GROW(new_nbuckets);
-  gh->limit_shrink = GHASH_LIMIT_SHRINK(new_nbuckets);
-  ghash_buckets_resize(gh, new_nbuckets);
+  ghash_slots_resize(gh, new_slot_bit);
 }
 
 /**
- * Clear and reset \a gh buckets, reserve again buckets for given number of entries.
+ * Make sure there is a free slot for one more entry, without exceeding the max load.
  */
-BLI_INLINE void ghash_buckets_reset(GHash *gh, const uint nentries)
+BLI_INLINE void ghash_slots_ensure_insert(GHash *gh)
 {
-  MEM_SAFE_FREE(gh->buckets);
-
-#ifdef GHASH_USE_MODULO_BUCKETS
-  gh->cursize = 0;
-  gh->size_min = 0;
-  gh->nbuckets = hashsizes[gh->cursize];
-#else
-  gh->bucket_bit = GHASH_BUCKET_BIT_MIN;
-  gh->bucket_bit_min = GHASH_BUCKET_BIT_MIN;
-  gh->nbuckets = 1u << gh->bucket_bit;
-  gh->bucket_mask = gh->nbuckets - 1;
-#endif
-
-  gh->limit_grow = GHASH_LIMIT_GROW(gh->nbuckets);
-  gh->limit_shrink = GHASH_LIMIT_SHRINK(gh->nbuckets);
-
-  gh->nentries = 0;
+  if (LIKELY(gh->nentries + gh->nremoved < gh->limit_grow)) {
+    return;
+  }
 
-  ghash_buckets_expand(gh, nentries, (nentries != 0));
+  /* Grow when most slots are used by entries, otherwise only clear the removed slots.
+   * Growing early leaves a margin above the shrink limit, to avoid resizing back and forth. */
+  if ((gh->nentries >= (gh->limit_grow / 4) * 3) && (gh->slot_bit < GHASH_SLOT_BIT_MAX)) {
+    ghash_slots_resize(gh, gh->slot_bit + 1);
+  }
+  else {
+    ghash_slots_resize(gh, gh->slot_bit);
+  }
 }
 
 /**
- * Internal lookup function.
- * Takes hash and bucket_index arguments to avoid calling #ghash_keyhash and #ghash_bucket_index
- * multiple times.
+ * Clear and reset \a gh slots, reserve again slots for given number of entries.
  */
-BLI_INLINE Entry *ghash_lookup_entry_ex(GHash *gh, const void *key, const uint bucket_index)
-{
-  Entry *e;
-  /* If we do not store GHash, not worth computing it for each entry here!
-   * Typically, comparison function will be quicker, and since it's needed in the end anyway... */
-  for (e = gh->buckets[bucket_index]; e; e = e->next) {
-    if (UNLIKELY(gh->cmpfp(key, e->key) == false)) {
-      return e;
-    }
-  }
+BLI_INLINE void ghash_slots_reset(GHash *gh, const uint nentries)
+{
+  MEM_SAFE_FREE(gh->slot_hashes);
+  MEM_SAFE_FREE(gh->slot_entries);
+
+  gh->slot_bit = GHASH_SLOT_BIT_MIN;
+  gh->slot_bit_min = GHASH_SLOT_BIT_MIN;
+  gh->nslots = 0;
+
+  gh->nentries = 0;
+  gh->nremoved = 0;
 
-  return NULL;
+  ghash_slots_expand(gh, nentries, (nentries != 0));
 }
 
 /**
- * Internal lookup function, returns previous entry of target one too.
- * Takes bucket_index argument to avoid calling #ghash_keyhash and #ghash_bucket_index
- * multiple times.
- * Useful when modifying buckets somehow (like removing an entry...).
+ * Internal lookup function, returns the slot of the entry or #GHASH_SLOT_NONE.
+ * Takes hash argument to avoid calling #ghash_keyhash multiple times.
  */
-BLI_INLINE Entry *ghash_lookup_entry_prev_ex(GHash *gh,
-                                             const void *key,
-                                             Entry **r_e_prev,
-                                             const uint bucket_index)
-{
-  /* If we do not store GHash, not worth computing it for each entry here!
-   * Typically, comparison function will be quicker, and since it's needed in the end anyway... */
-  for (Entry *e_prev = NULL, *e = gh->buckets[bucket_index]; e; e_prev = e, e = e->next) {
-    if (UNLIKELY(gh->cmpfp(key, e->key) == false)) {
-      *r_e_prev = e_prev;
-      return e;
+BLI_INLINE uint ghash_lookup_slot_ex(GHash *gh, const void *key, const uint hash)
+{
+  const uint *slot_hashes = gh->slot_hashes;
+  Entry **slot_entries = gh->slot_entries;
+  SLOT_PROBING_BEGIN (ProbingStrategy, hash, gh->slot_mask, slot_index) {
+    Entry *e = slot_entries[slot_index];
+    if (e == GHASH_SLOT_EMPTY) {
+      return GHASH_SLOT_NONE;
+    }
+    /* The comparison function is only called for matching hashes. */
+    if ((slot_hashes[slot_index] == hash) && GHASH_SLOT_IS_USED(e) &&
+        UNLIKELY(gh->cmpfp(key, e->key) == false)) {
+      return slot_index;
     }
   }
-
-  *r_e_prev = NULL;
-  return NULL;
+  SLOT_PROBING_END();
 }
 
 /**
- * Internal lookup function. Only wraps #ghash_lookup_entry_ex
+ * Internal lookup function. Only wraps #ghash_lookup_slot_ex
  */
 BLI_INLINE Entry *ghash_lookup_entry(GHash *gh, const void *key)
 {
-  const uint hash = ghash_keyhash(gh, key);
-  const uint bucket_index = ghash_bucket_index(gh, hash);
-  return ghash_lookup_entry_ex(gh, key, bucket_index);
+  const uint slot_index = ghash_lookup_slot_ex(gh, key, ghash_keyhash(gh, key));
+  return (slot_index != GHASH_SLOT_NONE) ? gh->slot_entries[slot_index] : NULL;
 }
 
 static GHash *ghash_new(GHashHashFP hashfp,
@@ -435,15 +362,16 @@ static GHash *ghash_new(GHashHashFP hashfp,
                         const uint nentries_reserve,
                         const uint flag)
 {
-  GHash *gh = MEM_mallocN(sizeof(*gh), info);
+  GHash *gh = (GHash *)MEM_mallocN(sizeof(*gh), info);
 
   gh->hashfp = hashfp;
   gh->cmpfp = cmpfp;
 
-  gh->buckets = NULL;
+  gh->slot_hashes = NULL;
+  gh->slot_entries = NULL;
   gh->flag = flag;
 
-  ghash_buckets_reset(gh, nentries_reserve);
+  ghash_slots_reset(gh, nentries_reserve);
   gh->entrypool = BLI_mempool_create(
       GHASH_ENTRY_SIZE(flag & GHASH_FLAG_IS_GSET), 64, 64, BLI_MEMPOOL_NOP);
 
@@ -451,65 +379,57 @@ static GHash *ghash_new(GHashHashFP hashfp,
 }
 
 /**
- * Internal insert function.
- * Takes hash and bucket_index arguments to avoid calling #ghash_keyhash and #ghash_bucket_index
- * multiple times.
+ * Insert function that takes a pre-allocated entry, the key must be set by the caller.
+ * Takes hash argument to avoid calling #ghash_keyhash multiple times.
  */
-BLI_INLINE void ghash_insert_ex(GHash *gh, void *key, void *val, const uint bucket_index)
+BLI_INLINE void ghash_insert_entry_ex(GHash *gh, Entry *e, const uint hash)
 {
-  GHashEntry *e = BLI_mempool_alloc(gh->entrypool);
-
-  BLI_assert((gh->flag & GHASH_FLAG_ALLOW_DUPES) || (BLI_ghash_haskey(gh, key) == 0));
-  BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
-
-  e->e.next = gh->buckets[bucket_index];
-  e->e.key = key;
-  e->val = val;
-  gh->buckets[bucket_index] = (Entry *)e;
+  ghash_slots_ensure_insert(gh);
 
-  ghash_buckets_expand(gh, ++gh->nentries, false);
+  const uint slot_index = ghash_find_free_slot_index(gh, hash);
+  if (gh->slot_entries[slot_index] == GHASH_SLOT_REMOVED) {
+    gh->nremoved--;
+  }
+  gh->slot_hashes[slot_index] = hash;
+  gh->slot_entries[slot_index] = e;
+  gh->nentries++;
 }
 
 /**
- * Insert function that takes a pre-allocated entry.
+ * Internal insert function.
+ * Takes hash argument to avoid calling #ghash_keyhash multiple times.
  */
-BLI_INLINE void ghash_insert_ex_keyonly_entry(GHash *gh,
-                                              void *key,
-                                              const uint bucket_index,
-                                              Entry *e)
+BLI_INLINE void ghash_insert_ex(GHash *gh, void *key, void *val, const uint hash)
 {
-  BLI_assert((gh->flag & GHASH_FLAG_ALLOW_DUPES) || (BLI_ghash_haskey(gh, key) == 0));
+  GHashEntry *e = (GHashEntry *)BLI_mempool_alloc(gh->entrypool);
 
-  e->next = gh->buckets[bucket_index];
-  e->key = key;
-  gh->buckets[bucket_index] = e;
+  BLI_assert((gh->flag & GHASH_FLAG_ALLOW_DUPES) || (BLI_ghash_haskey(gh, key) == 0));
+  BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
 
-  ghash_buckets_expand(gh, ++gh->nentries, false);
+  e->e.key = key;
+  e->val = val;
+  ghash_insert_entry_ex(gh, (Entry *)e, hash);
 }
 
 /**
  * Insert function that doesn't set the value (use for GSet)
  */
-BLI_INLINE void ghash_insert_ex_keyonly(GHash *gh, void *key, const uint bucket_index)
+BLI_INLINE void ghash_insert_ex_keyonly(GHash *gh, void *key, const uint hash)
 {
-  Entry *e = BLI_mempool_alloc(gh->entrypool);
+  Entry *e = (Entry *)BLI_mempool_alloc(gh->entrypool);
 
   BLI_assert((gh->flag & GHASH_FLAG_ALLOW_DUPES) || (BLI_ghash_haskey(gh, key) == 0));
   BLI_assert((gh->flag & GHASH_FLAG_IS_GSET) != 0);
 
-  e->next = gh->buckets[bucket_index];
   e->key = key;
-  gh->buckets[bucket_index] = e;
-
-  ghash_buckets_expand(gh, ++gh->nentries, false);
+  ghash_insert_entry_ex(gh, e, hash);
 }
 
 BLI_INLINE void ghash_insert(GHash *gh, void *key, void *val)
 {
   const uint hash = ghash_keyhash(gh, key);
-  const uint bucket_index = ghash_bucket_index(gh, hash);
 
-  ghash_insert_ex(gh, key, val, bucket_index);
+  ghash_insert_ex(gh, key, val, hash);
 }
 
 BLI_INLINE bool ghash_insert_safe(GHash *gh,
@@ -520,12 +440,12 @@ BLI_INLINE bool ghash_insert_safe(GHash *gh,
                                   GHashValFreeFP valfreefp)
 {
   const uint hash = ghash_keyhash(gh, key);
-  const uint bucket_index = ghash_bucket_index(gh, hash);
-  GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
+  const uint slot_index = ghash_lookup_slot_ex(gh, key, hash);
 
   BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
 
-  if (e) {
+  if (slot_index != GHASH_SLOT_NONE) {
+    GHashEntry *e = (GHashEntry *)gh->slot_entries[slot_index];
     if (override) {
       if (keyfreefp) {
         keyfreefp(e->e.key);
@@ -539,7 +459,7 @@ BLI_INLINE bool ghash_insert_safe(GHash *gh,
     return false;
   }
   else {
-    ghash_insert_ex(gh, key, val, bucket_index);
+    ghash_insert_ex(gh, key, val, hash);
     return true;
   }
 }
@@ -550,12 +470,12 @@ BLI_INLINE bool ghash_insert_safe_keyonly(GHash *gh,
                                           GHashKeyFreeFP keyfreefp)
 {
   const uint hash = ghash_keyhash(gh, key);
-  const uint bucket_index = ghash_bucket_index(gh, hash);
-  Entry *e = ghash_lookup_entry_ex(gh, key, bucket_index);
+  const uint slot_index = ghash_lookup_slot_ex(gh, key, hash);
 
   BLI_assert((gh->flag & GHASH_FLAG_IS_GSET) != 0);
 
-  if (e) {
+  if (slot_index != GHASH_SLOT_NONE) {
+    Entry *e = gh->slot_entries[slot_index];
     if (override) {
       if (keyfreefp) {
         keyfreefp(e->key);
@@ -565,67 +485,73 @@ BLI_INLINE bool ghash_insert_safe_keyonly(GHash *gh,
     return false;
   }
   else {
-    ghash_insert_ex_keyonly(gh, key, bucket_index);
+    ghash_insert_ex_keyonly(gh, key, hash);
     return true;
   }
 }
 
 /**
- * Remove the entry and return it, caller must free from gh->entrypool.
+ * Remove the entry in \a slot_index and return it, caller must free from gh->entrypool.
  */
-static Entry *ghash_remove_ex(GHash *gh,
-                              const void *key,
-                              GHashKeyFreeFP keyfreefp,
-                              GHashValFreeFP valfreefp,
-                              const uint bucket_index)
+static Entry *ghash_remove_slot(GHash *gh,
+                                const uint slot_index,
+                                GHashKeyFreeFP keyfreefp,
+                                GHashValFreeFP valfreefp)
 {
-  Entry *e_prev;
-  Entry *e = ghash_lookup_entry_prev_ex(gh, key, &e_prev, bucket_index);
+  Entry *e = gh->slot_entries[slot_index];
 
+  BLI_assert(GHASH_SLOT_IS_USED(e));
   BLI_assert(!valfreefp || !(gh->flag & GHASH_FLAG_IS_GSET));
 
-  if (e) {
-    if (keyfreefp) {
-      keyfreefp(e->key);
-    }
-    if (valfreefp) {
-      valfreefp(((GHashEntry *)e)->val);
-    }
+  if (keyfreefp) {
+    keyfreefp(e->key);
+  }
+  if (valfreefp) {
+    valfreefp(((GHashEntry *)e)->val);
+  }
 
-    if (e_prev) {
-      e_prev->next = e->next;
-    }
-    else {
-      gh->buckets[bucket_index] = e->next;
-    }
+  gh->slot_entries[slot_index] = GHASH_SLOT_REMOVED;
+  gh->nremoved++;
 
-    ghash_buckets_contract(gh, --gh->nentries, false, false);
-  }
+  ghash_slots_contract(gh, --gh->nentries, false, false);
 
   return e;
 }
 
+/**
+ * Remove the entry and return it, caller must free from gh->entrypool.
+ */
+static Entry *ghash_remove_ex(GHash *gh,
+                              const void *key,
+                              GHashKeyFreeFP keyfreefp,
+                              GHashValFreeFP valfreefp,
+                              const uint hash)
+{
+  const uint slot_index = ghash_lookup_slot_ex(gh, key, hash);
+  if (slot_index == GHASH_SLOT_NONE) {
+    return NULL;
+  }
+  return ghash_remove_slot(gh, slot_index, keyfreefp, valfreefp);
+}
+
 /**
  * Remove a random entry and return it (or NULL if empty), caller must free from gh->entrypool.
  */
 static Entry *ghash_pop(GHash *gh, GHashIterState *state)
 {
-  uint curr_bucket = state->curr_bucket;
+  uint curr_slot = state->curr_bucket;
   if (gh->nentries == 0) {
     return NULL;
   }
 
-  /* Note: using first_bucket_index here allows us to avoid potential
-   * huge number of loops over buckets,
+  /* Note: continuing from the previous slot allows us to avoid potential
+   * huge number of loops over slots,
    * in case we are popping from a large ghash with few items in it... */
-  curr_bucket = ghash_find_next_bucket_index(gh, curr_bucket);
-
-  Entry *e = gh->buckets[curr_bucket];
-  BLI_assert(e);
+  curr_slot = ghash_find_next_slot_index(gh, curr_slot);
 
-  ghash_remove_ex(gh, e->key, NULL, NULL, curr_bucket);
+  Entry *e = ghash_remove_slot(gh, curr_slot, NULL, NULL);
 
-  state->curr_bucket = curr_bucket;
+  state->curr_bucket = curr_slot;
   return e;
 }
 
@@ -634,15 +560,12 @@ static Entry *ghash_pop(GHash *gh, GHashIterState *state)
  */
 static void ghash_free_cb(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
 {
-  uint i;
-
   BLI_assert(keyfreefp || valfreefp);
   BLI_assert(!valfreefp || !(gh->flag & GHASH_FLAG_IS_GSET));
 
-  for (i = 0; i < gh->nbuckets; i++) {
-    Entry *e;
-
-    for (e = gh->buckets[i]; e; e = e->next) {
+  for (uint i = 0; i < gh->nslots; i++) {
+    Entry *e = gh->slot_entries[i];
+    if (GHASH_SLOT_IS_USED(e)) {
       if (keyfreefp) {
         keyfreefp(e->key);
       }
@@ -659,35 +582,33 @@ static void ghash_free_cb(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP va
 static GHash *ghash_copy(GHash *gh, GHashKeyCopyFP keycopyfp, GHashValCopyFP valcopyfp)
 {
   GHash *gh_new;
-  uint i;
-  /* This allows us to be sure to get the same number of buckets in gh_new as in ghash. */
-  const uint reserve_nentries_new = MAX2(GHASH_LIMIT_GROW(gh->nbuckets) - 1, gh->nentries);
 
   BLI_assert(!valcopyfp || !(gh->flag & GHASH_FLAG_IS_GSET));
 
   gh_new = ghash_new(gh->hashfp, gh->cmpfp, __func__, 0, gh->flag);
-  ghash_buckets_expand(gh_new, reserve_nentries_new, false);
-
-  BLI_assert(gh_new->nbuckets == gh->nbuckets);
+  /* This allows us to be sure to get the same number of slots in gh_new as in ghash. */
+  if (gh_new->slot_bit != gh->slot_bit) {
+    ghash_slots_resize(gh_new, gh->slot_bit);
+  }
+  gh_new->slot_bit_min = gh->slot_bit_min;
 
-  for (i = 0; i < gh->nbuckets; i++) {
-    Entry *e;
+  BLI_assert(gh_new->nslots == gh->nslots);
 
-    for (e = gh->buckets[i]; e; e = e->next) {
-      Entry *e_new = BLI_mempool_alloc(gh_new->entrypool);
+  /* Keep every entry in the same slot, removed slots are kept too so probing still works. */
+  memcpy(gh_new->slot_hashes, gh->slot_hashes, sizeof(*gh->slot_hashes) * gh->nslots);
+  for (uint i = 0; i < gh->nslots; i++) {
+    Entry *e = gh->slot_entries[i];
+    if (GHASH_SLOT_IS_USED(e)) {
+      Entry *e_new = (Entry *)BLI_mempool_alloc(gh_new->entrypool);
       ghash_entry_copy(gh_new, e_new, gh, e, keycopyfp, valcopyfp);
-
-      /* Warning!
-       * This means entries in buckets in new copy will be in reversed order!
-       * This shall not be an issue though, since order should never be assumed in ghash. */
-
-      /* Note: We can use 'i' here, since we are sure that
-       * 'gh' and 'gh_new' have the same number of buckets! */
-      e_new->next = gh_new->buckets[i];
-      gh_new->buckets[i] = e_new;
+      gh_new->slot_entries[i] = e_new;
+    }
+    else {
+      gh_new->slot_entries[i] = e;
     }
   }
   gh_new->nentries = gh->nentries;
+  gh_new->nremoved = gh->nremoved;
 
   return gh_new;
 }
@@ -705,7 +626,7 @@ static GHash *ghash_copy(GHash *gh, GHashKeyCopyFP keycopyfp, GHashValCopyFP val
  * \param cmpfp: Comparison callback.
  * \param info: Identifier string for the GHash.
  * \param nentries_reserve: Optionally reserve the number of members that the hash will hold.
- * Use this to avoid resizing buckets if the size is known or can be closely approximated.
+ * Use this to avoid resizing slots if the size is known or can be closely approximated.
  * \return  An empty GHash.
  */
 GHash *BLI_ghash_new_ex(GHashHashFP hashfp,
@@ -738,8 +659,8 @@ GHash *BLI_ghash_copy(GHash *gh, GHashKeyCopyFP keycopyfp, GHashValCopyFP valcop
  */
 void BLI_ghash_reserve(GHash *gh, const uint nentries_reserve)
 {
-  ghash_buckets_expand(gh, nentries_reserve, true);
-  ghash_buckets_contract(gh, nentries_reserve, true, false);
+  ghash_slots_expand(gh, nentries_reserve, true);
+  ghash_slots_contract(gh, nentries_reserve, true, false);
 }
 
 /**
@@ -784,9 +705,7 @@ bool BLI_ghash_reinsert(
  */
 void *BLI_ghash_replace_key(GHash *gh, void *key)
 {
-  const uint hash = ghash_keyhash(gh, key);
-  const uint bucket_index = ghash_bucket_index(gh, hash);
-  GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
+  GHashEntry *e = (GHashEntry *)ghash_lookup_entry(gh, key);
   if (e != NULL) {
     void *key_prev = e->e.key;
     e->e.key = key;
@@ -857,13 +776,17 @@ void **BLI_ghash_lookup_p(GHash *gh, const void *key)
 bool BLI_ghash_ensure_p(GHash *gh, void *key, void ***r_val)
 {
   const uint hash = ghash_keyhash(gh, key);
-  const uint bucket_index = ghash_bucket_index(gh, hash);
-  GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
-  const bool haskey = (e != NULL);
+  const uint slot_index = ghash_lookup_slot_ex(gh, key, hash);
+  const bool haskey = (slot_index != GHASH_SLOT_NONE);
+  GHashEntry *e;
 
-  if (!haskey) {
-    e = BLI_mempool_alloc(gh->entrypool);
-    ghash_insert_ex_keyonly_entry(gh, key, bucket_index, (Entry *)e);
+  if (haskey) {
+    e = (GHashEntry *)gh->slot_entries[slot_index];
+  }
+  else {
+    e = (GHashEntry *)BLI_mempool_alloc(gh->entrypool);
+    e->e.key = key;
+    ghash_insert_entry_ex(gh, (Entry *)e, hash);
   }
 
   *r_val = &e->val;
@@ -879,15 +802,18 @@ bool BLI_ghash_ensure_p(GHash *gh, void *key, void ***r_val)
 bool BLI_ghash_ensure_p_ex(GHash *gh, const void *key, void ***r_key, void ***r_val)
 {
   const uint hash = ghash_keyhash(gh, key);
-  const uint bucket_index = ghash_bucket_index(gh, hash);
-  GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
-  const bool haskey = (e != NULL);
-
-  if (!haskey) {
-    /* Pass 'key' in case we resize. */
-    e = BLI_mempool_alloc(gh->entrypool);
-    ghash_insert_ex_keyonly_entry(gh, (void *)key, bucket_index, (Entry *)e);
+  const uint slot_index = ghash_lookup_slot_ex(gh, key, hash);
+  const bool haskey = (slot_index != GHASH_SLOT_NONE);
+  GHashEntry *e;
+
+  if (haskey) {
+    e = (GHashEntry *)gh->slot_entries[slot_index];
+  }
+  else {
+    /* The hash is cached, so resizing never needs the key. */
+    e = (GHashEntry *)BLI_mempool_alloc(gh->entrypool);
     e->e.key = NULL; /* caller must re-assign */
+    ghash_insert_entry_ex(gh, (Entry *)e, hash);
   }
 
   *r_key = &e->e.key;
@@ -909,8 +835,7 @@ bool BLI_ghash_remove(GHash *gh,
                       GHashValFreeFP valfreefp)
 {
   const uint hash = ghash_keyhash(gh, key);
-  const uint bucket_index = ghash_bucket_index(gh, hash);
-  Entry *e = ghash_remove_ex(gh, key, keyfreefp, valfreefp, bucket_index);
+  Entry *e = ghash_remove_ex(gh, key, keyfreefp, valfreefp, hash);
   if (e) {
     BLI_mempool_free(gh->entrypool, e);
     return true;
@@ -932,8 +857,7 @@ bool BLI_ghash_remove(GHash *gh,
 void *BLI_ghash_popkey(GHash *gh, const void *key, GHashKeyFreeFP keyfreefp)
 {
   const uint hash = ghash_keyhash(gh, key);
-  const uint bucket_index = ghash_bucket_index(gh, hash);
-  GHashEntry *e = (GHashEntry *)ghash_remove_ex(gh, key, keyfreefp, NULL, bucket_index);
+  GHashEntry *e = (GHashEntry *)ghash_remove_ex(gh, key, keyfreefp, NULL, hash);
   BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
   if (e) {
     void *val = e->val;
@@ -997,7 +921,7 @@ void BLI_ghash_clear_ex(GHash *gh,
     ghash_free_cb(gh, keyfreefp, valfreefp);
   }
 
-  ghash_buckets_reset(gh, nentries_reserve);
+  ghash_slots_reset(gh, nentries_reserve);
   BLI_mempool_clear_ex(gh->entrypool, nentries_reserve ? (int)nentries_reserve : -1);
 }
 
@@ -1023,7 +947,8 @@ void BLI_ghash_free(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreef
     ghash_free_cb(gh, keyfreefp, valfreefp);
   }
 
-  MEM_freeN(gh->buckets);
+  MEM_freeN(gh->slot_hashes);
+  MEM_freeN(gh->slot_entries);
   BLI_mempool_destroy(gh->entrypool);
   MEM_freeN(gh);
 }
@@ -1060,7 +985,7 @@ void BLI_ghash_flag_clear(GHash *gh, uint flag)
  */
 GHashIterator *BLI_ghashIterator_new(GHash *gh)
 {
-  GHashIterator *ghi = MEM_mallocN(sizeof(*ghi), "ghash iterator");
+  GHashIterator *ghi = (GHashIterator *)MEM_mallocN(sizeof(*ghi), "ghash iterator");
   BLI_ghashIterator_init(ghi, gh);
   return ghi;
 }
@@ -1077,15 +1002,10 @@ void BLI_ghashIterator_init(GHashIterator *ghi, GHash *gh)
 {
   ghi->gh = gh;
   ghi->curEntry = NULL;
-  ghi->curBucket = UINT_MAX; /* wraps to zero */
+  ghi->curBucket = 0;
   if (gh->nentries) {
-    do {
-      ghi->curBucket++;
-      if (UNLIKELY(ghi->curBucket == ghi->gh->nbuckets)) {
-        break;
-      }
-      ghi->curEntry = ghi->gh->buckets[ghi->curBucket];
-    } while (!ghi->curEntry);
+    ghi->curBucket = ghash_find_next_slot_index(gh, 0);
+    ghi->curEntry = gh->slot_entries[ghi->curBucket];
   }
 }
 
@@ -1097,13 +1017,15 @@ void BLI_ghashIterator_init(GHashIterator *ghi, GHash *gh)
 void BLI_ghashIterator_step(GHashIterator *ghi)
 {
   if (ghi->curEntry) {
-    ghi->curEntry = ghi->curEntry->next;
-    while (!ghi->curEntry) {
-      ghi->curBucket++;
-      if (ghi->curBucket == ghi->gh->nbuckets) {
+    GHash *gh = ghi->gh;
+    ghi->curEntry = NULL;
+    /* Continue from the slot index, the current entry isn't accessed. */
+    while (++ghi->curBucket < gh->nslots) {
+      Entry *e = gh->slot_entries[ghi->curBucket];
+      if (GHASH_SLOT_IS_USED(e)) {
+        ghi->curEntry = e;
         break;
       }
-      ghi->curEntry = ghi->gh->buckets[ghi->curBucket];
     }
   }
 }
@@ -1158,8 +1080,7 @@ uint BLI_gset_len(GSet *gs)
 void BLI_gset_insert(GSet *gs, void *key)
 {
   const uint hash = ghash_keyhash((GHash *)gs, key);
-  const uint bucket_index = ghash_bucket_index((GHash *)gs, hash);
-  ghash_insert_ex_keyonly((GHash *)gs, key, bucket_index);
+  ghash_insert_ex_keyonly((GHash *)gs, key, hash);
 }
 
 /**
@@ -1181,16 +1102,20 @@ bool BLI_gset_add(GSet *gs, void *key)
  */
 bool BLI_gset_ensure_p_ex(GSet *gs, const void *key, void ***r_key)
 {
-  const uint hash = ghash_keyhash((GHash *)gs, key);
-  const uint bucket_index = ghash_bucket_index((GHash *)gs, hash);
-  GSetEntry *e = (GSetEntry *)ghash_lookup_entry_ex((GHash *)gs, key, bucket_index);
-  const bool haskey = (e != NULL);
-
-  if (!haskey) {
-    /* Pass 'key' in case we resize */
-    e = BLI_mempool_alloc(((GHash *)gs)->entrypool);
-    ghash_insert_ex_keyonly_entry((GHash *)gs, (void *)key, bucket_index, (Entry *)e);
+  GHash *gh = (GHash *)gs;
+  const uint hash = ghash_keyhash(gh, key);
+  const uint slot_index = ghash_lookup_slot_ex(gh, key, hash);
+  const bool haskey = (slot_index != GHASH_SLOT_NONE);
+  GSetEntry *e;
+
+  if (haskey) {
+    e = gh->slot_entries[slot_index];
+  }
+  else {
+    /* The hash is cached, so resizing never needs the key. */
+    e = (GSetEntry *)BLI_mempool_alloc(gh->entrypool);
     e->key = NULL; /* caller must re-assign */
+    ghash_insert_entry_ex(gh, e, hash);
   }
 
   *r_key = &e->key;
@@ -1302,8 +1227,7 @@ void *BLI_gset_lookup(GSet *gs, const void *key)
 void *BLI_gset_pop_key(GSet *gs, const void *key)
 {
   const uint hash = ghash_keyhash((GHash *)gs, key);
-  const uint bucket_index = ghash_bucket_index((GHash *)gs, hash);
-  Entry *e = ghash_remove_ex((GHash *)gs, key, NULL, NULL, bucket_index);
+  Entry *e = ghash_remove_ex((GHash *)gs, key, NULL, NULL, hash);
   if (e) {
     void *key_ret = e->key;
     BLI_mempool_free(((GHash *)gs)->entrypool, e);
@@ -1323,11 +1247,11 @@ void *BLI_gset_pop_key(GSet *gs, const void *key)
 #include "BLI_math.h"
 
 /**
- * \return number of buckets in the GHash.
+ * \return number of slots in the GHash.
  */
 int BLI_ghash_buckets_len(GHash *gh)
 {
-  return (int)gh->nbuckets;
+  return (int)gh->nslots;
 }
 int BLI_gset_buckets_len(GSet *gs)
 {
@@ -1339,6 +1263,9 @@ int BLI_gset_buckets_len(GSet *gs)
  * and return a few other stats like load,
  * variance of the distribution of the entries in the buckets, etc.
  *
+ * A bucket is the set of entries sharing the same initial slot,
+ * which is what their probing sequence starts from.
+ *
  * Smaller is better!
  */
 double BLI_ghash_calc_quality_ex(GHash *gh,
@@ -1371,7 +1298,15 @@ double BLI_ghash_calc_quality_ex(GHash *gh,
     return 0.0;
   }
 
-  mean = (double)gh->nentries / (double)gh->nbuckets;
+  uint *bucket_counts = (uint *)MEM_callocN(sizeof(*bucket_counts) * gh->nslots, __func__);
+  for (i = 0; i < gh->nslots; i++) {
+    if (GHASH_SLOT_IS_USED(gh->slot_entries[i])) {
+      const uint hash = gh->slot_hashes[i];
+      bucket_counts[ProbingStrategy(hash).get() & gh->slot_mask]++;
+    }
+  }
+
+  mean = (double)gh->nentries / (double)gh->nslots;
   if (r_load) {
     *r_load = mean;
   }
@@ -1384,29 +1319,21 @@ double BLI_ghash_calc_quality_ex(GHash *gh,
      * See https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Two-pass_algorithm
      */
     double sum = 0.0;
-    for (i = 0; i < gh->nbuckets; i++) {
-      int count = 0;
-      Entry *e;
-      for (e = gh->buckets[i]; e; e = e->next) {
-        count++;
-      }
-      sum += ((double)count - mean) * ((double)count - mean);
+    for (i = 0; i < gh->nslots; i++) {
+      const double count = (double)bucket_counts[i];
+      sum += (count - mean) * (count - mean);
     }
-    *r_variance = sum / (double)(gh->nbuckets - 1);
+    *r_variance = sum / (double)(gh->nslots - 1);
   }
 
   {
     uint64_t sum = 0;
-    uint64_t overloaded_buckets_threshold = (uint64_t)max_ii(GHASH_LIMIT_GROW(1), 1);
+    uint64_t overloaded_buckets_threshold = (uint64_t)max_ii((int)GHASH_LIMIT_GROW(1), 1);
     uint64_t sum_overloaded = 0;
     uint64_t sum_empty = 0;
 
-    for (i = 0; i < gh->nbuckets; i++) {
-      uint64_t count = 0;
-      Entry *e;
-      for (e = gh->buckets[i]; e; e = e->next) {
-        count++;
-      }
+    for (i = 0; i < gh->nslots; i++) {
+      const uint64_t count = bucket_counts[i];
       if (r_biggest_bucket) {
         *r_biggest_bucket = max_ii(*r_biggest_bucket, (int)count);
       }
@@ -1418,14 +1345,16 @@ double BLI_ghash_calc_quality_ex(GHash *gh,
       }
       sum += count * (count + 1);
     }
+    MEM_freeN(bucket_counts);
+
     if (r_prop_overloaded_buckets) {
-      *r_prop_overloaded_buckets = (double)sum_overloaded / (double)gh->nbuckets;
+      *r_prop_overloaded_buckets = (double)sum_overloaded / (double)gh->nslots;
     }
     if (r_prop_empty_buckets) {
-      *r_prop_empty_buckets = (double)sum_empty / (double)gh->nbuckets;
+      *r_prop_empty_buckets = (double)sum_empty / (double)gh->nslots;
     }
-    return ((double)sum * (double)gh->nbuckets /
-            ((double)gh->nentries * (gh->nentries + 2 * gh->nbuckets - 1)));
+    return ((double)sum * (double)gh->nslots /
+            ((double)gh->nentries * (gh->nentries + 2 * gh->nslots - 1)));
   }
 }
 double BLI_gset_calc_quality_ex(GSet *gs,
@@ -2062,6 +2062,130 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree batch queries
+ *
+ * Run many independent queries against the same tree in parallel. Queries are split into
+ * contiguous chunks, so neighboring queries (e.g. vertices of a mesh) tend to traverse the same
+ * nodes on the same thread.
+ *
+ * \{ */
+
+/* Below this number of queries the overhead of threading is not worth it. */
+#define BVH_BATCH_QUERY_MIN_PER_THREAD 256
+
+typedef struct BVHNearestBatchData {
+  BVHTree *tree;
+  const float (*co)[3];
+  BVHTreeNearest *nearest;
+  BVHTree_NearestPointCallback callback;
+  void *userdata;
+  int flag;
+} BVHNearestBatchData;
+
+static void bvhtree_find_nearest_batch_cb(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHNearestBatchData *data = userdata;
+  BLI_bvhtree_find_nearest_ex(
+      data->tree, data->co[i], &data->nearest[i], data->callback, data->userdata, data->flag);
+}
+
+/**
+ * Find the nearest node for every coordinate in \a co.
+ *
+ * \param nearest: Array of \a co_num items, `index` and `dist_sq` must be initialized as for
+ * #BLI_bvhtree_find_nearest_ex, e.g. to limit the search distance.
+ * \param callback: Called from multiple threads at once, so it must be thread-safe.
+ */
+void BLI_bvhtree_find_nearest_batch(BVHTree *tree,
+                                    const float (*co)[3],
+                                    BVHTreeNearest *nearest,
+                                    const int co_num,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    int flag)
+{
+  BVHNearestBatchData data = {
+      .tree = tree,
+      .co = co,
+      .nearest = nearest,
+      .callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (co_num > BVH_BATCH_QUERY_MIN_PER_THREAD);
+  settings.min_iter_per_thread = BVH_BATCH_QUERY_MIN_PER_THREAD;
+  BLI_task_parallel_range(0, co_num, &data, bvhtree_find_nearest_batch_cb, &settings);
+}
+
+typedef struct BVHRayCastBatchData {
+  BVHTree *tree;
+  const float (*co)[3];
+  const float (*dir)[3];
+  float radius;
+  BVHTreeRayHit *hit;
+  BVHTree_RayCastCallback callback;
+  void *userdata;
+  int flag;
+} BVHRayCastBatchData;
+
+static void bvhtree_ray_cast_batch_cb(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHRayCastBatchData *data = userdata;
+  BLI_bvhtree_ray_cast_ex(data->tree,
+                          data->co[i],
+                          data->dir[i],
+                          data->radius,
+                          &data->hit[i],
+                          data->callback,
+                          data->userdata,
+                          data->flag);
+}
+
+/**
+ * Cast one ray for every item in \a co and \a dir.
+ *
+ * \param hit: Array of \a ray_num items, `index` and `dist` must be initialized as for
+ * #BLI_bvhtree_ray_cast_ex, e.g. to limit the ray length.
+ * \param callback: Called from multiple threads at once, so it must be thread-safe.
+ */
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                float radius,
+                                BVHTreeRayHit *hit,
+                                const int ray_num,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag)
+{
+  BVHRayCastBatchData data = {
+      .tree = tree,
+      .co = co,
+      .dir = dir,
+      .radius = radius,
+      .hit = hit,
+      .callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (ray_num > BVH_BATCH_QUERY_MIN_PER_THREAD);
+  settings.min_iter_per_thread = BVH_BATCH_QUERY_MIN_PER_THREAD;
+  BLI_task_parallel_range(0, ray_num, &data, bvhtree_ray_cast_batch_cb, &settings);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_range_query
  *
@@ -104,6 +104,7 @@
 
 #include "BLI_listbase.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BLI_strict_flags.h"
 
@@ -160,6 +161,13 @@
 #  define BCHUNK_HASH_LEN 4
 #endif
 
+#ifdef USE_HASH_TABLE_ACCUMULATE
+/* Hash arrays with more elements than this are split into blocks of this size,
+ * which are hashed and accumulated in parallel.
+ */
+#  define BCHUNK_HASH_ARRAY_PARALLEL_BLOCK_LEN 65536
+#endif
+
 /* Calculate the key once and reuse it
  */
 #define USE_HASH_TABLE_KEY_CACHE
@@ -830,6 +838,77 @@ static void hash_accum(hash_key *hash_array, const size_t hash_array_len, size_t
   }
 }
 
+typedef struct HashArrayAccumData {
+  const BArrayInfo *info;
+  const uchar *data;
+  hash_key *hash_array;
+  size_t hash_array_len;
+  size_t blocks_num;
+} HashArrayAccumData;
+
+static void hash_array_accum_block_cb(void *__restrict userdata,
+                                      const int block_index,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const HashArrayAccumData *data = userdata;
+  const BArrayInfo *info = data->info;
+  const size_t block_start = (size_t)block_index * BCHUNK_HASH_ARRAY_PARALLEL_BLOCK_LEN;
+  const size_t block_end = ((size_t)block_index == data->blocks_num - 1) ?
+                               data->hash_array_len :
+                               block_start + BCHUNK_HASH_ARRAY_PARALLEL_BLOCK_LEN;
+
+  /* Also hash the elements the accumulation reads ahead into the next block,
+   * so the result is identical to accumulating the whole array at once. */
+  const size_t hash_block_end = MIN2(block_end + info->accum_read_ahead_len,
+                                     data->hash_array_len);
+  const size_t hash_block_len = hash_block_end - block_start;
+  hash_key *hash_block = MEM_mallocN(sizeof(*hash_block) * hash_block_len, __func__);
+
+  hash_array_from_data(info,
+                       &data->data[block_start * info->chunk_stride],
+                       hash_block_len * info->chunk_stride,
+                       hash_block);
+  hash_accum(hash_block, hash_block_len, info->accum_steps);
+
+  memcpy(&data->hash_array[block_start],
+         hash_block,
+         sizeof(*hash_block) * (block_end - block_start));
+  MEM_freeN(hash_block);
+}
+
+/**
+ * Equivalent to #hash_array_from_data followed by #hash_accum,
+ * large arrays are split into blocks which are processed in parallel.
+ */
+static void hash_array_from_data_accum(const BArrayInfo *info,
+                                       const uchar *data_slice,
+                                       const size_t data_slice_len,
+                                       hash_key *hash_array)
+{
+  const size_t hash_array_len = data_slice_len / info->chunk_stride;
+  /* The last block takes the remainder, so every block is at least the full block size. */
+  const size_t blocks_num = hash_array_len / BCHUNK_HASH_ARRAY_PARALLEL_BLOCK_LEN;
+
+  if (blocks_num < 2) {
+    hash_array_from_data(info, data_slice, data_slice_len, hash_array);
+    hash_accum(hash_array, hash_array_len, info->accum_steps);
+    return;
+  }
+
+  HashArrayAccumData data = {
+      .info = info,
+      .data = data_slice,
+      .hash_array = hash_array,
+      .hash_array_len = hash_array_len,
+      .blocks_num = blocks_num,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, (int)blocks_num, &data, hash_array_accum_block_cb, &settings);
+}
+
 /**
  * When we only need a single value, can use a small optimization.
  * we can avoid accumulating the tail of the array a little, each iteration.
@@ -1206,9 +1285,7 @@ static BChunkList *bchunk_list_from_data_merge(const BArrayInfo *info,
     const size_t table_hash_array_len = (data_len - i_prev) / info->chunk_stride;
     hash_key *table_hash_array = MEM_mallocN(sizeof(*table_hash_array) * table_hash_array_len,
                                              __func__);
-    hash_array_from_data(info, &data[i_prev], data_len - i_prev, table_hash_array);
-
-    hash_accum(table_hash_array, table_hash_array_len, info->accum_steps);
+    hash_array_from_data_accum(info, &data[i_prev], data_len - i_prev, table_hash_array);
 #else
     /* dummy vars */
     uint i_table_start = 0;
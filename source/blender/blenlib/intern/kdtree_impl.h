@@ -22,9 +22,11 @@
 
 #include "BLI_kdtree_impl.h"
 #include "BLI_math.h"
-#include "BLI_strict_flags.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
+#include "BLI_strict_flags.h"
+
 #define _CONCAT_AUX(MACRO_ARG1, MACRO_ARG2) MACRO_ARG1##MACRO_ARG2
 #define _CONCAT(MACRO_ARG1, MACRO_ARG2) _CONCAT_AUX(MACRO_ARG1, MACRO_ARG2)
 #define BLI_kdtree_nd_(id) _CONCAT(KDTREE_PREFIX_ID, _##id)
@@ -145,20 +147,15 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+/**
+ * Quicksort style partitioning of `nodes` around the median on `axis`.
+ * Returns the median, all nodes before it are not greater, all nodes after it not smaller.
+ */
+static uint kdtree_balance_partition(KDTreeNode *nodes, uint nodes_len, uint axis)
 {
-  KDTreeNode *node;
   float co;
   uint left, right, median, i, j;
 
-  if (nodes_len <= 0) {
-    return KD_NODE_UNSET;
-  }
-  else if (nodes_len == 1) {
-    return 0 + ofs;
-  }
-
-  /* quicksort style sorting around median */
   left = 0;
   right = nodes_len - 1;
   median = nodes_len / 2;
@@ -190,7 +187,23 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
     }
   }
 
+  return median;
+}
+
+static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+{
+  KDTreeNode *node;
+  uint median;
+
+  if (nodes_len <= 0) {
+    return KD_NODE_UNSET;
+  }
+  else if (nodes_len == 1) {
+    return 0 + ofs;
+  }
+
   /* set node and sort subnodes */
+  median = kdtree_balance_partition(nodes, nodes_len, axis);
   node = &nodes[median];
   node->d = axis;
   axis = (axis + 1) % KD_DIMS;
@@ -201,6 +214,68 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
   return median + ofs;
 }
 
+/**
+ * Sub-trees with fewer nodes are balanced in a single task.
+ */
+#define KD_BALANCE_TASK_NODES_MIN 8192
+
+typedef struct KDTreeBalanceTask {
+  KDTreeNode *nodes;
+  uint nodes_len;
+  uint axis;
+  uint ofs;
+  /* Receives the root of the balanced sub-tree. */
+  uint *r_node;
+} KDTreeBalanceTask;
+
+static void kdtree_balance_task(TaskPool *__restrict pool, void *taskdata);
+
+static void kdtree_balance_task_push(TaskPool *pool,
+                                     KDTreeNode *nodes,
+                                     uint nodes_len,
+                                     uint axis,
+                                     uint ofs,
+                                     uint *r_node)
+{
+  if (nodes_len < KD_BALANCE_TASK_NODES_MIN) {
+    *r_node = kdtree_balance(nodes, nodes_len, axis, ofs);
+    return;
+  }
+
+  KDTreeBalanceTask *task = MEM_mallocN(sizeof(*task), __func__);
+  task->nodes = nodes;
+  task->nodes_len = nodes_len;
+  task->axis = axis;
+  task->ofs = ofs;
+  task->r_node = r_node;
+  BLI_task_pool_push(pool, kdtree_balance_task, task, true, NULL);
+}
+
+/**
+ * Partitioning leaves both halves independent of each other,
+ * so they are balanced as separate tasks, each writing only to its own range of nodes.
+ */
+static void kdtree_balance_task(TaskPool *__restrict pool, void *taskdata)
+{
+  const KDTreeBalanceTask *task = taskdata;
+  KDTreeNode *nodes = task->nodes;
+  const uint nodes_len = task->nodes_len;
+
+  const uint median = kdtree_balance_partition(nodes, nodes_len, task->axis);
+  KDTreeNode *node = &nodes[median];
+  node->d = task->axis;
+  *task->r_node = median + task->ofs;
+
+  const uint axis = (task->axis + 1) % KD_DIMS;
+  kdtree_balance_task_push(pool, nodes, median, axis, task->ofs, &node->left);
+  kdtree_balance_task_push(pool,
+                           nodes + median + 1,
+                           (nodes_len - (median + 1)),
+                           axis,
+                           (median + 1) + task->ofs,
+                           &node->right);
+}
+
 void BLI_kdtree_nd_(balance)(KDTree *tree)
 {
   if (tree->root != KD_NODE_ROOT_IS_INIT) {
@@ -210,7 +285,15 @@ void BLI_kdtree_nd_(balance)(KDTree *tree)
     }
   }
 
-  tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  if (tree->nodes_len < KD_BALANCE_TASK_NODES_MIN) {
+    tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  }
+  else {
+    TaskPool *pool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+    kdtree_balance_task_push(pool, tree->nodes, tree->nodes_len, 0, 0, &tree->root);
+    BLI_task_pool_work_and_wait(pool);
+    BLI_task_pool_free(pool);
+  }
 
 #ifdef DEBUG
   tree->is_balanced = true;
@@ -806,6 +889,112 @@ finally:
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Batch Queries
+ *
+ * Run many queries on the same tree in parallel.
+ * \{ */
+
+#define KD_BATCH_QUERY_MIN_PER_THREAD 256
+
+typedef struct KDTreeBatchQueryData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+  KDTreeNearest *r_nearest;
+  float range;
+  bool (*search_cb)(
+      void *user_data, int search_index, int index, const float co[KD_DIMS], float dist_sq);
+  void *user_data;
+} KDTreeBatchQueryData;
+
+static void kdtree_find_nearest_batch_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchQueryData *data = userdata;
+  KDTreeNearest *nearest = &data->r_nearest[i];
+  if (BLI_kdtree_nd_(find_nearest)(data->tree, data->co[i], nearest) == -1) {
+    nearest->index = -1;
+  }
+}
+
+/**
+ * Find the nearest node for each of `co`, `r_nearest[i].index` is -1 when nothing is found.
+ */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const int co_len,
+                                        KDTreeNearest *r_nearest)
+{
+  KDTreeBatchQueryData data = {
+      .tree = tree,
+      .co = co,
+      .r_nearest = r_nearest,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = KD_BATCH_QUERY_MIN_PER_THREAD;
+  BLI_task_parallel_range(0, co_len, &data, kdtree_find_nearest_batch_cb, &settings);
+}
+
+typedef struct KDTreeBatchRangeSearch {
+  const KDTreeBatchQueryData *data;
+  int search_index;
+} KDTreeBatchRangeSearch;
+
+static bool kdtree_range_search_batch_search_cb(void *user_data,
+                                                int index,
+                                                const float co[KD_DIMS],
+                                                float dist_sq)
+{
+  const KDTreeBatchRangeSearch *search = user_data;
+  return search->data->search_cb(
+      search->data->user_data, search->search_index, index, co, dist_sq);
+}
+
+static void kdtree_range_search_batch_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchQueryData *data = userdata;
+  KDTreeBatchRangeSearch search = {data, i};
+  BLI_kdtree_nd_(range_search_cb)(
+      data->tree, data->co[i], data->range, kdtree_range_search_batch_search_cb, &search);
+}
+
+/**
+ * Version of #BLI_kdtree_nd_(range_search_cb) for many search locations,
+ * `search_index` is the index into `co` the result belongs to.
+ *
+ * \note `search_cb` is called from multiple threads,
+ * returning false only stops the search for the current location.
+ */
+void BLI_kdtree_nd_(range_search_batch_cb)(
+    const KDTree *tree,
+    const float (*co)[KD_DIMS],
+    const int co_len,
+    float range,
+    bool (*search_cb)(
+        void *user_data, int search_index, int index, const float co[KD_DIMS], float dist_sq),
+    void *user_data)
+{
+  KDTreeBatchQueryData data = {
+      .tree = tree,
+      .co = co,
+      .range = range,
+      .search_cb = search_cb,
+      .user_data = user_data,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = KD_BATCH_QUERY_MIN_PER_THREAD;
+  BLI_task_parallel_range(0, co_len, &data, kdtree_range_search_batch_cb, &settings);
+}
+
+/** \} */
+
 /**
  * Use when we want to loop over nodes ordered by index.
  * Requires indices to be aligned with nodes.
@@ -0,0 +1,477 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * Stable sorting of large arrays using the task scheduler.
+ *
+ * - Radix sort: LSD radix sort on 32 bit keys with an optional payload.
+ *   The array is split into blocks, each pass counts the digits of every block in parallel,
+ *   then scatters the blocks in parallel using per-block offsets.
+ * - Merge sort: sorts blocks in parallel, then merges runs level by level.
+ *   Every level is split into output segments, the start of a segment in both input runs
+ *   is found with a binary search (merge path), so even the last merge runs in parallel.
+ *
+ * Both sorts are stable and the result does not depend on the number of threads.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_sort.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "BLI_strict_flags.h"
+
+/* -------------------------------------------------------------------- */
+/** \name Radix Sort
+ * \{ */
+
+#define RADIX_DIGIT_BITS 8
+#define RADIX_DIGIT_NUM (1 << RADIX_DIGIT_BITS)
+#define RADIX_DIGIT_MASK (RADIX_DIGIT_NUM - 1)
+
+/* Elements per block, fewer elements are sorted in a single block (no threading). */
+#define RADIX_BLOCK_LEN_MIN 65536
+#define RADIX_BLOCKS_MAX 64
+
+typedef struct RadixSortData {
+  const uint *keys_src;
+  const uint *values_src;
+  uint *keys_dst;
+  uint *values_dst;
+  size_t len;
+  int blocks_num;
+  uint shift;
+  /* Per block: the digit counts, then the scatter offsets. */
+  size_t (*block_offsets)[RADIX_DIGIT_NUM];
+} RadixSortData;
+
+BLI_INLINE void radix_block_range(const RadixSortData *data,
+                                  const int block,
+                                  size_t *r_start,
+                                  size_t *r_end)
+{
+  *r_start = (data->len * (size_t)block) / (size_t)data->blocks_num;
+  *r_end = (data->len * (size_t)(block + 1)) / (size_t)data->blocks_num;
+}
+
+static void radix_sort_count_cb(void *__restrict userdata,
+                                const int block,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const RadixSortData *data = userdata;
+  size_t *counts = data->block_offsets[block];
+  size_t start, end;
+  radix_block_range(data, block, &start, &end);
+
+  memset(counts, 0, sizeof(*data->block_offsets));
+  for (size_t i = start; i < end; i++) {
+    counts[(data->keys_src[i] >> data->shift) & RADIX_DIGIT_MASK]++;
+  }
+}
+
+static void radix_sort_scatter_cb(void *__restrict userdata,
+                                  const int block,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const RadixSortData *data = userdata;
+  size_t *offsets = data->block_offsets[block];
+  size_t start, end;
+  radix_block_range(data, block, &start, &end);
+
+  if (data->values_src) {
+    for (size_t i = start; i < end; i++) {
+      const uint key = data->keys_src[i];
+      const size_t dst = offsets[(key >> data->shift) & RADIX_DIGIT_MASK]++;
+      data->keys_dst[dst] = key;
+      data->values_dst[dst] = data->values_src[i];
+    }
+  }
+  else {
+    for (size_t i = start; i < end; i++) {
+      const uint key = data->keys_src[i];
+      data->keys_dst[offsets[(key >> data->shift) & RADIX_DIGIT_MASK]++] = key;
+    }
+  }
+}
+
+/**
+ * Stable sort of \a keys in ascending order.
+ *
+ * \param values: Optional payload (may be NULL), reordered along with the keys,
+ * typically the original indices of the keys.
+ */
+void BLI_radix_sort_uint(uint *keys, uint *values, const size_t len)
+{
+  if (len < 2) {
+    return;
+  }
+
+  RadixSortData data;
+  data.len = len;
+  data.blocks_num = (int)min_zz(max_zz(len / RADIX_BLOCK_LEN_MIN, 1), RADIX_BLOCKS_MAX);
+  data.block_offsets = MEM_mallocN(sizeof(*data.block_offsets) * (size_t)data.blocks_num,
+                                   __func__);
+
+  uint *keys_tmp = MEM_mallocN(sizeof(*keys) * len, __func__);
+  uint *values_tmp = values ? MEM_mallocN(sizeof(*values) * len, __func__) : NULL;
+
+  uint *keys_src = keys, *keys_dst = keys_tmp;
+  uint *values_src = values, *values_dst = values_tmp;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (data.blocks_num > 1);
+  settings.min_iter_per_thread = 1;
+
+  for (uint shift = 0; shift < sizeof(uint) * 8; shift += RADIX_DIGIT_BITS) {
+    data.keys_src = keys_src;
+    data.values_src = values_src;
+    data.keys_dst = keys_dst;
+    data.values_dst = values_dst;
+    data.shift = shift;
+
+    BLI_task_parallel_range(0, data.blocks_num, &data, radix_sort_count_cb, &settings);
+
+    /* Turn the counts into offsets, digit major so equal keys keep their block order. */
+    bool is_single_digit = false;
+    size_t offset = 0;
+    for (int digit = 0; digit < RADIX_DIGIT_NUM; digit++) {
+      const size_t digit_start = offset;
+      for (int block = 0; block < data.blocks_num; block++) {
+        const size_t count = data.block_offsets[block][digit];
+        data.block_offsets[block][digit] = offset;
+        offset += count;
+      }
+      if (offset - digit_start == len) {
+        is_single_digit = true;
+        break;
+      }
+    }
+    /* All keys share this digit, the pass would not change the order. */
+    if (is_single_digit) {
+      continue;
+    }
+
+    BLI_task_parallel_range(0, data.blocks_num, &data, radix_sort_scatter_cb, &settings);
+
+    SWAP(uint *, keys_src, keys_dst);
+    SWAP(uint *, values_src, values_dst);
+  }
+
+  if (keys_src != keys) {
+    memcpy(keys, keys_src, sizeof(*keys) * len);
+    if (values) {
+      memcpy(values, values_src, sizeof(*values) * len);
+    }
+  }
+
+  MEM_freeN(keys_tmp);
+  if (values_tmp) {
+    MEM_freeN(values_tmp);
+  }
+  MEM_freeN(data.block_offsets);
+}
+
+/**
+ * Same as #BLI_radix_sort_uint for signed keys.
+ */
+void BLI_radix_sort_int(int *keys, uint *values, const size_t len)
+{
+  /* Flipping the sign bit makes the unsigned order match the signed order. */
+  uint *keys_uint = (uint *)keys;
+  for (size_t i = 0; i < len; i++) {
+    keys_uint[i] ^= 0x80000000u;
+  }
+  BLI_radix_sort_uint(keys_uint, values, len);
+  for (size_t i = 0; i < len; i++) {
+    keys_uint[i] ^= 0x80000000u;
+  }
+}
+
+BLI_INLINE uint radix_key_from_float(const float f)
+{
+  union {
+    float f;
+    uint u;
+  } key = {f};
+  /* Negative numbers are flipped entirely so larger magnitudes sort first,
+   * positive numbers only get the sign bit set so they sort after all negative numbers. */
+  return key.u ^ ((key.u & 0x80000000u) ? 0xffffffffu : 0x80000000u);
+}
+
+BLI_INLINE float radix_key_to_float(const uint u)
+{
+  union {
+    uint u;
+    float f;
+  } key = {u ^ ((u & 0x80000000u) ? 0x80000000u : 0xffffffffu)};
+  return key.f;
+}
+
+/**
+ * Same as #BLI_radix_sort_uint for float keys. NaN values sort after (positive NaN)
+ * or before (negative NaN) all other values, -0.0 sorts before 0.0.
+ */
+void BLI_radix_sort_float(float *keys, uint *values, const size_t len)
+{
+  if (len < 2) {
+    return;
+  }
+
+  uint *keys_uint = MEM_mallocN(sizeof(*keys_uint) * len, __func__);
+  for (size_t i = 0; i < len; i++) {
+    keys_uint[i] = radix_key_from_float(keys[i]);
+  }
+  BLI_radix_sort_uint(keys_uint, values, len);
+  for (size_t i = 0; i < len; i++) {
+    keys[i] = radix_key_to_float(keys_uint[i]);
+  }
+  MEM_freeN(keys_uint);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Merge Sort
+ * \{ */
+
+/* Elements sorted by a single task before merging, must be a power of two. */
+#define MERGE_BLOCK_LEN 4096
+/* Runs of this length are sorted with insertion sort inside a block. */
+#define MERGE_INSERTION_LEN 16
+/* Output elements merged by a single task, must be a power of two. */
+#define MERGE_SEGMENT_LEN 16384
+
+typedef struct MergeSortData {
+  char *array;
+  char *array_tmp;
+  size_t len;
+  size_t es;
+  BLI_sort_cmp_t cmp;
+  void *thunk;
+
+  /* Merge level. */
+  char *src;
+  char *dst;
+  size_t run_len;
+  size_t segment_len;
+} MergeSortData;
+
+/* Constant sizes let the compiler replace the call with a single move. */
+BLI_INLINE void merge_copy(char *dst, const char *src, const size_t es)
+{
+  switch (es) {
+    case 4:
+      memcpy(dst, src, 4);
+      break;
+    case 8:
+      memcpy(dst, src, 8);
+      break;
+    case 16:
+      memcpy(dst, src, 16);
+      break;
+    default:
+      memcpy(dst, src, es);
+      break;
+  }
+}
+
+static void merge_insertion_sort(char *array,
+                                 const size_t len,
+                                 char *elem_tmp,
+                                 const MergeSortData *data)
+{
+  const size_t es = data->es;
+  for (size_t i = 1; i < len; i++) {
+    char *p = array + i * es;
+    if (data->cmp(p - es, p, data->thunk) <= 0) {
+      continue;
+    }
+    merge_copy(elem_tmp, p, es);
+    do {
+      merge_copy(p, p - es, es);
+      p -= es;
+    } while (p > array && data->cmp(p - es, elem_tmp, data->thunk) > 0);
+    merge_copy(p, elem_tmp, es);
+  }
+}
+
+/**
+ * Merge the sorted runs \a a and \a b into \a dst, on equal elements \a a goes first.
+ */
+static void merge_runs(const char *a,
+                       size_t a_len,
+                       const char *b,
+                       size_t b_len,
+                       char *dst,
+                       const MergeSortData *data)
+{
+  const size_t es = data->es;
+  while (a_len && b_len) {
+    if (data->cmp(a, b, data->thunk) <= 0) {
+      merge_copy(dst, a, es);
+      a += es;
+      a_len--;
+    }
+    else {
+      merge_copy(dst, b, es);
+      b += es;
+      b_len--;
+    }
+    dst += es;
+  }
+  if (a_len) {
+    memcpy(dst, a, a_len * es);
+  }
+  else if (b_len) {
+    memcpy(dst, b, b_len * es);
+  }
+}
+
+/**
+ * Find how many elements of \a a are in the first \a dst_len elements of the merged output.
+ */
+static size_t merge_path_search(const char *a,
+                                const size_t a_len,
+                                const char *b,
+                                const size_t b_len,
+                                const size_t dst_len,
+                                const MergeSortData *data)
+{
+  const size_t es = data->es;
+  size_t lo = (dst_len > b_len) ? dst_len - b_len : 0;
+  size_t hi = min_zz(dst_len, a_len);
+  while (lo < hi) {
+    const size_t mid = (lo + hi) / 2;
+    if (data->cmp(a + mid * es, b + (dst_len - mid - 1) * es, data->thunk) <= 0) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static void merge_sort_block_cb(void *__restrict userdata,
+                                const int block,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MergeSortData *data = userdata;
+  const size_t es = data->es;
+  const size_t start = (size_t)block * MERGE_BLOCK_LEN;
+  const size_t len = min_zz(MERGE_BLOCK_LEN, data->len - start);
+
+  char *src = data->array + start * es;
+  char *dst = data->array_tmp + start * es;
+
+  /* The temporary block is unused until merging, use it to hold the element being inserted. */
+  for (size_t i = 0; i < len; i += MERGE_INSERTION_LEN) {
+    merge_insertion_sort(src + i * es, min_zz(MERGE_INSERTION_LEN, len - i), dst, data);
+  }
+
+  for (size_t run_len = MERGE_INSERTION_LEN; run_len < len; run_len *= 2) {
+    for (size_t i = 0; i < len; i += run_len * 2) {
+      const size_t a_len = min_zz(run_len, len - i);
+      const size_t b_len = min_zz(run_len, len - i - a_len);
+      merge_runs(src + i * es, a_len, src + (i + a_len) * es, b_len, dst + i * es, data);
+    }
+    SWAP(char *, src, dst);
+  }
+
+  /* Keep the sorted block in the array, merging starts from there. */
+  if (src != data->array + start * es) {
+    memcpy(data->array + start * es, src, len * es);
+  }
+}
+
+static void merge_sort_segment_cb(void *__restrict userdata,
+                                  const int segment,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MergeSortData *data = userdata;
+  const size_t es = data->es;
+  const size_t start = (size_t)segment * data->segment_len;
+  const size_t end = min_zz(start + data->segment_len, data->len);
+
+  /* The segment length divides the length of two runs, so a segment never spans two merges. */
+  const size_t pair_start = start - (start % (data->run_len * 2));
+  const size_t a_len = min_zz(data->run_len, data->len - pair_start);
+  const size_t b_len = min_zz(data->run_len, data->len - pair_start - a_len);
+  const char *a = data->src + pair_start * es;
+  const char *b = a + a_len * es;
+
+  const size_t a_start = merge_path_search(a, a_len, b, b_len, start - pair_start, data);
+  const size_t a_end = merge_path_search(a, a_len, b, b_len, end - pair_start, data);
+  const size_t b_start = (start - pair_start) - a_start;
+  const size_t b_end = (end - pair_start) - a_end;
+
+  merge_runs(a + a_start * es,
+             a_end - a_start,
+             b + b_start * es,
+             b_end - b_start,
+             data->dst + start * es,
+             data);
+}
+
+/**
+ * Stable sort with the same arguments as #BLI_qsort_r,
+ * large arrays are sorted in parallel, \a cmp has to be thread-safe.
+ */
+void BLI_merge_sort_r(void *a, size_t n, size_t es, BLI_sort_cmp_t cmp, void *thunk)
+{
+  if (n < 2) {
+    return;
+  }
+
+  MergeSortData data;
+  data.array = a;
+  data.array_tmp = MEM_mallocN(n * es, __func__);
+  data.len = n;
+  data.es = es;
+  data.cmp = cmp;
+  data.thunk = thunk;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (n > MERGE_BLOCK_LEN);
+  settings.min_iter_per_thread = 1;
+
+  const int blocks_num = (int)((n + MERGE_BLOCK_LEN - 1) / MERGE_BLOCK_LEN);
+  BLI_task_parallel_range(0, blocks_num, &data, merge_sort_block_cb, &settings);
+
+  data.src = data.array;
+  data.dst = data.array_tmp;
+  for (data.run_len = MERGE_BLOCK_LEN; data.run_len < n; data.run_len *= 2) {
+    data.segment_len = min_zz(data.run_len * 2, MERGE_SEGMENT_LEN);
+    const int segments_num = (int)((n + data.segment_len - 1) / data.segment_len);
+    BLI_task_parallel_range(0, segments_num, &data, merge_sort_segment_cb, &settings);
+    SWAP(char *, data.src, data.dst);
+  }
+
+  if (data.src != data.array) {
+    memcpy(data.array, data.src, n * es);
+  }
+  MEM_freeN(data.array_tmp);
+}
+
+/** \} */
@@ -32,6 +32,7 @@
 #include "BLI_mempool.h"
 #include "BLI_task.h"
 #include "BLI_threads.h"
+#include "BLI_trace.h"
 
 #ifdef WITH_TBB
 /* Quiet top level deprecation message, unrelated to API usage here. */
@@ -492,6 +493,7 @@ void BLI_task_pool_push(TaskPool *pool,
 
 void BLI_task_pool_work_and_wait(TaskPool *pool)
 {
+  BLI_trace_scope_begin("Task pool work and wait");
   switch (pool->type) {
     case TASK_POOL_TBB:
     case TASK_POOL_TBB_SUSPENDED:
@@ -503,6 +505,7 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
       background_task_pool_work_and_wait(pool);
       break;
   }
+  BLI_trace_scope_end();
 }
 
 void BLI_task_pool_cancel(TaskPool *pool)
@@ -0,0 +1,326 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_trace.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+
+/* Events per thread, when more are recorded the oldest ones are overwritten. */
+#define TRACE_THREAD_EVENTS_NUM (1 << 14)
+#define TRACE_STACK_DEPTH_MAX 64
+#define TRACE_NAME_MAX 64
+
+typedef struct TraceEvent {
+  double start;
+  double end;
+  char name[TRACE_NAME_MAX];
+} TraceEvent;
+
+typedef struct TraceThread {
+  struct TraceThread *next;
+  int id;
+  bool is_main;
+
+  /* Scopes which are begun but not ended yet, deeper scopes are counted but not recorded. */
+  TraceEvent stack[TRACE_STACK_DEPTH_MAX];
+  int stack_depth;
+
+  /* Ring buffer of ended scopes, only written by the owning thread. */
+  TraceEvent events[TRACE_THREAD_EVENTS_NUM];
+  uint64_t events_num;
+} TraceThread;
+
+static struct {
+  /* Read without locking by every scope marker, so only accessed atomically. */
+  int32_t enabled;
+  /* Number of threads currently recording an event, tracing only stops once it drops to zero
+   * so the thread buffers can be read and freed. */
+  int32_t writers_num;
+  /* Incremented for every tracing session, to detect thread buffers of previous sessions. */
+  int session;
+  char filepath[FILE_MAX];
+  double start_time;
+
+  /* All threads which recorded events in the current session, freed when tracing stops. */
+  TraceThread *threads;
+  int threads_num;
+  ThreadMutex threads_lock;
+} g_trace = {0, 0, 0, "", 0.0, NULL, 0, BLI_MUTEX_INITIALIZER};
+
+/* Only valid when the session matches the current one, the buffer is freed otherwise. */
+static ThreadLocal(TraceThread *) trace_thread;
+static ThreadLocal(void *) trace_thread_session;
+static bool trace_thread_local_created = false;
+
+/* Must only be called between #trace_writer_begin and #trace_writer_end. */
+static TraceThread *trace_thread_get(const bool create)
+{
+  if (LIKELY(POINTER_AS_INT(BLI_thread_local_get(trace_thread_session)) == g_trace.session)) {
+    return BLI_thread_local_get(trace_thread);
+  }
+  if (!create) {
+    return NULL;
+  }
+
+  /* Allocated with the system allocator, so tracing does not show up in memory statistics. */
+  TraceThread *thread = calloc(1, sizeof(TraceThread));
+  if (thread == NULL) {
+    return NULL;
+  }
+  thread->is_main = BLI_thread_is_main();
+
+  BLI_mutex_lock(&g_trace.threads_lock);
+  thread->id = g_trace.threads_num++;
+  thread->next = g_trace.threads;
+  g_trace.threads = thread;
+  BLI_mutex_unlock(&g_trace.threads_lock);
+
+  BLI_thread_local_set(trace_thread, thread);
+  BLI_thread_local_set(trace_thread_session, POINTER_FROM_INT(g_trace.session));
+  return thread;
+}
+
+/* Returns the buffer of the calling thread, or NULL when nothing should be recorded. When not
+ * NULL, #trace_writer_end must be called once recording is done. */
+static TraceThread *trace_writer_begin(const bool create)
+{
+  if (LIKELY(!atomic_load_int32(&g_trace.enabled))) {
+    return NULL;
+  }
+
+  /* Check again after registering as writer, stopping may have started in between. Both atomic
+   * operations are full barriers, see #trace_stop. */
+  atomic_add_and_fetch_int32(&g_trace.writers_num, 1);
+  if (atomic_cas_int32(&g_trace.enabled, 1, 1) == 0) {
+    atomic_sub_and_fetch_int32(&g_trace.writers_num, 1);
+    return NULL;
+  }
+
+  TraceThread *thread = trace_thread_get(create);
+  if (thread == NULL) {
+    atomic_sub_and_fetch_int32(&g_trace.writers_num, 1);
+  }
+  return thread;
+}
+
+static void trace_writer_end(void)
+{
+  atomic_sub_and_fetch_int32(&g_trace.writers_num, 1);
+}
+
+/* Disable recording and wait for threads which are still writing an event. Returns false when
+ * tracing was not enabled. */
+static bool trace_stop(void)
+{
+  if (atomic_cas_int32(&g_trace.enabled, 1, 0) == 0) {
+    return false;
+  }
+  /* Writers only take a few microseconds, no need to sleep. */
+  while (atomic_cas_int32(&g_trace.writers_num, 0, 0) != 0) {
+    /* Pass. */
+  }
+  return true;
+}
+
+static void trace_threads_free(void)
+{
+  BLI_mutex_lock(&g_trace.threads_lock);
+  TraceThread *thread = g_trace.threads;
+  while (thread) {
+    TraceThread *next = thread->next;
+    free(thread);
+    thread = next;
+  }
+  g_trace.threads = NULL;
+  g_trace.threads_num = 0;
+  BLI_mutex_unlock(&g_trace.threads_lock);
+}
+
+void BLI_trace_begin(const char *filepath)
+{
+  if (!trace_thread_local_created) {
+    BLI_thread_local_create(trace_thread);
+    BLI_thread_local_create(trace_thread_session);
+    trace_thread_local_created = true;
+  }
+
+  /* Discard an unfinished session. */
+  if (trace_stop()) {
+    trace_threads_free();
+  }
+
+  BLI_strncpy(g_trace.filepath, filepath, sizeof(g_trace.filepath));
+  g_trace.start_time = PIL_check_seconds_timer();
+  /* Thread local storage initializes the session to zero, so never use it. */
+  g_trace.session++;
+  if (g_trace.session == 0) {
+    g_trace.session++;
+  }
+  atomic_cas_int32(&g_trace.enabled, 0, 1);
+}
+
+bool BLI_trace_is_enabled(void)
+{
+  return atomic_load_int32(&g_trace.enabled) != 0;
+}
+
+/* Returns the event to fill in, or NULL when the scope is not recorded. */
+static TraceEvent *trace_scope_push(TraceThread *thread)
+{
+  TraceEvent *event = NULL;
+  if (thread->stack_depth < TRACE_STACK_DEPTH_MAX) {
+    event = &thread->stack[thread->stack_depth];
+    event->start = PIL_check_seconds_timer() - g_trace.start_time;
+  }
+  thread->stack_depth++;
+  return event;
+}
+
+void BLI_trace_scope_begin(const char *name)
+{
+  TraceThread *thread = trace_writer_begin(true);
+  if (LIKELY(thread == NULL)) {
+    return;
+  }
+  TraceEvent *event = trace_scope_push(thread);
+  if (event) {
+    BLI_strncpy(event->name, name, sizeof(event->name));
+  }
+  trace_writer_end();
+}
+
+void BLI_trace_scope_begin_fmt(const char *format, ...)
+{
+  TraceThread *thread = trace_writer_begin(true);
+  if (LIKELY(thread == NULL)) {
+    return;
+  }
+  TraceEvent *event = trace_scope_push(thread);
+  if (event) {
+    va_list args;
+    va_start(args, format);
+    BLI_vsnprintf(event->name, sizeof(event->name), format, args);
+    va_end(args);
+  }
+  trace_writer_end();
+}
+
+void BLI_trace_scope_end(void)
+{
+  /* The thread has no buffer in this session when the scope began before tracing started. */
+  TraceThread *thread = trace_writer_begin(false);
+  if (LIKELY(thread == NULL)) {
+    return;
+  }
+
+  if (thread->stack_depth > 0) {
+    thread->stack_depth--;
+    if (thread->stack_depth < TRACE_STACK_DEPTH_MAX) {
+      TraceEvent *event = &thread->events[thread->events_num % TRACE_THREAD_EVENTS_NUM];
+      *event = thread->stack[thread->stack_depth];
+      event->end = PIL_check_seconds_timer() - g_trace.start_time;
+      thread->events_num++;
+    }
+  }
+  trace_writer_end();
+}
+
+static void trace_write_name(FILE *file, const char *name)
+{
+  fputc('"', file);
+  for (const char *c = name; *c; c++) {
+    if (ELEM(*c, '"', '\\')) {
+      fputc('\\', file);
+      fputc(*c, file);
+    }
+    else if ((unsigned char)*c < 0x20) {
+      fputc(' ', file);
+    }
+    else {
+      fputc(*c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+bool BLI_trace_end(void)
+{
+  if (!trace_stop()) {
+    return false;
+  }
+
+  FILE *file = BLI_fopen(g_trace.filepath, "w");
+  if (file == NULL) {
+    printf("Failed to write trace file '%s'\n", g_trace.filepath);
+    trace_threads_free();
+    return false;
+  }
+
+  fputs("{\"traceEvents\":[\n", file);
+  bool first = true;
+
+  BLI_mutex_lock(&g_trace.threads_lock);
+  for (TraceThread *thread = g_trace.threads; thread; thread = thread->next) {
+    fprintf(file,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s %d\"}}",
+            first ? "" : ",\n",
+            thread->id,
+            thread->is_main ? "Main" : "Thread",
+            thread->id);
+    first = false;
+
+    uint64_t events_begin = 0;
+    if (thread->events_num > TRACE_THREAD_EVENTS_NUM) {
+      events_begin = thread->events_num - TRACE_THREAD_EVENTS_NUM;
+    }
+    for (uint64_t i = events_begin; i < thread->events_num; i++) {
+      const TraceEvent *event = &thread->events[i % TRACE_THREAD_EVENTS_NUM];
+      fputs(",\n{\"name\":", file);
+      trace_write_name(file, event->name);
+      /* Chrome trace timestamps are in microseconds. */
+      fprintf(file,
+              ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+              thread->id,
+              event->start * 1e6,
+              (event->end - event->start) * 1e6);
+    }
+  }
+  BLI_mutex_unlock(&g_trace.threads_lock);
+
+  fputs("\n]}\n", file);
+  fclose(file);
+
+  trace_threads_free();
+
+  printf("Trace written to '%s'\n", g_trace.filepath);
+  return true;
+}
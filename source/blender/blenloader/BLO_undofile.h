@@ -74,6 +74,7 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
 void BLO_memfile_write_finalize(MemFileWriteData *mem_data);
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, unsigned int size);
+void BLO_memfile_chunk_add_reused(MemFileWriteData *mem_data, MemFileChunk *reference_chunk);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
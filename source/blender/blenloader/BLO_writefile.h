@@ -70,7 +70,8 @@ extern bool BLO_write_file(struct Main *mainvar,
 extern bool BLO_write_file_mem(struct Main *mainvar,
                                struct MemFile *compare,
                                struct MemFile *current,
-                               int write_flags);
+                               int write_flags,
+                               bool use_id_reuse);
 
 /** \} */
 
@@ -35,6 +35,7 @@
 #include "BLI_linklist.h"
 #include "BLI_listbase.h"
 #include "BLI_string.h"
+#include "BLI_trace.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_genfile.h"
@@ -313,6 +314,7 @@ BlendFileData *BLO_read_from_file(const char *filepath,
   BlendFileData *bfd = NULL;
   FileData *fd;
 
+  BLI_trace_scope_begin("Read file");
   fd = blo_filedata_from_file(filepath, reports);
   if (fd) {
     fd->reports = reports;
@@ -320,6 +322,7 @@ BlendFileData *BLO_read_from_file(const char *filepath,
     bfd = blo_read_file_internal(fd, filepath);
     blo_filedata_free(fd);
   }
+  BLI_trace_scope_end();
 
   return bfd;
 }
@@ -396,7 +399,9 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain,
      * read IDs whenever possible. */
     blo_cache_storage_init(fd, oldmain);
 
+    BLI_trace_scope_begin("Read undo memfile");
     bfd = blo_read_file_internal(fd, filename);
+    BLI_trace_scope_end();
 
     /* Ensure relinked caches are not freed together with their old IDs. */
     blo_cache_storage_old_bmain_clear(fd, oldmain);
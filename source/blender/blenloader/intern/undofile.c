@@ -192,6 +192,25 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, uint siz
   }
 }
 
+/**
+ * Add a chunk sharing the memory of \a reference_chunk from the reference memfile,
+ * for data known to be unchanged, which then does not have to be written and compared again.
+ */
+void BLO_memfile_chunk_add_reused(MemFileWriteData *mem_data, MemFileChunk *reference_chunk)
+{
+  MemFile *memfile = mem_data->written_memfile;
+
+  MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
+  curchunk->size = reference_chunk->size;
+  curchunk->buf = reference_chunk->buf;
+  curchunk->is_identical = true;
+  curchunk->is_identical_future = true;
+  curchunk->id_session_uuid = reference_chunk->id_session_uuid;
+  BLI_addtail(&memfile->chunks, curchunk);
+
+  reference_chunk->is_identical_future = true;
+}
+
 struct Main *BLO_memfile_main_get(struct MemFile *memfile,
                                   struct Main *oldmain,
                                   struct Scene **r_scene)
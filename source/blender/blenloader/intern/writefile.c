@@ -149,6 +149,7 @@
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_mempool.h"
+#include "BLI_trace.h"
 #include "MEM_guardedalloc.h"  // MEM_freeN
 
 #include "BKE_action.h"
@@ -187,8 +188,12 @@
 
 #include "readfile.h"
 
+#include "CLG_log.h"
+
 #include <errno.h>
 
+static CLG_LogRef LOG = {"blo.writefile"};
+
 /* Make preferences read-only. */
 #define U (*((const UserDef *)&U))
 
@@ -331,6 +336,11 @@ typedef struct {
   MemFileWriteData mem;
   /** When true, write to #WriteData.current, could also call 'is_undo'. */
   bool use_memfile;
+  /**
+   * When true, IDs which were not tagged as changed since the reference #MemFile was written
+   * re-use their chunks from it, see #mywrite_id_reuse_chunk_find.
+   */
+  bool use_memfile_id_reuse;
 
   /**
    * Wrap writing, so we can use zlib or
@@ -544,6 +554,138 @@ static void mywrite_id_end(WriteData *wd, ID *UNUSED(id))
   }
 }
 
+/**
+ * Whether \a id was not tagged as changed since the last undo push,
+ * this must be checked before the tags are cleared for the next push.
+ *
+ * Only types of data-blocks which are tagged when edited are considered, others
+ * (UI data, scenes, texts, brushes, images...) are often changed without tagging.
+ */
+static bool mywrite_id_is_untagged(const ID *id)
+{
+  if (id->lib != NULL) {
+    return false;
+  }
+
+  switch ((ID_Type)GS(id->name)) {
+    case ID_OB:
+    case ID_ME:
+    case ID_CU:
+    case ID_MB:
+    case ID_LT:
+    case ID_KE:
+    case ID_MA:
+    case ID_TE:
+    case ID_LA:
+    case ID_CA:
+    case ID_WO:
+    case ID_GR:
+    case ID_NT:
+    case ID_LP:
+    case ID_SPK:
+    case ID_HA:
+    case ID_PT:
+    case ID_VO:
+      break;
+    default:
+      return false;
+  }
+
+  if (id->recalc_after_undo_push != 0) {
+    return false;
+  }
+  const bNodeTree *nodetree = ntreeFromID((ID *)id);
+  if (nodetree != NULL && nodetree->id.recalc_after_undo_push != 0) {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Find the chunks written for \a id in the reference undo step, which can be re-used instead of
+ * writing it again for an ID which was not tagged as changed since then.
+ *
+ * As a last check against untagged changes, the ID header stored in the reference chunks must
+ * match the current one, which also catches re-named and re-allocated IDs.
+ *
+ * \return the first reference chunk of the ID, or NULL when it can't be re-used.
+ */
+static MemFileChunk *mywrite_id_reuse_chunk_find(WriteData *wd, const ID *id)
+{
+  if (wd->mem.id_session_uuid_mapping == NULL) {
+    return NULL;
+  }
+  MemFileChunk *ref_chunk = BLI_ghash_lookup(wd->mem.id_session_uuid_mapping,
+                                             POINTER_FROM_UINT(id->session_uuid));
+  if (ref_chunk == NULL) {
+    return NULL;
+  }
+
+  /* The ID struct is always written first, at the start of its first chunk. */
+  if (ref_chunk->size < sizeof(BHead) + sizeof(ID)) {
+    return NULL;
+  }
+  const BHead *bhead = (const BHead *)ref_chunk->buf;
+  if ((bhead->code != GS(id->name)) || (bhead->old != id)) {
+    return NULL;
+  }
+  ID id_header = *id;
+  id_header.tag = 0;
+  id_header.prev = NULL;
+  id_header.next = NULL;
+  if (memcmp(bhead + 1, &id_header, sizeof(ID)) != 0) {
+    return NULL;
+  }
+  return ref_chunk;
+}
+
+/**
+ * Add the reference chunks of \a id found by #mywrite_id_reuse_chunk_find to the undo step.
+ */
+static void mywrite_id_reuse_chunks(WriteData *wd, const ID *id, MemFileChunk *ref_chunk)
+{
+  /* Chunks of the previous ID were flushed by #mywrite_id_end. */
+  BLI_assert(wd->buf_used_len == 0);
+
+  MemFileChunk *chunk = ref_chunk;
+  for (; chunk && (chunk->id_session_uuid == id->session_uuid); chunk = chunk->next) {
+    BLO_memfile_chunk_add_reused(&wd->mem, chunk);
+  }
+  wd->mem.reference_current_chunk = chunk;
+}
+
+/**
+ * With `--debug-io`, IDs with re-usable chunks are written anyway and the result is compared with
+ * the reference chunks, to find code changing data without tagging the ID. Such changes would not
+ * be undone when the chunks are re-used.
+ *
+ * \param chunk_last: Last chunk of the undo step before \a id was written.
+ */
+static void mywrite_id_reuse_check(WriteData *wd,
+                                   const ID *id,
+                                   const MemFileChunk *ref_chunk,
+                                   const MemFileChunk *chunk_last)
+{
+  const MemFileChunk *chunk = chunk_last ? chunk_last->next :
+                                           wd->mem.written_memfile->chunks.first;
+  bool is_identical = true;
+  for (; chunk && ref_chunk && (ref_chunk->id_session_uuid == id->session_uuid);
+       chunk = chunk->next, ref_chunk = ref_chunk->next) {
+    is_identical &= chunk->is_identical;
+  }
+  /* Both must have the same number of chunks. */
+  if (chunk != NULL || (ref_chunk && ref_chunk->id_session_uuid == id->session_uuid)) {
+    is_identical = false;
+  }
+
+  if (!is_identical) {
+    CLOG_WARN(&LOG,
+              "'%s' was changed without being tagged, re-using its undo data would lose the "
+              "changes",
+              id->name);
+  }
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -4015,6 +4157,7 @@ static bool write_file_handle(Main *mainvar,
                               MemFile *current,
                               int write_flags,
                               bool use_userdef,
+                              bool use_memfile_id_reuse,
                               const BlendThumbnail *thumb)
 {
   BHead bhead;
@@ -4025,6 +4168,7 @@ static bool write_file_handle(Main *mainvar,
   blo_split_main(&mainlist, mainvar);
 
   wd = mywrite_begin(ww, compare, current);
+  wd->use_memfile_id_reuse = wd->use_memfile && (compare != NULL) && use_memfile_id_reuse;
   BlendWriter writer = {wd};
 
   sprintf(buf,
@@ -4082,6 +4226,8 @@ static bool write_file_handle(Main *mainvar,
           BKE_lib_override_library_operations_store_start(bmain, override_storage, id);
         }
 
+        const bool id_is_untagged = wd->use_memfile_id_reuse && mywrite_id_is_untagged(id);
+
         if (wd->use_memfile) {
           /* Record the changes that happened up to this undo push in
            * recalc_up_to_undo_push, and clear recalc_after_undo_push again
@@ -4104,6 +4250,14 @@ static bool write_file_handle(Main *mainvar,
           }
         }
 
+        MemFileChunk *reuse_chunk = id_is_untagged ? mywrite_id_reuse_chunk_find(wd, id) : NULL;
+        if (reuse_chunk != NULL && (G.debug & G_DEBUG_IO) == 0) {
+          mywrite_id_reuse_chunks(wd, id, reuse_chunk);
+          continue;
+        }
+        const MemFileChunk *reuse_chunk_last = reuse_chunk ? wd->mem.written_memfile->chunks.last :
+                                                             NULL;
+
         mywrite_id_begin(wd, id);
 
         memcpy(id_buffer, id, idtype_struct_size);
@@ -4248,6 +4402,10 @@ static bool write_file_handle(Main *mainvar,
         }
 
         mywrite_id_end(wd, id);
+
+        if (reuse_chunk != NULL) {
+          mywrite_id_reuse_check(wd, id, reuse_chunk, reuse_chunk_last);
+        }
       }
 
       if (id_buffer != id_buffer_static) {
@@ -4445,7 +4603,10 @@ bool BLO_write_file(Main *mainvar,
   }
 
   /* actual file writing */
-  const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, use_userdef, thumb);
+  BLI_trace_scope_begin("Write file");
+  const bool err = write_file_handle(
+      mainvar, &ww, NULL, NULL, write_flags, use_userdef, false, thumb);
+  BLI_trace_scope_end();
 
   ww.close(&ww);
 
@@ -4485,14 +4646,22 @@ bool BLO_write_file(Main *mainvar,
 }
 
 /**
+ * \param use_id_reuse: Re-use the data stored in \a compare for IDs which were not tagged as
+ * changed since it was written, see #Main.is_memfile_undo_id_reuse_valid.
  * \return Success.
  */
-bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int write_flags)
+bool BLO_write_file_mem(Main *mainvar,
+                        MemFile *compare,
+                        MemFile *current,
+                        int write_flags,
+                        bool use_id_reuse)
 {
   bool use_userdef = false;
 
+  BLI_trace_scope_begin("Write undo memfile");
   const bool err = write_file_handle(
-      mainvar, NULL, compare, current, write_flags, use_userdef, NULL);
+      mainvar, NULL, compare, current, write_flags, use_userdef, use_id_reuse, NULL);
+  BLI_trace_scope_end();
 
   return (err == 0);
 }
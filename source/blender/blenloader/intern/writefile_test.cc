@@ -0,0 +1,153 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <string>
+
+#include "CLG_log.h"
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_listbase.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_global.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+}
+
+namespace blender::blenloader::tests {
+
+static Mesh *writefile_test_mesh_add(Main *bmain, const char *name, const int verts_len)
+{
+  Mesh *mesh = BKE_mesh_add(bmain, name);
+  CustomData_add_layer(&mesh->vdata, CD_MVERT, CD_CALLOC, NULL, verts_len);
+  mesh->totvert = verts_len;
+  BKE_mesh_update_customdata_pointers(mesh, false);
+  for (int i = 0; i < verts_len; i++) {
+    mesh->mvert[i].co[0] = (float)i;
+  }
+  return mesh;
+}
+
+/* Data of all IDs written to the undo step, in order. Other data such as #FileGlobal is written
+ * from the stack, its address changes between writes. */
+static std::string writefile_test_memfile_data(const MemFile *memfile)
+{
+  std::string data;
+  LISTBASE_FOREACH (const MemFileChunk *, chunk, &memfile->chunks) {
+    if (chunk->id_session_uuid != MAIN_ID_SESSION_UUID_UNSET) {
+      data.append(chunk->buf, chunk->size);
+    }
+  }
+  return data;
+}
+
+class WriteFileUndoTest : public testing::Test {
+ protected:
+  Main *bmain = nullptr;
+  Mesh *mesh_a = nullptr;
+  Mesh *mesh_b = nullptr;
+  MemFile reference = {{nullptr, nullptr}, 0};
+
+  void SetUp() override
+  {
+    CLG_init();
+    BLI_threadapi_init();
+    DNA_sdna_current_init();
+    BKE_idtype_init();
+
+    bmain = BKE_main_new();
+    mesh_a = writefile_test_mesh_add(bmain, "A", 10000);
+    mesh_b = writefile_test_mesh_add(bmain, "B", 100);
+    ASSERT_TRUE(BLO_write_file_mem(bmain, nullptr, &reference, 0, false));
+  }
+
+  void TearDown() override
+  {
+    BKE_main_free(bmain);
+    BLO_memfile_free(&reference);
+    DNA_sdna_current_free();
+    BLI_threadapi_exit();
+    CLG_exit();
+  }
+
+  /* Write an undo step re-using the untagged IDs from the reference one, and a full one. */
+  void write_steps(std::string *r_reuse, std::string *r_full)
+  {
+    /* Writing clears the tags, keep them for the second write. */
+    const int recalc_a = mesh_a->id.recalc_after_undo_push;
+    const int recalc_b = mesh_b->id.recalc_after_undo_push;
+
+    MemFile reuse = {{nullptr, nullptr}, 0};
+    EXPECT_TRUE(BLO_write_file_mem(bmain, &reference, &reuse, 0, true));
+    *r_reuse = writefile_test_memfile_data(&reuse);
+
+    mesh_a->id.recalc_after_undo_push = recalc_a;
+    mesh_b->id.recalc_after_undo_push = recalc_b;
+
+    MemFile full = {{nullptr, nullptr}, 0};
+    EXPECT_TRUE(BLO_write_file_mem(bmain, &reference, &full, 0, false));
+    *r_full = writefile_test_memfile_data(&full);
+
+    BLO_memfile_free(&reuse);
+    BLO_memfile_free(&full);
+  }
+};
+
+TEST_F(WriteFileUndoTest, ReuseMatchesFullWrite)
+{
+  mesh_b->mvert[0].co[1] = 1.0f;
+  mesh_b->id.recalc_after_undo_push = ID_RECALC_GEOMETRY;
+
+  std::string reuse, full;
+  write_steps(&reuse, &full);
+  EXPECT_TRUE(reuse == full);
+  EXPECT_TRUE(reuse != writefile_test_memfile_data(&reference));
+}
+
+TEST_F(WriteFileUndoTest, ReuseUntaggedChange)
+{
+  /* Changes without a tag are lost when re-using the data, this is how the re-use path is told
+   * apart from a full write. */
+  mesh_a->mvert[0].co[1] = 1.0f;
+
+  std::string reuse, full;
+  write_steps(&reuse, &full);
+  EXPECT_TRUE(reuse == writefile_test_memfile_data(&reference));
+  EXPECT_TRUE(reuse != full);
+
+  /* Checking with `--debug-io` writes the data anyway. */
+  G.debug |= G_DEBUG_IO;
+  write_steps(&reuse, &full);
+  G.debug &= ~G_DEBUG_IO;
+  EXPECT_TRUE(reuse == full);
+}
+
+}  // namespace blender::blenloader::tests
@@ -238,17 +238,26 @@ extern "C" {
  * \section workscheduler WorkScheduler
  * the WorkScheduler is implemented as a static class. the responsibility of the WorkScheduler
  * is to balance WorkPackages to the available and free devices.
- * the work-scheduler can work in 2 states.
+ * the work-scheduler can work in 3 states.
  * For witching these between the state you need to recompile blender
  *
  * \subsection multithread Multi threaded
- * Default the work-scheduler will place all work as WorkPackage in a queue.
+ * Default the work-scheduler will push every CPU WorkPackage as a task to a BLI_task_pool.
+ * The tasks are executed by the shared task scheduler, which keeps a work-stealing queue per
+ * worker thread. The compositor therefore shares the CPU cores with other systems (render,
+ * depsgraph evaluation) instead of running its own threads next to them.
+ *
+ * \subsection queuethread Queue threaded
+ * When COM_CURRENT_THREADING_MODEL is set to COM_TM_QUEUE the work-scheduler will place all work
+ * as WorkPackage in a queue.
  * For every CPUcore a working thread is created.
  * These working threads will ask the WorkScheduler if there is work
  * for a specific Device.
  * the work-scheduler will find work for the device and the device
  * will be asked to execute the WorkPackage.
  *
+ * OpenCL work is always scheduled through a queue with a thread per OpenCL device.
+ *
  * \subsection singlethread Single threaded
  * For debugging reasons the multi-threading can be disabled.
  * This is done by changing the COM_CURRENT_THREADING_MODEL
@@ -69,7 +69,6 @@ typedef enum CompositorPriority {
 // workscheduler threading models
 /**
  * COM_TM_QUEUE is a multi-threaded model, which uses the BLI_thread_queue pattern.
- * This is the default option.
  */
 #define COM_TM_QUEUE 1
 
@@ -80,9 +79,17 @@ typedef enum CompositorPriority {
 #define COM_TM_NOTHREAD 0
 
 /**
- * COM_CURRENT_THREADING_MODEL can be one of the above, COM_TM_QUEUE is currently default.
+ * COM_TM_TASK is a multi-threaded model, which pushes CPU work to a BLI_task_pool.
+ * Work is executed by the shared task scheduler, so the compositor does not create threads of
+ * its own and does not oversubscribe the CPU when other systems (render, depsgraph) are busy.
+ * This is the default option.
+ */
+#define COM_TM_TASK 2
+
+/**
+ * COM_CURRENT_THREADING_MODEL can be one of the above, COM_TM_TASK is currently default.
  */
-#define COM_CURRENT_THREADING_MODEL COM_TM_QUEUE
+#define COM_CURRENT_THREADING_MODEL COM_TM_TASK
 // chunk order
 /**
  * \brief The order of chunks to be scheduled
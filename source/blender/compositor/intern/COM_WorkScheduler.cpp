@@ -29,6 +29,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "PIL_time.h"
 
@@ -39,6 +40,8 @@
 #    warning COM_CURRENT_THREADING_MODEL COM_TM_NOTHREAD is activated. Use only for debugging.
 #  endif
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+/* do nothing */
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 /* do nothing - default */
 #else
 #  error COM_CURRENT_THREADING_MODEL No threading model selected
@@ -48,12 +51,17 @@
 static vector<CPUDevice *> g_cpudevices;
 static ThreadLocal(CPUDevice *) g_thread_device;
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE || COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+static bool g_cpuInitialized = false;
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 /// \brief list of all thread for every CPUDevice in cpudevices a thread exists
 static ListBase g_cputhreads;
-static bool g_cpuInitialized = false;
 /// \brief all scheduled work for the cpu
 static ThreadQueue *g_cpuqueue;
+#  else
+/// \brief all scheduled work for the cpu, executed by the shared task scheduler
+static TaskPool *g_cpupool;
+#  endif
 static ThreadQueue *g_gpuqueue;
 #  ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
@@ -84,7 +92,30 @@ void *WorkScheduler::thread_execute_cpu(void *data)
 
   return NULL;
 }
+#endif
+
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+void WorkScheduler::task_execute_cpu(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  WorkPackage *work = (WorkPackage *)taskdata;
+  /* Tasks can be executed by any worker of the task scheduler (including the thread waiting in
+   * #finish), so the device is bound to the thread for the duration of this package only.
+   * Packages can be nested when a worker steals work while waiting, restore the outer device. */
+  CPUDevice device(BLI_task_parallel_thread_id(NULL));
+  CPUDevice *outer_device = (CPUDevice *)BLI_thread_local_get(g_thread_device);
+  BLI_thread_local_set(g_thread_device, &device);
+  device.execute(work);
+  BLI_thread_local_set(g_thread_device, outer_device);
+}
+
+static void task_free_cpu(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  WorkPackage *work = (WorkPackage *)taskdata;
+  delete work;
+}
+#endif
 
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE || COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 void *WorkScheduler::thread_execute_gpu(void *data)
 {
   Device *device = (Device *)data;
@@ -106,30 +137,35 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
   CPUDevice device(0);
   device.execute(package);
   delete package;
-#elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE || COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #  ifdef COM_OPENCL_ENABLED
   if (group->isOpenCL() && g_openclActive) {
     BLI_thread_queue_push(g_gpuqueue, package);
+    return;
   }
-  else {
-    BLI_thread_queue_push(g_cpuqueue, package);
-  }
-#  else
+#  endif
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   BLI_thread_queue_push(g_cpuqueue, package);
+#  else
+  BLI_task_pool_push(g_cpupool, task_execute_cpu, package, false, task_free_cpu);
 #  endif
 #endif
 }
 
 void WorkScheduler::start(CompositorContext &context)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE || COM_CURRENT_THREADING_MODEL == COM_TM_TASK
   unsigned int index;
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   g_cpuqueue = BLI_thread_queue_init();
   BLI_threadpool_init(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
   for (index = 0; index < g_cpudevices.size(); index++) {
     Device *device = g_cpudevices[index];
     BLI_threadpool_insert(&g_cputhreads, device);
   }
+#  else
+  g_cpupool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+#  endif
 #  ifdef COM_OPENCL_ENABLED
   if (context.getHasActiveOpenCLDevices()) {
     g_gpuqueue = BLI_thread_queue_init();
@@ -148,27 +184,32 @@ void WorkScheduler::start(CompositorContext &context)
 }
 void WorkScheduler::finish()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE || COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #  ifdef COM_OPENCL_ENABLED
   if (g_openclActive) {
     BLI_thread_queue_wait_finish(g_gpuqueue);
-    BLI_thread_queue_wait_finish(g_cpuqueue);
-  }
-  else {
-    BLI_thread_queue_wait_finish(g_cpuqueue);
   }
+#  endif
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+  BLI_thread_queue_wait_finish(g_cpuqueue);
 #  else
-  BLI_thread_queue_wait_finish(cpuqueue);
+  /* The calling thread takes part in executing the scheduled packages. */
+  BLI_task_pool_work_and_wait(g_cpupool);
 #  endif
 #endif
 }
 void WorkScheduler::stop()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE || COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   BLI_thread_queue_nowait(g_cpuqueue);
   BLI_threadpool_end(&g_cputhreads);
   BLI_thread_queue_free(g_cpuqueue);
   g_cpuqueue = NULL;
+#  else
+  BLI_task_pool_free(g_cpupool);
+  g_cpupool = NULL;
+#  endif
 #  ifdef COM_OPENCL_ENABLED
   if (g_openclActive) {
     BLI_thread_queue_nowait(g_gpuqueue);
@@ -182,7 +223,7 @@ void WorkScheduler::stop()
 
 bool WorkScheduler::hasGPUDevices()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE || COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #  ifdef COM_OPENCL_ENABLED
   return !g_gpudevices.empty();
 #  else
@@ -193,7 +234,7 @@ bool WorkScheduler::hasGPUDevices()
 #endif
 }
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE || COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 static void CL_CALLBACK clContextError(const char *errinfo,
                                        const void * /*private_info*/,
                                        size_t /*cb*/,
@@ -205,7 +246,15 @@ static void CL_CALLBACK clContextError(const char *errinfo,
 
 void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  /* CPU work is executed by the task scheduler, devices are created per work package. The number
+   * of threads is controlled by the task scheduler. */
+  UNUSED_VARS(num_cpu_threads);
+  if (!g_cpuInitialized) {
+    BLI_thread_local_create(g_thread_device);
+    g_cpuInitialized = true;
+  }
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   /* deinitialize if number of threads doesn't match */
   if (g_cpudevices.size() != num_cpu_threads) {
     Device *device;
@@ -233,6 +282,9 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
     g_cpuInitialized = true;
   }
 
+#endif
+
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE || COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #  ifdef COM_OPENCL_ENABLED
   /* deinitialize OpenCL GPU's */
   if (use_opencl && !g_openclInitialized) {
@@ -327,7 +379,7 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 
 void WorkScheduler::deinitialize()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE || COM_CURRENT_THREADING_MODEL == COM_TM_TASK
   /* deinitialize CPU threads */
   if (g_cpuInitialized) {
     Device *device;
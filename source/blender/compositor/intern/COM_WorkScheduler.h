@@ -21,6 +21,7 @@
 
 #include "COM_ExecutionGroup.h"
 
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "COM_Device.h"
@@ -44,6 +45,18 @@ class WorkScheduler {
    */
   static void *thread_execute_cpu(void *data);
 
+  /**
+   * \brief main thread loop for gpudevices
+   * inside this loop new work is queried and being executed
+   */
+  static void *thread_execute_gpu(void *data);
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  /**
+   * \brief task callback for cpu work
+   * executes a single WorkPackage on the thread the task scheduler picked for it
+   */
+  static void task_execute_cpu(TaskPool *__restrict pool, void *taskdata);
+
   /**
    * \brief main thread loop for gpudevices
    * inside this loop new work is queried and being executed
@@ -30,6 +30,7 @@
 #include "BLI_compiler_attrs.h"
 #include "BLI_gsqueue.h"
 #include "BLI_task.h"
+#include "BLI_trace.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_global.h"
@@ -104,6 +105,9 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
 
   /* Sanity checks. */
   BLI_assert(!operation_node->is_noop() && "NOOP nodes should not actually be scheduled");
+  BLI_trace_scope_begin_fmt("%s %s",
+                            operation_node->owner->owner->name.c_str(),
+                            operationCodeAsString(operation_node->opcode));
   /* Perform operation. */
   if (state->do_stats) {
     const double start_time = PIL_check_seconds_timer();
@@ -113,6 +117,7 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
   else {
     operation_node->evaluate(depsgraph);
   }
+  BLI_trace_scope_end();
 }
 
 void deg_task_run_func(TaskPool *pool, void *taskdata)
@@ -587,6 +587,7 @@ void DRW_view_set_active(DRWView *view);
 
 void DRW_view_clip_planes_set(DRWView *view, float (*planes)[4], int plane_len);
 void DRW_view_camtexco_set(DRWView *view, float texco[4]);
+void DRW_view_culling_min_pixel_radius_set(DRWView *view, float radius);
 
 /* For all getters, if view is NULL, default view is assumed. */
 void DRW_view_winmat_get(const DRWView *view, float mat[4][4], bool inverse);
@@ -34,6 +34,7 @@
 #include "BLI_math_vector.h"
 #include "BLI_string.h"
 #include "BLI_task.h"
+#include "BLI_trace.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_mesh_types.h"
@@ -135,83 +136,168 @@ typedef struct MeshRenderData {
   int *lverts, *ledges;
 } MeshRenderData;
 
-static void mesh_render_data_update_loose_geom(MeshRenderData *mr,
-                                               const eMRIterType iter_type,
-                                               const eMRDataType UNUSED(data_flag))
-{
-  if (mr->extract_type != MR_EXTRACT_BMESH) {
-    /* Mesh */
-    if (iter_type & (MR_ITER_LEDGE | MR_ITER_LVERT)) {
-      mr->vert_loose_len = 0;
-      mr->edge_loose_len = 0;
+/* Number of elements tested for being loose by a single task. */
+#define MR_LOOSE_GEOM_CHUNK_SIZE 8192
 
-      BLI_bitmap *lvert_map = BLI_BITMAP_NEW(mr->vert_len, __func__);
+typedef bool(LooseGeomTestFn)(const MeshRenderData *mr, const BLI_bitmap *vert_used, int index);
 
-      mr->ledges = MEM_mallocN(mr->edge_len * sizeof(int), __func__);
-      const MEdge *med = mr->medge;
-      for (int med_index = 0; med_index < mr->edge_len; med_index++, med++) {
-        if (med->flag & ME_LOOSEEDGE) {
-          mr->ledges[mr->edge_loose_len++] = med_index;
-        }
-        /* Tag verts as not loose. */
-        BLI_BITMAP_ENABLE(lvert_map, med->v1);
-        BLI_BITMAP_ENABLE(lvert_map, med->v2);
-      }
-      if (mr->edge_loose_len < mr->edge_len) {
-        mr->ledges = MEM_reallocN(mr->ledges, mr->edge_loose_len * sizeof(*mr->ledges));
-      }
+typedef struct LooseGeomGatherData {
+  const MeshRenderData *mr;
+  /** Vertices used by an edge, only for #Mesh. */
+  BLI_bitmap *vert_used;
+  LooseGeomTestFn *is_loose;
+  int elem_len;
+  /** The loose elements of each chunk are written at the start of the chunk. */
+  int *indices;
+  int *chunk_loose_len;
+} LooseGeomGatherData;
 
-      mr->lverts = MEM_mallocN(mr->vert_len * sizeof(*mr->lverts), __func__);
-      for (int v = 0; v < mr->vert_len; v++) {
-        if (!BLI_BITMAP_TEST(lvert_map, v)) {
-          mr->lverts[mr->vert_loose_len++] = v;
-        }
-      }
-      if (mr->vert_loose_len < mr->vert_len) {
-        mr->lverts = MEM_reallocN(mr->lverts, mr->vert_loose_len * sizeof(*mr->lverts));
-      }
+static bool mesh_edge_is_loose(const MeshRenderData *mr,
+                               const BLI_bitmap *UNUSED(vert_used),
+                               int index)
+{
+  return (mr->medge[index].flag & ME_LOOSEEDGE) != 0;
+}
 
-      MEM_freeN(lvert_map);
+static bool mesh_vert_is_loose(const MeshRenderData *UNUSED(mr),
+                               const BLI_bitmap *vert_used,
+                               int index)
+{
+  return !BLI_BITMAP_TEST(vert_used, index);
+}
+
+static bool bm_edge_is_loose(const MeshRenderData *mr,
+                             const BLI_bitmap *UNUSED(vert_used),
+                             int index)
+{
+  return BM_edge_at_index(mr->bm, index)->l == NULL;
+}
 
-      mr->loop_loose_len = mr->vert_loose_len + (mr->edge_loose_len * 2);
+static bool bm_vert_is_loose(const MeshRenderData *mr,
+                             const BLI_bitmap *UNUSED(vert_used),
+                             int index)
+{
+  return BM_vert_at_index(mr->bm, index)->e == NULL;
+}
+
+static void mesh_render_data_loose_gather_cb(void *__restrict userdata,
+                                             const int chunk,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LooseGeomGatherData *data = userdata;
+  const int start = chunk * MR_LOOSE_GEOM_CHUNK_SIZE;
+  const int end = min_ii(start + MR_LOOSE_GEOM_CHUNK_SIZE, data->elem_len);
+  int loose_len = 0;
+  for (int index = start; index < end; index++) {
+    if (data->is_loose(data->mr, data->vert_used, index)) {
+      data->indices[start + loose_len++] = index;
     }
   }
-  else {
-    /* #BMesh */
-    BMesh *bm = mr->bm;
-    if (iter_type & (MR_ITER_LEDGE | MR_ITER_LVERT)) {
-      int elem_id;
-      BMIter iter;
-      BMVert *eve;
-      BMEdge *ede;
-      mr->vert_loose_len = 0;
-      mr->edge_loose_len = 0;
-
-      mr->lverts = MEM_mallocN(mr->vert_len * sizeof(*mr->lverts), __func__);
-      BM_ITER_MESH_INDEX (eve, &iter, bm, BM_VERTS_OF_MESH, elem_id) {
-        if (eve->e == NULL) {
-          mr->lverts[mr->vert_loose_len++] = elem_id;
-        }
-      }
-      if (mr->vert_loose_len < mr->vert_len) {
-        mr->lverts = MEM_reallocN(mr->lverts, mr->vert_loose_len * sizeof(*mr->lverts));
-      }
+  data->chunk_loose_len[chunk] = loose_len;
+}
 
-      mr->ledges = MEM_mallocN(mr->edge_len * sizeof(*mr->ledges), __func__);
-      BM_ITER_MESH_INDEX (ede, &iter, bm, BM_EDGES_OF_MESH, elem_id) {
-        if (ede->l == NULL) {
-          mr->ledges[mr->edge_loose_len++] = elem_id;
-        }
-      }
-      if (mr->edge_loose_len < mr->edge_len) {
-        mr->ledges = MEM_reallocN(mr->ledges, mr->edge_loose_len * sizeof(*mr->ledges));
-      }
+/**
+ * Gather the indices of the loose elements in chunks running in parallel. The chunks are joined
+ * in order, so the result is the same as with a single loop.
+ */
+static int *mesh_render_data_loose_gather(const MeshRenderData *mr,
+                                          BLI_bitmap *vert_used,
+                                          LooseGeomTestFn *is_loose,
+                                          const int elem_len,
+                                          int *r_loose_len)
+{
+  const int chunks_len = (elem_len + MR_LOOSE_GEOM_CHUNK_SIZE - 1) / MR_LOOSE_GEOM_CHUNK_SIZE;
+  LooseGeomGatherData data = {
+      .mr = mr,
+      .vert_used = vert_used,
+      .is_loose = is_loose,
+      .elem_len = elem_len,
+      .indices = MEM_mallocN(sizeof(int) * elem_len, __func__),
+      .chunk_loose_len = MEM_mallocN(sizeof(int) * chunks_len, __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = chunks_len > 1;
+  BLI_task_parallel_range(0, chunks_len, &data, mesh_render_data_loose_gather_cb, &settings);
+
+  int loose_len = 0;
+  for (int chunk = 0; chunk < chunks_len; chunk++) {
+    memmove(&data.indices[loose_len],
+            &data.indices[chunk * MR_LOOSE_GEOM_CHUNK_SIZE],
+            sizeof(int) * data.chunk_loose_len[chunk]);
+    loose_len += data.chunk_loose_len[chunk];
+  }
+  MEM_freeN(data.chunk_loose_len);
+
+  if (loose_len < elem_len) {
+    data.indices = MEM_reallocN(data.indices, sizeof(int) * loose_len);
+  }
+  *r_loose_len = loose_len;
+  return data.indices;
+}
+
+static void mesh_render_data_vert_used_cb(void *__restrict userdata,
+                                          const int chunk,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LooseGeomGatherData *data = userdata;
+  BLI_bitmap *vert_used = data->vert_used;
+  const int start = chunk * MR_LOOSE_GEOM_CHUNK_SIZE;
+  const int end = min_ii(start + MR_LOOSE_GEOM_CHUNK_SIZE, data->elem_len);
+  const MEdge *med = &data->mr->medge[start];
+  for (int med_index = start; med_index < end; med_index++, med++) {
+    /* Edges of other chunks can share the same bitmap block. */
+    atomic_fetch_and_or_uint32(&vert_used[med->v1 >> _BITMAP_POWER],
+                               1u << (med->v1 & _BITMAP_MASK));
+    atomic_fetch_and_or_uint32(&vert_used[med->v2 >> _BITMAP_POWER],
+                               1u << (med->v2 & _BITMAP_MASK));
+  }
+}
 
-      mr->loop_loose_len = mr->vert_loose_len + mr->edge_loose_len * 2;
-    }
+static void mesh_render_data_update_loose_geom(MeshRenderData *mr,
+                                               const eMRIterType iter_type,
+                                               const eMRDataType UNUSED(data_flag))
+{
+  if (!(iter_type & (MR_ITER_LEDGE | MR_ITER_LVERT))) {
+    return;
   }
+
+  if (mr->extract_type != MR_EXTRACT_BMESH) {
+    /* Mesh */
+    mr->ledges = mesh_render_data_loose_gather(
+        mr, NULL, mesh_edge_is_loose, mr->edge_len, &mr->edge_loose_len);
+
+    /* Tag verts as not loose. */
+    const int chunks_len = (mr->edge_len + MR_LOOSE_GEOM_CHUNK_SIZE - 1) /
+                           MR_LOOSE_GEOM_CHUNK_SIZE;
+    LooseGeomGatherData data = {
+        .mr = mr,
+        .vert_used = BLI_BITMAP_NEW(mr->vert_len, __func__),
+        .elem_len = mr->edge_len,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = chunks_len > 1;
+    BLI_task_parallel_range(0, chunks_len, &data, mesh_render_data_vert_used_cb, &settings);
+
+    mr->lverts = mesh_render_data_loose_gather(
+        mr, data.vert_used, mesh_vert_is_loose, mr->vert_len, &mr->vert_loose_len);
+    MEM_freeN(data.vert_used);
+  }
+  else {
+    /* #BMesh */
+    mr->lverts = mesh_render_data_loose_gather(
+        mr, NULL, bm_vert_is_loose, mr->vert_len, &mr->vert_loose_len);
+    mr->ledges = mesh_render_data_loose_gather(
+        mr, NULL, bm_edge_is_loose, mr->edge_len, &mr->edge_loose_len);
+  }
+
+  mr->loop_loose_len = mr->vert_loose_len + (mr->edge_loose_len * 2);
 }
 
+#undef MR_LOOSE_GEOM_CHUNK_SIZE
+
 /**
  * Part of the creation of the #MeshRenderData that happens in a thread.
  */
@@ -756,6 +842,8 @@ typedef void(ExtractLVertMeshFn)(const MeshRenderData *mr,
 
 typedef void *(ExtractInitFn)(const MeshRenderData *mr, void *buffer);
 typedef void(ExtractFinishFn)(const MeshRenderData *mr, void *buffer, void *data);
+typedef void *(ExtractTaskInitFn)(void *data);
+typedef void(ExtractTaskFinishFn)(void *data, void *task_data);
 
 typedef struct MeshExtract {
   /** Executed on main thread and return user data for iteration functions. */
@@ -771,6 +859,12 @@ typedef struct MeshExtract {
   ExtractLVertMeshFn *iter_lvert_mesh;
   /** Executed on one worker thread after all elements iterations. */
   ExtractFinishFn *finish;
+  /** Optional, executed on the worker thread of each range to create thread local user data for
+   * the iteration functions. Ranges share the user data returned by #init when not set. */
+  ExtractTaskInitFn *task_init;
+  /** Merges the thread local user data of a range back into the user data returned by #init
+   * and frees it. Executed for all ranges in order, right before #finish. */
+  ExtractTaskFinishFn *task_finish;
   /** Used to request common data. */
   const eMRDataType data_flag;
   /** Used to know if the element callbacks are thread-safe and can be parallelized. */
@@ -787,6 +881,14 @@ BLI_INLINE eMRIterType mesh_extract_iter_type(const MeshExtract *ext)
   return type;
 }
 
+/* Does the extraction use the normals or looptris computed by the render data update. */
+BLI_INLINE bool mesh_extract_uses_render_data_update(const MeshExtract *ext)
+{
+  return (mesh_extract_iter_type(ext) & MR_ITER_LOOPTRI) ||
+         (ext->data_flag &
+          (MR_DATA_POLY_NOR | MR_DATA_LOOP_NOR | MR_DATA_TAN_LOOP_NOR | MR_DATA_LOOPTRI));
+}
+
 /** \} */
 
 /* ---------------------------------------------------------------------- */
@@ -918,6 +1020,27 @@ static const MeshExtract extract_tris = {
 
 /** \} */
 
+/* ---------------------------------------------------------------------- */
+/** \name Index Buffer Builder Thread Local Data
+ *
+ * Index buffers where every element is written by a known set of loops can be filled from
+ * multiple threads. Each range gets its own copy of the builder sharing the same index data,
+ * the copies only differ in the #GPUIndexBufBuilder.index_len they track.
+ * \{ */
+
+static void *extract_elb_task_init(void *elb)
+{
+  return MEM_dupallocN(elb);
+}
+
+static void extract_elb_task_finish(void *elb, void *task_elb)
+{
+  GPU_indexbuf_join(elb, task_elb);
+  MEM_freeN(task_elb);
+}
+
+/** \} */
+
 /* ---------------------------------------------------------------------- */
 /** \name Extract Edges Indices
  * \{ */
@@ -931,6 +1054,40 @@ static void *extract_lines_init(const MeshRenderData *mr, void *UNUSED(buf))
   return elb;
 }
 
+/**
+ * Every loop of an edge writes the same line, from possibly different threads. Keep the line of
+ * the loop with the highest index, which is the last one written by the single threaded
+ * iteration, so the result doesn't depend on the order the ranges are executed in.
+ */
+BLI_INLINE void lines_set_verts(GPUIndexBufBuilder *elb, uint e_index, uint l_index, uint l_next)
+{
+  BLI_assert(l_index != l_next);
+  BLI_assert((e_index + 1) * 2 <= elb->max_index_len);
+  uint64_t *line = (uint64_t *)&elb->data[e_index * 2];
+  const uint verts_new[2] = {l_index, l_next};
+  uint64_t line_new;
+  memcpy(&line_new, verts_new, sizeof(line_new));
+
+  uint64_t line_prev = *line;
+  while (line_prev != line_new) {
+    uint verts_prev[2];
+    memcpy(verts_prev, &line_prev, sizeof(verts_prev));
+    if (verts_prev[0] > l_index) {
+      break;
+    }
+    const uint64_t line_cas = atomic_cas_uint64(line, line_prev, line_new);
+    if (line_cas == line_prev) {
+      break;
+    }
+    line_prev = line_cas;
+  }
+
+  const uint index_len = (e_index + 1) * 2;
+  if (elb->index_len < index_len) {
+    elb->index_len = index_len;
+  }
+}
+
 static void extract_lines_iter_poly_bm(const MeshRenderData *mr,
                                        const ExtractPolyBMesh_Params *params,
                                        void *elb)
@@ -943,10 +1100,10 @@ static void extract_lines_iter_poly_bm(const MeshRenderData *mr,
     l_iter = l_first = BM_FACE_FIRST_LOOP(f)->prev;
     do {
       if (!BM_elem_flag_test(l_iter->e, BM_ELEM_HIDDEN)) {
-        GPU_indexbuf_set_line_verts(elb,
-                                    BM_elem_index_get(l_iter->e),
-                                    BM_elem_index_get(l_iter),
-                                    BM_elem_index_get(l_iter->next));
+        lines_set_verts(elb,
+                        BM_elem_index_get(l_iter->e),
+                        BM_elem_index_get(l_iter),
+                        BM_elem_index_get(l_iter->next));
       }
       else {
         GPU_indexbuf_set_line_restart(elb, BM_elem_index_get(l_iter->e));
@@ -974,7 +1131,7 @@ static void extract_lines_iter_poly_mesh(const MeshRenderData *mr,
         if (!((mr->use_hide && (med->flag & ME_HIDE)) ||
               ((mr->extract_type == MR_EXTRACT_MAPPED) && (mr->e_origindex) &&
                (mr->e_origindex[ml->e] == ORIGINDEX_NONE)))) {
-          GPU_indexbuf_set_line_verts(elb, ml->e, ml_index, ml_index_next);
+          lines_set_verts(elb, ml->e, ml_index, ml_index_next);
         }
         else {
           GPU_indexbuf_set_line_restart(elb, ml->e);
@@ -990,7 +1147,7 @@ static void extract_lines_iter_poly_mesh(const MeshRenderData *mr,
       int ml_index = ml_index_last, ml_index_next = mp->loopstart;
       do {
         const MLoop *ml = &mloop[ml_index];
-        GPU_indexbuf_set_line_verts(elb, ml->e, ml_index, ml_index_next);
+        lines_set_verts(elb, ml->e, ml_index, ml_index_next);
       } while ((ml_index = ml_index_next++) != ml_index_last);
     }
     EXTRACT_POLY_FOREACH_MESH_END;
@@ -1053,8 +1210,10 @@ static const MeshExtract extract_lines = {
     .iter_ledge_bm = extract_lines_iter_ledge_bm,
     .iter_ledge_mesh = extract_lines_iter_ledge_mesh,
     .finish = extract_lines_finish,
+    .task_init = extract_elb_task_init,
+    .task_finish = extract_elb_task_finish,
     .data_flag = 0,
-    .use_threading = false,
+    .use_threading = true,
 };
 /** \} */
 
@@ -1087,8 +1246,10 @@ static const MeshExtract extract_lines_with_lines_loose = {
     .iter_ledge_bm = extract_lines_iter_ledge_bm,
     .iter_ledge_mesh = extract_lines_iter_ledge_mesh,
     .finish = extract_lines_with_lines_loose_finish,
+    .task_init = extract_elb_task_init,
+    .task_finish = extract_elb_task_finish,
     .data_flag = 0,
-    .use_threading = false,
+    .use_threading = true,
 };
 
 /** \} */
@@ -1104,11 +1265,34 @@ static void *extract_points_init(const MeshRenderData *mr, void *UNUSED(buf))
   return elb;
 }
 
+/**
+ * Every loop of a vertex writes its point, from possibly different threads. Keep the loop with
+ * the highest index, which is the last one written by the single threaded iteration, so the
+ * result doesn't depend on the order the ranges are executed in.
+ */
+BLI_INLINE void points_set_vert(GPUIndexBufBuilder *elb, uint v_index, uint l_index)
+{
+  BLI_assert(v_index < elb->max_index_len);
+  uint *point = &elb->data[v_index];
+  uint point_prev = *point;
+  while (point_prev < l_index) {
+    const uint point_cas = atomic_cas_uint32(point, point_prev, l_index);
+    if (point_cas == point_prev) {
+      break;
+    }
+    point_prev = point_cas;
+  }
+
+  if (elb->index_len < v_index + 1) {
+    elb->index_len = v_index + 1;
+  }
+}
+
 BLI_INLINE void vert_set_bm(GPUIndexBufBuilder *elb, BMVert *eve, int l_index)
 {
   const int v_index = BM_elem_index_get(eve);
   if (!BM_elem_flag_test(eve, BM_ELEM_HIDDEN)) {
-    GPU_indexbuf_set_point_vert(elb, v_index, l_index);
+    points_set_vert(elb, v_index, l_index);
   }
   else {
     GPU_indexbuf_set_point_restart(elb, v_index);
@@ -1124,7 +1308,7 @@ BLI_INLINE void vert_set_mesh(GPUIndexBufBuilder *elb,
   if (!((mr->use_hide && (mv->flag & ME_HIDE)) ||
         ((mr->extract_type == MR_EXTRACT_MAPPED) && (mr->v_origindex) &&
          (mr->v_origindex[v_index] == ORIGINDEX_NONE)))) {
-    GPU_indexbuf_set_point_vert(elb, v_index, l_index);
+    points_set_vert(elb, v_index, l_index);
   }
   else {
     GPU_indexbuf_set_point_restart(elb, v_index);
@@ -1216,8 +1400,10 @@ static const MeshExtract extract_points = {
     .iter_lvert_bm = extract_points_iter_lvert_bm,
     .iter_lvert_mesh = extract_points_iter_lvert_mesh,
     .finish = extract_points_finish,
+    .task_init = extract_elb_task_init,
+    .task_finish = extract_elb_task_finish,
     .data_flag = 0,
-    .use_threading = false,
+    .use_threading = true,
 };
 
 /** \} */
@@ -1292,8 +1478,10 @@ static const MeshExtract extract_fdots = {
     .iter_poly_bm = extract_fdots_iter_poly_bm,
     .iter_poly_mesh = extract_fdots_iter_poly_mesh,
     .finish = extract_fdots_finish,
+    .task_init = extract_elb_task_init,
+    .task_finish = extract_elb_task_finish,
     .data_flag = 0,
-    .use_threading = false,
+    .use_threading = true,
 };
 
 /** \} */
@@ -1380,68 +1568,112 @@ static const MeshExtract extract_lines_paint_mask = {
 
 #define NO_EDGE INT_MAX
 
+/** Edge of a single triangle, kept until the triangle on the other side is found. */
+typedef struct LineAdjacencyEdge {
+  /** Vertices and loops of the edge, in the winding order of the triangle. */
+  uint v2, v3;
+  uint l2, l3;
+  /** Loop of the triangle opposite to the edge. */
+  uint l1;
+  bool is_open;
+} LineAdjacencyEdge;
+
+/**
+ * Used for the whole buffer and as thread local data of each range. Ranges only pair the edges of
+ * their own triangles, the edges they leave open are paired with the ones of the previous ranges
+ * by #extract_lines_adjacency_task_finish, in range order.
+ */
 typedef struct MeshExtract_LineAdjacency_Data {
-  GPUIndexBufBuilder elb;
+  /** Maps an edge to its index in #edges, #NO_EDGE once both its triangles are found. */
   EdgeHash *eh;
+  /** #LineAdjacencyEdge in the order they were found. */
+  BLI_Buffer edges;
+  /** Four indices per line. */
+  BLI_Buffer lines;
   bool is_manifold;
-  /* Array to convert vert index to any loop index of this vert. */
-  uint vert_to_loop[0];
 } MeshExtract_LineAdjacency_Data;
 
+static MeshExtract_LineAdjacency_Data *lines_adjacency_data_create(const uint edges_len_reserve,
+                                                                   const uint lines_len_reserve)
+{
+  MeshExtract_LineAdjacency_Data *data = MEM_callocN(sizeof(*data), __func__);
+  data->eh = BLI_edgehash_new_ex(__func__, edges_len_reserve);
+  BLI_buffer_field_init(&data->edges, LineAdjacencyEdge);
+  BLI_buffer_field_init(&data->lines, uint);
+  BLI_buffer_resize(&data->lines, lines_len_reserve * 4);
+  BLI_buffer_clear(&data->lines);
+  data->is_manifold = true;
+  return data;
+}
+
+static void lines_adjacency_data_free(MeshExtract_LineAdjacency_Data *data)
+{
+  BLI_edgehash_free(data->eh, NULL);
+  BLI_buffer_field_free(&data->edges);
+  BLI_buffer_field_free(&data->lines);
+  MEM_freeN(data);
+}
+
 static void *extract_lines_adjacency_init(const MeshRenderData *mr, void *UNUSED(buf))
 {
   /* Similar to poly_to_tri_count().
    * There is always (loop + triangle - 1) edges inside a polygon.
    * Accumulate for all polys and you get : */
   uint tess_edge_len = mr->loop_len + mr->tri_len - mr->poly_len;
+  return lines_adjacency_data_create(tess_edge_len, tess_edge_len);
+}
 
-  size_t vert_to_loop_size = sizeof(uint) * mr->vert_len;
+BLI_INLINE void lines_adjacency_add_line(
+    MeshExtract_LineAdjacency_Data *data, uint v1, uint v2, uint v3, uint v4)
+{
+  BLI_buffer_resize(&data->lines, data->lines.count + 4);
+  uint *line = &BLI_buffer_at(&data->lines, uint, data->lines.count - 4);
+  line[0] = v1;
+  line[1] = v2;
+  line[2] = v3;
+  line[3] = v4;
+}
 
-  MeshExtract_LineAdjacency_Data *data = MEM_callocN(sizeof(*data) + vert_to_loop_size, __func__);
-  GPU_indexbuf_init(&data->elb, GPU_PRIM_LINES_ADJ, tess_edge_len, mr->loop_len);
-  data->eh = BLI_edgehash_new_ex(__func__, tess_edge_len);
-  data->is_manifold = true;
-  return data;
+BLI_INLINE void lines_adjacency_edge(
+    uint v2, uint v3, uint l1, uint l2, uint l3, MeshExtract_LineAdjacency_Data *data)
+{
+  bool inv_indices = (v2 > v3);
+  void **pval;
+  bool value_is_init = BLI_edgehash_ensure_p(data->eh, v2, v3, &pval);
+  int edge_index = POINTER_AS_INT(*pval);
+  if (!value_is_init || edge_index == NO_EDGE) {
+    *pval = POINTER_FROM_INT((int)data->edges.count);
+    const LineAdjacencyEdge edge = {v2, v3, l2, l3, l1, true};
+    BLI_buffer_append(&data->edges, LineAdjacencyEdge, edge);
+  }
+  else {
+    /* HACK Tag as not used. Prevent overhead of BLI_edgehash_remove. */
+    *pval = POINTER_FROM_INT(NO_EDGE);
+    LineAdjacencyEdge *edge_opposite = &BLI_buffer_at(
+        &data->edges, LineAdjacencyEdge, edge_index);
+    edge_opposite->is_open = false;
+    bool inv_opposite = (edge_opposite->v2 > edge_opposite->v3);
+    uint l_opposite = edge_opposite->l1;
+    if (inv_opposite == inv_indices) {
+      /* Don't share edge if triangles have non matching winding. */
+      lines_adjacency_add_line(data, l1, l2, l3, l1);
+      lines_adjacency_add_line(data, l_opposite, l2, l3, l_opposite);
+      data->is_manifold = false;
+    }
+    else {
+      lines_adjacency_add_line(data, l1, l2, l3, l_opposite);
+    }
+  }
 }
 
 BLI_INLINE void lines_adjacency_triangle(
     uint v1, uint v2, uint v3, uint l1, uint l2, uint l3, MeshExtract_LineAdjacency_Data *data)
 {
-  GPUIndexBufBuilder *elb = &data->elb;
   /* Iterate around the triangle's edges. */
   for (int e = 0; e < 3; e++) {
     SHIFT3(uint, v3, v2, v1);
     SHIFT3(uint, l3, l2, l1);
-
-    bool inv_indices = (v2 > v3);
-    void **pval;
-    bool value_is_init = BLI_edgehash_ensure_p(data->eh, v2, v3, &pval);
-    int v_data = POINTER_AS_INT(*pval);
-    if (!value_is_init || v_data == NO_EDGE) {
-      /* Save the winding order inside the sign bit. Because the
-       * Edge-hash sort the keys and we need to compare winding later. */
-      int value = (int)l1 + 1; /* 0 cannot be signed so add one. */
-      *pval = POINTER_FROM_INT((inv_indices) ? -value : value);
-      /* Store loop indices for remaining non-manifold edges. */
-      data->vert_to_loop[v2] = l2;
-      data->vert_to_loop[v3] = l3;
-    }
-    else {
-      /* HACK Tag as not used. Prevent overhead of BLI_edgehash_remove. */
-      *pval = POINTER_FROM_INT(NO_EDGE);
-      bool inv_opposite = (v_data < 0);
-      uint l_opposite = (uint)abs(v_data) - 1;
-      /* TODO Make this part thread-safe. */
-      if (inv_opposite == inv_indices) {
-        /* Don't share edge if triangles have non matching winding. */
-        GPU_indexbuf_add_line_adj_verts(elb, l1, l2, l3, l1);
-        GPU_indexbuf_add_line_adj_verts(elb, l_opposite, l2, l3, l_opposite);
-        data->is_manifold = false;
-      }
-      else {
-        GPU_indexbuf_add_line_adj_verts(elb, l1, l2, l3, l_opposite);
-      }
-    }
+    lines_adjacency_edge(v2, v3, l1, l2, l3, data);
   }
 }
 
@@ -1484,33 +1716,60 @@ static void extract_lines_adjacency_iter_looptri_mesh(const MeshRenderData *mr,
   EXTRACT_TRIS_LOOPTRI_FOREACH_MESH_END;
 }
 
+static void *extract_lines_adjacency_task_init(void *UNUSED(data))
+{
+  return lines_adjacency_data_create(0, 0);
+}
+
+static void extract_lines_adjacency_task_finish(void *_data, void *_task_data)
+{
+  MeshExtract_LineAdjacency_Data *data = _data;
+  MeshExtract_LineAdjacency_Data *task_data = _task_data;
+
+  /* Lines of the edges paired within the range. */
+  if (task_data->lines.count != 0) {
+    const size_t lines_len = data->lines.count;
+    BLI_buffer_resize(&data->lines, lines_len + task_data->lines.count);
+    memcpy(&BLI_buffer_at(&data->lines, uint, lines_len),
+           task_data->lines.data,
+           sizeof(uint) * task_data->lines.count);
+  }
+
+  const LineAdjacencyEdge *edge = task_data->edges.data;
+  for (size_t i = 0; i < task_data->edges.count; i++, edge++) {
+    if (edge->is_open) {
+      lines_adjacency_edge(edge->v2, edge->v3, edge->l1, edge->l2, edge->l3, data);
+    }
+  }
+  data->is_manifold &= task_data->is_manifold;
+
+  lines_adjacency_data_free(task_data);
+}
+
 static void extract_lines_adjacency_finish(const MeshRenderData *mr, void *ibo, void *_data)
 {
   MeshExtract_LineAdjacency_Data *data = _data;
   /* Create edges for remaining non manifold edges. */
-  EdgeHashIterator *ehi = BLI_edgehashIterator_new(data->eh);
-  for (; !BLI_edgehashIterator_isDone(ehi); BLI_edgehashIterator_step(ehi)) {
-    uint v2, v3, l1, l2, l3;
-    int v_data = POINTER_AS_INT(BLI_edgehashIterator_getValue(ehi));
-    if (v_data != NO_EDGE) {
-      BLI_edgehashIterator_getKey(ehi, &v2, &v3);
-      l1 = (uint)abs(v_data) - 1;
-      if (v_data < 0) { /* inv_opposite  */
-        SWAP(uint, v2, v3);
-      }
-      l2 = data->vert_to_loop[v2];
-      l3 = data->vert_to_loop[v3];
-      GPU_indexbuf_add_line_adj_verts(&data->elb, l1, l2, l3, l1);
+  const LineAdjacencyEdge *edge = data->edges.data;
+  for (size_t i = 0; i < data->edges.count; i++, edge++) {
+    if (edge->is_open) {
+      lines_adjacency_add_line(data, edge->l1, edge->l2, edge->l3, edge->l1);
       data->is_manifold = false;
     }
   }
-  BLI_edgehashIterator_free(ehi);
-  BLI_edgehash_free(data->eh, NULL);
 
   mr->cache->is_manifold = data->is_manifold;
 
-  GPU_indexbuf_build_in_place(&data->elb, ibo);
-  MEM_freeN(data);
+  GPUIndexBufBuilder elb;
+  const uint lines_len = (uint)data->lines.count / 4;
+  GPU_indexbuf_init(&elb, GPU_PRIM_LINES_ADJ, lines_len, mr->loop_len);
+  if (lines_len != 0) {
+    memcpy(elb.data, data->lines.data, sizeof(uint) * data->lines.count);
+  }
+  elb.index_len = (uint)data->lines.count;
+  GPU_indexbuf_build_in_place(&elb, ibo);
+
+  lines_adjacency_data_free(data);
 }
 
 #undef NO_EDGE
@@ -1520,8 +1779,10 @@ static const MeshExtract extract_lines_adjacency = {
     .iter_looptri_bm = extract_lines_adjacency_iter_looptri_bm,
     .iter_looptri_mesh = extract_lines_adjacency_iter_looptri_mesh,
     .finish = extract_lines_adjacency_finish,
+    .task_init = extract_lines_adjacency_task_init,
+    .task_finish = extract_lines_adjacency_task_finish,
     .data_flag = 0,
-    .use_threading = false,
+    .use_threading = true,
 };
 
 /** \} */
@@ -2293,6 +2554,37 @@ static const MeshExtract extract_uv = {
 /** \name Extract Tangent layers
  * \{ */
 
+typedef struct ExtractTanConvertData {
+  float (**layers_data)[4];
+  int layers_len;
+  int loop_len;
+  /** Deinterleaved, each layer uses #loop_len elements. */
+  void *vbo_data;
+  bool do_hq;
+} ExtractTanConvertData;
+
+/* Converting every loop on its own, the tangents can be computed in a single task only. */
+static void extract_tan_convert_cb(void *__restrict userdata,
+                                   const int ml_index,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ExtractTanConvertData *data = userdata;
+  for (int i = 0; i < data->layers_len; i++) {
+    const float *tan = data->layers_data[i][ml_index];
+    const int elem_index = i * data->loop_len + ml_index;
+    if (data->do_hq) {
+      short(*tan_data)[4] = (short(*)[4])data->vbo_data + elem_index;
+      normal_float_to_short_v3(*tan_data, tan);
+      (*tan_data)[3] = (tan[3] > 0.0f) ? SHRT_MAX : SHRT_MIN;
+    }
+    else {
+      GPUPackedNormal *tan_data = (GPUPackedNormal *)data->vbo_data + elem_index;
+      *tan_data = GPU_normal_convert_i10_v3(tan);
+      tan_data->w = (tan[3] > 0.0f) ? 1 : -2;
+    }
+  }
+}
+
 static void extract_tan_ex(const MeshRenderData *mr, GPUVertBuf *vbo, const bool do_hq)
 {
   GPUVertCompType comp_type = do_hq ? GPU_COMP_I16 : GPU_COMP_I10;
@@ -2416,47 +2708,29 @@ static void extract_tan_ex(const MeshRenderData *mr, GPUVertBuf *vbo, const bool
   GPU_vertbuf_init_with_format(vbo, &format);
   GPU_vertbuf_data_alloc(vbo, v_len);
 
-  if (do_hq) {
-    short(*tan_data)[4] = (short(*)[4])vbo->data;
-    for (int i = 0; i < tan_len; i++) {
-      const char *name = tangent_names[i];
-      float(*layer_data)[4] = (float(*)[4])CustomData_get_layer_named(
-          &loop_data, CD_TANGENT, name);
-      for (int ml_index = 0; ml_index < mr->loop_len; ml_index++) {
-        normal_float_to_short_v3(*tan_data, layer_data[ml_index]);
-        (*tan_data)[3] = (layer_data[ml_index][3] > 0.0f) ? SHRT_MAX : SHRT_MIN;
-        tan_data++;
-      }
-    }
-    if (use_orco_tan) {
-      float(*layer_data)[4] = (float(*)[4])CustomData_get_layer_n(&loop_data, CD_TANGENT, 0);
-      for (int ml_index = 0; ml_index < mr->loop_len; ml_index++) {
-        normal_float_to_short_v3(*tan_data, layer_data[ml_index]);
-        (*tan_data)[3] = (layer_data[ml_index][3] > 0.0f) ? SHRT_MAX : SHRT_MIN;
-        tan_data++;
-      }
-    }
+  /* Tangent layers in the order of the attributes. */
+  float(*layers_data[MAX_MTFACE + 1])[4];
+  int layers_len = 0;
+  for (int i = 0; i < tan_len; i++) {
+    layers_data[layers_len++] = CustomData_get_layer_named(
+        &loop_data, CD_TANGENT, tangent_names[i]);
   }
-  else {
-    GPUPackedNormal *tan_data = (GPUPackedNormal *)vbo->data;
-    for (int i = 0; i < tan_len; i++) {
-      const char *name = tangent_names[i];
-      float(*layer_data)[4] = (float(*)[4])CustomData_get_layer_named(
-          &loop_data, CD_TANGENT, name);
-      for (int ml_index = 0; ml_index < mr->loop_len; ml_index++) {
-        *tan_data = GPU_normal_convert_i10_v3(layer_data[ml_index]);
-        tan_data->w = (layer_data[ml_index][3] > 0.0f) ? 1 : -2;
-        tan_data++;
-      }
-    }
-    if (use_orco_tan) {
-      float(*layer_data)[4] = (float(*)[4])CustomData_get_layer_n(&loop_data, CD_TANGENT, 0);
-      for (int ml_index = 0; ml_index < mr->loop_len; ml_index++) {
-        *tan_data = GPU_normal_convert_i10_v3(layer_data[ml_index]);
-        tan_data->w = (layer_data[ml_index][3] > 0.0f) ? 1 : -2;
-        tan_data++;
-      }
-    }
+  if (use_orco_tan) {
+    layers_data[layers_len++] = CustomData_get_layer_n(&loop_data, CD_TANGENT, 0);
+  }
+
+  if (layers_len != 0) {
+    ExtractTanConvertData data = {
+        .layers_data = layers_data,
+        .layers_len = layers_len,
+        .loop_len = mr->loop_len,
+        .vbo_data = vbo->data,
+        .do_hq = do_hq,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 8192;
+    BLI_task_parallel_range(0, mr->loop_len, &data, extract_tan_convert_cb, &settings);
   }
 
   CustomData_free(&loop_data, mr->loop_len);
@@ -5009,6 +5283,9 @@ static const MeshExtract extract_fdot_idx = {
  * \{ */
 typedef struct ExtractUserData {
   void *user_data;
+  /** Thread local user data of each range, see #MeshExtract.task_init. */
+  void **task_user_data;
+  int task_user_data_len;
 } ExtractUserData;
 
 typedef enum ExtractTaskDataType {
@@ -5021,8 +5298,12 @@ typedef struct ExtractTaskData {
   const MeshRenderData *mr;
   const MeshExtract *extract;
   ExtractTaskDataType tasktype;
+  /** Name of the extracted buffer, for profiling. */
+  const char *name;
   eMRIterType iter_type;
   int start, end;
+  /** Index of the range in #ExtractUserData.task_user_data. */
+  int task_index;
   /** Decremented each time a task is finished. */
   int32_t *task_counter;
   void *buf;
@@ -5031,6 +5312,7 @@ typedef struct ExtractTaskData {
 
 static ExtractTaskData *extract_task_data_create_mesh_extract(const MeshRenderData *mr,
                                                               const MeshExtract *extract,
+                                                              const char *name,
                                                               void *buf,
                                                               int32_t *task_counter)
 {
@@ -5038,6 +5320,7 @@ static ExtractTaskData *extract_task_data_create_mesh_extract(const MeshRenderDa
   taskdata->next = NULL;
   taskdata->prev = NULL;
   taskdata->tasktype = EXTRACT_MESH_EXTRACT;
+  taskdata->name = name;
   taskdata->mr = mr;
   taskdata->extract = extract;
   taskdata->buf = buf;
@@ -5053,6 +5336,7 @@ static ExtractTaskData *extract_task_data_create_mesh_extract(const MeshRenderDa
   taskdata->task_counter = task_counter;
   taskdata->start = 0;
   taskdata->end = INT_MAX;
+  taskdata->task_index = 0;
   return taskdata;
 }
 
@@ -5060,6 +5344,7 @@ static ExtractTaskData *extract_task_data_create_lines_loose(const MeshRenderDat
 {
   ExtractTaskData *taskdata = MEM_callocN(sizeof(*taskdata), __func__);
   taskdata->tasktype = EXTRACT_LINES_LOOSE;
+  taskdata->name = "ibo.lines_loose";
   taskdata->mr = mr;
   return taskdata;
 }
@@ -5067,6 +5352,9 @@ static ExtractTaskData *extract_task_data_create_lines_loose(const MeshRenderDat
 static void extract_task_data_free(void *data)
 {
   ExtractTaskData *task_data = data;
+  if (task_data->user_data) {
+    MEM_SAFE_FREE(task_data->user_data->task_user_data);
+  }
   MEM_SAFE_FREE(task_data->user_data);
   MEM_freeN(task_data);
 }
@@ -5159,23 +5447,34 @@ static void extract_init(ExtractTaskData *data)
 static void extract_run(void *__restrict taskdata)
 {
   ExtractTaskData *data = (ExtractTaskData *)taskdata;
+  BLI_trace_scope_begin_fmt("Draw extract %s", data->name);
   if (data->tasktype == EXTRACT_MESH_EXTRACT) {
-    mesh_extract_iter(data->mr,
-                      data->iter_type,
-                      data->start,
-                      data->end,
-                      data->extract,
-                      data->user_data->user_data);
+    ExtractUserData *user_data = data->user_data;
+    void *iter_user_data = user_data->user_data;
+    if (user_data->task_user_data) {
+      iter_user_data = data->extract->task_init(user_data->user_data);
+      user_data->task_user_data[data->task_index] = iter_user_data;
+    }
+
+    mesh_extract_iter(
+        data->mr, data->iter_type, data->start, data->end, data->extract, iter_user_data);
 
     /* If this is the last task, we do the finish function. */
     int remainin_tasks = atomic_sub_and_fetch_int32(data->task_counter, 1);
-    if (remainin_tasks == 0 && data->extract->finish != NULL) {
-      data->extract->finish(data->mr, data->buf, data->user_data->user_data);
+    if (remainin_tasks == 0) {
+      /* Merge in range order, so the result doesn't depend on the scheduling. */
+      for (int i = 0; i < user_data->task_user_data_len; i++) {
+        data->extract->task_finish(user_data->user_data, user_data->task_user_data[i]);
+      }
+      if (data->extract->finish != NULL) {
+        data->extract->finish(data->mr, data->buf, user_data->user_data);
+      }
     }
   }
   else if (data->tasktype == EXTRACT_LINES_LOOSE) {
     extract_lines_loose_subbuffer(data->mr);
   }
+  BLI_trace_scope_end();
 }
 
 static void extract_init_and_run(void *__restrict taskdata)
@@ -5313,6 +5612,57 @@ static struct TaskNode *user_data_init_task_node_create(struct TaskGraph *task_g
 }
 
 /** \} */
+
+/* ---------------------------------------------------------------------- */
+/** \name Task Group
+ *
+ * Extractions that start once the same parent node is done.
+ * \{ */
+typedef struct ExtractTaskGroup {
+  struct TaskNode *task_node_parent;
+  struct TaskNode *task_node_user_data_init;
+  ExtractSingleThreadedTaskData *single_threaded_task_data;
+  UserDataInitTaskData *user_data_init_task_data;
+} ExtractTaskGroup;
+
+static void extract_task_group_init(struct TaskGraph *task_graph,
+                                    ExtractTaskGroup *group,
+                                    struct TaskNode *task_node_parent)
+{
+  group->task_node_parent = task_node_parent;
+  group->single_threaded_task_data = MEM_callocN(sizeof(ExtractSingleThreadedTaskData),
+                                                 __func__);
+  group->user_data_init_task_data = MEM_callocN(sizeof(UserDataInitTaskData), __func__);
+  group->task_node_user_data_init = user_data_init_task_node_create(
+      task_graph, group->user_data_init_task_data);
+}
+
+static void extract_task_group_link(struct TaskGraph *task_graph, ExtractTaskGroup *group)
+{
+  /* Only create the edge when there is user data that needs to be initialized.
+   * The task is still part of the graph so the task_data will be freed when the graph is freed.
+   */
+  if (!BLI_listbase_is_empty(&group->user_data_init_task_data->task_datas)) {
+    BLI_task_graph_edge_create(group->task_node_parent, group->task_node_user_data_init);
+  }
+
+  if (!BLI_listbase_is_empty(&group->single_threaded_task_data->task_datas)) {
+    struct TaskNode *task_node = extract_single_threaded_task_node_create(
+        task_graph, group->single_threaded_task_data);
+    BLI_task_graph_edge_create(group->task_node_parent, task_node);
+  }
+  else {
+    extract_single_threaded_task_data_free(group->single_threaded_task_data);
+  }
+}
+
+static void extract_start_node_exec(void *__restrict UNUSED(task_data))
+{
+  /* Only used to start the nodes that don't depend on each other at once. */
+}
+
+/** \} */
+
 /* ---------------------------------------------------------------------- */
 /** \name Extract Loop
  * \{ */
@@ -5322,26 +5672,27 @@ static void extract_range_task_create(struct TaskGraph *task_graph,
                                       ExtractTaskData *taskdata,
                                       const eMRIterType type,
                                       int start,
-                                      int length)
+                                      int length,
+                                      int *r_task_index)
 {
   taskdata = MEM_dupallocN(taskdata);
   atomic_add_and_fetch_int32(taskdata->task_counter, 1);
   taskdata->iter_type = type;
   taskdata->start = start;
   taskdata->end = start + length;
+  taskdata->task_index = (*r_task_index)++;
   struct TaskNode *task_node = BLI_task_graph_node_create(
       task_graph, extract_run, taskdata, MEM_freeN);
   BLI_task_graph_edge_create(task_node_user_data_init, task_node);
 }
 
 static void extract_task_create(struct TaskGraph *task_graph,
-                                struct TaskNode *task_node_mesh_render_data,
-                                struct TaskNode *task_node_user_data_init,
-                                ListBase *single_threaded_task_datas,
-                                ListBase *user_data_init_task_datas,
+                                ExtractTaskGroup *task_group_render_data,
+                                ExtractTaskGroup *task_group_independent,
                                 const Scene *scene,
                                 const MeshRenderData *mr,
                                 const MeshExtract *extract,
+                                const char *name,
                                 void *buf,
                                 int32_t *task_counter)
 {
@@ -5354,53 +5705,83 @@ static void extract_task_create(struct TaskGraph *task_graph,
     extract = &extract_tan_hq;
   }
 
+  ExtractTaskGroup *group = mesh_extract_uses_render_data_update(extract) ?
+                                task_group_render_data :
+                                task_group_independent;
+  struct TaskNode *task_node_user_data_init = group->task_node_user_data_init;
+
   /* Divide extraction of the VBO/IBO into sensible chunks of works. */
   ExtractTaskData *taskdata = extract_task_data_create_mesh_extract(
-      mr, extract, buf, task_counter);
+      mr, extract, name, buf, task_counter);
 
   /* Simple heuristic. */
   const int chunk_size = 8192;
   const bool use_thread = (mr->loop_len + mr->loop_loose_len) > chunk_size;
   if (use_thread && extract->use_threading) {
+    int task_len = 0;
 
     /* Divide task into sensible chunks. */
     if (taskdata->iter_type & MR_ITER_LOOPTRI) {
       for (int i = 0; i < mr->tri_len; i += chunk_size) {
-        extract_range_task_create(
-            task_graph, task_node_user_data_init, taskdata, MR_ITER_LOOPTRI, i, chunk_size);
+        extract_range_task_create(task_graph,
+                                  task_node_user_data_init,
+                                  taskdata,
+                                  MR_ITER_LOOPTRI,
+                                  i,
+                                  chunk_size,
+                                  &task_len);
       }
     }
     if (taskdata->iter_type & MR_ITER_POLY) {
       for (int i = 0; i < mr->poly_len; i += chunk_size) {
-        extract_range_task_create(
-            task_graph, task_node_user_data_init, taskdata, MR_ITER_POLY, i, chunk_size);
+        extract_range_task_create(task_graph,
+                                  task_node_user_data_init,
+                                  taskdata,
+                                  MR_ITER_POLY,
+                                  i,
+                                  chunk_size,
+                                  &task_len);
       }
     }
     if (taskdata->iter_type & MR_ITER_LEDGE) {
       for (int i = 0; i < mr->edge_loose_len; i += chunk_size) {
-        extract_range_task_create(
-            task_graph, task_node_user_data_init, taskdata, MR_ITER_LEDGE, i, chunk_size);
+        extract_range_task_create(task_graph,
+                                  task_node_user_data_init,
+                                  taskdata,
+                                  MR_ITER_LEDGE,
+                                  i,
+                                  chunk_size,
+                                  &task_len);
       }
     }
     if (taskdata->iter_type & MR_ITER_LVERT) {
       for (int i = 0; i < mr->vert_loose_len; i += chunk_size) {
-        extract_range_task_create(
-            task_graph, task_node_user_data_init, taskdata, MR_ITER_LVERT, i, chunk_size);
+        extract_range_task_create(task_graph,
+                                  task_node_user_data_init,
+                                  taskdata,
+                                  MR_ITER_LVERT,
+                                  i,
+                                  chunk_size,
+                                  &task_len);
       }
     }
-    BLI_addtail(user_data_init_task_datas, taskdata);
+    if (extract->task_init) {
+      taskdata->user_data->task_user_data = MEM_callocN(sizeof(void *) * task_len, __func__);
+      taskdata->user_data->task_user_data_len = task_len;
+    }
+    BLI_addtail(&group->user_data_init_task_data->task_datas, taskdata);
   }
   else if (use_thread) {
     /* One task for the whole VBO. */
     (*task_counter)++;
     struct TaskNode *one_task = BLI_task_graph_node_create(
         task_graph, extract_init_and_run, taskdata, extract_task_data_free);
-    BLI_task_graph_edge_create(task_node_mesh_render_data, one_task);
+    BLI_task_graph_edge_create(group->task_node_parent, one_task);
   }
   else {
     /* Single threaded extraction. */
     (*task_counter)++;
-    BLI_addtail(single_threaded_task_datas, taskdata);
+    BLI_addtail(&group->single_threaded_task_data->task_datas, taskdata);
   }
 }
 
@@ -5432,6 +5813,10 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
    * user_data needed for the extraction based on the data extracted from the mesh.
    * counters are used to check if the finalize of a task has to be called.
    *
+   * For meshes that aren't in edit mode, the extractions that don't need the normals or looptris
+   * get their own `user_data_init` and `single_threaded` nodes. These are linked to an empty
+   * `start` node next to the `mesh_render_data` node so they don't have to wait for it.
+   *
    *                           Mesh extraction sub graph
    *
    *                                                       +----------------------+
@@ -5532,24 +5917,33 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
 
   struct TaskNode *task_node_mesh_render_data = mesh_extract_render_data_node_create(
       task_graph, mr, iter_flag, data_flag);
-  ExtractSingleThreadedTaskData *single_threaded_task_data = MEM_callocN(
-      sizeof(ExtractSingleThreadedTaskData), __func__);
-  UserDataInitTaskData *user_data_init_task_data = MEM_callocN(sizeof(UserDataInitTaskData),
-                                                               __func__);
-  user_data_init_task_data->task_counters = task_counters;
-  struct TaskNode *task_node_user_data_init = user_data_init_task_node_create(
-      task_graph, user_data_init_task_data);
+  struct TaskNode *task_node_start = task_node_mesh_render_data;
+
+  ExtractTaskGroup task_group_render_data;
+  extract_task_group_init(task_graph, &task_group_render_data, task_node_mesh_render_data);
+  task_group_render_data.user_data_init_task_data->task_counters = task_counters;
+
+  /* Extractions that don't use the normals and looptris can run alongside the render data
+   * update. Not for #BMesh, where calculating the loop normals tags the edges that other
+   * extractions read the flags of. */
+  ExtractTaskGroup task_group_independent_data;
+  ExtractTaskGroup *task_group_independent = &task_group_render_data;
+  if (mr->extract_type != MR_EXTRACT_BMESH) {
+    task_node_start = BLI_task_graph_node_create(task_graph, extract_start_node_exec, NULL, NULL);
+    BLI_task_graph_edge_create(task_node_start, task_node_mesh_render_data);
+    extract_task_group_init(task_graph, &task_group_independent_data, task_node_start);
+    task_group_independent = &task_group_independent_data;
+  }
 
 #define EXTRACT(buf, name) \
   if (mbc.buf.name) { \
     extract_task_create(task_graph, \
-                        task_node_mesh_render_data, \
-                        task_node_user_data_init, \
-                        &single_threaded_task_data->task_datas, \
-                        &user_data_init_task_data->task_datas, \
+                        &task_group_render_data, \
+                        task_group_independent, \
                         scene, \
                         mr, \
                         &extract_##name, \
+                        #buf "." #name, \
                         mbc.buf.name, \
                         &task_counters[counter_used++]); \
   } \
@@ -5586,20 +5980,19 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
                                              &extract_lines_with_lines_loose :
                                              &extract_lines;
     extract_task_create(task_graph,
-                        task_node_mesh_render_data,
-                        task_node_user_data_init,
-                        &single_threaded_task_data->task_datas,
-                        &user_data_init_task_data->task_datas,
+                        &task_group_render_data,
+                        task_group_independent,
                         scene,
                         mr,
                         lines_extractor,
+                        "ibo.lines",
                         mbc.ibo.lines,
                         &task_counters[counter_used++]);
   }
   else {
     if (do_lines_loose_subbuffer) {
       ExtractTaskData *taskdata = extract_task_data_create_lines_loose(mr);
-      BLI_addtail(&single_threaded_task_data->task_datas, taskdata);
+      BLI_addtail(&task_group_independent->single_threaded_task_data->task_datas, taskdata);
     }
   }
   EXTRACT(ibo, points);
@@ -5611,24 +6004,13 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
   EXTRACT(ibo, edituv_points);
   EXTRACT(ibo, edituv_fdots);
 
-  /* Only create the edge when there is user data that needs to be initialized.
-   * The task is still part of the graph so the task_data will be freed when the graph is freed.
-   */
-  if (!BLI_listbase_is_empty(&user_data_init_task_data->task_datas)) {
-    BLI_task_graph_edge_create(task_node_mesh_render_data, task_node_user_data_init);
-  }
-
-  if (!BLI_listbase_is_empty(&single_threaded_task_data->task_datas)) {
-    struct TaskNode *task_node = extract_single_threaded_task_node_create(
-        task_graph, single_threaded_task_data);
-    BLI_task_graph_edge_create(task_node_mesh_render_data, task_node);
-  }
-  else {
-    extract_single_threaded_task_data_free(single_threaded_task_data);
+  extract_task_group_link(task_graph, &task_group_render_data);
+  if (task_group_independent != &task_group_render_data) {
+    extract_task_group_link(task_graph, task_group_independent);
   }
 
   /* Trigger the sub-graph for this mesh. */
-  BLI_task_graph_node_push_work(task_node_mesh_render_data);
+  BLI_task_graph_node_push_work(task_node_start);
 
 #undef EXTRACT
 
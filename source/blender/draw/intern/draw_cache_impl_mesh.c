@@ -621,6 +621,53 @@ static void mesh_batch_cache_discard_uvedit_select(MeshBatchCache *cache)
   cache->batch_ready &= ~MBC_EDITUV;
 }
 
+/* Free the content of the buffer but keep the buffer itself, so the batches using it stay valid
+ * and it is extracted again on the next request. */
+static void mesh_batch_cache_vbo_clear_content(GPUVertBuf *vbo)
+{
+  if (vbo != NULL) {
+    GPU_vertbuf_clear(vbo);
+    memset(&vbo->format, 0, sizeof(vbo->format));
+  }
+}
+
+static void mesh_batch_cache_discard_deform(MeshBatchCache *cache)
+{
+  /* Only buffers that depend on the vertex positions or normals are updated. Attributes (UV's,
+   * colors, weights, orco) and edit flags are kept as they are. Index buffers are kept too, the
+   * triangle ones depend on the positions of quads and n-gons, so this is only used when the
+   * triangulation didn't change, see #mesh_build_data_deform_prev_finish. */
+  FOREACH_MESH_BUFFER_CACHE (cache, mbufcache) {
+    mesh_batch_cache_vbo_clear_content(mbufcache->vbo.pos_nor);
+    mesh_batch_cache_vbo_clear_content(mbufcache->vbo.lnor);
+    mesh_batch_cache_vbo_clear_content(mbufcache->vbo.tan);
+    mesh_batch_cache_vbo_clear_content(mbufcache->vbo.edge_fac);
+    mesh_batch_cache_vbo_clear_content(mbufcache->vbo.mesh_analysis);
+    mesh_batch_cache_vbo_clear_content(mbufcache->vbo.stretch_area);
+    mesh_batch_cache_vbo_clear_content(mbufcache->vbo.stretch_angle);
+    mesh_batch_cache_vbo_clear_content(mbufcache->vbo.fdots_pos);
+    mesh_batch_cache_vbo_clear_content(mbufcache->vbo.fdots_nor);
+    mesh_batch_cache_vbo_clear_content(mbufcache->vbo.skin_roots);
+  }
+  /* The cleared buffers get new GPU buffers, the vertex arrays referencing the old ones have to be
+   * recreated. */
+  for (int i = 0; i < sizeof(cache->batch) / sizeof(void *); i++) {
+    GPUBatch *batch = ((GPUBatch **)&cache->batch)[i];
+    if (batch != NULL) {
+      GPU_batch_vao_cache_clear(batch);
+    }
+  }
+  if (cache->surface_per_mat) {
+    for (int i = 0; i < cache->mat_len; i++) {
+      if (cache->surface_per_mat[i] != NULL) {
+        GPU_batch_vao_cache_clear(cache->surface_per_mat[i]);
+      }
+    }
+  }
+  /* Go through the extraction again, it skips the buffers that are still valid. */
+  cache->batch_ready = 0;
+}
+
 void DRW_mesh_batch_cache_dirty_tag(Mesh *me, int mode)
 {
   MeshBatchCache *cache = me->runtime.batch_cache;
@@ -673,6 +720,9 @@ void DRW_mesh_batch_cache_dirty_tag(Mesh *me, int mode)
     case BKE_MESH_BATCH_DIRTY_UVEDIT_ALL:
       mesh_batch_cache_discard_uvedit(cache);
       break;
+    case BKE_MESH_BATCH_DIRTY_DEFORM:
+      mesh_batch_cache_discard_deform(cache);
+      break;
     case BKE_MESH_BATCH_DIRTY_UVEDIT_SELECT:
       FOREACH_MESH_BUFFER_CACHE (cache, mbufcache) {
         GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.edituv_data);
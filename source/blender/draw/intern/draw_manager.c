@@ -417,6 +417,7 @@ static void drw_viewport_cache_resize(void)
     BLI_memblock_clear(DST.vmempool->obmats, NULL);
     BLI_memblock_clear(DST.vmempool->obinfos, NULL);
     BLI_memblock_clear(DST.vmempool->cullstates, NULL);
+    BLI_memblock_clear(DST.vmempool->cullchunks, NULL);
     BLI_memblock_clear(DST.vmempool->shgroups, NULL);
     BLI_memblock_clear(DST.vmempool->uniforms, NULL);
     BLI_memblock_clear(DST.vmempool->passes, NULL);
@@ -530,6 +531,9 @@ static void drw_viewport_var_init(void)
       uint chunk_len = sizeof(DRWCullingState) * DRW_RESOURCE_CHUNK_LEN;
       DST.vmempool->cullstates = BLI_memblock_create_ex(sizeof(DRWCullingState), chunk_len);
     }
+    if (DST.vmempool->cullchunks == NULL) {
+      DST.vmempool->cullchunks = BLI_memblock_create(sizeof(DRWCullingChunk));
+    }
     if (DST.vmempool->shgroups == NULL) {
       DST.vmempool->shgroups = BLI_memblock_create(sizeof(DRWShadingGroup));
     }
@@ -549,6 +553,8 @@ static void drw_viewport_var_init(void)
 
     DST.resource_handle = 0;
     DST.pass_handle = 0;
+    /* Chunk bounds were cleared with the memory pools. */
+    DST.culling_chunks_handle = 0;
 
     draw_unit_state_create();
 
@@ -576,6 +582,11 @@ static void drw_viewport_var_init(void)
     DST.view_default = DRW_view_create(rv3d->viewmat, rv3d->winmat, NULL, NULL, NULL);
     DRW_view_camtexco_set(DST.view_default, rv3d->viewcamtexcofac);
 
+    /* Objects smaller than a pixel are not noticeable while the view is moving. */
+    if (rv3d->rflag & RV3D_NAVIGATING) {
+      DRW_view_culling_min_pixel_radius_set(DST.view_default, 0.5f);
+    }
+
     if (DST.draw_ctx.sh_cfg == GPU_SHADER_CFG_CLIPPED) {
       int plane_len = (RV3D_LOCK_FLAGS(rv3d) & RV3D_BOXCLIP) ? 4 : 6;
       DRW_view_clip_planes_set(DST.view_default, rv3d->clip, plane_len);
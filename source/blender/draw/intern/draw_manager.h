@@ -105,6 +105,14 @@ typedef struct DRWCullingState {
   void *user_data;
 } DRWCullingState;
 
+/**
+ * Bounds of all the #DRWCullingState of one resource chunk, used to cull
+ * or accept whole chunks at once. Resources bypassing culling are excluded.
+ */
+typedef struct DRWCullingChunk {
+  float min[3], max[3];
+} DRWCullingChunk;
+
 /* Minimum max UBO size is 64KiB. We take the largest
  * UBO struct and alloc the max number.
  * ((1 << 16) / sizeof(DRWObjectMatrix)) = 512
@@ -405,6 +413,8 @@ struct DRWView {
   BoundBox frustum_corners;
   BoundSphere frustum_bsphere;
   float frustum_planes[6][4];
+  /** Cull resources whose projected radius is smaller than this (in pixels). 0 to disable. */
+  float culling_min_pixel_radius;
   /** Custom visibility function. */
   DRWCallVisibilityFn *visibility_fn;
   void *user_data;
@@ -486,6 +496,8 @@ typedef struct DRWManager {
   DRWResourceHandle resource_handle;
   /** Handle of next DRWPass to be allocated. */
   DRWResourceHandle pass_handle;
+  /** Value of resource_handle when the #DRWCullingChunk bounds were last computed. */
+  DRWResourceHandle culling_chunks_handle;
 
   /** Dupli state. NULL if not dupli. */
   struct DupliObject *dupli_source;
@@ -778,6 +778,8 @@ void DRW_shgroup_call_ex(DRWShadingGroup *shgroup,
     if (bypass_culling) {
       /* NOTE this will disable culling for the whole object. */
       culling->bsphere.radius = -1.0f;
+      /* Chunk bounds may already contain this resource. */
+      DST.culling_chunks_handle = 0;
     }
   }
 }
@@ -1721,6 +1723,7 @@ DRWView *DRW_view_create(const float viewmat[4][4],
     view->culling_mask = 0u;
   }
   view->clip_planes_len = 0;
+  view->culling_min_pixel_radius = 0.0f;
   view->visibility_fn = visibility_fn;
   view->parent = NULL;
 
@@ -1879,6 +1882,17 @@ void DRW_view_camtexco_set(DRWView *view, float texco[4])
   copy_v4_v4(view->storage.viewcamtexcofac, texco);
 }
 
+/**
+ * Cull resources whose bounding sphere projects to less than \a radius pixels.
+ * Only used for views culling their own resources (not sub views). 0 disables it.
+ */
+void DRW_view_culling_min_pixel_radius_set(DRWView *view, float radius)
+{
+  BLI_assert(view->parent == NULL);
+  view->culling_min_pixel_radius = radius;
+  view->is_dirty = true;
+}
+
 /* Return world space frustum corners. */
 void DRW_view_frustum_corners_get(const DRWView *view, BoundBox *corners)
 {
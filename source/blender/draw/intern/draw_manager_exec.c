@@ -594,6 +594,86 @@ void DRW_culling_frustum_planes_get(const DRWView *view, float planes[6][4])
   memcpy(planes, view->frustum_planes, sizeof(float) * 6 * 4);
 }
 
+typedef enum eDRWCullingChunkResult {
+  DRW_CULLING_CHUNK_OUTSIDE = 0,
+  DRW_CULLING_CHUNK_INTERSECT,
+  DRW_CULLING_CHUNK_INSIDE,
+} eDRWCullingChunkResult;
+
+/* Compute the bounds of every resource chunk. Only done once per redraw unless
+ * resources are added or modified after the first culling. */
+static void draw_culling_chunks_update(void)
+{
+  if (DST.culling_chunks_handle == DST.resource_handle) {
+    return;
+  }
+  DST.culling_chunks_handle = DST.resource_handle;
+
+  BLI_memblock_clear(DST.vmempool->cullchunks, NULL);
+
+  BLI_memblock_iter iter;
+  BLI_memblock_iternew(DST.vmempool->cullstates, &iter);
+  DRWCullingChunk *chunk = NULL;
+  DRWCullingState *cull;
+  for (int i = 0; (cull = BLI_memblock_iterstep(&iter)); i++) {
+    if ((i % DRW_RESOURCE_CHUNK_LEN) == 0) {
+      chunk = BLI_memblock_alloc(DST.vmempool->cullchunks);
+      INIT_MINMAX(chunk->min, chunk->max);
+    }
+    if (cull->bsphere.radius >= 0.0f) {
+      const float *center = cull->bsphere.center;
+      const float radius = cull->bsphere.radius;
+      for (int axis = 0; axis < 3; axis++) {
+        chunk->min[axis] = min_ff(chunk->min[axis], center[axis] - radius);
+        chunk->max[axis] = max_ff(chunk->max[axis], center[axis] + radius);
+      }
+    }
+  }
+}
+
+static eDRWCullingChunkResult draw_culling_chunk_test(const float (*frustum_planes)[4],
+                                                      const DRWCullingChunk *chunk)
+{
+  if (chunk->min[0] > chunk->max[0]) {
+    /* Only contains resources bypassing culling. */
+    return DRW_CULLING_CHUNK_OUTSIDE;
+  }
+
+  eDRWCullingChunkResult result = DRW_CULLING_CHUNK_INSIDE;
+  for (int p = 0; p < 6; p++) {
+    const float *plane = frustum_planes[p];
+    /* Box corners the furthest in front of and behind the plane. */
+    float front[3], back[3];
+    for (int axis = 0; axis < 3; axis++) {
+      front[axis] = (plane[axis] > 0.0f) ? chunk->max[axis] : chunk->min[axis];
+      back[axis] = (plane[axis] > 0.0f) ? chunk->min[axis] : chunk->max[axis];
+    }
+    if (plane_point_side_v3(plane, front) < 0.0f) {
+      return DRW_CULLING_CHUNK_OUTSIDE;
+    }
+    if (plane_point_side_v3(plane, back) < 0.0f) {
+      result = DRW_CULLING_CHUNK_INTERSECT;
+    }
+  }
+  return result;
+}
+
+/* Return True if the given BoundSphere projects to less than min_radius pixels.
+ * pixel_fac converts a radius at a clip space depth of 1 to pixels. */
+static bool draw_culling_pixel_test(const float persmat[4][4],
+                                    const float pixel_fac,
+                                    const float min_radius,
+                                    const BoundSphere *bsphere)
+{
+  const float *co = bsphere->center;
+  float w = persmat[0][3] * co[0] + persmat[1][3] * co[1] + persmat[2][3] * co[2] + persmat[3][3];
+  if (w <= bsphere->radius) {
+    /* Crossing the camera plane. */
+    return false;
+  }
+  return bsphere->radius * pixel_fac < min_radius * w;
+}
+
 static void draw_compute_culling(DRWView *view)
 {
   view = view->parent ? view->parent : view;
@@ -604,16 +684,50 @@ static void draw_compute_culling(DRWView *view)
     return;
   }
 
-  BLI_memblock_iter iter;
+  draw_culling_chunks_update();
+
+  /* Visibility functions need to be run on every resource. */
+  const bool use_chunk_test = (view->visibility_fn == NULL);
+  const bool use_pixel_test = (view->culling_min_pixel_radius > 0.0f);
+  const float pixel_fac = 0.5f * max_ff(view->storage.winmat[0][0] * DST.size[0],
+                                        view->storage.winmat[1][1] * DST.size[1]);
+
+  BLI_memblock_iter iter, chunk_iter;
   BLI_memblock_iternew(DST.vmempool->cullstates, &iter);
+  BLI_memblock_iternew(DST.vmempool->cullchunks, &chunk_iter);
+  eDRWCullingChunkResult chunk_result = DRW_CULLING_CHUNK_INTERSECT;
   DRWCullingState *cull;
-  while ((cull = BLI_memblock_iterstep(&iter))) {
+  for (int i = 0; (cull = BLI_memblock_iterstep(&iter)); i++) {
+    if ((i % DRW_RESOURCE_CHUNK_LEN) == 0) {
+      DRWCullingChunk *chunk = BLI_memblock_iterstep(&chunk_iter);
+      BLI_assert(chunk != NULL);
+      if (use_chunk_test) {
+        chunk_result = draw_culling_chunk_test(view->frustum_planes, chunk);
+      }
+    }
+
     if (cull->bsphere.radius < 0.0) {
       cull->mask = 0;
     }
     else {
-      bool culled = !draw_culling_sphere_test(
-          &view->frustum_bsphere, view->frustum_planes, &cull->bsphere);
+      bool culled;
+      switch (chunk_result) {
+        case DRW_CULLING_CHUNK_OUTSIDE:
+          culled = true;
+          break;
+        case DRW_CULLING_CHUNK_INSIDE:
+          culled = false;
+          break;
+        default:
+          culled = !draw_culling_sphere_test(
+              &view->frustum_bsphere, view->frustum_planes, &cull->bsphere);
+          break;
+      }
+
+      if (!culled && use_pixel_test) {
+        culled = draw_culling_pixel_test(
+            view->storage.persmat, pixel_fac, view->culling_min_pixel_radius, &cull->bsphere);
+      }
 
 #ifdef DRW_DEBUG_CULLING
       if (G.debug_value != 0) {
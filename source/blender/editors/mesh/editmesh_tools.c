@@ -40,6 +40,7 @@
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_rand.h"
+#include "BLI_sort.h"
 #include "BLI_sort_utils.h"
 #include "BLI_string.h"
 
@@ -6271,7 +6272,7 @@ typedef struct BMElemSort {
   int org_idx;
 } BMElemSort;
 
-static int bmelemsort_comp(const void *v1, const void *v2)
+static int bmelemsort_comp(const void *v1, const void *v2, void *UNUSED(user_data))
 {
   const BMElemSort *x1 = v1, *x2 = v2;
 
@@ -6695,7 +6696,7 @@ static void sort_bmelem_flag(bContext *C,
       int tot = totelem[j];
       int aff = affected[j];
 
-      qsort(sb, aff, sizeof(BMElemSort), bmelemsort_comp);
+      BLI_merge_sort_r(sb, (size_t)aff, sizeof(BMElemSort), bmelemsort_comp, NULL);
 
       mp = map[j] = MEM_mallocN(sizeof(int) * tot, "sort_bmelem map");
       p_blk = pb + tot - 1;
@@ -31,6 +31,7 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
+#include "BLI_system.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_mesh_types.h"
@@ -128,9 +129,22 @@ static bool object_remesh_poll(bContext *C)
   return ED_operator_object_active_editable_mesh(C);
 }
 
+/* Only shows progress. The operator blocks the main thread, so no events are handled while it
+ * runs and it can't be cancelled. Unlike QuadriFlow it is not a job, since the undo step is
+ * pushed when the operator finishes. */
+static void voxel_remesh_update(void *customdata, float progress, int *cancel)
+{
+  wmWindow *win = customdata;
+  if (win) {
+    WM_cursor_time(win, (int)(progress * 100.0f));
+  }
+  *cancel = 0;
+}
+
 static int voxel_remesh_exec(bContext *C, wmOperator *op)
 {
   Object *ob = CTX_data_active_object(C);
+  wmWindow *win = CTX_wm_window(C);
 
   Mesh *mesh = ob->data;
   Mesh *new_mesh;
@@ -145,8 +159,23 @@ static int voxel_remesh_exec(bContext *C, wmOperator *op)
     isovalue = mesh->remesh_voxel_size * 0.3f;
   }
 
-  new_mesh = BKE_mesh_remesh_voxel_to_mesh_nomain(
-      mesh, mesh->remesh_voxel_size, mesh->remesh_voxel_adaptivity, isovalue);
+  /* Split the volume in bricks when it would use more than the memory limit. */
+  size_t memory_limit = (size_t)RNA_int_get(op->ptr, "memory_limit");
+  if (memory_limit == 0) {
+    memory_limit = BLI_system_memory_max_in_megabytes() / 2;
+  }
+  memory_limit *= 1024 * 1024;
+
+  new_mesh = BKE_mesh_remesh_voxel_to_mesh_chunked_nomain(mesh,
+                                                          mesh->remesh_voxel_size,
+                                                          mesh->remesh_voxel_adaptivity,
+                                                          isovalue,
+                                                          memory_limit,
+                                                          voxel_remesh_update,
+                                                          win);
+  if (win) {
+    WM_cursor_modal_restore(win);
+  }
 
   if (!new_mesh) {
     BKE_report(op->reports, RPT_ERROR, "Voxel remesher failed to create mesh");
@@ -215,6 +244,17 @@ void OBJECT_OT_voxel_remesh(wmOperatorType *ot)
   ot->exec = voxel_remesh_exec;
 
   ot->flag = OPTYPE_REGISTER | OPTYPE_UNDO;
+
+  RNA_def_int(ot->srna,
+              "memory_limit",
+              0,
+              0,
+              INT_MAX,
+              "Memory Limit",
+              "Maximum memory used by the volume in megabytes, larger volumes are remeshed in "
+              "multiple parts (0 to use half of the system memory)",
+              0,
+              1 << 20);
 }
 
 /** \} */
@@ -24,6 +24,10 @@
 
 #include "MEM_guardedalloc.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "BLI_blenlib.h"
 #include "BLI_dial_2d.h"
 #include "BLI_ghash.h"
@@ -2344,16 +2348,11 @@ static float brush_strength(const Sculpt *sd,
   }
 }
 
-/* Return a multiplier for brush strength on a particular vertex. */
-float SCULPT_brush_strength_factor(SculptSession *ss,
-                                   const Brush *br,
-                                   const float brush_point[3],
-                                   const float len,
-                                   const short vno[3],
-                                   const float fno[3],
-                                   const float mask,
-                                   const int vertex_index,
-                                   const int thread_id)
+/* Strength of the brush texture at a vertex. */
+static float sculpt_brush_texture_strength(SculptSession *ss,
+                                           const Brush *br,
+                                           const float brush_point[3],
+                                           const int thread_id)
 {
   StrokeCache *cache = ss->cache;
   const Scene *scene = cache->vc->scene;
@@ -2416,6 +2415,23 @@ float SCULPT_brush_strength_factor(SculptSession *ss,
     }
   }
 
+  return avg;
+}
+
+/* Return a multiplier for brush strength on a particular vertex. */
+float SCULPT_brush_strength_factor(SculptSession *ss,
+                                   const Brush *br,
+                                   const float brush_point[3],
+                                   const float len,
+                                   const short vno[3],
+                                   const float fno[3],
+                                   const float mask,
+                                   const int vertex_index,
+                                   const int thread_id)
+{
+  StrokeCache *cache = ss->cache;
+  float avg = sculpt_brush_texture_strength(ss, br, brush_point, thread_id);
+
   /* Hardness. */
   float final_len = len;
   const float hardness = br->hardness;
@@ -2444,6 +2460,354 @@ float SCULPT_brush_strength_factor(SculptSession *ss,
   return avg;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Batched Brush Strength
+ *
+ * Same result as #SCULPT_brush_test_init_with_falloff_shape and #SCULPT_brush_strength_factor,
+ * evaluated for a block of vertices. The distances, hardness, falloff curve presets, front-face
+ * and mask factors are computed four vertices at a time with SSE2. The texture, custom curves
+ * and automasking are evaluated per vertex, only for the vertices inside of the brush.
+ * \{ */
+
+#define SCULPT_BRUSH_BATCH_LANES 4
+
+void SCULPT_brush_batch_init(SculptBrushBatch *batch, const Brush *br, const bool use_normals)
+{
+  batch->len = 0;
+  batch->use_normals = use_normals || (br->flag & BRUSH_FRONTFACE);
+  batch->active_len = 0;
+}
+
+void SCULPT_brush_batch_add(SculptBrushBatch *batch, const PBVHVertexIter *vd)
+{
+  BLI_assert(batch->len < SCULPT_BRUSH_BATCH_SIZE);
+  const int k = batch->len++;
+
+  batch->co[0][k] = vd->co[0];
+  batch->co[1][k] = vd->co[1];
+  batch->co[2][k] = vd->co[2];
+  if (batch->use_normals) {
+    float no[3];
+    if (vd->no) {
+      normal_short_to_float_v3(no, vd->no);
+    }
+    else {
+      copy_v3_v3(no, vd->fno);
+    }
+    batch->no[0][k] = no[0];
+    batch->no[1][k] = no[1];
+    batch->no[2][k] = no[2];
+  }
+  batch->mask[k] = vd->mask ? *vd->mask : 0.0f;
+  batch->vertex_index[k] = vd->index;
+  batch->node_index[k] = vd->i;
+  batch->co_ptr[k] = vd->co;
+  batch->mask_ptr[k] = vd->mask;
+  batch->mvert[k] = vd->mvert;
+}
+
+/* Number of vertices rounded up to whole groups of lanes, the padding is filled with vertices
+ * that are outside of any brush. */
+static int sculpt_brush_batch_pad(SculptBrushBatch *batch)
+{
+  const int len_padded = (batch->len + SCULPT_BRUSH_BATCH_LANES - 1) / SCULPT_BRUSH_BATCH_LANES *
+                         SCULPT_BRUSH_BATCH_LANES;
+  for (int k = batch->len; k < len_padded; k++) {
+    for (int j = 0; j < 3; j++) {
+      batch->co[j][k] = FLT_MAX;
+      batch->no[j][k] = 0.0f;
+    }
+    batch->mask[k] = 0.0f;
+  }
+  return len_padded;
+}
+
+/* Squared distance to the brush, see #SCULPT_brush_test_sphere_sq and
+ * #SCULPT_brush_test_circle_sq. */
+static void sculpt_brush_batch_dist_sq(const SculptBrushTest *test,
+                                       const bool use_plane,
+                                       const SculptBrushBatch *batch,
+                                       const int len_padded,
+                                       float *r_dist_sq)
+{
+  const float *plane = test->plane_view;
+  const float *location = test->location;
+#ifdef __SSE2__
+  const __m128 plane_x = _mm_set1_ps(plane[0]);
+  const __m128 plane_y = _mm_set1_ps(plane[1]);
+  const __m128 plane_z = _mm_set1_ps(plane[2]);
+  const __m128 plane_w = _mm_set1_ps(plane[3]);
+  const __m128 location_x = _mm_set1_ps(location[0]);
+  const __m128 location_y = _mm_set1_ps(location[1]);
+  const __m128 location_z = _mm_set1_ps(location[2]);
+  for (int k = 0; k < len_padded; k += SCULPT_BRUSH_BATCH_LANES) {
+    __m128 x = _mm_loadu_ps(&batch->co[0][k]);
+    __m128 y = _mm_loadu_ps(&batch->co[1][k]);
+    __m128 z = _mm_loadu_ps(&batch->co[2][k]);
+    if (use_plane) {
+      /* Project onto the view plane. */
+      const __m128 side = _mm_add_ps(
+          _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x, x), _mm_mul_ps(plane_y, y)),
+                     _mm_mul_ps(plane_z, z)),
+          plane_w);
+      x = _mm_sub_ps(x, _mm_mul_ps(plane_x, side));
+      y = _mm_sub_ps(y, _mm_mul_ps(plane_y, side));
+      z = _mm_sub_ps(z, _mm_mul_ps(plane_z, side));
+    }
+    const __m128 dx = _mm_sub_ps(x, location_x);
+    const __m128 dy = _mm_sub_ps(y, location_y);
+    const __m128 dz = _mm_sub_ps(z, location_z);
+    _mm_storeu_ps(&r_dist_sq[k],
+                  _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                             _mm_mul_ps(dz, dz)));
+  }
+#else
+  for (int k = 0; k < len_padded; k++) {
+    float co[3] = {batch->co[0][k], batch->co[1][k], batch->co[2][k]};
+    if (use_plane) {
+      float co_proj[3];
+      closest_to_plane_normalized_v3(co_proj, plane, co);
+      copy_v3_v3(co, co_proj);
+    }
+    r_dist_sq[k] = len_squared_v3v3(co, location);
+  }
+#endif
+}
+
+#ifdef __SSE2__
+/* See #BKE_brush_curve_strength, \a p is one minus the relative distance. */
+static __m128 sculpt_brush_batch_curve_preset_v4(const int curve_preset, const __m128 p)
+{
+  switch (curve_preset) {
+    case BRUSH_CURVE_SHARP:
+      return _mm_mul_ps(p, p);
+    case BRUSH_CURVE_SMOOTH:
+      return _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(3.0f), p), p),
+                        _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(2.0f), p), p), p));
+    case BRUSH_CURVE_SMOOTHER: {
+      const __m128 p_cube = _mm_mul_ps(_mm_mul_ps(p, p), p);
+      const __m128 poly = _mm_add_ps(
+          _mm_mul_ps(p, _mm_sub_ps(_mm_mul_ps(p, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))),
+          _mm_set1_ps(10.0f));
+      return _mm_mul_ps(p_cube, poly);
+    }
+    case BRUSH_CURVE_ROOT:
+      return _mm_sqrt_ps(p);
+    case BRUSH_CURVE_LIN:
+      return p;
+    case BRUSH_CURVE_SPHERE:
+      return _mm_sqrt_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(2.0f), p), _mm_mul_ps(p, p)));
+    case BRUSH_CURVE_POW4:
+      return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(p, p), p), p);
+    case BRUSH_CURVE_INVSQUARE:
+      return _mm_mul_ps(p, _mm_sub_ps(_mm_set1_ps(2.0f), p));
+    case BRUSH_CURVE_CONSTANT:
+    default:
+      return _mm_set1_ps(1.0f);
+  }
+}
+#endif
+
+/* Multiply the factors with the hardness and falloff curve, front-face and mask factors. See
+ * #SCULPT_brush_strength_factor. Custom curves are passed in \a curve_custom. */
+static void sculpt_brush_batch_falloff(SculptSession *ss,
+                                       const Brush *br,
+                                       const bool use_mask,
+                                       const float *curve_custom,
+                                       const int len_padded,
+                                       SculptBrushBatch *batch)
+{
+  const StrokeCache *cache = ss->cache;
+  const float radius = cache->radius;
+  const float hardness = br->hardness;
+  const bool use_frontface = (br->flag & BRUSH_FRONTFACE) != 0;
+  const float *view_normal = cache->view_normal;
+
+#ifdef __SSE2__
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 radius_v4 = _mm_set1_ps(radius);
+  const __m128 hardness_v4 = _mm_set1_ps(hardness);
+  const __m128 hardness_range = _mm_set1_ps(1.0f - hardness);
+  for (int k = 0; k < len_padded; k += SCULPT_BRUSH_BATCH_LANES) {
+    const __m128 len = _mm_loadu_ps(&batch->dist[k]);
+
+    /* Hardness. */
+    const __m128 p = _mm_div_ps(len, radius_v4);
+    __m128 final_len;
+    if (hardness == 1.0f) {
+      final_len = _mm_and_ps(_mm_cmpge_ps(p, hardness_v4), radius_v4);
+    }
+    else {
+      final_len = _mm_mul_ps(_mm_div_ps(_mm_sub_ps(p, hardness_v4), hardness_range), radius_v4);
+      final_len = _mm_and_ps(_mm_cmpge_ps(p, hardness_v4), final_len);
+    }
+
+    /* Falloff curve. */
+    __m128 curve;
+    if (curve_custom) {
+      curve = _mm_loadu_ps(&curve_custom[k]);
+    }
+    else {
+      const __m128 curve_p = _mm_sub_ps(one, _mm_div_ps(final_len, radius_v4));
+      curve = sculpt_brush_batch_curve_preset_v4(br->curve_preset, curve_p);
+      curve = _mm_and_ps(_mm_cmplt_ps(final_len, radius_v4), curve);
+    }
+    __m128 factor = _mm_mul_ps(_mm_loadu_ps(&batch->factor[k]), curve);
+
+    if (use_frontface) {
+      const __m128 dot = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&batch->no[0][k]), _mm_set1_ps(view_normal[0])),
+                     _mm_mul_ps(_mm_loadu_ps(&batch->no[1][k]), _mm_set1_ps(view_normal[1]))),
+          _mm_mul_ps(_mm_loadu_ps(&batch->no[2][k]), _mm_set1_ps(view_normal[2])));
+      factor = _mm_mul_ps(factor, _mm_max_ps(dot, zero));
+    }
+
+    /* Paint mask. */
+    if (use_mask) {
+      factor = _mm_mul_ps(factor, _mm_sub_ps(one, _mm_loadu_ps(&batch->mask[k])));
+    }
+
+    _mm_storeu_ps(&batch->factor[k], factor);
+  }
+#else
+  for (int k = 0; k < len_padded; k++) {
+    const float len = batch->dist[k];
+
+    /* Hardness. */
+    float final_len = len;
+    float p = len / radius;
+    if (p < hardness) {
+      final_len = 0.0f;
+    }
+    else if (hardness == 1.0f) {
+      final_len = radius;
+    }
+    else {
+      p = (p - hardness) / (1.0f - hardness);
+      final_len = p * radius;
+    }
+
+    /* Falloff curve. */
+    batch->factor[k] *= curve_custom ? curve_custom[k] :
+                                       BKE_brush_curve_strength(br, final_len, radius);
+
+    if (use_frontface) {
+      const float dot = batch->no[0][k] * view_normal[0] + batch->no[1][k] * view_normal[1] +
+                        batch->no[2][k] * view_normal[2];
+      batch->factor[k] *= dot > 0.0f ? dot : 0.0f;
+    }
+
+    /* Paint mask. */
+    if (use_mask) {
+      batch->factor[k] *= 1.0f - batch->mask[k];
+    }
+  }
+#endif
+}
+
+/**
+ * Test the vertices of the batch against the brush and compute the strength factor of the ones
+ * inside, see #SCULPT_brush_strength_factor.
+ *
+ * \param use_mask: When false the paint mask is ignored, as if it was zero everywhere.
+ */
+void SCULPT_brush_batch_strength_factors(SculptSession *ss,
+                                         const Brush *br,
+                                         const SculptBrushTest *test,
+                                         const char falloff_shape,
+                                         const bool use_mask,
+                                         const int thread_id,
+                                         SculptBrushBatch *batch)
+{
+  const StrokeCache *cache = ss->cache;
+  const int len_padded = sculpt_brush_batch_pad(batch);
+
+  /* Brush test. */
+  float *dist_sq = batch->dist;
+  sculpt_brush_batch_dist_sq(
+      test, falloff_shape != PAINT_FALLOFF_SHAPE_SPHERE, batch, len_padded, dist_sq);
+
+  batch->active_len = 0;
+  for (int k = 0; k < batch->len; k++) {
+    if (dist_sq[k] <= test->radius_squared) {
+      if (test->clip_rv3d) {
+        const float co[3] = {batch->co[0][k], batch->co[1][k], batch->co[2][k]};
+        if (sculpt_brush_test_clipping(test, co)) {
+          continue;
+        }
+      }
+      batch->active[batch->active_len++] = k;
+    }
+  }
+  if (batch->active_len == 0) {
+    return;
+  }
+
+  for (int k = 0; k < len_padded; k++) {
+    batch->dist[k] = sqrtf(dist_sq[k]);
+  }
+
+  /* Texture. Inactive lanes are still part of the vector operations below, so they must hold
+   * valid floats. */
+  if (br->mtex.tex) {
+    copy_vn_fl(batch->factor, len_padded, 0.0f);
+    for (int i = 0; i < batch->active_len; i++) {
+      const int k = batch->active[i];
+      const float co[3] = {batch->co[0][k], batch->co[1][k], batch->co[2][k]};
+      batch->factor[k] = sculpt_brush_texture_strength(ss, br, co, thread_id);
+    }
+  }
+  else {
+    copy_vn_fl(batch->factor, len_padded, 1.0f);
+  }
+
+  /* Custom falloff curves can't be vectorized. */
+  float curve_custom[SCULPT_BRUSH_BATCH_SIZE];
+  const bool use_curve_custom = br->curve_preset == BRUSH_CURVE_CUSTOM;
+  if (use_curve_custom) {
+    copy_vn_fl(curve_custom, len_padded, 0.0f);
+    for (int i = 0; i < batch->active_len; i++) {
+      const int k = batch->active[i];
+      const float len = batch->dist[k];
+      float final_len = len;
+      float p = len / cache->radius;
+      if (p < br->hardness) {
+        final_len = 0.0f;
+      }
+      else if (br->hardness == 1.0f) {
+        final_len = cache->radius;
+      }
+      else {
+        p = (p - br->hardness) / (1.0f - br->hardness);
+        final_len = p * cache->radius;
+      }
+      curve_custom[k] = BKE_brush_curve_strength(br, final_len, cache->radius);
+    }
+  }
+
+  sculpt_brush_batch_falloff(
+      ss, br, use_mask, use_curve_custom ? curve_custom : NULL, len_padded, batch);
+
+  /* Auto-masking. */
+  if (cache->automask_factor) {
+    for (int i = 0; i < batch->active_len; i++) {
+      const int k = batch->active[i];
+      batch->factor[k] *= cache->automask_factor[batch->vertex_index[k]];
+    }
+  }
+  else if (cache->automask_settings.flags & (BRUSH_AUTOMASKING_FACE_SETS |
+                                             BRUSH_AUTOMASKING_BOUNDARY_EDGES |
+                                             BRUSH_AUTOMASKING_BOUNDARY_FACE_SETS)) {
+    for (int i = 0; i < batch->active_len; i++) {
+      const int k = batch->active[i];
+      batch->factor[k] *= SCULPT_automasking_factor_get(ss, batch->vertex_index[k]);
+    }
+  }
+}
+
+/** \} */
+
 /* Test AABB against sphere. */
 bool SCULPT_search_sphere_cb(PBVHNode *node, void *data_v)
 {
@@ -2909,14 +3273,36 @@ static void do_mask_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
   }
 }
 
+static void do_draw_brush_batch(SculptThreadedTaskData *data,
+                                const SculptBrushTest *test,
+                                const int thread_id,
+                                float (*proxy)[3],
+                                SculptBrushBatch *batch)
+{
+  SculptSession *ss = data->ob->sculpt;
+  const float *offset = data->offset;
+
+  SCULPT_brush_batch_strength_factors(
+      ss, data->brush, test, data->brush->falloff_shape, true, thread_id, batch);
+
+  for (int i = 0; i < batch->active_len; i++) {
+    const int k = batch->active[i];
+    /* Offset vertex. */
+    mul_v3_v3fl(proxy[batch->node_index[k]], offset, batch->factor[k]);
+
+    if (batch->mvert[k]) {
+      batch->mvert[k]->flag |= ME_VERT_PBVH_UPDATE;
+    }
+  }
+  batch->len = 0;
+}
+
 static void do_draw_brush_task_cb_ex(void *__restrict userdata,
                                      const int n,
                                      const TaskParallelTLS *__restrict tls)
 {
   SculptThreadedTaskData *data = userdata;
   SculptSession *ss = data->ob->sculpt;
-  const Brush *brush = data->brush;
-  const float *offset = data->offset;
 
   PBVHVertexIter vd;
   float(*proxy)[3];
@@ -2924,32 +3310,22 @@ static void do_draw_brush_task_cb_ex(void *__restrict userdata,
   proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
 
   SculptBrushTest test;
-  SculptBrushTestFn sculpt_brush_test_sq_fn = SCULPT_brush_test_init_with_falloff_shape(
-      ss, &test, data->brush->falloff_shape);
+  SCULPT_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
   const int thread_id = BLI_task_parallel_thread_id(tls);
 
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, data->brush, false);
+
   BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
   {
-    if (sculpt_brush_test_sq_fn(&test, vd.co)) {
-      /* Offset vertex. */
-      const float fade = SCULPT_brush_strength_factor(ss,
-                                                      brush,
-                                                      vd.co,
-                                                      sqrtf(test.dist),
-                                                      vd.no,
-                                                      vd.fno,
-                                                      vd.mask ? *vd.mask : 0.0f,
-                                                      vd.index,
-                                                      thread_id);
-
-      mul_v3_v3fl(proxy[vd.i], offset, fade);
-
-      if (vd.mvert) {
-        vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
-      }
+    SCULPT_brush_batch_add(&batch, &vd);
+    if (batch.len == SCULPT_BRUSH_BATCH_SIZE) {
+      do_draw_brush_batch(data, &test, thread_id, proxy, &batch);
     }
   }
   BKE_pbvh_vertex_iter_end;
+
+  do_draw_brush_batch(data, &test, thread_id, proxy, &batch);
 }
 
 static void do_draw_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -4346,55 +4722,62 @@ static void do_layer_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode
   BLI_task_parallel_range(0, totnode, &data, do_layer_brush_task_cb_ex, &settings);
 }
 
+static void do_inflate_brush_batch(SculptThreadedTaskData *data,
+                                   const SculptBrushTest *test,
+                                   const int thread_id,
+                                   float (*proxy)[3],
+                                   SculptBrushBatch *batch)
+{
+  SculptSession *ss = data->ob->sculpt;
+  const float bstrength = ss->cache->bstrength;
+
+  SCULPT_brush_batch_strength_factors(
+      ss, data->brush, test, data->brush->falloff_shape, true, thread_id, batch);
+
+  for (int i = 0; i < batch->active_len; i++) {
+    const int k = batch->active[i];
+    const float fade = bstrength * batch->factor[k];
+    float val[3] = {batch->no[0][k], batch->no[1][k], batch->no[2][k]};
+
+    mul_v3_fl(val, fade * ss->cache->radius);
+    mul_v3_v3v3(proxy[batch->node_index[k]], val, ss->cache->scale);
+
+    if (batch->mvert[k]) {
+      batch->mvert[k]->flag |= ME_VERT_PBVH_UPDATE;
+    }
+  }
+  batch->len = 0;
+}
+
 static void do_inflate_brush_task_cb_ex(void *__restrict userdata,
                                         const int n,
                                         const TaskParallelTLS *__restrict tls)
 {
   SculptThreadedTaskData *data = userdata;
   SculptSession *ss = data->ob->sculpt;
-  const Brush *brush = data->brush;
 
   PBVHVertexIter vd;
   float(*proxy)[3];
-  const float bstrength = ss->cache->bstrength;
 
   proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
 
   SculptBrushTest test;
-  SculptBrushTestFn sculpt_brush_test_sq_fn = SCULPT_brush_test_init_with_falloff_shape(
-      ss, &test, data->brush->falloff_shape);
+  SCULPT_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
   const int thread_id = BLI_task_parallel_thread_id(tls);
 
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, data->brush, true);
+
   BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
   {
-    if (sculpt_brush_test_sq_fn(&test, vd.co)) {
-      const float fade = bstrength * SCULPT_brush_strength_factor(ss,
-                                                                  brush,
-                                                                  vd.co,
-                                                                  sqrtf(test.dist),
-                                                                  vd.no,
-                                                                  vd.fno,
-                                                                  vd.mask ? *vd.mask : 0.0f,
-                                                                  vd.index,
-                                                                  thread_id);
-      float val[3];
-
-      if (vd.fno) {
-        copy_v3_v3(val, vd.fno);
-      }
-      else {
-        normal_short_to_float_v3(val, vd.no);
-      }
-
-      mul_v3_fl(val, fade * ss->cache->radius);
-      mul_v3_v3v3(proxy[vd.i], val, ss->cache->scale);
-
-      if (vd.mvert) {
-        vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
-      }
+    SCULPT_brush_batch_add(&batch, &vd);
+    if (batch.len == SCULPT_BRUSH_BATCH_SIZE) {
+      do_inflate_brush_batch(data, &test, thread_id, proxy, &batch);
     }
   }
   BKE_pbvh_vertex_iter_end;
+
+  do_inflate_brush_batch(data, &test, thread_id, proxy, &batch);
 }
 
 static void do_inflate_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -7163,7 +7546,7 @@ void SCULPT_flush_update_step(bContext *C, SculptUpdateType update_flags)
   }
 
   if (mmd != NULL) {
-    multires_mark_as_modified(depsgraph, ob, MULTIRES_COORDS_MODIFIED);
+    multires_mark_sculpt_grids_as_modified(depsgraph, ob);
   }
 
   DEG_id_tag_update(&ob->id, ID_RECALC_SHADING);
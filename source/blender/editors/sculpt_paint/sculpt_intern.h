@@ -37,6 +37,7 @@
 #include "BKE_paint.h"
 #include "BKE_pbvh.h"
 
+struct BArrayState;
 struct KeyBlock;
 struct Object;
 struct SculptPoseIKChainSegment;
@@ -533,6 +534,18 @@ typedef struct SculptUndoNode {
   /* Sculpt Face Sets */
   int *face_sets;
 
+  /* De-duplicated arrays of a finished undo step, the arrays above are NULL while they are
+   * stored here. See the array store in sculpt_undo.c. */
+  struct {
+    struct BArrayState *co;
+    struct BArrayState *orig_co;
+    struct BArrayState *col;
+    struct BArrayState *mask;
+    struct BArrayState *index;
+    struct BArrayState *grids;
+    struct BArrayState *face_sets;
+  } store;
+
   size_t undo_size;
 } SculptUndoNode;
 
@@ -721,6 +734,47 @@ float SCULPT_brush_strength_factor(struct SculptSession *ss,
                                    const int vertex_index,
                                    const int thread_id);
 
+/* Batched brush strength, for brushes that only need the strength factor of every vertex.
+ * The vertices of a node are gathered into blocks, which are tested against the brush and
+ * get their strength factors computed all at once. */
+
+/* Number of vertices in a #SculptBrushBatch, a multiple of 4. */
+#define SCULPT_BRUSH_BATCH_SIZE 128
+
+typedef struct SculptBrushBatch {
+  int len;
+  /* Gather the vertex normals, they are needed for front-face falloff. */
+  bool use_normals;
+
+  /* Coordinates and normals as structure of arrays. */
+  float co[3][SCULPT_BRUSH_BATCH_SIZE];
+  float no[3][SCULPT_BRUSH_BATCH_SIZE];
+  float mask[SCULPT_BRUSH_BATCH_SIZE];
+  /* #PBVHVertexIter.index and #PBVHVertexIter.i */
+  int vertex_index[SCULPT_BRUSH_BATCH_SIZE];
+  int node_index[SCULPT_BRUSH_BATCH_SIZE];
+  float *co_ptr[SCULPT_BRUSH_BATCH_SIZE];
+  float *mask_ptr[SCULPT_BRUSH_BATCH_SIZE];
+  struct MVert *mvert[SCULPT_BRUSH_BATCH_SIZE];
+
+  /* Result of #SCULPT_brush_batch_strength_factors, the vertices inside of the brush and the
+   * distance and strength factor of every vertex. */
+  int active_len;
+  int active[SCULPT_BRUSH_BATCH_SIZE];
+  float dist[SCULPT_BRUSH_BATCH_SIZE];
+  float factor[SCULPT_BRUSH_BATCH_SIZE];
+} SculptBrushBatch;
+
+void SCULPT_brush_batch_init(SculptBrushBatch *batch, const struct Brush *br, bool use_normals);
+void SCULPT_brush_batch_add(SculptBrushBatch *batch, const PBVHVertexIter *vd);
+void SCULPT_brush_batch_strength_factors(struct SculptSession *ss,
+                                         const struct Brush *br,
+                                         const SculptBrushTest *test,
+                                         const char falloff_shape,
+                                         const bool use_mask,
+                                         const int thread_id,
+                                         SculptBrushBatch *batch);
+
 /* just for vertex paint. */
 bool SCULPT_pbvh_calc_area_normal(const struct Brush *brush,
                                   Object *ob,
@@ -195,15 +195,48 @@ void SCULPT_neighbor_color_average(SculptSession *ss, float result[4], int index
   }
 }
 
+static void do_smooth_brush_batch(SculptThreadedTaskData *data,
+                                  const SculptBrushTest *test,
+                                  const float bstrength,
+                                  const int thread_id,
+                                  SculptBrushBatch *batch)
+{
+  SculptSession *ss = data->ob->sculpt;
+  Sculpt *sd = data->sd;
+  const bool smooth_mask = data->smooth_mask;
+
+  SCULPT_brush_batch_strength_factors(
+      ss, data->brush, test, data->brush->falloff_shape, !smooth_mask, thread_id, batch);
+
+  for (int i = 0; i < batch->active_len; i++) {
+    const int k = batch->active[i];
+    const int vertex_index = batch->vertex_index[k];
+    const float fade = bstrength * batch->factor[k];
+    if (smooth_mask) {
+      float *mask = batch->mask_ptr[k];
+      float val = SCULPT_neighbor_mask_average(ss, vertex_index) - *mask;
+      val *= fade * bstrength;
+      *mask += val;
+      CLAMP(*mask, 0.0f, 1.0f);
+    }
+    else {
+      float *co = batch->co_ptr[k];
+      float avg[3], val[3];
+      SCULPT_neighbor_coords_average(ss, avg, vertex_index);
+      sub_v3_v3v3(val, avg, co);
+      madd_v3_v3v3fl(val, co, val, fade);
+      SCULPT_clip(sd, ss, co, val);
+    }
+  }
+  batch->len = 0;
+}
+
 static void do_smooth_brush_task_cb_ex(void *__restrict userdata,
                                        const int n,
                                        const TaskParallelTLS *__restrict tls)
 {
   SculptThreadedTaskData *data = userdata;
   SculptSession *ss = data->ob->sculpt;
-  Sculpt *sd = data->sd;
-  const Brush *brush = data->brush;
-  const bool smooth_mask = data->smooth_mask;
   float bstrength = data->strength;
 
   PBVHVertexIter vd;
@@ -211,40 +244,25 @@ static void do_smooth_brush_task_cb_ex(void *__restrict userdata,
   CLAMP(bstrength, 0.0f, 1.0f);
 
   SculptBrushTest test;
-  SculptBrushTestFn sculpt_brush_test_sq_fn = SCULPT_brush_test_init_with_falloff_shape(
-      ss, &test, data->brush->falloff_shape);
+  SCULPT_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
 
   const int thread_id = BLI_task_parallel_thread_id(tls);
 
+  /* Neighbors are averaged after the whole batch is tested, this gives the same result as
+   * smoothing each vertex right away since the strength only depends on the vertex itself. */
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, data->brush, false);
+
   BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
   {
-    if (sculpt_brush_test_sq_fn(&test, vd.co)) {
-      const float fade = bstrength * SCULPT_brush_strength_factor(
-                                         ss,
-                                         brush,
-                                         vd.co,
-                                         sqrtf(test.dist),
-                                         vd.no,
-                                         vd.fno,
-                                         smooth_mask ? 0.0f : (vd.mask ? *vd.mask : 0.0f),
-                                         vd.index,
-                                         thread_id);
-      if (smooth_mask) {
-        float val = SCULPT_neighbor_mask_average(ss, vd.index) - *vd.mask;
-        val *= fade * bstrength;
-        *vd.mask += val;
-        CLAMP(*vd.mask, 0.0f, 1.0f);
-      }
-      else {
-        float avg[3], val[3];
-        SCULPT_neighbor_coords_average(ss, avg, vd.index);
-        sub_v3_v3v3(val, avg, vd.co);
-        madd_v3_v3v3fl(val, vd.co, val, fade);
-        SCULPT_clip(sd, ss, vd.co, val);
-      }
+    SCULPT_brush_batch_add(&batch, &vd);
+    if (batch.len == SCULPT_BRUSH_BATCH_SIZE) {
+      do_smooth_brush_batch(data, &test, bstrength, thread_id, &batch);
     }
   }
   BKE_pbvh_vertex_iter_end;
+
+  do_smooth_brush_batch(data, &test, bstrength, thread_id, &batch);
 }
 
 void SCULPT_smooth(Sculpt *sd,
@@ -70,6 +70,18 @@
 #include "bmesh.h"
 #include "sculpt_intern.h"
 
+#define USE_ARRAY_STORE
+
+#ifdef USE_ARRAY_STORE
+#  include "BLI_array_store.h"
+#  include "BLI_array_store_utils.h"
+/* Strokes often change only a part of the vertices of a node, small chunks let the unchanged
+ * parts be shared with the previous state of the node. */
+#  define ARRAY_CHUNK_SIZE 128
+
+#  define USE_ARRAY_STORE_THREAD
+#endif
+
 /* Implementation of undo system for objects in sculpt mode.
  *
  * Each undo step in sculpt mode consists of list of nodes, each node contains:
@@ -107,7 +119,12 @@
  * does modifications on it.
  *
  * End of dynamic topology and symmetrize in this mode are handled in a special
- * manner as well. */
+ * manner as well.
+ *
+ * Once an undo step is finished, the arrays of its COORDS, MASK, COLOR and FACE_SETS nodes are
+ * moved into an array store. This de-duplicates them against the arrays of the same BVH node in
+ * the previous step, so strokes only pay for the part of the nodes they changed. The arrays are
+ * expanded again while the step is restored. */
 
 typedef struct UndoSculpt {
   ListBase nodes;
@@ -117,6 +134,291 @@ typedef struct UndoSculpt {
 
 static UndoSculpt *sculpt_undo_get_nodes(void);
 
+#ifdef USE_ARRAY_STORE
+
+/* -------------------------------------------------------------------- */
+/** \name Array Store
+ * \{ */
+
+static struct {
+  struct BArrayStore_AtSize bs_stride;
+  /* Number of undo nodes with stored arrays. */
+  int users;
+
+#  ifdef USE_ARRAY_STORE_THREAD
+  TaskPool *task_pool;
+#  endif
+} sculpt_arraystore = {{NULL}};
+
+#  define SCULPT_UNDO_ARRAYS_NUM 7
+
+typedef struct SculptUndoArray {
+  void **data;
+  BArrayState **state;
+  int stride;
+  /* Restoring the node swaps the array with the current values. */
+  bool is_swapped;
+} SculptUndoArray;
+
+static void sculpt_undo_node_arrays(SculptUndoNode *unode,
+                                    SculptUndoArray r_arrays[SCULPT_UNDO_ARRAYS_NUM])
+{
+  r_arrays[0] = (SculptUndoArray){
+      (void **)&unode->co, &unode->store.co, sizeof(*unode->co), true};
+  r_arrays[1] = (SculptUndoArray){
+      (void **)&unode->orig_co, &unode->store.orig_co, sizeof(*unode->orig_co), true};
+  r_arrays[2] = (SculptUndoArray){
+      (void **)&unode->mask, &unode->store.mask, sizeof(*unode->mask), true};
+  r_arrays[3] = (SculptUndoArray){
+      (void **)&unode->col, &unode->store.col, sizeof(*unode->col), false};
+  r_arrays[4] = (SculptUndoArray){
+      (void **)&unode->index, &unode->store.index, sizeof(*unode->index), false};
+  r_arrays[5] = (SculptUndoArray){
+      (void **)&unode->grids, &unode->store.grids, sizeof(*unode->grids), false};
+  r_arrays[6] = (SculptUndoArray){
+      (void **)&unode->face_sets, &unode->store.face_sets, sizeof(*unode->face_sets), false};
+}
+
+static bool sculpt_undo_arraystore_node_is_stored(SculptUndoNode *unode)
+{
+  SculptUndoArray arrays[SCULPT_UNDO_ARRAYS_NUM];
+  sculpt_undo_node_arrays(unode, arrays);
+  for (int i = 0; i < SCULPT_UNDO_ARRAYS_NUM; i++) {
+    if (*arrays[i].state) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Move the expanded arrays of the node into the array store. Arrays which are stored already are
+ * replaced, using their previous state as reference, otherwise the array of \a unode_ref is used.
+ */
+static void sculpt_undo_arraystore_compact_node(SculptUndoNode *unode, SculptUndoNode *unode_ref)
+{
+  SculptUndoArray arrays[SCULPT_UNDO_ARRAYS_NUM], arrays_ref[SCULPT_UNDO_ARRAYS_NUM];
+  sculpt_undo_node_arrays(unode, arrays);
+  if (unode_ref) {
+    sculpt_undo_node_arrays(unode_ref, arrays_ref);
+  }
+
+  const bool was_stored = sculpt_undo_arraystore_node_is_stored(unode);
+
+  for (int i = 0; i < SCULPT_UNDO_ARRAYS_NUM; i++) {
+    SculptUndoArray *array = &arrays[i];
+    if (*array->data == NULL) {
+      continue;
+    }
+
+    BArrayStore *bs = BLI_array_store_at_size_ensure(
+        &sculpt_arraystore.bs_stride, array->stride, ARRAY_CHUNK_SIZE);
+    BArrayState *state_reference = *array->state;
+    if (state_reference == NULL && unode_ref) {
+      state_reference = *arrays_ref[i].state;
+    }
+
+    BArrayState *state = BLI_array_store_state_add(
+        bs, *array->data, MEM_allocN_len(*array->data), state_reference);
+    if (*array->state) {
+      BLI_array_store_state_remove(bs, *array->state);
+    }
+    *array->state = state;
+
+    MEM_freeN(*array->data);
+    *array->data = NULL;
+  }
+
+  if (!was_stored && sculpt_undo_arraystore_node_is_stored(unode)) {
+    sculpt_arraystore.users += 1;
+  }
+}
+
+static void sculpt_undo_arraystore_expand_node(SculptUndoNode *unode)
+{
+  SculptUndoArray arrays[SCULPT_UNDO_ARRAYS_NUM];
+  sculpt_undo_node_arrays(unode, arrays);
+  for (int i = 0; i < SCULPT_UNDO_ARRAYS_NUM; i++) {
+    if (*arrays[i].state) {
+      BLI_assert(*arrays[i].data == NULL);
+      size_t data_len;
+      *arrays[i].data = BLI_array_store_state_data_get_alloc(*arrays[i].state, &data_len);
+    }
+  }
+}
+
+/**
+ * Remove the expanded arrays which were not changed by restoring the node.
+ */
+static void sculpt_undo_arraystore_expand_clear_unchanged_node(SculptUndoNode *unode)
+{
+  SculptUndoArray arrays[SCULPT_UNDO_ARRAYS_NUM];
+  sculpt_undo_node_arrays(unode, arrays);
+  for (int i = 0; i < SCULPT_UNDO_ARRAYS_NUM; i++) {
+    if (*arrays[i].state && !arrays[i].is_swapped) {
+      MEM_SAFE_FREE(*arrays[i].data);
+    }
+  }
+}
+
+static void sculpt_undo_arraystore_free_node(SculptUndoNode *unode)
+{
+  if (!sculpt_undo_arraystore_node_is_stored(unode)) {
+    return;
+  }
+
+  SculptUndoArray arrays[SCULPT_UNDO_ARRAYS_NUM];
+  sculpt_undo_node_arrays(unode, arrays);
+  for (int i = 0; i < SCULPT_UNDO_ARRAYS_NUM; i++) {
+    if (*arrays[i].state) {
+      BArrayStore *bs = BLI_array_store_at_size_get(&sculpt_arraystore.bs_stride,
+                                                    arrays[i].stride);
+      BLI_array_store_state_remove(bs, *arrays[i].state);
+      *arrays[i].state = NULL;
+    }
+  }
+
+  sculpt_arraystore.users -= 1;
+  BLI_assert(sculpt_arraystore.users >= 0);
+}
+
+/**
+ * Compact all nodes of an undo step. Nodes are de-duplicated against the node of the same BVH
+ * node in \a lb_ref, which is typically the previous step. The memory this adds to the array
+ * store is written to \a r_undo_size.
+ */
+static void sculpt_undo_arraystore_compact_list(ListBase *lb,
+                                                const ListBase *lb_ref,
+                                                size_t *r_undo_size)
+{
+  size_t size_expanded_prev, size_compacted_prev;
+  BLI_array_store_at_size_calc_memory_usage(
+      &sculpt_arraystore.bs_stride, &size_expanded_prev, &size_compacted_prev);
+
+  GHash *unode_ref_map = NULL;
+  if (lb_ref && !BLI_listbase_is_empty(lb_ref)) {
+    unode_ref_map = BLI_ghash_ptr_new(__func__);
+    LISTBASE_FOREACH (SculptUndoNode *, unode_ref, lb_ref) {
+      if (unode_ref->node) {
+        BLI_ghash_reinsert(unode_ref_map, unode_ref->node, unode_ref, NULL, NULL);
+      }
+    }
+  }
+
+  LISTBASE_FOREACH (SculptUndoNode *, unode, lb) {
+    SculptUndoNode *unode_ref = NULL;
+    if (unode_ref_map && unode->node) {
+      unode_ref = BLI_ghash_lookup(unode_ref_map, unode->node);
+    }
+    sculpt_undo_arraystore_compact_node(unode, unode_ref);
+  }
+
+  if (unode_ref_map) {
+    BLI_ghash_free(unode_ref_map, NULL, NULL);
+  }
+
+  if (r_undo_size) {
+    size_t size_expanded, size_compacted;
+    BLI_array_store_at_size_calc_memory_usage(
+        &sculpt_arraystore.bs_stride, &size_expanded, &size_compacted);
+    *r_undo_size = size_compacted - size_compacted_prev;
+  }
+}
+
+#  ifdef USE_ARRAY_STORE_THREAD
+
+struct SculptArrayStoreTaskData {
+  ListBase *lb;
+  const ListBase *lb_ref; /* can be NULL */
+  size_t *r_undo_size;    /* can be NULL */
+};
+
+static void sculpt_undo_arraystore_compact_cb(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  struct SculptArrayStoreTaskData *task_data = taskdata;
+  sculpt_undo_arraystore_compact_list(task_data->lb, task_data->lb_ref, task_data->r_undo_size);
+}
+
+#  endif /* USE_ARRAY_STORE_THREAD */
+
+/**
+ * Wait for the compaction running in the background, it has to be done before the stored arrays
+ * or the sizes of the steps are accessed.
+ */
+static void sculpt_undo_arraystore_wait(void)
+{
+#  ifdef USE_ARRAY_STORE_THREAD
+  if (sculpt_arraystore.task_pool) {
+    BLI_task_pool_work_and_wait(sculpt_arraystore.task_pool);
+  }
+#  endif
+}
+
+static void sculpt_undo_arraystore_compact_list_push(ListBase *lb,
+                                                     const ListBase *lb_ref,
+                                                     size_t *r_undo_size)
+{
+#  ifdef USE_ARRAY_STORE_THREAD
+  if (sculpt_arraystore.task_pool == NULL) {
+    sculpt_arraystore.task_pool = BLI_task_pool_create_background(NULL, TASK_PRIORITY_LOW);
+  }
+
+  struct SculptArrayStoreTaskData *task_data = MEM_mallocN(sizeof(*task_data), __func__);
+  task_data->lb = lb;
+  task_data->lb_ref = lb_ref;
+  task_data->r_undo_size = r_undo_size;
+
+  BLI_task_pool_push(
+      sculpt_arraystore.task_pool, sculpt_undo_arraystore_compact_cb, task_data, true, NULL);
+#  else
+  sculpt_undo_arraystore_compact_list(lb, lb_ref, r_undo_size);
+#  endif
+}
+
+static void sculpt_undo_arraystore_expand_list(ListBase *lb)
+{
+  sculpt_undo_arraystore_wait();
+
+  LISTBASE_FOREACH (SculptUndoNode *, unode, lb) {
+    sculpt_undo_arraystore_expand_node(unode);
+  }
+}
+
+/**
+ * Store the arrays of a step again after it was restored.
+ */
+static void sculpt_undo_arraystore_compact_restored_list(ListBase *lb)
+{
+  LISTBASE_FOREACH (SculptUndoNode *, unode, lb) {
+    sculpt_undo_arraystore_expand_clear_unchanged_node(unode);
+  }
+  sculpt_undo_arraystore_compact_list_push(lb, NULL, NULL);
+}
+
+static void sculpt_undo_arraystore_free_list(ListBase *lb)
+{
+  sculpt_undo_arraystore_wait();
+
+  LISTBASE_FOREACH (SculptUndoNode *, unode, lb) {
+    sculpt_undo_arraystore_free_node(unode);
+  }
+
+  if (sculpt_arraystore.users == 0) {
+    BLI_array_store_at_size_clear(&sculpt_arraystore.bs_stride);
+
+#  ifdef USE_ARRAY_STORE_THREAD
+    if (sculpt_arraystore.task_pool) {
+      BLI_task_pool_free(sculpt_arraystore.task_pool);
+      sculpt_arraystore.task_pool = NULL;
+    }
+#  endif
+  }
+}
+
+/** \} */
+
+#endif /* USE_ARRAY_STORE */
+
 static void update_cb(PBVHNode *node, void *rebuild)
 {
   BKE_pbvh_node_mark_update(node);
@@ -828,6 +1130,10 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
 
 static void sculpt_undo_free_list(ListBase *lb)
 {
+#ifdef USE_ARRAY_STORE
+  sculpt_undo_arraystore_free_list(lb);
+#endif
+
   SculptUndoNode *unode = lb->first;
   while (unode != NULL) {
     SculptUndoNode *unode_next = unode->next;
@@ -1001,7 +1307,7 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
       unode->co = MEM_callocN(sizeof(float[3]) * allvert, "SculptUndoNode.co");
       unode->no = MEM_callocN(sizeof(short[3]) * allvert, "SculptUndoNode.no");
 
-      usculpt->undo_size = (sizeof(float[3]) + sizeof(short[3]) + sizeof(int)) * allvert;
+      usculpt->undo_size += (sizeof(float[3]) + sizeof(short[3]) + sizeof(int)) * allvert;
       break;
     case SCULPT_UNDO_HIDDEN:
       if (maxgrid) {
@@ -1015,13 +1321,13 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
     case SCULPT_UNDO_MASK:
       unode->mask = MEM_callocN(sizeof(float) * allvert, "SculptUndoNode.mask");
 
-      usculpt->undo_size += (sizeof(float) * sizeof(int)) * allvert;
+      usculpt->undo_size += (sizeof(float) + sizeof(int)) * allvert;
 
       break;
     case SCULPT_UNDO_COLOR:
       unode->col = MEM_callocN(sizeof(MPropCol) * allvert, "SculptUndoNode.col");
 
-      usculpt->undo_size += (sizeof(MPropCol) * sizeof(int)) * allvert;
+      usculpt->undo_size += (sizeof(MPropCol) + sizeof(int)) * allvert;
 
       break;
     case SCULPT_UNDO_DYNTOPO_BEGIN:
@@ -1165,6 +1471,7 @@ static SculptUndoNode *sculpt_undo_face_sets_push(Object *ob, SculptUndoType typ
   }
 
   BLI_addtail(&usculpt->nodes, unode);
+  usculpt->undo_size += sizeof(int) * me->totpoly;
 
   return unode;
 }
@@ -1406,6 +1713,29 @@ static bool sculpt_undosys_step_encode(struct bContext *UNUSED(C),
   SculptUndoStep *us = (SculptUndoStep *)us_p;
   us->step.data_size = us->data.undo_size;
 
+#ifdef USE_ARRAY_STORE
+  {
+    /* The step isn't added to the stack yet, the last sculpt step is the previous one. */
+    UndoStack *ustack = ED_undo_stack_get();
+    SculptUndoStep *us_prev = NULL;
+    sculpt_undo_arraystore_wait();
+    LISTBASE_FOREACH_BACKWARD (UndoStep *, us_iter, &ustack->steps) {
+      if (us_iter->type == us_p->type) {
+        /* The steps are compacted by now, use the memory their arrays actually take. */
+        us_iter->data_size = ((SculptUndoStep *)us_iter)->data.undo_size;
+        if (us_prev == NULL) {
+          us_prev = (SculptUndoStep *)us_iter;
+        }
+      }
+    }
+
+    /* Until the compaction is done, the step is counted with the size of its expanded arrays. */
+    sculpt_undo_arraystore_compact_list_push(&us->data.nodes,
+                                             us_prev ? &us_prev->data.nodes : NULL,
+                                             &us->data.undo_size);
+  }
+#endif
+
   SculptUndoNode *unode = us->data.nodes.last;
   if (unode && unode->type == SCULPT_UNDO_DYNTOPO_END) {
     us->step.use_memfile_step = true;
@@ -1424,7 +1754,13 @@ static void sculpt_undosys_step_decode_undo_impl(struct bContext *C,
                                                  SculptUndoStep *us)
 {
   BLI_assert(us->step.is_applied == true);
+#ifdef USE_ARRAY_STORE
+  sculpt_undo_arraystore_expand_list(&us->data.nodes);
+#endif
   sculpt_undo_restore_list(C, depsgraph, &us->data.nodes);
+#ifdef USE_ARRAY_STORE
+  sculpt_undo_arraystore_compact_restored_list(&us->data.nodes);
+#endif
   us->step.is_applied = false;
 }
 
@@ -1433,7 +1769,13 @@ static void sculpt_undosys_step_decode_redo_impl(struct bContext *C,
                                                  SculptUndoStep *us)
 {
   BLI_assert(us->step.is_applied == false);
+#ifdef USE_ARRAY_STORE
+  sculpt_undo_arraystore_expand_list(&us->data.nodes);
+#endif
   sculpt_undo_restore_list(C, depsgraph, &us->data.nodes);
+#ifdef USE_ARRAY_STORE
+  sculpt_undo_arraystore_compact_restored_list(&us->data.nodes);
+#endif
   us->step.is_applied = true;
 }
 
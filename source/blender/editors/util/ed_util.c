@@ -298,6 +298,10 @@ bool ED_editors_flush_edits_ex(Main *bmain, bool for_render, bool check_needs_fl
   }
 
   bmain->is_memfile_undo_flush_needed = false;
+  if (has_edited) {
+    /* The flushed data isn't tagged, the next memfile undo step must write it. */
+    bmain->is_memfile_undo_id_reuse_valid = false;
+  }
 
   return has_edited;
 }
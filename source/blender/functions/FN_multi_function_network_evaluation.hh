@@ -23,14 +23,19 @@
 
 #include "FN_multi_function_network.hh"
 
+struct TaskParallelTLS;
+
 namespace blender::fn {
 
 class MFNetworkEvaluationStorage;
+class MFNetworkEvaluationScratch;
 
 class MFNetworkEvaluator : public MultiFunction {
  private:
   Vector<const MFOutputSocket *> inputs_;
   Vector<const MFInputSocket *> outputs_;
+  /** Only networks without vector parameters can be split into chunks. */
+  bool allow_chunked_evaluation_;
 
  public:
   MFNetworkEvaluator(Vector<const MFOutputSocket *> inputs, Vector<const MFInputSocket *> outputs);
@@ -40,6 +45,20 @@ class MFNetworkEvaluator : public MultiFunction {
  private:
   using Storage = MFNetworkEvaluationStorage;
 
+  void call_chunked(IndexMask mask, MFParams params, MFContext context) const;
+  static void call_chunk_cb(void *__restrict userdata,
+                            const int chunk_index,
+                            const TaskParallelTLS *__restrict tls);
+  void call_chunk(uint chunk_index,
+                  IndexMask mask,
+                  MFParams params,
+                  MFContext context,
+                  MFNetworkEvaluationScratch &scratch) const;
+  void evaluate(IndexMask mask,
+                MFParams params,
+                MFContext context,
+                MFNetworkEvaluationScratch *scratch) const;
+
   void copy_inputs_to_storage(MFParams params, Storage &storage) const;
   void copy_outputs_to_storage(
       MFParams params,
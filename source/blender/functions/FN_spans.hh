@@ -163,6 +163,12 @@ class GMutableSpan {
     return POINTER_OFFSET(buffer_, type_->size() * index);
   }
 
+  GMutableSpan slice(uint start, uint size) const
+  {
+    BLI_assert(start + size <= size_);
+    return GMutableSpan(*type_, POINTER_OFFSET(buffer_, type_->size() * start), size);
+  }
+
   template<typename T> MutableSpan<T> typed()
   {
     BLI_assert(type_->is<T>());
@@ -391,6 +397,28 @@ class GVSpan : public VSpanBase<void> {
     return (*this)[0];
   }
 
+  /**
+   * Returns a virtual span that starts at the given index. A single element stays single.
+   */
+  GVSpan slice(uint start, uint size) const
+  {
+    BLI_assert(start + size <= this->virtual_size_);
+    GVSpan ref = *this;
+    ref.virtual_size_ = size;
+    switch (this->category_) {
+      case VSpanCategory::Single:
+        break;
+      case VSpanCategory::FullArray:
+        ref.data_.full_array.data = POINTER_OFFSET(this->data_.full_array.data,
+                                                   start * type_->size());
+        break;
+      case VSpanCategory::FullPointerArray:
+        ref.data_.full_pointer_array.data = this->data_.full_pointer_array.data + start;
+        break;
+    }
+    return ref;
+  }
+
   void materialize_to_uninitialized(void *dst) const
   {
     this->materialize_to_uninitialized(IndexRange(virtual_size_), dst);
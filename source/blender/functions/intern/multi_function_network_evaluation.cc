@@ -28,9 +28,11 @@
  * - Avoids data copies in many cases.
  * - Every node is executed at most once.
  * - Can compute sub-functions on a single element, when the result is the same for all elements.
+ * - Large masks are split into chunks which are evaluated in parallel. Every chunk only needs
+ *   small intermediate buffers that stay in the cache. They are reused by the following nodes and
+ *   chunks evaluated on the same thread, so a chain of nodes effectively runs fused per chunk.
  *
  * Possible improvements:
- * - Cache and reuse buffers.
  * - Use "deepest depth first" heuristic to decide which order the inputs of a node should be
  *   computed. This reduces the number of required temporary buffers when they are reused.
  */
@@ -38,11 +40,48 @@
 #include "FN_multi_function_network_evaluation.hh"
 
 #include "BLI_stack.hh"
+#include "BLI_task.h"
 
 namespace blender::fn {
 
+/* Number of indices evaluated at once when the mask is split into chunks. Intermediate buffers
+ * of a few chunk sized float3 arrays should fit into the L2 cache. */
+#define MF_NETWORK_CHUNK_SIZE 4096
+
 struct Value;
 
+/**
+ * Intermediate buffers of chunked evaluation. Every thread evaluates many chunks of the same
+ * size, so buffers freed by one node can be reused by the next node and by the next chunk.
+ */
+class MFNetworkEvaluationScratch : NonCopyable, NonMovable {
+ private:
+  LinearAllocator<> allocator_;
+  Vector<std::pair<uint, void *>> free_buffers_;
+
+ public:
+  /** Indices of the current chunk, when the mask is not a range. */
+  Vector<uint> chunk_indices;
+
+  void *allocate(uint size, uint alignment)
+  {
+    for (uint i : free_buffers_.index_range()) {
+      const std::pair<uint, void *> &item = free_buffers_[i];
+      if (item.first == size && ((uintptr_t)item.second & (alignment - 1)) == 0) {
+        void *buffer = item.second;
+        free_buffers_.remove_and_reorder(i);
+        return buffer;
+      }
+    }
+    return allocator_.allocate(size, alignment);
+  }
+
+  void deallocate(void *buffer, uint size)
+  {
+    free_buffers_.append({size, buffer});
+  }
+};
+
 /**
  * This keeps track of all the values that flow through the multi-function network. Therefore it
  * maintains a mapping between output sockets and their corresponding values. Every `value`
@@ -56,9 +95,13 @@ class MFNetworkEvaluationStorage {
   IndexMask mask_;
   Array<Value *> value_per_output_id_;
   uint min_array_size_;
+  /** Buffers are allocated from here when not null, instead of the guarded allocator. */
+  MFNetworkEvaluationScratch *scratch_;
 
  public:
-  MFNetworkEvaluationStorage(IndexMask mask, uint socket_id_amount);
+  MFNetworkEvaluationStorage(IndexMask mask,
+                             uint socket_id_amount,
+                             MFNetworkEvaluationScratch *scratch);
   ~MFNetworkEvaluationStorage();
 
   /* Add the values that have been provided by the caller of the multi-function network. */
@@ -97,11 +140,15 @@ class MFNetworkEvaluationStorage {
   bool socket_is_computed(const MFOutputSocket &socket);
   bool is_same_value_for_every_index(const MFOutputSocket &socket);
   bool socket_has_buffer_for_output(const MFOutputSocket &socket);
+
+ private:
+  void *allocate_full_buffer(const CPPType &type);
+  void free_full_buffer(GMutableSpan span);
 };
 
 MFNetworkEvaluator::MFNetworkEvaluator(Vector<const MFOutputSocket *> inputs,
                                        Vector<const MFInputSocket *> outputs)
-    : inputs_(std::move(inputs)), outputs_(std::move(outputs))
+    : inputs_(std::move(inputs)), outputs_(std::move(outputs)), allow_chunked_evaluation_(true)
 {
   BLI_assert(outputs_.size() > 0);
   MFSignatureBuilder signature = this->get_builder("Function Tree");
@@ -116,6 +163,7 @@ MFNetworkEvaluator::MFNetworkEvaluator(Vector<const MFOutputSocket *> inputs,
         break;
       case MFDataType::Vector:
         signature.vector_input(socket->name(), type.vector_base_type());
+        allow_chunked_evaluation_ = false;
         break;
     }
   }
@@ -130,6 +178,7 @@ MFNetworkEvaluator::MFNetworkEvaluator(Vector<const MFOutputSocket *> inputs,
         break;
       case MFDataType::Vector:
         signature.vector_output(socket->name(), type.vector_base_type());
+        allow_chunked_evaluation_ = false;
         break;
     }
   }
@@ -141,8 +190,124 @@ void MFNetworkEvaluator::call(IndexMask mask, MFParams params, MFContext context
     return;
   }
 
+  if (allow_chunked_evaluation_ && mask.size() >= MF_NETWORK_CHUNK_SIZE * 2) {
+    this->call_chunked(mask, params, context);
+  }
+  else {
+    this->evaluate(mask, params, context, nullptr);
+  }
+}
+
+struct ChunkedEvaluationData {
+  const MFNetworkEvaluator *evaluator;
+  IndexMask mask;
+  MFParams *params;
+  MFContext *context;
+};
+
+struct ChunkedEvaluationTLS {
+  /* Created on first use, the task system copies this struct for every task. */
+  MFNetworkEvaluationScratch *scratch;
+};
+
+static void chunked_evaluation_free_cb(const void *__restrict UNUSED(userdata),
+                                       void *__restrict chunk)
+{
+  ChunkedEvaluationTLS *tls_data = (ChunkedEvaluationTLS *)chunk;
+  delete tls_data->scratch;
+}
+
+BLI_NOINLINE void MFNetworkEvaluator::call_chunked(IndexMask mask,
+                                                   MFParams params,
+                                                   MFContext context) const
+{
+  ChunkedEvaluationData data = {this, mask, &params, &context};
+  ChunkedEvaluationTLS tls_data = {nullptr};
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  settings.userdata_chunk = &tls_data;
+  settings.userdata_chunk_size = sizeof(tls_data);
+  settings.func_free = chunked_evaluation_free_cb;
+
+  const uint chunks_num = (mask.size() + MF_NETWORK_CHUNK_SIZE - 1) / MF_NETWORK_CHUNK_SIZE;
+  BLI_task_parallel_range(0, (int)chunks_num, &data, call_chunk_cb, &settings);
+}
+
+void MFNetworkEvaluator::call_chunk_cb(void *__restrict userdata,
+                                       const int chunk_index,
+                                       const TaskParallelTLS *__restrict tls)
+{
+  const ChunkedEvaluationData *data = (const ChunkedEvaluationData *)userdata;
+  ChunkedEvaluationTLS *tls_data = (ChunkedEvaluationTLS *)tls->userdata_chunk;
+  if (tls_data->scratch == nullptr) {
+    tls_data->scratch = new MFNetworkEvaluationScratch();
+  }
+  data->evaluator->call_chunk(
+      (uint)chunk_index, data->mask, *data->params, *data->context, *tls_data->scratch);
+}
+
+/**
+ * Evaluate the network for a part of the mask. All parameters are offset so that the chunk
+ * starts at index zero, this keeps the intermediate buffers as small as the chunk.
+ */
+void MFNetworkEvaluator::call_chunk(uint chunk_index,
+                                    IndexMask mask,
+                                    MFParams params,
+                                    MFContext context,
+                                    MFNetworkEvaluationScratch &scratch) const
+{
+  const uint start = chunk_index * MF_NETWORK_CHUNK_SIZE;
+  const uint size = std::min<uint>(MF_NETWORK_CHUNK_SIZE, mask.size() - start);
+  Span<uint> indices = mask.indices().slice(start, size);
+  const uint offset = indices.first();
+  const uint array_size = indices.last() - offset + 1;
+
+  IndexMask chunk_mask;
+  if (array_size == size) {
+    chunk_mask = IndexRange(size);
+  }
+  else {
+    scratch.chunk_indices.clear();
+    for (uint i : indices) {
+      scratch.chunk_indices.append(i - offset);
+    }
+    chunk_mask = scratch.chunk_indices.as_span();
+  }
+
+  MFParamsBuilder chunk_params{*this, array_size};
+  for (uint param_index : this->param_indices()) {
+    MFParamType param_type = this->param_type(param_index);
+    switch (param_type.category()) {
+      case MFParamType::SingleInput: {
+        GVSpan values = params.readonly_single_input(param_index);
+        chunk_params.add_readonly_single_input(values.slice(offset, array_size));
+        break;
+      }
+      case MFParamType::SingleOutput: {
+        GMutableSpan values = params.uninitialized_single_output(param_index);
+        chunk_params.add_uninitialized_single_output(values.slice(offset, array_size));
+        break;
+      }
+      default: {
+        /* Networks with other parameters are not split into chunks. */
+        BLI_assert(false);
+        break;
+      }
+    }
+  }
+
+  this->evaluate(chunk_mask, chunk_params, context, &scratch);
+}
+
+BLI_NOINLINE void MFNetworkEvaluator::evaluate(IndexMask mask,
+                                               MFParams params,
+                                               MFContext context,
+                                               MFNetworkEvaluationScratch *scratch) const
+{
   const MFNetwork &network = outputs_[0]->node().network();
-  Storage storage(mask, network.socket_id_amount());
+  Storage storage(mask, network.socket_id_amount(), scratch);
 
   Vector<const MFInputSocket *> outputs_to_initialize_in_the_end;
 
@@ -506,10 +671,13 @@ struct OwnVectorValue : public Value {
 /** \name Storage methods
  * \{ */
 
-MFNetworkEvaluationStorage::MFNetworkEvaluationStorage(IndexMask mask, uint socket_id_amount)
+MFNetworkEvaluationStorage::MFNetworkEvaluationStorage(IndexMask mask,
+                                                       uint socket_id_amount,
+                                                       MFNetworkEvaluationScratch *scratch)
     : mask_(mask),
       value_per_output_id_(socket_id_amount, nullptr),
-      min_array_size_(mask.min_array_size())
+      min_array_size_(mask.min_array_size()),
+      scratch_(scratch)
 {
 }
 
@@ -528,7 +696,7 @@ MFNetworkEvaluationStorage::~MFNetworkEvaluationStorage()
       }
       else {
         type.destruct_indices(span.buffer(), mask_);
-        MEM_freeN(span.buffer());
+        this->free_full_buffer(span);
       }
     }
     else if (any_value->type == ValueType::OwnVector) {
@@ -538,6 +706,24 @@ MFNetworkEvaluationStorage::~MFNetworkEvaluationStorage()
   }
 }
 
+void *MFNetworkEvaluationStorage::allocate_full_buffer(const CPPType &type)
+{
+  if (scratch_ != nullptr) {
+    return scratch_->allocate(min_array_size_ * type.size(), type.alignment());
+  }
+  return MEM_mallocN_aligned(min_array_size_ * type.size(), type.alignment(), AT);
+}
+
+void MFNetworkEvaluationStorage::free_full_buffer(GMutableSpan span)
+{
+  if (scratch_ != nullptr) {
+    scratch_->deallocate(span.buffer(), span.size() * span.type().size());
+  }
+  else {
+    MEM_freeN(span.buffer());
+  }
+}
+
 IndexMask MFNetworkEvaluationStorage::mask() const
 {
   return mask_;
@@ -638,7 +824,7 @@ void MFNetworkEvaluationStorage::finish_input_socket(const MFInputSocket &socket
         }
         else {
           type.destruct_indices(span.buffer(), mask_);
-          MEM_freeN(span.buffer());
+          this->free_full_buffer(span);
         }
         value_per_output_id_[origin.id()] = nullptr;
       }
@@ -702,7 +888,7 @@ GMutableSpan MFNetworkEvaluationStorage::get_single_output__full(const MFOutputS
   Value *any_value = value_per_output_id_[socket.id()];
   if (any_value == nullptr) {
     const CPPType &type = socket.data_type().single_type();
-    void *buffer = MEM_mallocN_aligned(min_array_size_ * type.size(), type.alignment(), AT);
+    void *buffer = this->allocate_full_buffer(type);
     GMutableSpan span(type, buffer, min_array_size_);
 
     auto *value = allocator_.construct<OwnSingleValue>(span, socket.targets().size(), false);
@@ -806,7 +992,7 @@ GMutableSpan MFNetworkEvaluationStorage::get_mutable_single__full(const MFInputS
   }
 
   GVSpan virtual_span = this->get_single_input__full(input);
-  void *new_buffer = MEM_mallocN_aligned(min_array_size_ * type.size(), type.alignment(), AT);
+  void *new_buffer = this->allocate_full_buffer(type);
   GMutableSpan new_array_ref(type, new_buffer, min_array_size_);
   virtual_span.materialize_to_uninitialized(mask_, new_array_ref.buffer());
 
@@ -89,6 +89,10 @@ void GPU_indexbuf_set_point_restart(GPUIndexBufBuilder *builder, uint elem);
 void GPU_indexbuf_set_line_restart(GPUIndexBufBuilder *builder, uint elem);
 void GPU_indexbuf_set_tri_restart(GPUIndexBufBuilder *builder, uint elem);
 
+/* Merge a copy of `builder_to` that was used to fill a part of the shared index data, for
+ * example from another thread. */
+void GPU_indexbuf_join(GPUIndexBufBuilder *builder_to, const GPUIndexBufBuilder *builder_from);
+
 GPUIndexBuf *GPU_indexbuf_build(GPUIndexBufBuilder *);
 void GPU_indexbuf_build_in_place(GPUIndexBufBuilder *, GPUIndexBuf *);
 
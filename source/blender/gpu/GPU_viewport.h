@@ -49,6 +49,7 @@ typedef struct ViewportMemoryPool {
   struct BLI_memblock *obmats;
   struct BLI_memblock *obinfos;
   struct BLI_memblock *cullstates;
+  struct BLI_memblock *cullchunks;
   struct BLI_memblock *shgroups;
   struct BLI_memblock *uniforms;
   struct BLI_memblock *views;
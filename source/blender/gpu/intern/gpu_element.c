@@ -239,6 +239,14 @@ void GPU_indexbuf_set_tri_restart(GPUIndexBufBuilder *builder, uint elem)
   }
 }
 
+void GPU_indexbuf_join(GPUIndexBufBuilder *builder_to, const GPUIndexBufBuilder *builder_from)
+{
+  BLI_assert(builder_to->data == builder_from->data);
+  if (builder_to->index_len < builder_from->index_len) {
+    builder_to->index_len = builder_from->index_len;
+  }
+}
+
 GPUIndexBuf *GPU_indexbuf_create_subrange(GPUIndexBuf *elem_src, uint start, uint length)
 {
   GPUIndexBuf *elem = MEM_callocN(sizeof(GPUIndexBuf), "GPUIndexBuf");
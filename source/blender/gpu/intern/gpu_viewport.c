@@ -999,6 +999,9 @@ void GPU_viewport_free(GPUViewport *viewport)
   if (viewport->vmempool.cullstates != NULL) {
     BLI_memblock_destroy(viewport->vmempool.cullstates, NULL);
   }
+  if (viewport->vmempool.cullchunks != NULL) {
+    BLI_memblock_destroy(viewport->vmempool.cullchunks, NULL);
+  }
   if (viewport->vmempool.shgroups != NULL) {
     BLI_memblock_destroy(viewport->vmempool.shgroups, NULL);
   }
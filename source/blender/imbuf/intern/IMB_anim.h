@@ -81,6 +81,15 @@
 
 #define MAXNUMSTREAMS 50
 
+/* Number of frames decoded while seeking which are kept for scrubbing backwards. Fewer frames
+ * are kept for large movies, so they use at most ANIM_DECODED_FRAMES_MEM_MAX bytes. */
+#define ANIM_DECODED_FRAMES_MAX 8
+#define ANIM_DECODED_FRAMES_MEM_MAX (128 * 1024 * 1024)
+
+/* Decoding threads per movie. Several movies are often decoded at the same time, and frame
+ * threading adds a frame of latency and memory per thread. */
+#define ANIM_DECODE_THREADS_MAX 4
+
 struct IDProperty;
 struct _AviMovie;
 struct anim_index;
@@ -137,6 +146,16 @@ struct anim {
   int64_t last_pts;
   int64_t next_pts;
   AVPacket next_packet;
+
+  /* Ring buffer of frames decoded on the way to a frame after seeking backwards. Each frame is
+   * shown for pts in range [pts, next_pts). Frames are removed once fetched, and all of them
+   * are freed as soon as a frame is fetched without seeking backwards. */
+  struct {
+    struct ImBuf *ibuf;
+    int64_t pts;
+    int64_t next_pts;
+  } decoded_frames[ANIM_DECODED_FRAMES_MAX];
+  int decoded_frames_next;
 #endif
 
   char index_dir[768];
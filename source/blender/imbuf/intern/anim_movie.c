@@ -55,6 +55,7 @@
 
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "MEM_guardedalloc.h"
@@ -573,6 +574,10 @@ static int startffmpeg(struct anim *anim)
 
   pCodecCtx->workaround_bugs = 1;
 
+  /* Decode using frame and slice threads, whichever the codec supports. */
+  pCodecCtx->thread_count = MIN2(BLI_system_thread_count(), ANIM_DECODE_THREADS_MAX);
+  pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
   if (avcodec_open2(pCodecCtx, pCodec, NULL) < 0) {
     avformat_close_input(&pFormatCtx);
     return -1;
@@ -640,6 +645,8 @@ static int startffmpeg(struct anim *anim)
   anim->last_pts = -1;
   anim->next_pts = -1;
   anim->next_packet.stream_index = -1;
+  memset(anim->decoded_frames, 0, sizeof(anim->decoded_frames));
+  anim->decoded_frames_next = 0;
 
   anim->pFrame = av_frame_alloc();
   anim->pFrameComplete = false;
@@ -876,6 +883,66 @@ static void ffmpeg_postprocess(struct anim *anim)
   }
 }
 
+/* Postprocess the image in anim->pFrame into a newly allocated buffer,
+ * leaving anim->last_frame untouched. */
+static ImBuf *ffmpeg_postprocess_new_ibuf(struct anim *anim)
+{
+  ImBuf *last_frame = anim->last_frame;
+  ImBuf *ibuf = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
+  ibuf->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
+
+  anim->last_frame = ibuf;
+  ffmpeg_postprocess(anim);
+  anim->last_frame = last_frame;
+
+  return ibuf;
+}
+
+static void ffmpeg_decoded_frames_add(struct anim *anim,
+                                      ImBuf *ibuf,
+                                      int64_t pts,
+                                      int64_t next_pts)
+{
+  int index = anim->decoded_frames_next;
+
+  IMB_freeImBuf(anim->decoded_frames[index].ibuf);
+  anim->decoded_frames[index].ibuf = ibuf;
+  anim->decoded_frames[index].pts = pts;
+  anim->decoded_frames[index].next_pts = next_pts;
+
+  anim->decoded_frames_next = (index + 1) % ANIM_DECODED_FRAMES_MAX;
+}
+
+/* Remove the frame shown at pts from the ring and return it. The caller caches fetched frames
+ * itself, so keeping them here as well would only hold the memory twice. */
+static ImBuf *ffmpeg_decoded_frames_take(struct anim *anim, int64_t pts)
+{
+  for (int i = 0; i < ANIM_DECODED_FRAMES_MAX; i++) {
+    ImBuf *ibuf = anim->decoded_frames[i].ibuf;
+    if (ibuf && anim->decoded_frames[i].pts <= pts && anim->decoded_frames[i].next_pts > pts) {
+      anim->decoded_frames[i].ibuf = NULL;
+      return ibuf;
+    }
+  }
+  return NULL;
+}
+
+static int ffmpeg_decoded_frames_keep_num(const struct anim *anim)
+{
+  const size_t frame_size = (size_t)anim->x * (size_t)anim->y * 4;
+  const size_t num = ANIM_DECODED_FRAMES_MEM_MAX / MAX2(frame_size, 1);
+  return (int)CLAMPIS(num, 1, ANIM_DECODED_FRAMES_MAX);
+}
+
+static void ffmpeg_decoded_frames_free(struct anim *anim)
+{
+  for (int i = 0; i < ANIM_DECODED_FRAMES_MAX; i++) {
+    IMB_freeImBuf(anim->decoded_frames[i].ibuf);
+    anim->decoded_frames[i].ibuf = NULL;
+  }
+  anim->decoded_frames_next = 0;
+}
+
 /* decode one video frame also considering the packet read into next_packet */
 
 static int ffmpeg_decode_video_frame(struct anim *anim)
@@ -968,10 +1035,15 @@ static int ffmpeg_decode_video_frame(struct anim *anim)
   return (rval >= 0);
 }
 
-static void ffmpeg_decode_video_frame_scan(struct anim *anim, int64_t pts_to_search)
+/* Decode frames until the one containing pts_to_search.
+ * Frames passed on the way with pts >= pts_keep_from are kept in anim->decoded_frames. */
+static void ffmpeg_decode_video_frame_scan(struct anim *anim,
+                                           int64_t pts_to_search,
+                                           int64_t pts_keep_from)
 {
   /* there seem to exist *very* silly GOP lengths out in the wild... */
   int count = 1000;
+  bool decoded = false;
 
   av_log(anim->pFormatCtx,
          AV_LOG_DEBUG,
@@ -985,9 +1057,22 @@ static void ffmpeg_decode_video_frame_scan(struct anim *anim, int64_t pts_to_sea
            "  WHILE: pts=%lld in search of %lld\n",
            (long long int)anim->next_pts,
            (long long int)pts_to_search);
+    /* Only frames decoded by this scan are valid, pFrame could be from before seeking. */
+    ImBuf *keep_ibuf = NULL;
+    int64_t keep_pts = anim->next_pts;
+    if (decoded && anim->next_pts >= pts_keep_from) {
+      keep_ibuf = ffmpeg_postprocess_new_ibuf(anim);
+    }
+
     if (!ffmpeg_decode_video_frame(anim)) {
+      IMB_freeImBuf(keep_ibuf);
       break;
     }
+    decoded = true;
+
+    if (keep_ibuf) {
+      ffmpeg_decoded_frames_add(anim, keep_ibuf, keep_pts, anim->next_pts);
+    }
     count--;
   }
   if (count == 0) {
@@ -1109,11 +1194,22 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
     return anim->last_frame;
   }
 
+  /* Frame was decoded while seeking to a later frame. The decoder stays where it is, so
+   * anim->curposition is not changed. */
+  ImBuf *decoded_frame = ffmpeg_decoded_frames_take(anim, pts_to_search);
+  if (decoded_frame) {
+    av_log(anim->pFormatCtx, AV_LOG_DEBUG, "FETCH: frame decoded while seeking\n");
+    return decoded_frame;
+  }
+
+  /* Not scrubbing backwards through the kept frames anymore, a backward seek fills them again. */
+  ffmpeg_decoded_frames_free(anim);
+
   if (position > anim->curposition + 1 && anim->preseek && !tc_index &&
       position - (anim->curposition + 1) < anim->preseek) {
     av_log(anim->pFormatCtx, AV_LOG_DEBUG, "FETCH: within preseek interval (no index)\n");
 
-    ffmpeg_decode_video_frame_scan(anim, pts_to_search);
+    ffmpeg_decode_video_frame_scan(anim, pts_to_search, INT64_MAX);
   }
   else if (tc_index && IMB_indexer_can_scan(tc_index, old_frame_index, new_frame_index)) {
     av_log(anim->pFormatCtx,
@@ -1121,7 +1217,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
            "FETCH: within preseek interval "
            "(index tells us)\n");
 
-    ffmpeg_decode_video_frame_scan(anim, pts_to_search);
+    ffmpeg_decode_video_frame_scan(anim, pts_to_search, INT64_MAX);
   }
   else if (position != anim->curposition + 1) {
     long long pos;
@@ -1193,7 +1289,14 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
     /* memset(anim->pFrame, ...) ?? */
 
     if (ret >= 0) {
-      ffmpeg_decode_video_frame_scan(anim, pts_to_search);
+      /* When going backwards, keep frames preceding the requested one, so scrubbing further back
+       * does not need to seek and decode from a key frame again. */
+      int64_t pts_keep_from = INT64_MAX;
+      if (position < anim->curposition) {
+        pts_keep_from = pts_to_search - (int64_t)(ffmpeg_decoded_frames_keep_num(anim) /
+                                                  (pts_time_base * frame_rate));
+      }
+      ffmpeg_decode_video_frame_scan(anim, pts_to_search, pts_keep_from);
     }
   }
   else if (position == 0 && anim->curposition == -1) {
@@ -1251,6 +1354,7 @@ static void free_anim_ffmpeg(struct anim *anim)
 
     sws_freeContext(anim->img_convert_ctx);
     IMB_freeImBuf(anim->last_frame);
+    ffmpeg_decoded_frames_free(anim);
     if (anim->next_packet.stream_index != -1) {
       av_free_packet(&anim->next_packet);
     }
@@ -1407,10 +1511,8 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
 #endif
 #ifdef WITH_FFMPEG
     case ANIM_FFMPEG:
+      /* Position is set internally, it is not changed for frames kept from seeking. */
       ibuf = ffmpeg_fetchibuf(anim, position, tc);
-      if (ibuf) {
-        anim->curposition = position;
-      }
       filter_y = 0; /* done internally */
       break;
 #endif
@@ -1420,7 +1522,7 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
     if (filter_y) {
       IMB_filtery(ibuf);
     }
-    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, anim->curposition + 1);
+    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, position + 1);
   }
   return (ibuf);
 }
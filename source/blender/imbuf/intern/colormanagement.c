@@ -1763,6 +1763,78 @@ static void display_buffer_apply_threaded(ImBuf *ibuf,
                                do_display_buffer_apply_thread);
 }
 
+/* Fast path for the most common display transform: scene linear float buffer displayed with a
+ * view which is plain sRGB. Pixels are converted with the built-in sRGB lookup table straight
+ * into the display byte buffer, without OCIO and without intermediate linear buffers. */
+static void *do_display_buffer_apply_linear_to_srgb_thread(void *handle_v)
+{
+  DisplayBufferThread *handle = (DisplayBufferThread *)handle_v;
+
+  IMB_buffer_byte_from_float(handle->display_buffer_byte,
+                             handle->buffer,
+                             handle->channels,
+                             handle->dither,
+                             IB_PROFILE_SRGB,
+                             IB_PROFILE_LINEAR_RGB,
+                             handle->predivide,
+                             handle->width,
+                             handle->tot_line,
+                             handle->width,
+                             handle->width);
+
+  return NULL;
+}
+
+static void display_buffer_apply_linear_to_srgb_threaded(ImBuf *ibuf,
+                                                         unsigned char *display_buffer_byte)
+{
+  DisplayBufferInitData init_data = {NULL};
+
+  init_data.ibuf = ibuf;
+  init_data.buffer = ibuf->rect_float;
+  init_data.display_buffer_byte = display_buffer_byte;
+
+  IMB_processor_apply_threaded(ibuf->y,
+                               sizeof(DisplayBufferThread),
+                               &init_data,
+                               display_buffer_init_handle,
+                               do_display_buffer_apply_linear_to_srgb_thread);
+}
+
+static bool is_display_transform_linear_to_srgb(
+    ImBuf *ibuf,
+    const ColorManagedViewSettings *view_settings,
+    const ColorManagedDisplaySettings *display_settings)
+{
+  if (ibuf->rect_float == NULL || (ibuf->colormanage_flag & IMB_COLORMANAGE_IS_DATA)) {
+    return false;
+  }
+  if (!ELEM(ibuf->channels, 3, 4)) {
+    return false;
+  }
+  if (ibuf->float_colorspace &&
+      !IMB_colormanagement_space_is_scene_linear(ibuf->float_colorspace)) {
+    return false;
+  }
+  if ((view_settings->flag & COLORMANAGE_VIEW_USE_CURVES) || view_settings->exposure != 0.0f ||
+      view_settings->gamma != 1.0f) {
+    return false;
+  }
+
+  ColorManagedLook *look_descr = colormanage_look_get_named(view_settings->look);
+  if (look_descr != NULL && !STREQ(look_descr->process_space, "")) {
+    return false;
+  }
+
+  const char *view_colorspace_name = IMB_colormanagement_get_display_colorspace_name(
+      view_settings, display_settings);
+  ColorSpace *view_colorspace = colormanage_colorspace_get_named(view_colorspace_name);
+
+  /* Built-in sRGB detection is relative to scene linear, so this also covers the scene linear
+   * role of the current configuration. */
+  return (view_colorspace && IMB_colormanagement_space_is_srgb(view_colorspace));
+}
+
 static bool is_ibuf_rect_in_display_space(ImBuf *ibuf,
                                           const ColorManagedViewSettings *view_settings,
                                           const ColorManagedDisplaySettings *display_settings)
@@ -1804,6 +1876,12 @@ static void colormanage_display_buffer_process_ex(
     skip_transform = is_ibuf_rect_in_display_space(ibuf, view_settings, display_settings);
   }
 
+  if (display_buffer == NULL &&
+      is_display_transform_linear_to_srgb(ibuf, view_settings, display_settings)) {
+    display_buffer_apply_linear_to_srgb_threaded(ibuf, display_buffer_byte);
+    return;
+  }
+
   if (skip_transform == false) {
     cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
   }
@@ -210,7 +210,7 @@ void IMB_buffer_byte_from_float(uchar *rect_to,
         if (dither && predivide) {
           for (x = 0; x < width; x++, from += 4, to += 4) {
             premul_to_straight_v4_v4(straight, from);
-            linearrgb_to_srgb_ushort4(us, from);
+            linearrgb_to_srgb_ushort4(us, straight);
             ushort_to_byte_dither_v4(to, us, di, (float)x * inv_width, t);
           }
         }
@@ -223,7 +223,7 @@ void IMB_buffer_byte_from_float(uchar *rect_to,
         else if (predivide) {
           for (x = 0; x < width; x++, from += 4, to += 4) {
             premul_to_straight_v4_v4(straight, from);
-            linearrgb_to_srgb_ushort4(us, from);
+            linearrgb_to_srgb_ushort4(us, straight);
             ushort_to_byte_v4(to, us);
           }
         }
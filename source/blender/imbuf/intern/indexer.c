@@ -29,6 +29,7 @@
 #include "BLI_ghash.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 #ifdef _WIN32
 #  include "BLI_winstuff.h"
@@ -780,6 +781,9 @@ static IndexBuildContext *index_ffmpeg_create_context(struct anim *anim,
 
   context->iCodecCtx->workaround_bugs = 1;
 
+  context->iCodecCtx->thread_count = MIN2(BLI_system_thread_count(), ANIM_DECODE_THREADS_MAX);
+  context->iCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
   if (avcodec_open2(context->iCodecCtx, context->iCodec, NULL) < 0) {
     avformat_close_input(&context->iFormatCtx);
     MEM_freeN(context);
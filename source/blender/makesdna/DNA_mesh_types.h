@@ -107,6 +107,9 @@ typedef struct Mesh_Runtime {
   /** Non-manifold boundary data for Shrinkwrap Target Project. */
   struct ShrinkwrapBoundaryData *shrinkwrap_data;
 
+  /** Compact copy of the vertex group weights for armature deform (`armature_deform.c`). */
+  struct ArmatureSkinTable *armature_skin_table;
+
   /** Set by modifier stack if only deformed from original. */
   char deformed_only;
   /**
@@ -138,7 +138,13 @@ typedef struct Object_Runtime {
 
   /** Selection id of this object; only available in the original object */
   int select_id;
-  char _pad1[3];
+  char _pad1[2];
+
+  /**
+   * The evaluated mesh only differs from the previous evaluation by its vertex positions, its
+   * draw cache is taken over from the previous one.
+   */
+  char is_data_eval_deform_update;
 
   /**
    * Denotes whether the evaluated data is owned by this object or is referenced and owned by
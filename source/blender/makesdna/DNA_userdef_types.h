@@ -623,8 +623,9 @@ typedef struct UserDef_Experimental {
   char use_new_hair_type;
   char use_cycles_debug;
   char use_sculpt_vertex_colors;
+  char use_undo_skip_unchanged;
   /** `makesdna` does not allow empty structs. */
-  char _pad[3];
+  char _pad[2];
 } UserDef_Experimental;
 
 #define USER_EXPERIMENTAL_TEST(userdef, member) \
@@ -1327,6 +1328,7 @@ typedef enum eUserpref_DiskCacheCompression {
   USER_SEQ_DISK_CACHE_COMPRESSION_NONE = 0,
   USER_SEQ_DISK_CACHE_COMPRESSION_LOW = 1,
   USER_SEQ_DISK_CACHE_COMPRESSION_HIGH = 2,
+  USER_SEQ_DISK_CACHE_COMPRESSION_FAST = 3,
 } eUserpref_DiskCacheCompression;
 
 /* Locale Ids. Auto will try to get local from OS. Our default is English though. */
@@ -1818,6 +1818,17 @@ static void rna_def_modifier_subsurf(BlenderRNA *brna)
       prop, "Use Creases", "Use mesh edge crease information to sharpen edges");
   RNA_def_property_update(prop, 0, "rna_Modifier_update");
 
+  prop = RNA_def_property(srna, "use_topology_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flags", eSubsurfModifierFlag_UseTopologyCache);
+  RNA_def_property_ui_text(prop,
+                           "Cache Topology",
+                           "Keep a full copy of the subdivided mesh in memory while the topology "
+                           "of the base mesh does not change, and only re-evaluate vertex "
+                           "positions and normals. Faster playback of deforming meshes, but uses "
+                           "more memory and animated attributes other than positions are not "
+                           "updated");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   RNA_define_lib_overridable(false);
 }
 
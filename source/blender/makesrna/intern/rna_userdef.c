@@ -5248,6 +5248,11 @@ static void rna_def_userdef_system(BlenderRNA *brna)
        0,
        "High",
        "Works on slower storage devices and uses most CPU resources"},
+      {USER_SEQ_DISK_CACHE_COMPRESSION_FAST,
+       "FAST",
+       0,
+       "Fast",
+       "Requires fast storage, decoding uses multiple threads and is fastest for playback"},
       {0, NULL, 0, NULL, NULL},
   };
 
@@ -6101,6 +6106,15 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
       "Undo Legacy",
       "Use legacy undo (slower than the new default one, but may be more stable in some cases)");
 
+  prop = RNA_def_property(srna, "use_undo_skip_unchanged", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_undo_skip_unchanged", 1);
+  RNA_def_property_ui_text(prop,
+                           "Undo Skip Unchanged",
+                           "Re-use the global undo data of data-blocks which were not tagged as "
+                           "changed since the previous step, instead of writing them again "
+                           "(faster in large scenes, but changes made without tagging the "
+                           "data-block are not undone)");
+
   prop = RNA_def_property(srna, "use_new_particle_system", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "use_new_particle_system", 1);
   RNA_def_property_ui_text(
@@ -166,6 +166,8 @@ static void subdiv_mesh_settings_init(SubdivToMeshSettings *settings,
   settings->resolution = (1 << level) + 1;
   settings->use_optimal_display = (smd->flags & eSubsurfModifierFlag_ControlEdges) &&
                                   !(ctx->flag & MOD_APPLY_TO_BASE_MESH);
+  settings->use_topology_cache = (smd->flags & eSubsurfModifierFlag_UseTopologyCache) &&
+                                 !(ctx->flag & MOD_APPLY_TO_BASE_MESH);
 }
 
 static Mesh *subdiv_as_mesh(SubsurfModifierData *smd,
@@ -416,6 +418,7 @@ static void advanced_panel_draw(const bContext *C, Panel *panel)
   uiItemR(layout, &ptr, "quality", 0, NULL, ICON_NONE);
   uiItemR(layout, &ptr, "uv_smooth", 0, NULL, ICON_NONE);
   uiItemR(layout, &ptr, "use_creases", 0, NULL, ICON_NONE);
+  uiItemR(layout, &ptr, "use_topology_cache", 0, NULL, ICON_NONE);
 }
 
 static void panelRegister(ARegionType *region_type)
@@ -281,20 +281,29 @@ int main(int argc,
 
   /* NOTE: Special exception for guarded allocator type switch:
    *       we need to perform switch from lock-free to fully
-   *       guarded allocator before any allocation happened.
+   *       guarded or thread caching allocator before any allocation happened.
    */
   {
     int i;
+    bool use_tcache_allocator = false;
     for (i = 0; i < argc; i++) {
       if (STR_ELEM(argv[i], "-d", "--debug", "--debug-memory", "--debug-all")) {
         printf("Switching to fully guarded memory allocator.\n");
         MEM_use_guarded_allocator();
+        use_tcache_allocator = false;
         break;
       }
+      else if (STREQ(argv[i], "--thread-cached-allocator")) {
+        use_tcache_allocator = true;
+      }
       else if (STREQ(argv[i], "--")) {
         break;
       }
     }
+    if (use_tcache_allocator) {
+      printf("Switching to thread caching memory allocator.\n");
+      MEM_use_tcache_allocator();
+    }
   }
 
 #ifdef BUILD_DATE
@@ -41,10 +41,12 @@
 #  include "BLI_string_utf8.h"
 #  include "BLI_system.h"
 #  include "BLI_threads.h"
+#  include "BLI_trace.h"
 #  include "BLI_utildefines.h"
 
 #  include "BLO_readfile.h" /* only for BLO_has_bfile_extension */
 
+#  include "BKE_blender.h"
 #  include "BKE_blender_version.h"
 #  include "BKE_context.h"
 
@@ -611,6 +613,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
 
   printf("\n");
   BLI_argsPrintArgDoc(ba, "--debug-fpe");
+  BLI_argsPrintArgDoc(ba, "--debug-trace");
   BLI_argsPrintArgDoc(ba, "--disable-crash-handler");
   BLI_argsPrintArgDoc(ba, "--disable-abort-handler");
 
@@ -619,6 +622,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_argsPrintArgDoc(ba, "--app-template");
   BLI_argsPrintArgDoc(ba, "--factory-startup");
   BLI_argsPrintArgDoc(ba, "--enable-event-simulate");
+  BLI_argsPrintArgDoc(ba, "--thread-cached-allocator");
   printf("\n");
   BLI_argsPrintArgDoc(ba, "--env-system-datafiles");
   BLI_argsPrintArgDoc(ba, "--env-system-scripts");
@@ -1091,6 +1095,31 @@ static int arg_handle_debug_fpe_set(int UNUSED(argc),
   return 0;
 }
 
+static void arg_handle_debug_trace_exit(void *UNUSED(user_data))
+{
+  BLI_trace_end();
+}
+
+static const char arg_handle_debug_trace_set_doc[] =
+    "<filename>\n"
+    "\tRecord a timeline of depsgraph evaluation, modifiers, drawing, file I/O and task pools\n"
+    "\tand write it to <filename> on exit, in Chrome trace JSON format.";
+static int arg_handle_debug_trace_set(int argc, const char **argv, void *UNUSED(data))
+{
+  const char *arg_id = "--debug-trace";
+  if (argc > 1) {
+    if (!BLI_trace_is_enabled()) {
+      BKE_blender_atexit_register(arg_handle_debug_trace_exit, NULL);
+    }
+    BLI_trace_begin(argv[1]);
+    return 1;
+  }
+  else {
+    printf("\nError: '%s' no args given.\n", arg_id);
+    return 0;
+  }
+}
+
 static const char arg_handle_app_template_doc[] =
     "<template>\n"
     "\tSet the application template (matching the directory name), use 'default' for none.";
@@ -1130,6 +1159,18 @@ static int arg_handle_enable_event_simulate(int UNUSED(argc),
   return 0;
 }
 
+static const char arg_handle_thread_cached_allocator_set_doc[] =
+    "\n\t"
+    "Use a memory allocator which caches small blocks per thread,\n"
+    "\tthis can be faster when many threads allocate memory at the same time.";
+static int arg_handle_thread_cached_allocator_set(int UNUSED(argc),
+                                                  const char **UNUSED(argv),
+                                                  void *UNUSED(data))
+{
+  /* Handled in 'main' since the allocator must be switched before any allocation happened. */
+  return 0;
+}
+
 static const char arg_handle_env_system_set_doc_datafiles[] =
     "\n\t"
     "Set the " STRINGIFY_ARG(BLENDER_SYSTEM_DATAFILES) " environment variable.";
@@ -2125,6 +2166,7 @@ void main_args_setup(bContext *C, bArgs *ba)
   BLI_argsAdd(ba, 1, NULL, "--debug-io", CB(arg_handle_debug_mode_io), NULL);
 
   BLI_argsAdd(ba, 1, NULL, "--debug-fpe", CB(arg_handle_debug_fpe_set), NULL);
+  BLI_argsAdd(ba, 1, NULL, "--debug-trace", CB(arg_handle_debug_trace_set), NULL);
 
 #  ifdef WITH_LIBMV
   BLI_argsAdd(ba, 1, NULL, "--debug-libmv", CB(arg_handle_debug_mode_libmv), NULL);
@@ -2213,6 +2255,8 @@ void main_args_setup(bContext *C, bArgs *ba)
   BLI_argsAdd(ba, 1, NULL, "--app-template", CB(arg_handle_app_template), NULL);
   BLI_argsAdd(ba, 1, NULL, "--factory-startup", CB(arg_handle_factory_startup_set), NULL);
   BLI_argsAdd(ba, 1, NULL, "--enable-event-simulate", CB(arg_handle_enable_event_simulate), NULL);
+  BLI_argsAdd(
+      ba, 1, NULL, "--thread-cached-allocator", CB(arg_handle_thread_cached_allocator_set), NULL);
 
   /* TODO, add user env vars? */
   BLI_argsAdd(
@@ -714,6 +714,12 @@ TEST(array_store, TestData_Stride32_Chunk64_Mutate8)
   random_data_mutate_helper(0, 256, 200, 32, 64, 7117, 8);
 }
 
+/* Large enough for the hashing to be split into blocks. */
+TEST(array_store, TestData_Stride4_Chunk256_Mutate8_Large)
+{
+  random_data_mutate_helper(200000, 262144, 6, 4, 256, 2442, 8);
+}
+
 /* -------------------------------------------------------------------- */
 /* Randomized Chunks Test */
 
@@ -803,6 +809,12 @@ TEST(array_store, TestChunk_Rand31_Stride11_Chunk21)
   random_chunk_mutate_helper(31, 100, 11, 21, 7117);
 }
 
+/* Large enough for the hashing to be split into blocks. */
+TEST(array_store, TestChunk_Rand1024_Stride12_Chunk256_Large)
+{
+  random_chunk_mutate_helper(1024, 4, 12, 256, 4224);
+}
+
 #if 0
 /* -------------------------------------------------------------------- */
 
@@ -348,6 +348,99 @@ TEST(ghash, IntRandMurmur2a50000000)
 }
 #endif
 
+/* Int: random keys, removed and inserted again, with lookups of missing keys. */
+
+static void randint_churn_ghash_tests(GHash *ghash, const char *id, const unsigned int nbr)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  unsigned int *data = (unsigned int *)MEM_mallocN(sizeof(*data) * (size_t)nbr * 2, __func__);
+  unsigned int *dt;
+  unsigned int i;
+
+  {
+    /* Second half of the keys is never inserted, only looked up. */
+    RNG *rng = BLI_rng_new(1);
+    for (i = nbr * 2, dt = data; i--; dt++) {
+      *dt = BLI_rng_get_uint(rng) | 1;
+    }
+    BLI_rng_free(rng);
+  }
+
+  for (i = nbr, dt = data; i--; dt++) {
+    BLI_ghash_insert(ghash, POINTER_FROM_UINT(*dt), POINTER_FROM_UINT(*dt));
+  }
+
+  {
+    TIMEIT_START(int_churn);
+
+    /* Remove and insert every key in a sliding window, leaving removed slots behind. */
+    const unsigned int window = MAX2(nbr / 16, 1u);
+    for (unsigned int pass = 0; pass < 16; pass++) {
+      for (i = 0; i < nbr; i += window) {
+        const unsigned int end = MIN2(i + window, nbr);
+        for (unsigned int j = i; j < end; j++) {
+          BLI_ghash_remove(ghash, POINTER_FROM_UINT(data[j]), NULL, NULL);
+        }
+        for (unsigned int j = i; j < end; j++) {
+          BLI_ghash_insert(ghash, POINTER_FROM_UINT(data[j]), POINTER_FROM_UINT(data[j]));
+        }
+      }
+    }
+
+    TIMEIT_END(int_churn);
+  }
+
+  PRINTF_GHASH_STATS(ghash);
+
+  {
+    TIMEIT_START(int_lookup_hit);
+
+    for (i = nbr, dt = data; i--; dt++) {
+      void *v = BLI_ghash_lookup(ghash, POINTER_FROM_UINT(*dt));
+      EXPECT_EQ(POINTER_AS_UINT(v), *dt);
+    }
+
+    TIMEIT_END(int_lookup_hit);
+  }
+
+  {
+    TIMEIT_START(int_lookup_miss);
+
+    unsigned int found = 0;
+    for (i = nbr, dt = data + nbr; i--; dt++) {
+      found += BLI_ghash_haskey(ghash, POINTER_FROM_UINT(*dt));
+    }
+    /* Random keys may collide with inserted ones, but hardly ever. */
+    EXPECT_LT(found, nbr / 1000 + 1);
+
+    TIMEIT_END(int_lookup_miss);
+  }
+
+  EXPECT_EQ(BLI_ghash_len(ghash), nbr);
+
+  BLI_ghash_free(ghash, NULL, NULL);
+  MEM_freeN(data);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ghash, IntRandChurnGHash12000)
+{
+  GHash *ghash = BLI_ghash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+  randint_churn_ghash_tests(ghash, "RandIntChurnGHash - GHash - 12000", 12000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ghash, IntRandChurnGHash10000000)
+{
+  GHash *ghash = BLI_ghash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+  randint_churn_ghash_tests(ghash, "RandIntChurnGHash - GHash - 10000000", 10000000);
+}
+#endif
+
 static unsigned int ghashutil_tests_nohash_p(const void *p)
 {
   return POINTER_AS_UINT(p);
@@ -136,3 +136,73 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/* Batch queries must give the same results as running the queries one by one.
+ * Returns the number of rays which hit a node. */
+static int batch_queries_test(int points_len, int queries_len, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.01f, 8, 8);
+
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance(tree);
+
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+  float(*dir)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+  BVHTreeNearest *nearest = (BVHTreeNearest *)MEM_mallocN(sizeof(*nearest) * queries_len,
+                                                          __func__);
+  BVHTreeRayHit *hit = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hit) * queries_len, __func__);
+  for (int i = 0; i < queries_len; i++) {
+    rng_v3_round(co[i], 3, rng, 1000, 1.5f);
+    BLI_rng_get_float_unit_v3(rng, dir[i]);
+    nearest[i].index = -1;
+    nearest[i].dist_sq = FLT_MAX;
+    hit[i].index = -1;
+    hit[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+
+  BLI_bvhtree_find_nearest_batch(tree, co, nearest, queries_len, NULL, NULL, 0);
+  BLI_bvhtree_ray_cast_batch(
+      tree, co, dir, 0.0f, hit, queries_len, NULL, NULL, BVH_RAYCAST_DEFAULT);
+
+  int hits_num = 0;
+  for (int i = 0; i < queries_len; i++) {
+    BVHTreeNearest nearest_single = {0};
+    nearest_single.index = -1;
+    nearest_single.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, co[i], &nearest_single, NULL, NULL);
+    EXPECT_EQ(nearest[i].index, nearest_single.index);
+    EXPECT_EQ(nearest[i].dist_sq, nearest_single.dist_sq);
+
+    BVHTreeRayHit hit_single = {0};
+    hit_single.index = -1;
+    hit_single.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hit_single, NULL, NULL);
+    EXPECT_EQ(hit[i].index, hit_single.index);
+    EXPECT_EQ(hit[i].dist, hit_single.dist);
+    hits_num += (hit[i].index != -1);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+  MEM_freeN(nearest);
+  MEM_freeN(hit);
+
+  return hits_num;
+}
+
+TEST(kdopbvh, BatchQueries_10)
+{
+  batch_queries_test(500, 10, 12);
+}
+TEST(kdopbvh, BatchQueries_10000)
+{
+  EXPECT_GT(batch_queries_test(5000, 10000, 123), 0);
+}
@@ -0,0 +1,146 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+}
+
+#define NUM_RUN_AVERAGED 10
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static float (*kdtree_random_coords(int coords_len, uint seed))[3]
+{
+  float(*coords)[3] = (float(*)[3])MEM_malloc_arrayN(coords_len, sizeof(*coords), __func__);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < coords_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, coords[i]);
+    mul_v3_fl(coords[i], BLI_rng_get_float(rng));
+  }
+  BLI_rng_free(rng);
+  return coords;
+}
+
+static KDTree_3d *kdtree_build(const float (*coords)[3], int coords_len)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(coords_len);
+  for (int i = 0; i < coords_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, coords[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+static bool kdtree_range_count_cb(void *user_data,
+                                  int search_index,
+                                  int UNUSED(index),
+                                  const float UNUSED(co[3]),
+                                  float UNUSED(dist_sq))
+{
+  int *counts = (int *)user_data;
+  counts[search_index]++;
+  return true;
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+static void kdtree_performance_test(const char *id, const int tree_len, const int query_len)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  BLI_threadapi_init();
+
+  float(*tree_coords)[3] = kdtree_random_coords(tree_len, 1);
+  float(*query_coords)[3] = kdtree_random_coords(query_len, 2);
+
+  double time_balance = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    KDTree_3d *tree = BLI_kdtree_3d_new(tree_len);
+    for (int j = 0; j < tree_len; j++) {
+      BLI_kdtree_3d_insert(tree, j, tree_coords[j]);
+    }
+    const double init_time = PIL_check_seconds_timer();
+    BLI_kdtree_3d_balance(tree);
+    time_balance += PIL_check_seconds_timer() - init_time;
+    BLI_kdtree_3d_free(tree);
+  }
+  printf("\tBalance: done in %fs on average over %d runs\n",
+         time_balance / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED);
+
+  KDTree_3d *tree = kdtree_build(tree_coords, tree_len);
+
+  KDTreeNearest_3d *nearest = (KDTreeNearest_3d *)MEM_malloc_arrayN(
+      query_len, sizeof(*nearest), __func__);
+  KDTreeNearest_3d *nearest_batch = (KDTreeNearest_3d *)MEM_malloc_arrayN(
+      query_len, sizeof(*nearest_batch), __func__);
+
+  double init_time = PIL_check_seconds_timer();
+  for (int i = 0; i < query_len; i++) {
+    BLI_kdtree_3d_find_nearest(tree, query_coords[i], &nearest[i]);
+  }
+  printf("\tFind nearest: done in %fs\n", PIL_check_seconds_timer() - init_time);
+
+  init_time = PIL_check_seconds_timer();
+  BLI_kdtree_3d_find_nearest_batch(tree, query_coords, query_len, nearest_batch);
+  printf("\tFind nearest batch: done in %fs\n", PIL_check_seconds_timer() - init_time);
+
+  for (int i = 0; i < query_len; i++) {
+    EXPECT_EQ(nearest[i].index, nearest_batch[i].index);
+    EXPECT_EQ(nearest[i].dist, nearest_batch[i].dist);
+  }
+
+  const float range = 0.01f;
+  int *counts = (int *)MEM_calloc_arrayN(query_len, sizeof(*counts), __func__);
+  int *counts_batch = (int *)MEM_calloc_arrayN(query_len, sizeof(*counts_batch), __func__);
+
+  init_time = PIL_check_seconds_timer();
+  for (int i = 0; i < query_len; i++) {
+    KDTreeNearest_3d *range_nearest = NULL;
+    counts[i] = BLI_kdtree_3d_range_search(tree, query_coords[i], &range_nearest, range);
+    MEM_SAFE_FREE(range_nearest);
+  }
+  printf("\tRange search: done in %fs\n", PIL_check_seconds_timer() - init_time);
+
+  init_time = PIL_check_seconds_timer();
+  BLI_kdtree_3d_range_search_batch_cb(
+      tree, query_coords, query_len, range, kdtree_range_count_cb, counts_batch);
+  printf("\tRange search batch: done in %fs\n", PIL_check_seconds_timer() - init_time);
+
+  for (int i = 0; i < query_len; i++) {
+    EXPECT_EQ(counts[i], counts_batch[i]);
+  }
+
+  MEM_freeN(counts);
+  MEM_freeN(counts_batch);
+  MEM_freeN(nearest);
+  MEM_freeN(nearest_batch);
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(tree_coords);
+  MEM_freeN(query_coords);
+
+  BLI_threadapi_exit();
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdtree, Query10k)
+{
+  kdtree_performance_test("KDTree - 10000 points, 10000 queries", 10000, 10000);
+}
+
+TEST(kdtree, Query1M)
+{
+  kdtree_performance_test("KDTree - 1000000 points, 10000 queries", 1000000, 10000);
+}
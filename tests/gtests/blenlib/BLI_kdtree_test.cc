@@ -0,0 +1,154 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+}
+
+using Coord = std::array<float, 3>;
+
+/* Sizes below and above the thresholds for balancing and querying in parallel. */
+#define TREE_LEN_SMALL 1000
+#define TREE_LEN_LARGE 50000
+#define QUERY_LEN_SMALL 100
+#define QUERY_LEN_LARGE 2000
+
+static std::vector<Coord> kdtree_random_coords(int coords_len, uint seed)
+{
+  std::vector<Coord> coords(coords_len);
+  RNG *rng = BLI_rng_new(seed);
+  for (Coord &co : coords) {
+    BLI_rng_get_float_unit_v3(rng, co.data());
+    mul_v3_fl(co.data(), BLI_rng_get_float(rng));
+  }
+  BLI_rng_free(rng);
+  return coords;
+}
+
+static int brute_force_nearest(const std::vector<Coord> &tree_coords, const float co[3])
+{
+  int index = -1;
+  float dist_sq_min = FLT_MAX;
+  for (int i = 0; i < (int)tree_coords.size(); i++) {
+    const float dist_sq = len_squared_v3v3(tree_coords[i].data(), co);
+    if (dist_sq < dist_sq_min) {
+      dist_sq_min = dist_sq;
+      index = i;
+    }
+  }
+  return index;
+}
+
+static std::vector<int> brute_force_range(const std::vector<Coord> &tree_coords,
+                                          const float co[3],
+                                          const float range)
+{
+  std::vector<int> indices;
+  for (int i = 0; i < (int)tree_coords.size(); i++) {
+    if (len_squared_v3v3(tree_coords[i].data(), co) <= range * range) {
+      indices.push_back(i);
+    }
+  }
+  return indices;
+}
+
+static bool kdtree_range_collect_cb(void *user_data,
+                                    int search_index,
+                                    int index,
+                                    const float UNUSED(co[3]),
+                                    float UNUSED(dist_sq))
+{
+  std::vector<std::vector<int>> *indices = (std::vector<std::vector<int>> *)user_data;
+  (*indices)[search_index].push_back(index);
+  return true;
+}
+
+static void kdtree_brute_force_test(const int tree_len, const int query_len)
+{
+  BLI_threadapi_init();
+
+  const std::vector<Coord> tree_coords = kdtree_random_coords(tree_len, 1);
+  const std::vector<Coord> query_coords = kdtree_random_coords(query_len, 2);
+
+  KDTree_3d *tree = BLI_kdtree_3d_new(tree_len);
+  for (int i = 0; i < tree_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, tree_coords[i].data());
+  }
+  BLI_kdtree_3d_balance(tree);
+
+  /* Nearest. */
+  std::vector<KDTreeNearest_3d> nearest_batch(query_len);
+  BLI_kdtree_3d_find_nearest_batch(
+      tree, (const float(*)[3])query_coords.data(), query_len, nearest_batch.data());
+  for (int i = 0; i < query_len; i++) {
+    const float *co = query_coords[i].data();
+    const int index = brute_force_nearest(tree_coords, co);
+
+    KDTreeNearest_3d nearest;
+    EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, co, &nearest), index);
+    EXPECT_EQ(nearest.index, index);
+    EXPECT_EQ(nearest_batch[i].index, index);
+    EXPECT_FLOAT_EQ(nearest_batch[i].dist, len_v3v3(tree_coords[index].data(), co));
+  }
+
+  /* Range. */
+  const float range = 0.05f;
+  std::vector<std::vector<int>> range_batch(query_len);
+  BLI_kdtree_3d_range_search_batch_cb(tree,
+                                      (const float(*)[3])query_coords.data(),
+                                      query_len,
+                                      range,
+                                      kdtree_range_collect_cb,
+                                      &range_batch);
+  for (int i = 0; i < query_len; i++) {
+    const float *co = query_coords[i].data();
+    const std::vector<int> expected = brute_force_range(tree_coords, co, range);
+
+    KDTreeNearest_3d *range_nearest = NULL;
+    const int found_len = BLI_kdtree_3d_range_search(tree, co, &range_nearest, range);
+    std::vector<int> found;
+    for (int j = 0; j < found_len; j++) {
+      found.push_back(range_nearest[j].index);
+    }
+    MEM_SAFE_FREE(range_nearest);
+    std::sort(found.begin(), found.end());
+    EXPECT_EQ(found, expected);
+
+    std::sort(range_batch[i].begin(), range_batch[i].end());
+    EXPECT_EQ(range_batch[i], expected);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  BLI_threadapi_exit();
+}
+
+TEST(kdtree, BruteForceSmall)
+{
+  kdtree_brute_force_test(TREE_LEN_SMALL, QUERY_LEN_SMALL);
+}
+
+TEST(kdtree, BruteForceSmallTreeManyQueries)
+{
+  kdtree_brute_force_test(TREE_LEN_SMALL, QUERY_LEN_LARGE);
+}
+
+TEST(kdtree, BruteForceLarge)
+{
+  kdtree_brute_force_test(TREE_LEN_LARGE, QUERY_LEN_SMALL);
+}
+
+TEST(kdtree, BruteForceLargeTreeManyQueries)
+{
+  kdtree_brute_force_test(TREE_LEN_LARGE, QUERY_LEN_LARGE);
+}
@@ -0,0 +1,67 @@
+/* Apache License, Version 2.0 */
+
+#include "BLI_sharded_edge_set.hh"
+#include "BLI_strict_flags.h"
+
+#include "testing/testing.h"
+
+namespace blender {
+
+TEST(ordered_edge, Order)
+{
+  OrderedEdge a(3, 1);
+  EXPECT_EQ(a.v_low, 1u);
+  EXPECT_EQ(a.v_high, 3u);
+  EXPECT_EQ(a, OrderedEdge(1, 3));
+  EXPECT_EQ(a.hash(), OrderedEdge(1, 3).hash());
+}
+
+static void fill_edge_set(ShardedEdgeSet &edge_set, const uint verts_num)
+{
+  /* Add every edge of a closed loop twice, once in each direction. */
+  for (uint shard_index = 0; shard_index < edge_set.shards_num(); shard_index++) {
+    for (uint i = 0; i < verts_num * 2; i++) {
+      const OrderedEdge edge = (i < verts_num) ? OrderedEdge(i, (i + 1) % verts_num) :
+                                                 OrderedEdge((i + 1) % verts_num, i % verts_num);
+      if (edge_set.shard_index(edge) == shard_index) {
+        edge_set.shard(shard_index).add(edge);
+      }
+    }
+  }
+  edge_set.update_offsets();
+}
+
+TEST(sharded_edge_set, SingleShard)
+{
+  ShardedEdgeSet edge_set(1);
+  fill_edge_set(edge_set, 10);
+  EXPECT_EQ(edge_set.size(), 10u);
+  /* A single shard keeps the insertion order. */
+  for (uint i = 0; i < 10; i++) {
+    EXPECT_EQ(edge_set.index_of(OrderedEdge(i, (i + 1) % 10)), i);
+  }
+}
+
+TEST(sharded_edge_set, MultipleShards)
+{
+  ShardedEdgeSet edge_set(16);
+  fill_edge_set(edge_set, 1000);
+  EXPECT_EQ(edge_set.size(), 1000u);
+
+  uint shards_used = 0;
+  for (uint shard_index = 0; shard_index < edge_set.shards_num(); shard_index++) {
+    shards_used += edge_set.shard(shard_index).size() > 0;
+  }
+  EXPECT_GT(shards_used, 1u);
+
+  /* Every edge has a unique index. */
+  Array<bool> used(1000, false);
+  for (uint i = 0; i < 1000; i++) {
+    const uint index = edge_set.index_of(OrderedEdge((i + 1) % 1000, i));
+    EXPECT_LT(index, 1000u);
+    EXPECT_FALSE(used[index]);
+    used[index] = true;
+  }
+}
+
+}  // namespace blender
@@ -0,0 +1,117 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <climits>
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_rand.h"
+#include "BLI_sort.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Run the longest tests! */
+//#define SORT_RUN_BIG
+
+struct SortElem {
+  float key;
+  uint index;
+};
+
+static int sort_elem_cmp(const void *a, const void *b, void *UNUSED(thunk))
+{
+  const SortElem *x = (const SortElem *)a, *y = (const SortElem *)b;
+  return (x->key > y->key) - (x->key < y->key);
+}
+
+static void sort_tests(const uint len, const char *id)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  RNG *rng = BLI_rng_new(0);
+  uint *keys_init = (uint *)MEM_mallocN(sizeof(uint) * len, __func__);
+  for (uint i = 0; i < len; i++) {
+    keys_init[i] = BLI_rng_get_uint(rng);
+  }
+  BLI_rng_free(rng);
+
+  uint *keys = (uint *)MEM_mallocN(sizeof(uint) * len, __func__);
+  uint *values = (uint *)MEM_mallocN(sizeof(uint) * len, __func__);
+  SortElem *elems = (SortElem *)MEM_mallocN(sizeof(SortElem) * len, __func__);
+
+  {
+    memcpy(keys, keys_init, sizeof(uint) * len);
+    for (uint i = 0; i < len; i++) {
+      values[i] = i;
+    }
+    TIMEIT_START(radix_sort_uint);
+    BLI_radix_sort_uint(keys, values, len);
+    TIMEIT_END(radix_sort_uint);
+  }
+
+  {
+    float *keys_float = (float *)keys;
+    for (uint i = 0; i < len; i++) {
+      keys_float[i] = (float)keys_init[i] / (float)UINT_MAX - 0.5f;
+      values[i] = i;
+    }
+    TIMEIT_START(radix_sort_float);
+    BLI_radix_sort_float(keys_float, values, len);
+    TIMEIT_END(radix_sort_float);
+  }
+
+  for (uint i = 0; i < len; i++) {
+    elems[i].key = (float)keys_init[i];
+    elems[i].index = i;
+  }
+  {
+    TIMEIT_START(merge_sort);
+    BLI_merge_sort_r(elems, len, sizeof(*elems), sort_elem_cmp, NULL);
+    TIMEIT_END(merge_sort);
+  }
+
+  for (uint i = 0; i < len; i++) {
+    elems[i].key = (float)keys_init[i];
+    elems[i].index = i;
+  }
+  {
+    TIMEIT_START(qsort);
+    BLI_qsort_r(elems, len, sizeof(*elems), sort_elem_cmp, NULL);
+    TIMEIT_END(qsort);
+  }
+
+  MEM_freeN(keys_init);
+  MEM_freeN(keys);
+  MEM_freeN(values);
+  MEM_freeN(elems);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(sort, Random1M)
+{
+  BLI_threadapi_init();
+  sort_tests(1000000, "Random 1M");
+  BLI_threadapi_exit();
+}
+
+TEST(sort, Random10M)
+{
+  BLI_threadapi_init();
+  sort_tests(10000000, "Random 10M");
+  BLI_threadapi_exit();
+}
+
+#ifdef SORT_RUN_BIG
+TEST(sort, Random50M)
+{
+  BLI_threadapi_init();
+  sort_tests(50000000, "Random 50M");
+  BLI_threadapi_exit();
+}
+#endif
@@ -0,0 +1,195 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "BLI_rand.h"
+#include "BLI_sort.h"
+#include "BLI_utildefines.h"
+}
+
+/* Large enough to use several blocks and merge levels. */
+#define SORT_LEN_LARGE 300007
+
+struct SortElem {
+  int key;
+  uint index;
+};
+
+static int sort_elem_cmp(const void *a, const void *b, void *UNUSED(thunk))
+{
+  const SortElem *x = (const SortElem *)a, *y = (const SortElem *)b;
+  return (x->key > y->key) - (x->key < y->key);
+}
+
+static void radix_sort_uint_test(const uint len, const uint key_mask)
+{
+  RNG *rng = BLI_rng_new(len);
+  std::vector<uint> keys(len), values(len);
+  std::vector<std::pair<uint, uint>> expected(len);
+  for (uint i = 0; i < len; i++) {
+    keys[i] = BLI_rng_get_uint(rng) & key_mask;
+    values[i] = i;
+    expected[i] = std::make_pair(keys[i], i);
+  }
+  BLI_rng_free(rng);
+
+  /* Pairs with the index as second member sort the same as a stable sort on the key. */
+  std::sort(expected.begin(), expected.end());
+  BLI_radix_sort_uint(keys.data(), values.data(), len);
+
+  for (uint i = 0; i < len; i++) {
+    EXPECT_EQ(keys[i], expected[i].first);
+    EXPECT_EQ(values[i], expected[i].second);
+  }
+}
+
+TEST(sort, RadixUintEmpty)
+{
+  BLI_radix_sort_uint(NULL, NULL, 0);
+  uint key = 5;
+  BLI_radix_sort_uint(&key, NULL, 1);
+  EXPECT_EQ(key, 5u);
+}
+
+TEST(sort, RadixUintSmall)
+{
+  radix_sort_uint_test(1000, 0xffffffff);
+}
+
+TEST(sort, RadixUintSmallDuplicates)
+{
+  radix_sort_uint_test(1000, 0x0f0f);
+}
+
+TEST(sort, RadixUintLarge)
+{
+  radix_sort_uint_test(SORT_LEN_LARGE, 0xffffffff);
+}
+
+TEST(sort, RadixUintLargeDuplicates)
+{
+  radix_sort_uint_test(SORT_LEN_LARGE, 0xff00ff);
+}
+
+TEST(sort, RadixUintNoValues)
+{
+  const uint keys_init[] = {7, 0xffffffff, 3, 0, 3, 0x10000, 7};
+  const uint keys_sorted[] = {0, 3, 3, 7, 7, 0x10000, 0xffffffff};
+  uint keys[ARRAY_SIZE(keys_init)];
+  memcpy(keys, keys_init, sizeof(keys));
+  BLI_radix_sort_uint(keys, NULL, ARRAY_SIZE(keys));
+  for (uint i = 0; i < ARRAY_SIZE(keys); i++) {
+    EXPECT_EQ(keys[i], keys_sorted[i]);
+  }
+}
+
+TEST(sort, RadixInt)
+{
+  int keys[] = {5, -1, INT_MAX, 0, INT_MIN, -1, 5, -100};
+  uint values[ARRAY_SIZE(keys)];
+  for (uint i = 0; i < ARRAY_SIZE(keys); i++) {
+    values[i] = i;
+  }
+  const int keys_sorted[] = {INT_MIN, -100, -1, -1, 0, 5, 5, INT_MAX};
+  const uint values_sorted[] = {4, 7, 1, 5, 3, 0, 6, 2};
+
+  BLI_radix_sort_int(keys, values, ARRAY_SIZE(keys));
+  for (uint i = 0; i < ARRAY_SIZE(keys); i++) {
+    EXPECT_EQ(keys[i], keys_sorted[i]);
+    EXPECT_EQ(values[i], values_sorted[i]);
+  }
+}
+
+TEST(sort, RadixFloat)
+{
+  RNG *rng = BLI_rng_new(0);
+  const uint len = SORT_LEN_LARGE;
+  std::vector<float> keys(len);
+  std::vector<uint> values(len);
+  for (uint i = 0; i < len; i++) {
+    /* Few distinct values, with both signs, zeros and large magnitudes. */
+    keys[i] = (float)(BLI_rng_get_int(rng) % 2001 - 1000) * 1e3f;
+    values[i] = i;
+  }
+  keys[0] = -0.0f;
+  BLI_rng_free(rng);
+
+  std::vector<float> keys_init = keys;
+  BLI_radix_sort_float(keys.data(), values.data(), len);
+
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+  for (uint i = 0; i < len; i++) {
+    EXPECT_EQ(keys[i], keys_init[values[i]]);
+    if (i > 0 && keys[i - 1] == keys[i]) {
+      EXPECT_LT(values[i - 1], values[i]);
+    }
+  }
+}
+
+static void merge_sort_test(const uint len, const int key_range)
+{
+  RNG *rng = BLI_rng_new(len);
+  std::vector<SortElem> elems(len);
+  for (uint i = 0; i < len; i++) {
+    elems[i].key = BLI_rng_get_int(rng) % key_range;
+    elems[i].index = i;
+  }
+  BLI_rng_free(rng);
+
+  std::vector<SortElem> expected = elems;
+  std::stable_sort(expected.begin(), expected.end(), [](const SortElem &a, const SortElem &b) {
+    return a.key < b.key;
+  });
+  BLI_merge_sort_r(elems.data(), len, sizeof(SortElem), sort_elem_cmp, NULL);
+
+  for (uint i = 0; i < len; i++) {
+    EXPECT_EQ(elems[i].key, expected[i].key);
+    EXPECT_EQ(elems[i].index, expected[i].index);
+  }
+}
+
+TEST(sort, MergeEmpty)
+{
+  SortElem elem = {1, 0};
+  BLI_merge_sort_r(&elem, 0, sizeof(SortElem), sort_elem_cmp, NULL);
+  BLI_merge_sort_r(&elem, 1, sizeof(SortElem), sort_elem_cmp, NULL);
+  EXPECT_EQ(elem.key, 1);
+}
+
+TEST(sort, MergeSmall)
+{
+  merge_sort_test(1000, 100);
+}
+
+TEST(sort, MergeLarge)
+{
+  merge_sort_test(SORT_LEN_LARGE, 1 << 30);
+}
+
+TEST(sort, MergeLargeDuplicates)
+{
+  merge_sort_test(SORT_LEN_LARGE, 50);
+}
+
+TEST(sort, MergeLargeSorted)
+{
+  const uint len = SORT_LEN_LARGE;
+  std::vector<SortElem> elems(len);
+  for (uint i = 0; i < len; i++) {
+    elems[i].key = (int)(len - i) / 3;
+    elems[i].index = i;
+  }
+  BLI_merge_sort_r(elems.data(), len, sizeof(SortElem), sort_elem_cmp, NULL);
+  for (uint i = 1; i < len; i++) {
+    EXPECT_LE(elems[i - 1].key, elems[i].key);
+    if (elems[i - 1].key == elems[i].key) {
+      EXPECT_LT(elems[i - 1].index, elems[i].index);
+    }
+  }
+}
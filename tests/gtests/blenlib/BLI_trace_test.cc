@@ -0,0 +1,140 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_trace.h"
+#include "BLI_utildefines.h"
+}
+
+static std::string read_file(const std::string &filepath)
+{
+  std::ifstream file(filepath);
+  std::stringstream stream;
+  stream << file.rdbuf();
+  return stream.str();
+}
+
+static size_t count_substr(const std::string &str, const std::string &substr)
+{
+  size_t count = 0;
+  for (size_t pos = str.find(substr); pos != std::string::npos;
+       pos = str.find(substr, pos + substr.size())) {
+    count++;
+  }
+  return count;
+}
+
+TEST(trace, Disabled)
+{
+  EXPECT_FALSE(BLI_trace_is_enabled());
+  /* Markers are no-ops when tracing is disabled. */
+  BLI_trace_scope_begin("Unused");
+  BLI_trace_scope_end();
+  EXPECT_FALSE(BLI_trace_end());
+}
+
+TEST(trace, NestedScopes)
+{
+  const std::string filepath = ::testing::TempDir() + "BLI_trace_test_nested.json";
+
+  BLI_threadapi_init();
+  BLI_trace_begin(filepath.c_str());
+  EXPECT_TRUE(BLI_trace_is_enabled());
+
+  BLI_trace_scope_begin("Outer");
+  for (int i = 0; i < 3; i++) {
+    BLI_trace_scope_begin_fmt("Inner \"%d\"", i);
+    BLI_trace_scope_end();
+  }
+  BLI_trace_scope_end();
+  /* Unbalanced end is ignored. */
+  BLI_trace_scope_end();
+
+  EXPECT_TRUE(BLI_trace_end());
+  EXPECT_FALSE(BLI_trace_is_enabled());
+
+  const std::string json = read_file(filepath);
+  EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0);
+  EXPECT_EQ(count_substr(json, "\"ph\":\"X\""), 4);
+  EXPECT_EQ(count_substr(json, "\"name\":\"Outer\""), 1);
+  EXPECT_EQ(count_substr(json, "\"name\":\"Inner \\\"1\\\"\""), 1);
+  BLI_threadapi_exit();
+}
+
+static void trace_task_func(void *__restrict UNUSED(userdata),
+                            const int index,
+                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BLI_trace_scope_begin_fmt("Task %d", index);
+  BLI_trace_scope_end();
+}
+
+TEST(trace, Threads)
+{
+  const std::string filepath = ::testing::TempDir() + "BLI_trace_test_threads.json";
+  const int num_tasks = 1000;
+
+  BLI_threadapi_init();
+  BLI_trace_begin(filepath.c_str());
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, num_tasks, NULL, trace_task_func, &settings);
+
+  EXPECT_TRUE(BLI_trace_end());
+
+  const std::string json = read_file(filepath);
+  EXPECT_EQ(count_substr(json, "\"ph\":\"X\""), num_tasks);
+  EXPECT_EQ(count_substr(json, "\"name\":\"Task 999\""), 1);
+  EXPECT_GE(count_substr(json, "\"ph\":\"M\""), 1);
+  BLI_threadapi_exit();
+}
+
+TEST(trace, EndWhileRecording)
+{
+  const std::string filepath = ::testing::TempDir() + "BLI_trace_test_recording.json";
+  const int num_threads = 4;
+
+  BLI_threadapi_init();
+
+  /* Threads keep recording across sessions, buffers of a stopped session are freed while
+   * they still reference them in thread local storage. */
+  std::atomic<bool> running(true);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&running]() {
+      while (running) {
+        BLI_trace_scope_begin("Recording");
+        BLI_trace_scope_end();
+      }
+    });
+  }
+
+  for (int session = 0; session < 3; session++) {
+    BLI_trace_begin(filepath.c_str());
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_TRUE(BLI_trace_end());
+
+    const std::string json = read_file(filepath);
+    EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+  }
+
+  running = false;
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  BLI_threadapi_exit();
+}
@@ -250,4 +250,82 @@ TEST(multi_function_network, Test2)
   }
 }
 
+TEST(multi_function_network, Chunked)
+{
+  CustomMF_SI_SO<int, int> add_10_fn("add 10", [](int value) { return value + 10; });
+  CustomMF_SI_SI_SO<int, int, int> add_fn("add", [](int a, int b) { return a + b; });
+  CustomMF_SI_SO<int, int> negate_fn("negate", [](int value) { return -value; });
+
+  MFNetwork network;
+
+  MFNode &node1 = network.add_function(add_10_fn);
+  MFNode &node2 = network.add_function(add_fn);
+  MFNode &node3 = network.add_function(negate_fn);
+  MFOutputSocket &input_a = network.add_input("A", MFDataType::ForSingle<int>());
+  MFOutputSocket &input_b = network.add_input("B", MFDataType::ForSingle<int>());
+  MFInputSocket &output_1 = network.add_output("Out 1", MFDataType::ForSingle<int>());
+  MFInputSocket &output_2 = network.add_output("Out 2", MFDataType::ForSingle<int>());
+  network.add_link(input_a, node1.input(0));
+  network.add_link(node1.output(0), node2.input(0));
+  network.add_link(input_b, node2.input(1));
+  network.add_link(node2.output(0), node3.input(0));
+  network.add_link(node3.output(0), output_1);
+  network.add_link(node1.output(0), output_2);
+
+  MFNetworkEvaluator network_fn{{&input_a, &input_b}, {&output_1, &output_2}};
+
+  /* Large enough to be split into several chunks, with a partial last chunk. */
+  const uint size = 100003;
+  Array<int> values(size);
+  for (uint i : values.index_range()) {
+    values[i] = (int)i;
+  }
+  const int value_b = 5;
+
+  {
+    Array<int> results_1(size, 0);
+    Array<int> results_2(size, 0);
+
+    MFParamsBuilder params(network_fn, size);
+    params.add_readonly_single_input(values.as_span());
+    params.add_readonly_single_input(&value_b);
+    params.add_uninitialized_single_output(results_1.as_mutable_span());
+    params.add_uninitialized_single_output(results_2.as_mutable_span());
+
+    MFContextBuilder context;
+
+    network_fn.call(IndexRange(size), params, context);
+
+    for (uint i = 0; i < size; i++) {
+      EXPECT_EQ(results_1[i], -((int)i + 15));
+      EXPECT_EQ(results_2[i], (int)i + 10);
+    }
+  }
+  {
+    Vector<uint> indices;
+    for (uint i = 3; i < size; i += 3) {
+      indices.append(i);
+    }
+
+    Array<int> results_1(size, 0);
+    Array<int> results_2(size, 0);
+
+    MFParamsBuilder params(network_fn, size);
+    params.add_readonly_single_input(values.as_span());
+    params.add_readonly_single_input(&value_b);
+    params.add_uninitialized_single_output(results_1.as_mutable_span());
+    params.add_uninitialized_single_output(results_2.as_mutable_span());
+
+    MFContextBuilder context;
+
+    network_fn.call(indices.as_span(), params, context);
+
+    for (uint i = 0; i < size; i++) {
+      const bool is_masked = (i % 3 == 0) && i > 0;
+      EXPECT_EQ(results_1[i], is_masked ? -((int)i + 15) : 0);
+      EXPECT_EQ(results_2[i], is_masked ? (int)i + 10 : 0);
+    }
+  }
+}
+
 }  // namespace blender::fn
@@ -0,0 +1,136 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+TEST(guardedalloc, TCacheMemoryInUse)
+{
+  MEM_use_tcache_allocator();
+
+  const size_t mem_in_use = MEM_get_memory_in_use();
+  const unsigned int blocks_in_use = MEM_get_memory_blocks_in_use();
+
+  void *small = MEM_mallocN(24, __func__);
+  void *large = MEM_mallocN(1024 * 1024, __func__);
+  void *aligned = MEM_mallocN_aligned(100, 64, __func__);
+  EXPECT_EQ(MEM_get_memory_in_use(), mem_in_use + 24 + 1024 * 1024 + 100);
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use + 3);
+  EXPECT_EQ(MEM_allocN_len(small), 24);
+  EXPECT_EQ((uintptr_t)aligned % 64, 0);
+
+  MEM_freeN(small);
+  MEM_freeN(large);
+  MEM_freeN(aligned);
+  EXPECT_EQ(MEM_get_memory_in_use(), mem_in_use);
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use);
+}
+
+TEST(guardedalloc, TCacheReuseSizeClass)
+{
+  MEM_use_tcache_allocator();
+
+  /* Freed blocks are reused for other lengths in the same size class. */
+  char *a = (char *)MEM_mallocN(20, __func__);
+  memset(a, 255, 20);
+  MEM_freeN(a);
+
+  char *b = (char *)MEM_callocN(24, __func__);
+  EXPECT_EQ(MEM_allocN_len(b), 24);
+  for (int i = 0; i < 24; i++) {
+    EXPECT_EQ(b[i], 0);
+  }
+
+  b = (char *)MEM_recallocN(b, 2000);
+  for (int i = 0; i < 2000; i++) {
+    EXPECT_EQ(b[i], 0);
+  }
+  MEM_freeN(b);
+}
+
+TEST(guardedalloc, TCacheThreads)
+{
+  MEM_use_tcache_allocator();
+
+  const size_t mem_in_use = MEM_get_memory_in_use();
+  const unsigned int blocks_in_use = MEM_get_memory_blocks_in_use();
+  const int num_threads = 8;
+  const int num_blocks = 10000;
+
+  /* Allocate in one set of threads and free in another, so thread local usage only adds up
+   * when combined over all threads. */
+  std::vector<std::vector<void *>> blocks(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&blocks, t]() {
+      for (int i = 0; i < num_blocks; i++) {
+        blocks[t].push_back(MEM_mallocN((size_t)(i % 1500) + 1, __func__));
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use + num_threads * num_blocks);
+
+  threads.clear();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&blocks, t]() {
+      for (void *block : blocks[(t + 1) % num_threads]) {
+        MEM_freeN(block);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(MEM_get_memory_in_use(), mem_in_use);
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use);
+}
+
+TEST(guardedalloc, TCacheThreadsConcurrentStatistics)
+{
+  MEM_use_tcache_allocator();
+
+  const unsigned int blocks_in_use = MEM_get_memory_blocks_in_use();
+  const int num_threads = 8;
+  const int num_blocks = 10000;
+  const unsigned int blocks_max = blocks_in_use + num_threads * num_blocks;
+
+  /* Usage flushed by other threads must never be counted twice while reading statistics. */
+  std::vector<std::vector<void *>> blocks(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&blocks, t]() {
+      for (int i = 0; i < num_blocks; i++) {
+        blocks[t].push_back(MEM_mallocN((size_t)(i % 100) + 1, __func__));
+      }
+    });
+  }
+  unsigned int blocks_prev = blocks_in_use;
+  while (blocks_prev < blocks_max) {
+    const unsigned int blocks = MEM_get_memory_blocks_in_use();
+    EXPECT_GE(blocks, blocks_prev);
+    EXPECT_LE(blocks, blocks_max);
+    if (blocks < blocks_prev || blocks > blocks_max) {
+      break;
+    }
+    blocks_prev = blocks;
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_max);
+
+  for (std::vector<void *> &thread_blocks : blocks) {
+    for (void *block : thread_blocks) {
+      MEM_freeN(block);
+    }
+  }
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use);
+}